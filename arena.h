@@ -0,0 +1,53 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+using namespace std;
+
+// Deleter para objetos criados em uma arena monotônica: só roda o
+// destrutor, a memória volta de uma vez quando a arena é liberada
+template <typename T>
+struct ArenaDeleter {
+    ArenaDeleter() = default;
+    template <typename U>
+    ArenaDeleter(const ArenaDeleter<U>&) {}
+
+    void operator()(T* object) const {
+        if (object) object->~T();
+    }
+};
+
+template <typename T>
+using arena_ptr = unique_ptr<T, ArenaDeleter<T>>;
+
+// A arena precisa ser uma monotonic_buffer_resource (ou outra que ignore
+// deallocate) e viver mais que o objeto criado
+template <typename T, typename... Args>
+arena_ptr<T> arena_new(pmr::memory_resource& arena, Args&&... args) {
+    void* memory = arena.allocate(sizeof(T), alignof(T));
+    return arena_ptr<T>(new (memory) T(forward<Args>(args)...));
+}
+
+// Arena monotônica com um bloco inicial próprio; reset() descarta tudo em
+// O(1) e volta a usar o bloco inicial, sem chamar malloc na linha seguinte
+class Arena : public pmr::monotonic_buffer_resource {
+    private:
+        static constexpr size_t INITIAL_SIZE = 64 * 1024;
+        unique_ptr<byte[]> initial_buffer;
+
+        Arena(unique_ptr<byte[]> buffer, size_t size)
+            : pmr::monotonic_buffer_resource(buffer.get(), size), initial_buffer(move(buffer)) {}
+
+    public:
+        explicit Arena(size_t size = INITIAL_SIZE) : Arena(make_unique<byte[]>(size), size) {}
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        inline void reset() { release(); }
+};
+
+#endif
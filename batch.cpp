@@ -0,0 +1,319 @@
+#include "batch.h"
+#include <algorithm>
+#include <cstring>
+
+#if !defined(EDOO_NO_SIMD) && defined(__AVX2__)
+#define EDOO_SIMD_AVX2 1
+#include <immintrin.h>
+#elif !defined(EDOO_NO_SIMD) && defined(__SSE2__)
+#define EDOO_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+void ColumnBatch::bind(uint32_t slot, const int32_t* values) {
+    if (slot >= columns.size()) columns.resize(slot + 1);
+    columns[slot].ints = values;
+    columns[slot].bools = nullptr;
+}
+
+void ColumnBatch::bind(uint32_t slot, const bool* values) {
+    if (slot >= columns.size()) columns.resize(slot + 1);
+    columns[slot].bools = values;
+    columns[slot].ints = nullptr;
+}
+
+size_t BatchResult::error_count() const {
+    size_t count = 0;
+    for (uint64_t word : errors) count += __builtin_popcountll(word);
+    return count;
+}
+
+variant<int, bool> BatchResult::get(size_t row) const {
+    if (has_error(row)) throw ExpressionError("Divisão por zero");
+    if (type == ValueType::BOOLEAN) return values[row] != 0;
+    return values[row];
+}
+
+// Um vetor de LANES inteiros e as operações usadas pelos kernels
+#if EDOO_SIMD_AVX2
+using Vec = __m256i;
+constexpr size_t LANES = 8;
+static inline Vec vec_load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const Vec*>(p)); }
+static inline void vec_store(int32_t* p, Vec v) { _mm256_storeu_si256(reinterpret_cast<Vec*>(p), v); }
+static inline Vec vec_set1(int32_t x) { return _mm256_set1_epi32(x); }
+static inline Vec vec_add(Vec a, Vec b) { return _mm256_add_epi32(a, b); }
+static inline Vec vec_sub(Vec a, Vec b) { return _mm256_sub_epi32(a, b); }
+static inline Vec vec_mul(Vec a, Vec b) { return _mm256_mullo_epi32(a, b); }
+static inline Vec vec_and(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+static inline Vec vec_or(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+static inline Vec vec_xor(Vec a, Vec b) { return _mm256_xor_si256(a, b); }
+static inline Vec vec_cmpgt(Vec a, Vec b) { return _mm256_cmpgt_epi32(a, b); }
+static inline Vec vec_cmpeq(Vec a, Vec b) { return _mm256_cmpeq_epi32(a, b); }
+#elif EDOO_SIMD_SSE2
+using Vec = __m128i;
+constexpr size_t LANES = 4;
+static inline Vec vec_load(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const Vec*>(p)); }
+static inline void vec_store(int32_t* p, Vec v) { _mm_storeu_si128(reinterpret_cast<Vec*>(p), v); }
+static inline Vec vec_set1(int32_t x) { return _mm_set1_epi32(x); }
+static inline Vec vec_add(Vec a, Vec b) { return _mm_add_epi32(a, b); }
+static inline Vec vec_sub(Vec a, Vec b) { return _mm_sub_epi32(a, b); }
+// SSE2 não tem mullo_epi32: multiplica as posições pares e ímpares e junta
+static inline Vec vec_mul(Vec a, Vec b) {
+    Vec even = _mm_mul_epu32(a, b);
+    Vec odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+static inline Vec vec_and(Vec a, Vec b) { return _mm_and_si128(a, b); }
+static inline Vec vec_or(Vec a, Vec b) { return _mm_or_si128(a, b); }
+static inline Vec vec_xor(Vec a, Vec b) { return _mm_xor_si128(a, b); }
+static inline Vec vec_cmpgt(Vec a, Vec b) { return _mm_cmpgt_epi32(a, b); }
+static inline Vec vec_cmpeq(Vec a, Vec b) { return _mm_cmpeq_epi32(a, b); }
+#endif
+
+const char* BatchEvaluator::instruction_set() {
+#if EDOO_SIMD_AVX2
+    return "AVX2";
+#elif EDOO_SIMD_SSE2
+    return "SSE2";
+#else
+    return "escalar";
+#endif
+}
+
+#if EDOO_SIMD_AVX2 || EDOO_SIMD_SSE2
+#define KERNEL_SIMD(expr) static Vec simd(Vec a, Vec b) { const Vec one = vec_set1(1); (void)one; return expr; }
+#else
+#define KERNEL_SIMD(expr)
+#endif
+
+// Operações elemento a elemento: scalar para a cauda do bloco (e para
+// quando não há SIMD), simd para LANES elementos por vez. Comparações
+// devolvem 0/1, como o VM
+#define KERNEL(name, scalar_expr, simd_expr) \
+    struct name { \
+        static int32_t scalar(int32_t a, int32_t b) { return scalar_expr; } \
+        KERNEL_SIMD(simd_expr) \
+    };
+
+// Aritmética em uint32_t para dar a volta no overflow como as instruções SIMD
+KERNEL(Add, static_cast<int32_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b)), vec_add(a, b))
+KERNEL(Sub, static_cast<int32_t>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b)), vec_sub(a, b))
+KERNEL(Mul, static_cast<int32_t>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b)), vec_mul(a, b))
+KERNEL(Less, a < b, vec_and(vec_cmpgt(b, a), one))
+KERNEL(Greater, a > b, vec_and(vec_cmpgt(a, b), one))
+KERNEL(LessEqual, a <= b, vec_xor(vec_and(vec_cmpgt(a, b), one), one))
+KERNEL(GreaterEqual, a >= b, vec_xor(vec_and(vec_cmpgt(b, a), one), one))
+KERNEL(Equal, a == b, vec_and(vec_cmpeq(a, b), one))
+KERNEL(NotEqual, a != b, vec_xor(vec_and(vec_cmpeq(a, b), one), one))
+KERNEL(And, a & b, vec_and(a, b))
+KERNEL(Or, a | b, vec_or(a, b))
+
+#undef KERNEL
+#undef KERNEL_SIMD
+
+// a[i] = Op(a[i], b[i]): o resultado fica no operando da esquerda, como na pilha do VM
+template <typename Op>
+static void binary_kernel(int32_t* a, const int32_t* b, size_t count) {
+    size_t i = 0;
+#if EDOO_SIMD_AVX2 || EDOO_SIMD_SSE2
+    for (; i + LANES <= count; i += LANES) {
+        vec_store(a + i, Op::simd(vec_load(a + i), vec_load(b + i)));
+    }
+#endif
+    for (; i < count; i++) {
+        a[i] = Op::scalar(a[i], b[i]);
+    }
+}
+
+static void negate_kernel(int32_t* a, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        a[i] = static_cast<int32_t>(0u - static_cast<uint32_t>(a[i]));
+    }
+}
+
+// Não há divisão inteira em SIMD. Divisor zero liga o bit da linha e usa 1
+// no lugar, para que as instruções seguintes continuem bem definidas
+static void divide_kernel(int32_t* a, const int32_t* b, size_t count, uint64_t* errors) {
+    for (size_t i = 0; i < count; i++) {
+        int32_t divisor = b[i];
+        if (divisor == 0) {
+            errors[i / 64] |= uint64_t(1) << (i % 64);
+            divisor = 1;
+        }
+        a[i] = a[i] / divisor;
+    }
+}
+
+static void fill_kernel(int32_t* a, int32_t value, size_t count) {
+    for (size_t i = 0; i < count; i++) a[i] = value;
+}
+
+// rows nulo: linhas contíguas a partir de begin; senão, as linhas listadas
+static void load_int_kernel(int32_t* a, const int32_t* values, const uint32_t* rows, size_t begin, size_t count) {
+    if (!rows) {
+        memcpy(a, values + begin, count * sizeof(int32_t));
+        return;
+    }
+    for (size_t i = 0; i < count; i++) a[i] = values[rows[i]];
+}
+
+static void load_bool_kernel(int32_t* a, const bool* values, const uint32_t* rows, size_t begin, size_t count) {
+    if (!rows) {
+        values += begin;
+        for (size_t i = 0; i < count; i++) a[i] = values[i];
+        return;
+    }
+    for (size_t i = 0; i < count; i++) a[i] = values[rows[i]];
+}
+
+void BatchEvaluator::check_columns(const CompiledExpression& expression, const ColumnBatch& columns) {
+    for (const auto& variable : expression.get_variables()) {
+        bool bound = variable.type == ValueType::INTEGER ? columns.int_column(variable.slot) != nullptr
+                                                         : columns.bool_column(variable.slot) != nullptr;
+        if (!bound) {
+            throw VariableError("Coluna ausente ou de outro tipo para a variável " + variable.name);
+        }
+    }
+}
+
+// Linhas decididas pela esquerda de um && (valor 0) ou || (valor != 0), um
+// bit por linha; devolve se todas as count linhas foram decididas
+static bool decided_kernel(const int32_t* a, bool decisive, size_t count, uint64_t* decided) {
+    bool all = true;
+    for (size_t w = 0; w < (count + 63) / 64; w++) {
+        size_t n = min<size_t>(64, count - w * 64);
+        uint64_t bits = 0;
+        for (size_t i = 0; i < n; i++) {
+            bits |= uint64_t((a[w * 64 + i] != 0) == decisive) << i;
+        }
+        decided[w] = bits;
+        all = all && bits == (n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1);
+    }
+    return all;
+}
+
+void BatchEvaluator::prepare(const Program& program) {
+    registers.resize(max<size_t>(program.max_stack, 1) * BLOCK_SIZE);
+    block_errors.resize(BLOCK_SIZE / 64);
+}
+
+const int32_t* BatchEvaluator::run_block(const Program& program, size_t first, size_t last, const ColumnBatch& columns,
+                                         const uint32_t* rows, size_t begin, size_t count) {
+    // sp aponta para o próximo bloco livre da pilha
+    int32_t* sp = registers.data();
+    fill(block_errors.begin(), block_errors.end(), 0);
+    constexpr size_t WORDS = BLOCK_SIZE / 64;
+    jump_targets.clear();
+    jump_masks.clear();
+
+    const Instruction* code = program.code.data();
+    for (size_t index = first; ; index++) {
+        // Fim de um curto-circuito: as linhas decididas pela esquerda ficam
+        // com os erros de antes da direita
+        while (!jump_targets.empty() && jump_targets.back() == index) {
+            const uint64_t* saved = jump_masks.data() + jump_masks.size() - 2 * WORDS;
+            const uint64_t* decided = saved + WORDS;
+            for (size_t w = 0; w < WORDS; w++) {
+                block_errors[w] = saved[w] | (block_errors[w] & ~decided[w]);
+            }
+            jump_targets.pop_back();
+            jump_masks.resize(jump_masks.size() - 2 * WORDS);
+        }
+        if (index == last) break;
+
+        const Instruction* ip = code + index;
+        switch (ip->op) {
+            case OpCode::PUSH_INT:
+            case OpCode::PUSH_BOOL:
+                fill_kernel(sp, ip->operand, count);
+                sp += BLOCK_SIZE;
+                break;
+            case OpCode::LOAD_I:
+                load_int_kernel(sp, columns.int_column(ip->operand), rows, begin, count);
+                sp += BLOCK_SIZE;
+                break;
+            case OpCode::LOAD_B:
+                load_bool_kernel(sp, columns.bool_column(ip->operand), rows, begin, count);
+                sp += BLOCK_SIZE;
+                break;
+            case OpCode::NEG_I:
+                negate_kernel(sp - BLOCK_SIZE, count);
+                break;
+            case OpCode::DIV_I:
+                sp -= BLOCK_SIZE;
+                divide_kernel(sp - BLOCK_SIZE, sp, count, block_errors.data());
+                break;
+
+            #define BINARY_CASE(opcode, kernel) \
+            case OpCode::opcode: \
+                sp -= BLOCK_SIZE; \
+                binary_kernel<kernel>(sp - BLOCK_SIZE, sp, count); \
+                break;
+            BINARY_CASE(ADD_I, Add)
+            BINARY_CASE(SUB_I, Sub)
+            BINARY_CASE(MUL_I, Mul)
+            BINARY_CASE(LT_I, Less)
+            BINARY_CASE(GT_I, Greater)
+            BINARY_CASE(LE_I, LessEqual)
+            BINARY_CASE(GE_I, GreaterEqual)
+            BINARY_CASE(EQ_I, Equal)
+            BINARY_CASE(NE_I, NotEqual)
+            BINARY_CASE(AND_B, And)
+            BINARY_CASE(OR_B, Or)
+            BINARY_CASE(EQ_B, Equal)
+            BINARY_CASE(NE_B, NotEqual)
+            #undef BINARY_CASE
+
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE: {
+                size_t target = index + ip->operand;
+                size_t mark = jump_masks.size();
+                jump_masks.resize(mark + 2 * WORDS);
+                if (decided_kernel(sp - BLOCK_SIZE, ip->op == OpCode::JUMP_IF_TRUE, count, jump_masks.data() + WORDS + mark)) {
+                    // A esquerda decide o bloco inteiro: pula a direita
+                    jump_masks.resize(mark);
+                    index = target - 1;
+                    break;
+                }
+                copy(block_errors.begin(), block_errors.end(), jump_masks.begin() + mark);
+                jump_targets.push_back(target);
+                break;
+            }
+            case OpCode::FAIL:
+                // ExpressionEvaluator::compile rejeita programas mal tipados
+                program.failures[ip->operand].raise();
+            case OpCode::HALT:
+                return sp - BLOCK_SIZE;
+        }
+    }
+    return sp - BLOCK_SIZE;
+}
+
+BatchResult BatchEvaluator::evaluate(const CompiledExpression& expression, const ColumnBatch& columns) {
+    BatchResult result;
+    evaluate(expression, columns, result);
+    return result;
+}
+
+void BatchEvaluator::evaluate(const CompiledExpression& expression, const ColumnBatch& columns, BatchResult& out) {
+    check_columns(expression, columns);
+
+    const Program& program = expression.get_program();
+    size_t rows = columns.size();
+    out.type = program.result_type;
+    out.values.resize(rows);
+    out.errors.assign((rows + 63) / 64, 0);
+
+    prepare(program);
+
+    for (size_t begin = 0; begin < rows; begin += BLOCK_SIZE) {
+        size_t count = min(BLOCK_SIZE, rows - begin);
+        const int32_t* values = run_block(program, 0, program.code.size(), columns, nullptr, begin, count);
+        memcpy(out.values.data() + begin, values, count * sizeof(int32_t));
+        // begin é múltiplo de BLOCK_SIZE, que é múltiplo de 64
+        for (size_t w = 0; w < (count + 63) / 64; w++) {
+            out.errors[begin / 64 + w] = block_errors[w];
+        }
+    }
+}
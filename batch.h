@@ -0,0 +1,94 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "compiled_expression.h"
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+// Colunas de entrada: uma por variável, indexadas pelo slot. Os dados são
+// emprestados, então precisam viver até o fim da avaliação
+class ColumnBatch {
+    private:
+        struct Column {
+            const int32_t* ints = nullptr;
+            const bool* bools = nullptr;
+        };
+
+        vector<Column> columns;
+        size_t rows;
+
+    public:
+        explicit ColumnBatch(size_t rows) : rows(rows) {}
+
+        void bind(uint32_t slot, const int32_t* values);
+        void bind(uint32_t slot, const bool* values);
+
+        inline size_t size() const { return rows; }
+        inline const int32_t* int_column(uint32_t slot) const {
+            return slot < columns.size() ? columns[slot].ints : nullptr;
+        }
+        inline const bool* bool_column(uint32_t slot) const {
+            return slot < columns.size() ? columns[slot].bools : nullptr;
+        }
+};
+
+// Coluna de saída. Booleanos ficam como 0/1; linhas cuja avaliação falharia
+// (divisão por zero) têm o bit ligado em errors e valor indefinido
+class BatchResult {
+    public:
+        ValueType type = ValueType::INVALID;
+        vector<int32_t> values;
+        vector<uint64_t> errors;
+
+        inline size_t size() const { return values.size(); }
+        inline bool has_error(size_t row) const { return (errors[row / 64] >> (row % 64)) & 1; }
+        size_t error_count() const;
+
+        // Mesmo resultado de CompiledExpression::evaluate para a linha: lança
+        // ExpressionError("Divisão por zero") se a linha falhou
+        variant<int, bool> get(size_t row) const;
+};
+
+// Avalia o bytecode de uma CompiledExpression coluna a coluna, em blocos de
+// BLOCK_SIZE linhas: cada instrução vira um laço (kernel) sobre o bloco
+// inteiro em vez de um despacho por linha. Os kernels usam AVX2 ou SSE2
+// quando o compilador os habilita e laços escalares caso contrário
+// (EDOO_NO_SIMD força os escalares). && e || avaliam a direita para o bloco
+// todo, menos quando a esquerda já decide todas as linhas; erros da direita
+// nas linhas decididas são descartados, como no curto-circuito do VM
+class BatchEvaluator {
+    public:
+        static constexpr size_t BLOCK_SIZE = 1024;
+
+    private:
+        // Pilha de blocos, reaproveitada entre chamadas
+        vector<int32_t> registers;
+        vector<uint64_t> block_errors;
+        // Curto-circuitos abertos em run_block, do mais externo ao mais
+        // interno: o índice em que terminam e, para cada um, BLOCK_SIZE / 64
+        // palavras com os erros de antes da direita e outras tantas com as
+        // linhas já decididas pela esquerda
+        vector<size_t> jump_targets;
+        vector<uint64_t> jump_masks;
+
+        static void check_columns(const CompiledExpression& expression, const ColumnBatch& columns);
+        void prepare(const Program& program);
+        // Executa code[first, last) sobre count linhas: contíguas a partir de
+        // begin, ou as listadas em rows. Devolve o bloco do topo da pilha;
+        // os erros ficam em block_errors
+        const int32_t* run_block(const Program& program, size_t first, size_t last, const ColumnBatch& columns,
+                                 const uint32_t* rows, size_t begin, size_t count);
+
+        friend class FilterEvaluator;
+
+    public:
+        BatchResult evaluate(const CompiledExpression& expression, const ColumnBatch& columns);
+        // Reaproveita a memória de out
+        void evaluate(const CompiledExpression& expression, const ColumnBatch& columns, BatchResult& out);
+
+        // Nome do conjunto de instruções usado pelos kernels
+        static const char* instruction_set();
+};
+
+#endif
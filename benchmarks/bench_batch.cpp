@@ -0,0 +1,88 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "parser.h"
+#include "filter.h"
+using namespace std;
+
+// Mesma regra avaliada linha a linha (CompiledExpression::evaluate, pelo VM
+// e pelo JIT) e coluna a coluna (BatchEvaluator)
+int main(int argc, char* argv[]) {
+    size_t rows = (argc > 1) ? stoul(argv[1]) : 10000000;
+
+    Variables variables;
+    uint32_t price = variables.declare("price", ValueType::INTEGER);
+    uint32_t quantity = variables.declare("quantity", ValueType::INTEGER);
+    uint32_t active = variables.declare("active", ValueType::BOOLEAN);
+    ExpressionEvaluator evaluator;
+    CompiledExpression rule = evaluator.compile("price * quantity - 50 > 1000 && active || quantity == 0", variables);
+
+    mt19937 rng(42);
+    vector<int32_t> prices(rows), quantities(rows);
+    unique_ptr<bool[]> actives(new bool[rows]);
+    for (size_t i = 0; i < rows; i++) {
+        prices[i] = rng() % 500;
+        quantities[i] = rng() % 20;
+        actives[i] = rng() & 1;
+    }
+
+    size_t row_hits = 0;
+    auto start = chrono::steady_clock::now();
+    int32_t slots[3];
+    for (size_t i = 0; i < rows; i++) {
+        slots[price] = prices[i];
+        slots[quantity] = quantities[i];
+        slots[active] = actives[i];
+        row_hits += get<bool>(rule.evaluate(slots));
+    }
+    double row_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    CompiledExpression native = rule;
+    bool jit = native.enable_jit();
+    size_t jit_hits = 0;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < rows; i++) {
+        slots[price] = prices[i];
+        slots[quantity] = quantities[i];
+        slots[active] = actives[i];
+        jit_hits += get<bool>(native.evaluate(slots));
+    }
+    double jit_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    ColumnBatch columns(rows);
+    columns.bind(price, prices.data());
+    columns.bind(quantity, quantities.data());
+    columns.bind(active, actives.get());
+    BatchEvaluator batch;
+    BatchResult result;
+    // A primeira chamada aloca a coluna de saída; mede a segunda
+    batch.evaluate(rule, columns, result);
+    start = chrono::steady_clock::now();
+    batch.evaluate(rule, columns, result);
+    double batch_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    size_t batch_hits = 0;
+    for (int32_t value : result.values) batch_hits += value;
+
+    FilterEvaluator filter;
+    FilterResult selected;
+    filter.filter(rule, columns, selected);
+    start = chrono::steady_clock::now();
+    filter.filter(rule, columns, selected);
+    double filter_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double input_bytes = rows * (2 * sizeof(int32_t) + sizeof(bool));
+    cout << "linhas: " << rows << "\n";
+    cout << "kernels: " << BatchEvaluator::instruction_set() << "\n";
+    cout << "por linha: " << row_time * 1e9 / rows << " ns/linha\n";
+    cout << "por linha (JIT" << (jit ? "" : " indisponível, VM") << "): " << jit_time * 1e9 / rows << " ns/linha, "
+         << row_time / jit_time << "x\n";
+    cout << "em colunas: " << batch_time * 1e9 / rows << " ns/linha, "
+         << input_bytes / batch_time / 1e9 << " GB/s de entrada\n";
+    cout << "speedup: " << row_time / batch_time << "x\n";
+    cout << "filtro: " << filter_time * 1e9 / rows << " ns/linha\n";
+    cout << selected.statistics_to_string();
+    return row_hits == batch_hits && jit_hits == row_hits && selected.selection.size() == batch_hits ? 0 : 1;
+}
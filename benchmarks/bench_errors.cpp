@@ -0,0 +1,49 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "parser.h"
+using namespace std;
+
+// Linhas com uma fração de inválidas, avaliadas com exceções (evaluate) e
+// sem (try_evaluate)
+int main(int argc, char* argv[]) {
+    size_t lines = (argc > 1) ? stoul(argv[1]) : 1000000;
+    double invalid_fraction = (argc > 2) ? stod(argv[2]) : 0.3;
+
+    const vector<string> valid = {"1 + 2 * 3", "(4 + 5) * 6 > 50", "true && (3 < 4)", "- 7 * 8 / 2"};
+    const vector<string> invalid = {"1 / 0", "1 + true", "(1 + 2", "1 $ 2", "- true", "99999999999"};
+    mt19937 rng(42);
+    uniform_real_distribution<double> coin(0.0, 1.0);
+    vector<string> input(lines);
+    for (auto& line : input) {
+        line = (coin(rng) < invalid_fraction) ? invalid[rng() % invalid.size()] : valid[rng() % valid.size()];
+    }
+
+    ExpressionEvaluator evaluator(Engine::BYTECODE);
+    size_t errors = 0;
+    auto start = chrono::steady_clock::now();
+    for (const auto& line : input) {
+        try {
+            evaluator.evaluate(line);
+        } catch (const exception&) {
+            errors++;
+        }
+        evaluator.reset();
+    }
+    double throwing = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    size_t try_errors = 0;
+    start = chrono::steady_clock::now();
+    for (const auto& line : input) {
+        if (!evaluator.try_evaluate(line)) try_errors++;
+        evaluator.reset();
+    }
+    double non_throwing = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << lines << " linhas, " << errors << " com erro" << endl;
+    cout << "evaluate:     " << throwing << " s" << endl;
+    cout << "try_evaluate: " << non_throwing << " s (" << throwing / non_throwing << "x)" << endl;
+    return errors == try_errors ? 0 : 1;
+}
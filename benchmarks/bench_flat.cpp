@@ -0,0 +1,245 @@
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "parser.h"
+#include "workload.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+enum class CacheEvent { L1_READ_MISSES, LLC_MISSES };
+
+// Um contador de hardware do processo (perf_event_open). Sem permissão, sem
+// PMU (máquinas virtuais) ou fora do Linux fica indisponível
+class CacheCounter {
+    private:
+        int fd = -1;
+
+    public:
+        explicit CacheCounter(CacheEvent event) {
+#ifdef __linux__
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            if (event == CacheEvent::L1_READ_MISSES) {
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            } else {
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            }
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+            (void)event;
+#endif
+        }
+        ~CacheCounter() {
+#ifdef __linux__
+            if (fd >= 0) close(fd);
+#endif
+        }
+        CacheCounter(const CacheCounter&) = delete;
+        CacheCounter& operator=(const CacheCounter&) = delete;
+
+        inline bool available() const { return fd >= 0; }
+
+        void start() {
+#ifdef __linux__
+            if (fd < 0) return;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+        }
+        uint64_t stop() {
+            uint64_t count = 0;
+#ifdef __linux__
+            if (fd < 0) return 0;
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &count, sizeof(count)) != sizeof(count)) count = 0;
+#endif
+            return count;
+        }
+};
+
+struct Pass {
+    double seconds = 0;
+    uint64_t l1_misses = 0;
+    uint64_t llc_misses = 0;
+};
+
+// Bytes do nó da árvore, pelo tipo concreto
+static size_t node_size(const Expression& expression) {
+    switch (expression.get_kind()) {
+        case ExpressionKind::LITERAL:  return sizeof(Literal);
+        case ExpressionKind::VARIABLE: return sizeof(Variable);
+        case ExpressionKind::PRIMARY:  return sizeof(PrimaryExpression);
+        case ExpressionKind::UNARY:    return sizeof(UnaryExpression);
+        case ExpressionKind::BINARY:   return sizeof(BinaryExpression);
+    }
+    return 0;
+}
+
+// Nós da árvore e linhas de cache de 64 bytes distintas que eles ocupam
+static void walk(const Expression& root, size_t& nodes, size_t& lines) {
+    unordered_set<uintptr_t> touched;
+    vector<const Expression*> pending = {&root};
+    while (!pending.empty()) {
+        const Expression* expression = pending.back();
+        pending.pop_back();
+        nodes++;
+        uintptr_t begin = reinterpret_cast<uintptr_t>(expression);
+        for (uintptr_t line = begin / 64; line <= (begin + node_size(*expression) - 1) / 64; line++) touched.insert(line);
+        switch (expression->get_kind()) {
+            case ExpressionKind::PRIMARY:
+                pending.push_back(&static_cast<const PrimaryExpression*>(expression)->get_expression());
+                break;
+            case ExpressionKind::UNARY:
+                pending.push_back(&static_cast<const UnaryExpression*>(expression)->get_expression());
+                break;
+            case ExpressionKind::BINARY:
+                pending.push_back(&static_cast<const BinaryExpression*>(expression)->get_left());
+                pending.push_back(&static_cast<const BinaryExpression*>(expression)->get_right());
+                break;
+            default:
+                break;
+        }
+    }
+    lines += touched.size();
+}
+
+static size_t cache_lines(size_t bytes) { return (bytes + 63) / 64; }
+
+// Linhas de cache que a varredura lê e escreve: opcodes, filhos, literais e
+// os dois arrays de trabalho (as posições só são lidas nos erros)
+static size_t flat_lines(const FlatExpression& flat) {
+    size_t n = flat.size();
+    return cache_lines(n) + 2 * cache_lines(n * sizeof(uint32_t)) + cache_lines(flat.get_literals().size() * sizeof(int32_t))
+         + cache_lines(n * sizeof(int32_t)) + cache_lines(n * sizeof(uint32_t));
+}
+
+template <typename Function>
+static Pass measure(size_t repetitions, CacheCounter& l1, CacheCounter& llc, Function function) {
+    Pass best;
+    for (size_t r = 0; r < repetitions; r++) {
+        l1.start();
+        llc.start();
+        auto start = chrono::steady_clock::now();
+        function();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        uint64_t l1_misses = l1.stop();
+        uint64_t llc_misses = llc.stop();
+        if (r == 0 || seconds < best.seconds) best = {seconds, l1_misses, llc_misses};
+    }
+    return best;
+}
+
+// As mesmas linhas de cada carga (sem as inválidas) como árvores, todas
+// vivas numa Arena, e como FlatExpression: bytes por nó, tempo de avaliação
+// por nó e falhas de cache (contadores de hardware, se houver, e as linhas
+// de cache que cada representação ocupa)
+int main(int argc, char* argv[]) {
+    size_t count = (argc > 1) ? stoul(argv[1]) : 20000;
+    size_t repetitions = (argc > 2) ? stoul(argv[2]) : 5;
+
+    CacheCounter l1(CacheEvent::L1_READ_MISSES);
+    CacheCounter llc(CacheEvent::LLC_MISSES);
+    bool counters = l1.available() && llc.available();
+    if (!counters) cout << "contadores de cache indisponíveis (perf_event_open); só as linhas de cache tocadas\n";
+
+    cout << fixed << setprecision(2);
+    cout << left << setw(9) << "carga" << right << setw(8) << "nós" << setw(8) << "nós" << setw(9) << "B/nó" << setw(9) << "B/nó"
+         << setw(10) << "linhas" << setw(10) << "linhas" << setw(9) << "ns/nó" << setw(9) << "ns/nó" << setw(9) << "speedup";
+    if (counters) cout << setw(11) << "L1 miss" << setw(11) << "L1 miss" << setw(11) << "LLC miss" << setw(11) << "LLC miss";
+    cout << "\n" << left << setw(9) << "" << right << setw(8) << "árvore" << setw(8) << "flat" << setw(9) << "árvore" << setw(9) << "flat"
+         << setw(10) << "árv./nó" << setw(10) << "flat/nó" << setw(9) << "árvore" << setw(9) << "flat" << setw(9) << "";
+    if (counters) cout << setw(11) << "árv./nó" << setw(11) << "flat/nó" << setw(11) << "árv./nó" << setw(11) << "flat/nó";
+    cout << "\n";
+
+    for (WorkloadKind kind : {WorkloadKind::SHORT, WorkloadKind::CHAIN, WorkloadKind::NESTED, WorkloadKind::BOOLEAN, WorkloadKind::MIXED}) {
+        WorkloadOptions options;
+        options.lines = count;
+        options.error_ratio = 0.0;
+        vector<string> lines = WorkloadGenerator(options).generate(kind);
+
+        Arena arena;
+        CountingResource counting(arena);
+        vector<ExpressionPtr> trees;
+        vector<FlatExpression> flats;
+        size_t tree_nodes = 0, tree_lines = 0, flat_nodes = 0, flat_bytes = 0, flat_touched = 0;
+        for (const auto& line : lines) {
+            Lexer lexer(line);
+            Parser parser(lexer, counting);
+            if (auto expr = parser.try_parse()) {
+                walk(*expr, tree_nodes, tree_lines);
+                flats.emplace_back(*expr);
+                trees.push_back(move(expr));
+            }
+        }
+        for (auto& flat : flats) {
+            // Aloca os arrays de trabalho antes de medir
+            flat.try_evaluate();
+            flat_nodes += flat.size();
+            flat_bytes += flat.memory();
+            flat_touched += flat_lines(flat);
+        }
+
+        int64_t tree_sink = 0, flat_sink = 0;
+        Pass tree = measure(repetitions, l1, llc, [&] {
+            int64_t sum = 0;
+            for (const auto& expr : trees) {
+                try {
+                    auto value = expr->evaluate();
+                    sum += holds_alternative<int>(value) ? get<int>(value) : get<bool>(value);
+                } catch (const exception&) {
+                    sum--;
+                }
+            }
+            tree_sink = sum;
+        });
+        Pass flat = measure(repetitions, l1, llc, [&] {
+            int64_t sum = 0;
+            for (auto& expression : flats) {
+                EvaluationResult result = expression.try_evaluate();
+                if (result) {
+                    const auto& value = result.get_value();
+                    sum += holds_alternative<int>(value) ? get<int>(value) : get<bool>(value);
+                } else {
+                    sum--;
+                }
+            }
+            flat_sink = sum;
+        });
+        if (tree_sink != flat_sink) {
+            cerr << workload_name(kind) << ": resultados diferentes" << endl;
+            return 1;
+        }
+
+        double tree_ns = tree.seconds * 1e9 / tree_nodes;
+        double flat_ns = flat.seconds * 1e9 / flat_nodes;
+        cout << left << setw(9) << workload_name(kind) << right << setw(8) << tree_nodes / trees.size()
+             << setw(8) << flat_nodes / flats.size()
+             << setw(9) << static_cast<double>(counting.bytes) / tree_nodes << setw(9) << static_cast<double>(flat_bytes) / flat_nodes
+             << setw(10) << static_cast<double>(tree_lines) / tree_nodes << setw(10) << static_cast<double>(flat_touched) / flat_nodes
+             << setw(9) << tree_ns << setw(9) << flat_ns << setw(8) << tree.seconds / flat.seconds << "x";
+        if (counters) {
+            cout << setw(11) << static_cast<double>(tree.l1_misses) / tree_nodes << setw(11) << static_cast<double>(flat.l1_misses) / flat_nodes
+                 << setw(11) << static_cast<double>(tree.llc_misses) / tree_nodes << setw(11) << static_cast<double>(flat.llc_misses) / flat_nodes;
+        }
+        cout << "\n";
+
+        flats.clear();
+        trees.clear();
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "parser.h"
+#include "incremental.h"
+using namespace std;
+
+// Uma regra grande (pontuação ponderada de N variáveis, em árvore
+// balanceada, e um limite) num fluxo de eventos que mudam um ou dois campos:
+// avaliação completa pelo VM e pelo JIT a cada evento x IncrementalExpression
+int main(int argc, char* argv[]) {
+    size_t events = (argc > 1) ? stoul(argv[1]) : 1000000;
+    size_t fields = (argc > 2) ? stoul(argv[2]) : 256;
+
+    Variables variables;
+    function<string(size_t, size_t)> score = [&](size_t first, size_t count) -> string {
+        if (count == 1) {
+            string name = "f" + to_string(first);
+            variables.declare(name, ValueType::INTEGER);
+            return name + " * " + to_string(1 + first % 7);
+        }
+        return "( " + score(first, count / 2) + " ) + ( " + score(first + count / 2, count - count / 2) + " )";
+    };
+    string input = "( " + score(0, fields) + " ) > " + to_string(fields * 200);
+    ExpressionEvaluator evaluator;
+    CompiledExpression rule = evaluator.compile(input, variables);
+
+    mt19937 rng(42);
+    vector<uint32_t> changed(events * 2);
+    vector<int32_t> values(events * 2);
+    for (size_t i = 0; i < changed.size(); i++) {
+        changed[i] = rng() % fields;
+        values[i] = rng() % 100;
+    }
+    // Metade dos eventos muda um campo, a outra metade dois
+    auto changes = [](size_t event) { return 1 + event % 2; };
+
+    vector<int32_t> slots(fields, 0);
+    size_t vm_hits = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t e = 0; e < events; e++) {
+        for (size_t j = 0; j < changes(e); j++) slots[changed[2 * e + j]] = values[2 * e + j];
+        vm_hits += get<bool>(rule.evaluate(slots.data()));
+    }
+    double vm_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    CompiledExpression native = rule;
+    bool jit = native.enable_jit();
+    fill(slots.begin(), slots.end(), 0);
+    size_t jit_hits = 0;
+    start = chrono::steady_clock::now();
+    for (size_t e = 0; e < events; e++) {
+        for (size_t j = 0; j < changes(e); j++) slots[changed[2 * e + j]] = values[2 * e + j];
+        jit_hits += get<bool>(native.evaluate(slots.data()));
+    }
+    double jit_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    IncrementalExpression incremental(rule);
+    size_t incremental_hits = 0, recomputed = 0;
+    start = chrono::steady_clock::now();
+    for (size_t e = 0; e < events; e++) {
+        for (size_t j = 0; j < changes(e); j++) incremental.set(changed[2 * e + j], values[2 * e + j]);
+        incremental_hits += get<bool>(incremental.evaluate());
+        recomputed += incremental.get_recomputed();
+    }
+    double incremental_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "eventos: " << events << ", campos: " << fields << ", nós: " << incremental.size() << "\n";
+    cout << "completa (VM): " << vm_time * 1e9 / events << " ns/evento\n";
+    cout << "completa (JIT" << (jit ? "" : " indisponível, VM") << "): " << jit_time * 1e9 / events << " ns/evento\n";
+    cout << "incremental: " << incremental_time * 1e9 / events << " ns/evento, "
+         << static_cast<double>(recomputed) / events << " nós recalculados/evento, "
+         << vm_time / incremental_time << "x sobre o VM, " << jit_time / incremental_time << "x sobre o JIT\n";
+    return vm_hits == jit_hits && jit_hits == incremental_hits ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "parser.h"
+using namespace std;
+
+// Gera expressões totalmente parentizadas (um operador por nível), que
+// tanto a cadeia recursiva antiga quanto o Parser atual aceitam
+static string random_expression(mt19937& rng, int depth) {
+    static const char* int_ops[] = {"+", "-", "*"};
+    uniform_int_distribution<int> literal(1, 99);
+    if (depth == 0) {
+        return to_string(literal(rng));
+    }
+    string op = int_ops[rng() % 3];
+    return "( " + random_expression(rng, depth - 1) + " " + op + " " + random_expression(rng, depth - 1) + " )";
+}
+
+// A cadeia recursiva antiga, como base de comparação: uma função por nível
+// de precedência, cada uma montando o seu std::map de operadores a cada
+// chamada e aceitando um operador só. Os nós vão para a mesma arena e são
+// os mesmos do Parser, para a diferença medida ser só a do parser
+class ChainParser {
+    private:
+        Lexer lexer;
+        Token current_token;
+        pmr::memory_resource& arena;
+
+        void advance(TokenType expected_type) {
+            if (current_token.get_type() != expected_type) {
+                throw ParserError(string("Erro de sintaxe: Esperado ") + token_type_name(expected_type));
+            }
+            current_token = lexer.get_next_token();
+        }
+
+        // Um nível: operando (operador operando)?, com os operadores do mapa
+        template <typename Next>
+        ExpressionPtr level(const map<TokenType, string>& operadores, Next next) {
+            auto e1 = (this->*next)();
+            if (operadores.find(current_token.get_type()) != operadores.end()) {
+                string operador = operadores.at(current_token.get_type());
+                advance(current_token.get_type());
+                auto e2 = (this->*next)();
+                return arena_new<BinaryExpression>(arena, move(e1), operador, move(e2), &arena);
+            }
+            return e1;
+        }
+
+    public:
+        ChainParser(const Lexer& l, pmr::memory_resource& arena)
+            : lexer(l), current_token(lexer.get_next_token()), arena(arena) {}
+
+        ExpressionPtr parse_exp() { return parse_or_exp(); }
+
+        ExpressionPtr parse_or_exp() {
+            map<TokenType, string> operadores = {{TokenType::OR, "||"}};
+            return level(operadores, &ChainParser::parse_and_exp);
+        }
+
+        ExpressionPtr parse_and_exp() {
+            map<TokenType, string> operadores = {{TokenType::AND, "&&"}};
+            return level(operadores, &ChainParser::parse_eq_exp);
+        }
+
+        ExpressionPtr parse_eq_exp() {
+            map<TokenType, string> operadores = {{TokenType::EQUALS, "=="}, {TokenType::NOT_EQUALS, "!="}};
+            return level(operadores, &ChainParser::parse_rel_exp);
+        }
+
+        ExpressionPtr parse_rel_exp() {
+            map<TokenType, string> operadores = {
+                {TokenType::LESS, "<"}, {TokenType::GREATER, ">"},
+                {TokenType::LESS_EQUAL, "<="}, {TokenType::GREATER_EQUAL, ">="}
+            };
+            return level(operadores, &ChainParser::parse_add_exp);
+        }
+
+        ExpressionPtr parse_add_exp() {
+            map<TokenType, string> operadores = {{TokenType::PLUS, "+"}, {TokenType::MINUS, "-"}};
+            return level(operadores, &ChainParser::parse_mul_exp);
+        }
+
+        ExpressionPtr parse_mul_exp() {
+            map<TokenType, string> operadores = {{TokenType::MULTIPLY, "*"}, {TokenType::DIVIDE, "/"}};
+            return level(operadores, &ChainParser::parse_unary_exp);
+        }
+
+        ExpressionPtr parse_unary_exp() {
+            if (current_token.get_type() == TokenType::MINUS) {
+                advance(TokenType::MINUS);
+                return arena_new<UnaryExpression>(arena, "-", parse_primary_exp(), &arena);
+            }
+            return parse_primary_exp();
+        }
+
+        ExpressionPtr parse_primary_exp() {
+            Token token = current_token;
+            if (token.get_type() == TokenType::INTEGER) {
+                advance(TokenType::INTEGER);
+                return arena_new<PrimaryExpression>(arena, arena_new<Literal>(arena, token.get_int()));
+            }
+            if (token.get_type() == TokenType::BOOLEAN) {
+                advance(TokenType::BOOLEAN);
+                return arena_new<PrimaryExpression>(arena, arena_new<Literal>(arena, token.get_bool()));
+            }
+            if (token.get_type() == TokenType::LPAREN) {
+                advance(TokenType::LPAREN);
+                auto e1 = parse_exp();
+                advance(TokenType::RPAREN);
+                return arena_new<PrimaryExpression>(arena, move(e1), true);
+            }
+            throw ParserError(string("Erro de sintaxe: Token inesperado: ") + token_type_name(token.get_type()));
+        }
+};
+
+static vector<string> make_workload(size_t count) {
+    mt19937 rng(42);
+    vector<string> lines;
+    lines.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        string left = random_expression(rng, 3);
+        string right = random_expression(rng, 2);
+        lines.push_back(left + " < " + right + " || " + "( " + right + " == 7 )");
+    }
+    return lines;
+}
+
+// Segundos para montar (e descartar) a árvore de todas as linhas com P
+template <typename P>
+static double time_parser(const vector<string>& lines, size_t& parsed) {
+    Arena arena;
+    parsed = 0;
+    auto start = chrono::steady_clock::now();
+    for (const auto& line : lines) {
+        Lexer lexer(line);
+        P parser(lexer, arena);
+        auto expr = parser.parse_exp();
+        parsed += (expr != nullptr);
+        expr.reset();
+        arena.reset();
+    }
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* name, double elapsed, size_t lines) {
+    cout << name << ": " << elapsed << " s, " << elapsed * 1e9 / lines << " ns/linha, "
+         << lines / elapsed << " linhas/s\n";
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = (argc > 1) ? stoul(argv[1]) : 200000;
+    auto lines = make_workload(count);
+
+    size_t chain_parsed = 0, parsed = 0;
+    double chain = time_parser<ChainParser>(lines, chain_parsed);
+    double climbing = time_parser<Parser>(lines, parsed);
+
+    cout << "linhas: " << lines.size() << "\n";
+    report("cadeia recursiva (std::map por chamada)", chain, lines.size());
+    report("Parser (tabela de operadores)", climbing, lines.size());
+    cout << "aceleração: " << chain / climbing << "x\n";
+    return parsed == lines.size() && chain_parsed == lines.size() ? 0 : 1;
+}
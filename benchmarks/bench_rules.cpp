@@ -0,0 +1,124 @@
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "rule_file.h"
+using namespace std;
+
+static const char* operators[] = {"+", "-", "*"};
+static const char* comparisons[] = {"<", ">", "<=", ">=", "==", "!="};
+
+// Regras sobre 8 variáveis inteiras e 2 booleanas, de 10 a 20 tokens
+static vector<string> generate(size_t count, mt19937& rng) {
+    vector<string> rules;
+    rules.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        string rule = "v" + to_string(rng() % 8);
+        size_t terms = 1 + rng() % 3;
+        for (size_t t = 0; t < terms; t++) {
+            rule += string(" ") + operators[rng() % 3] + " " + (rng() % 2 ? "v" + to_string(rng() % 8) : to_string(rng() % 100));
+        }
+        rule += string(" ") + comparisons[rng() % 6] + " " + to_string(rng() % 1000);
+        if (rng() % 2) rule += rng() % 2 ? " && b0" : " || b1";
+        rules.push_back(rule);
+    }
+    return rules;
+}
+
+static double since(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Tempo até a primeira avaliação de uma regra escolhida pelo nome, para N
+// regras: lendo e compilando o texto de todas (como quem carrega as regras
+// da fonte a cada início) x abrindo o arquivo binário de RuleFileWriter com
+// mmap (e com verify, que lê o código de todas). O arquivo é lido do page
+// cache: a diferença é o trabalho por regra, não o disco
+int main(int argc, char* argv[]) {
+    size_t largest = (argc > 1) ? stoul(argv[1]) : 100000;
+    size_t repetitions = (argc > 2) ? stoul(argv[2]) : 5;
+    string path = "/tmp/edoo_bench_rules.bin";
+
+    Variables variables;
+    for (int i = 0; i < 8; i++) variables.declare("v" + to_string(i), ValueType::INTEGER);
+    variables.declare("b0", ValueType::BOOLEAN);
+    variables.declare("b1", ValueType::BOOLEAN);
+    int32_t slots[10] = {3, 14, 15, 92, 65, 35, 89, 79, 1, 0};
+
+    cout << fixed << setprecision(3);
+    cout << right << setw(8) << "regras" << setw(12) << "MB" << setw(14) << "fonte (ms)" << setw(14) << "mmap (ms)"
+         << setw(16) << "+verify (ms)" << setw(10) << "speedup" << "\n";
+
+    mt19937 rng(7);
+    for (size_t count = 100; count <= largest; count *= 10) {
+        vector<string> sources = generate(count, rng);
+        RuleFileWriter writer;
+        for (const auto& variable : variables) writer.declare(variable.name, variable.type);
+        for (size_t i = 0; i < count; i++) writer.add("regra_" + to_string(i), sources[i]);
+        writer.write(path);
+        string target = "regra_" + to_string(count / 2);
+
+        double compile_time = 0, open_time = 0, verify_time = 0;
+        int64_t compile_sink = 0, open_sink = 0;
+        for (size_t r = 0; r < repetitions; r++) {
+            auto start = chrono::steady_clock::now();
+            {
+                ExpressionEvaluator evaluator;
+                vector<pair<string, CompiledExpression>> rules;
+                rules.reserve(count);
+                for (size_t i = 0; i < count; i++) {
+                    rules.emplace_back("regra_" + to_string(i), evaluator.compile(sources[i], variables));
+                }
+                for (const auto& rule : rules) {
+                    if (rule.first == target) {
+                        auto value = rule.second.evaluate(slots);
+                        compile_sink += holds_alternative<int>(value) ? get<int>(value) : get<bool>(value);
+                        break;
+                    }
+                }
+            }
+            double seconds = since(start);
+            if (r == 0 || seconds < compile_time) compile_time = seconds;
+
+            start = chrono::steady_clock::now();
+            {
+                RuleFile rules(path);
+                auto value = rules.rule(target).evaluate(slots);
+                open_sink += holds_alternative<int>(value) ? get<int>(value) : get<bool>(value);
+            }
+            seconds = since(start);
+            if (r == 0 || seconds < open_time) open_time = seconds;
+
+            start = chrono::steady_clock::now();
+            {
+                RuleFile rules(path);
+                rules.verify();
+                rules.rule(target).evaluate(slots);
+            }
+            seconds = since(start);
+            if (r == 0 || seconds < verify_time) verify_time = seconds;
+        }
+        if (compile_sink != open_sink) {
+            cerr << count << " regras: resultados diferentes" << endl;
+            return 1;
+        }
+
+        // E todas as regras, uma a uma, contra a compilação em memória
+        RuleFile rules(path);
+        ExpressionEvaluator evaluator;
+        for (size_t i = 0; i < count; i++) {
+            if (rules.rule(i).evaluate(slots) != evaluator.compile(sources[i], variables).evaluate(slots)) {
+                cerr << "regra_" << i << ": resultados diferentes" << endl;
+                return 1;
+            }
+        }
+
+        cout << setw(8) << count << setw(12) << writer.serialize().size() / 1e6 << setw(14) << compile_time * 1e3
+             << setw(14) << open_time * 1e3 << setw(16) << verify_time * 1e3 << setw(9) << compile_time / open_time << "x\n";
+    }
+    remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,388 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "fast_io.h"
+#include "parser.h"
+#include "workload.h"
+using namespace std;
+
+// Conta as alocações do processo inteiro (inclusive as da Arena, que pede
+// blocos ao operator new)
+static size_t allocation_count = 0;
+
+void* operator new(size_t size) {
+    allocation_count++;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void* operator new(size_t size, align_val_t alignment) {
+    allocation_count++;
+    size_t a = static_cast<size_t>(alignment);
+    if (void* p = aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, align_val_t) noexcept { free(p); }
+
+struct Measurement {
+    string workload;
+    string stage;
+    double lines_per_second = 0;
+    double ns_per_token = 0;
+    double allocations_per_line = 0;
+    // Só na saída, não vai para o arquivo da base
+    double gigabytes_per_second = 0;
+};
+
+// Mede fn (que processa todas as linhas) repetindo até passar de min_time,
+// e devolve a melhor passada. tokens e bytes são os totais de uma passada
+template <typename Fn>
+static Measurement measure(const string& workload, const string& stage, size_t lines, size_t tokens, size_t bytes,
+                           double min_time, Fn fn) {
+    double best = 1e300;
+    double total = 0;
+    size_t allocations = 0;
+    do {
+        size_t before = allocation_count;
+        auto start = chrono::steady_clock::now();
+        fn();
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        allocations = allocation_count - before;
+        best = min(best, elapsed);
+        total += elapsed;
+    } while (total < min_time);
+
+    Measurement m;
+    m.workload = workload;
+    m.stage = stage;
+    m.lines_per_second = lines / best;
+    m.ns_per_token = tokens ? best * 1e9 / tokens : 0;
+    m.allocations_per_line = static_cast<double>(allocations) / lines;
+    m.gigabytes_per_second = bytes / best / 1e9;
+    return m;
+}
+
+// Variáveis voláteis para o compilador não descartar o trabalho medido
+static volatile size_t sink;
+
+// Linhas por lote do ExpressionDag, como no driver com --dedup
+constexpr size_t DEDUP_BATCH = 1024;
+// Bytes por bloco do TokenBuffer, como o BLOCK_BYTES do driver
+constexpr size_t BULK_BYTES = 1 << 16;
+
+// Compartilhamento de subexpressões nos lotes de uma carga
+struct DedupReport {
+    string workload;
+    uint64_t occurrences = 0;
+    uint64_t distinct = 0;
+    // Média por lote: nós do DAG x árvores do lote inteiro guardadas
+    double dag_bytes = 0;
+    double tree_bytes = 0;
+};
+
+static vector<DedupReport> dedup_reports;
+
+static vector<Measurement> run_workload(WorkloadKind kind, const WorkloadOptions& options, double min_time) {
+    vector<string> lines = WorkloadGenerator(options).generate(kind);
+    string name = workload_name(kind);
+    vector<Measurement> results;
+
+    size_t tokens = 0;
+    size_t bytes = 0;
+    for (const auto& line : lines) {
+        Lexer lexer(line);
+        while (lexer.next_token().get_type() != TokenType::END_OF_FILE) tokens++;
+        bytes += line.size() + 1;
+    }
+
+    // Lexer: só tokenizar
+    results.push_back(measure(name, "lexer", lines.size(), tokens, bytes, min_time, [&] {
+        size_t count = 0;
+        for (const auto& line : lines) {
+            Lexer lexer(line);
+            while (lexer.next_token().get_type() != TokenType::END_OF_FILE) count++;
+        }
+        sink = count;
+    }));
+
+    // Tokenização em bloco, como no --fast-io: blocos de linhas inteiras de
+    // até BULK_BYTES, o TokenBuffer reaproveitado de um bloco para o outro
+    string text;
+    for (const auto& line : lines) text += line + "\n";
+    TokenBuffer buffer;
+    results.push_back(measure(name, "bulk", lines.size(), tokens, bytes, min_time, [&] {
+        LineReader reader(text);
+        size_t count = 0;
+        while (!reader.at_end()) {
+            buffer.clear();
+            buffer.add_lines(reader.next_block(BULK_BYTES));
+            count += buffer.token_count();
+        }
+        sink = count;
+    }));
+
+    // Parser: tokenizar e montar a árvore (o Parser puxa os tokens do Lexer)
+    Arena arena;
+    results.push_back(measure(name, "parser", lines.size(), tokens, bytes, min_time, [&] {
+        size_t parsed = 0;
+        for (const auto& line : lines) {
+            Lexer lexer(line);
+            Parser parser(lexer, arena);
+            parsed += parser.try_parse() != nullptr;
+            arena.reset();
+        }
+        sink = parsed;
+    }));
+
+    // O mesmo, com os tokens vindos do TokenBuffer
+    results.push_back(measure(name, "bulkparse", lines.size(), tokens, bytes, min_time, [&] {
+        LineReader reader(text);
+        size_t parsed = 0;
+        while (!reader.at_end()) {
+            buffer.clear();
+            buffer.add_lines(reader.next_block(BULK_BYTES));
+            for (size_t i = 0; i < buffer.size(); i++) {
+                TokenLine line = buffer.line(i);
+                if (line.text.empty()) continue;
+                Parser parser(line, arena);
+                parsed += parser.try_parse() != nullptr;
+                arena.reset();
+            }
+        }
+        sink = parsed;
+    }));
+
+    // Avaliação sobre árvores e programas já prontos, para não medir a leitura
+    Arena trees_arena;
+    Compiler compiler;
+    vector<ExpressionPtr> trees;
+    vector<Program> programs;
+    for (const auto& line : lines) {
+        Lexer lexer(line);
+        Parser parser(lexer, trees_arena);
+        if (auto expr = parser.try_parse()) {
+            programs.push_back(compiler.compile(*expr));
+            trees.push_back(move(expr));
+        }
+    }
+
+    results.push_back(measure(name, "tree", lines.size(), tokens, bytes, min_time, [&] {
+        size_t errors = 0;
+        for (const auto& tree : trees) {
+            try {
+                tree->evaluate();
+            } catch (const exception&) {
+                errors++;
+            }
+        }
+        sink = errors;
+    }));
+
+    results.push_back(measure(name, "bytecode", lines.size(), tokens, bytes, min_time, [&] {
+        size_t errors = 0;
+        variant<int, bool> value;
+        EvaluationError error;
+        for (const auto& program : programs) {
+            errors += !VirtualMachine::try_run(program, nullptr, value, error);
+        }
+        sink = errors;
+    }));
+
+    // De ponta a ponta, como o driver faz com --bytecode
+    ExpressionEvaluator evaluator(Engine::BYTECODE);
+    results.push_back(measure(name, "total", lines.size(), tokens, bytes, min_time, [&] {
+        size_t errors = 0;
+        for (const auto& line : lines) {
+            errors += !evaluator.try_evaluate(line).ok();
+            evaluator.reset();
+        }
+        sink = errors;
+    }));
+
+    // De ponta a ponta pelo ExpressionDag, um lote a cada DEDUP_BATCH linhas
+    auto dag = make_shared<ExpressionDag>();
+    ExpressionEvaluator shared_evaluator;
+    shared_evaluator.set_dag(dag);
+    results.push_back(measure(name, "dedup", lines.size(), tokens, bytes, min_time, [&] {
+        size_t errors = 0;
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (i % DEDUP_BATCH == 0) dag->clear();
+            errors += !shared_evaluator.try_evaluate(lines[i]).ok();
+            shared_evaluator.reset();
+        }
+        sink = errors;
+    }));
+
+    DedupReport report;
+    report.workload = name;
+    size_t batches = 0;
+    Arena batch_arena;
+    CountingResource counting(batch_arena);
+    for (size_t begin = 0; begin < lines.size(); begin += DEDUP_BATCH) {
+        dag->clear();
+        counting.bytes = 0;
+        vector<ExpressionPtr> batch;
+        for (size_t i = begin; i < min(begin + DEDUP_BATCH, lines.size()); i++) {
+            Lexer lexer(lines[i]);
+            Parser parser(lexer, counting);
+            if (auto expr = parser.try_parse()) {
+                dag->intern(*expr);
+                batch.push_back(move(expr));
+            }
+        }
+        ExpressionDag::Statistics statistics = dag->statistics();
+        report.occurrences += statistics.occurrences;
+        report.distinct += statistics.distinct;
+        report.dag_bytes += statistics.memory;
+        report.tree_bytes += counting.bytes;
+        batches++;
+        batch.clear();
+        batch_arena.reset();
+    }
+    report.dag_bytes /= max<size_t>(batches, 1);
+    report.tree_bytes /= max<size_t>(batches, 1);
+    dedup_reports.push_back(report);
+
+    trees.clear();
+    return results;
+}
+
+static void save_baseline(const string& path, const vector<Measurement>& results) {
+    ofstream file(path);
+    if (!file) {
+        cerr << "Não foi possível escrever " << path << endl;
+        exit(1);
+    }
+    file << setprecision(10);
+    for (const auto& m : results) {
+        file << m.workload << " " << m.stage << " " << m.lines_per_second << " "
+             << m.ns_per_token << " " << m.allocations_per_line << "\n";
+    }
+}
+
+static map<pair<string, string>, Measurement> load_baseline(const string& path) {
+    ifstream file(path);
+    if (!file) {
+        cerr << "Não foi possível ler " << path << endl;
+        exit(1);
+    }
+    map<pair<string, string>, Measurement> baseline;
+    Measurement m;
+    while (file >> m.workload >> m.stage >> m.lines_per_second >> m.ns_per_token >> m.allocations_per_line) {
+        baseline[{m.workload, m.stage}] = m;
+    }
+    return baseline;
+}
+
+static string difference(double now, double before) {
+    ostringstream out;
+    out << showpos << fixed << setprecision(2) << now - before;
+    return out.str();
+}
+
+static string percent(double now, double before) {
+    if (before == 0) return "-";
+    ostringstream out;
+    out << showpos << fixed << setprecision(1) << (now - before) * 100.0 / before << "%";
+    return out.str();
+}
+
+static void usage() {
+    cerr << "uso: bench_suite [--lines N] [--seed S] [--errors R] [--time SEGUNDOS]\n"
+            "                  [--workload short|chain|nested|boolean|mixed]...\n"
+            "                  [--save ARQUIVO] [--compare ARQUIVO] [--threshold PORCENTO]\n";
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    WorkloadOptions options;
+    vector<WorkloadKind> kinds;
+    double min_time = 0.2;
+    // Em máquinas compartilhadas passadas curtas variam alguns por cento
+    double threshold = 10.0;
+    string save_path, compare_path;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) usage();
+        string value = argv[++i];
+        if (arg == "--lines") options.lines = stoul(value);
+        else if (arg == "--seed") options.seed = static_cast<uint32_t>(stoul(value));
+        else if (arg == "--errors") options.error_ratio = stod(value);
+        else if (arg == "--time") min_time = stod(value);
+        else if (arg == "--save") save_path = value;
+        else if (arg == "--compare") compare_path = value;
+        else if (arg == "--threshold") threshold = stod(value);
+        else if (arg == "--workload") {
+            WorkloadKind kind;
+            if (!parse_workload_kind(value, kind)) usage();
+            kinds.push_back(kind);
+        }
+        else usage();
+    }
+    if (kinds.empty()) {
+        kinds = {WorkloadKind::SHORT, WorkloadKind::CHAIN, WorkloadKind::NESTED, WorkloadKind::BOOLEAN, WorkloadKind::MIXED};
+    }
+
+    vector<Measurement> results;
+    for (WorkloadKind kind : kinds) {
+        auto measured = run_workload(kind, options, min_time);
+        results.insert(results.end(), measured.begin(), measured.end());
+    }
+
+    map<pair<string, string>, Measurement> baseline;
+    if (!compare_path.empty()) baseline = load_baseline(compare_path);
+
+    cout << left << setw(9) << "carga" << setw(10) << "estágio" << right << setw(14) << "linhas/s"
+         << setw(11) << "ns/token" << setw(8) << "GB/s" << setw(13) << "alocs/linha";
+    if (!baseline.empty()) cout << setw(11) << "linhas/s" << setw(11) << "alocs";
+    cout << "\n";
+
+    size_t regressions = 0;
+    for (const auto& m : results) {
+        cout << left << setw(9) << m.workload << setw(9) << m.stage << right << fixed
+             << setw(14) << setprecision(0) << m.lines_per_second
+             << setw(11) << setprecision(2) << m.ns_per_token
+             << setw(8) << setprecision(3) << m.gigabytes_per_second
+             << setw(13) << setprecision(2) << m.allocations_per_line;
+        auto found = baseline.find({m.workload, m.stage});
+        if (found != baseline.end()) {
+            const Measurement& before = found->second;
+            cout << setw(11) << percent(m.lines_per_second, before.lines_per_second)
+                 << setw(11) << difference(m.allocations_per_line, before.allocations_per_line);
+            // Regressão: vazão caiu mais que o limite ou passou a alocar mais
+            if ((m.lines_per_second - before.lines_per_second) * 100.0 / before.lines_per_second < -threshold
+             || m.allocations_per_line > before.allocations_per_line + 0.005) {
+                cout << "  REGRESSÃO";
+                regressions++;
+            }
+        }
+        cout << "\n";
+    }
+
+    cout << "\n" << left << setw(9) << "carga" << right << setw(12) << "nós/lote" << setw(12) << "distintos"
+         << setw(8) << "razão" << setw(13) << "bytes DAG" << setw(15) << "bytes árvores" << "\n";
+    for (const auto& report : dedup_reports) {
+        double batches = max(1.0, ceil(static_cast<double>(options.lines) / DEDUP_BATCH));
+        cout << left << setw(9) << report.workload << right << fixed << setprecision(0)
+             << setw(12) << report.occurrences / batches << setw(12) << report.distinct / batches
+             << setw(8) << setprecision(2) << (report.distinct ? static_cast<double>(report.occurrences) / report.distinct : 1.0)
+             << setw(13) << setprecision(0) << report.dag_bytes << setw(15) << report.tree_bytes << "\n";
+    }
+
+    if (!save_path.empty()) save_baseline(save_path, results);
+    if (!baseline.empty()) {
+        cout << regressions << " regressões (limite " << threshold << "%)" << endl;
+    }
+    return regressions == 0 ? 0 : 2;
+}
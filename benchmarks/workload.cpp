@@ -0,0 +1,125 @@
+#include "workload.h"
+
+static const WorkloadKind ALL_KINDS[] = {
+    WorkloadKind::SHORT, WorkloadKind::CHAIN, WorkloadKind::NESTED, WorkloadKind::BOOLEAN, WorkloadKind::MIXED
+};
+
+const char* workload_name(WorkloadKind kind) {
+    switch (kind) {
+        case WorkloadKind::SHORT:   return "short";
+        case WorkloadKind::CHAIN:   return "chain";
+        case WorkloadKind::NESTED:  return "nested";
+        case WorkloadKind::BOOLEAN: return "boolean";
+        case WorkloadKind::MIXED:   return "mixed";
+    }
+    return "?";
+}
+
+bool parse_workload_kind(const string& name, WorkloadKind& kind) {
+    for (WorkloadKind k : ALL_KINDS) {
+        if (name == workload_name(k)) {
+            kind = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+// uniform_int_distribution não tem resultado fixo entre bibliotecas padrão;
+// o resto da divisão tem, e o viés não importa aqui
+int WorkloadGenerator::small_int(int low, int high) {
+    return low + static_cast<int>(rng() % static_cast<uint32_t>(high - low + 1));
+}
+
+string WorkloadGenerator::short_expression() {
+    static const char* ops[] = {"+", "-", "*"};
+    string result = to_string(small_int(1, 99));
+    int terms = small_int(1, 3);
+    for (int i = 0; i < terms; i++) {
+        result += " ";
+        result += ops[rng() % 3];
+        result += " " + to_string(small_int(1, 99));
+    }
+    return result;
+}
+
+// Só + e -, com valores pequenos, para a soma não estourar
+string WorkloadGenerator::chain_expression() {
+    string result = to_string(small_int(1, 9));
+    for (size_t i = 1; i < options.chain_length; i++) {
+        result += (rng() & 1) ? " + " : " - ";
+        result += to_string(small_int(1, 9));
+    }
+    return result;
+}
+
+// Cada nível abre um parêntese no começo e fecha com um operando no fim;
+// multiplicações só por 1 e -1 para o valor ficar limitado
+string WorkloadGenerator::nested_expression() {
+    string open(options.nesting_depth, '(');
+    string result = open + to_string(small_int(1, 9));
+    for (size_t i = 0; i < options.nesting_depth; i++) {
+        switch (rng() % 3) {
+            case 0: result += " + " + to_string(small_int(1, 9)); break;
+            case 1: result += " - " + to_string(small_int(1, 9)); break;
+            default: result += (rng() & 1) ? " * 1" : " * - 1"; break;
+        }
+        result += ")";
+    }
+    return result;
+}
+
+string WorkloadGenerator::boolean_expression() {
+    static const char* comparisons[] = {"<", ">", "<=", ">=", "==", "!="};
+    static const char* connectives[] = {"&&", "||"};
+    auto comparison = [&]() {
+        return to_string(small_int(0, 20)) + " " + comparisons[rng() % 6] + " " + to_string(small_int(0, 20));
+    };
+    string result = comparison();
+    int terms = small_int(2, 6);
+    for (int i = 0; i < terms; i++) {
+        result += " ";
+        result += connectives[rng() % 2];
+        switch (rng() % 3) {
+            case 0: result += " " + comparison(); break;
+            case 1: result += " ( " + comparison() + " " + connectives[rng() % 2] + " " + comparison() + " )"; break;
+            default: result += (rng() & 1) ? " true" : " false"; break;
+        }
+    }
+    return result;
+}
+
+string WorkloadGenerator::invalid_expression() {
+    string valid = short_expression();
+    switch (rng() % 5) {
+        case 0: return valid + " $ 1";                 // token desconhecido
+        case 1: return "( " + valid;                   // parêntese sem fechar
+        case 2: return valid + " + true";              // tipos diferentes
+        case 3: return valid + " / ( 2 - 2 )";         // divisão por zero
+        default: return valid + " 99999999999";        // inteiro fora do intervalo
+    }
+}
+
+string WorkloadGenerator::line(WorkloadKind kind) {
+    switch (kind) {
+        case WorkloadKind::SHORT:   return short_expression();
+        case WorkloadKind::CHAIN:   return chain_expression();
+        case WorkloadKind::NESTED:  return nested_expression();
+        case WorkloadKind::BOOLEAN: return boolean_expression();
+        case WorkloadKind::MIXED:
+            break;
+    }
+    if (static_cast<double>(rng()) / mt19937::max() < options.error_ratio) {
+        return invalid_expression();
+    }
+    return line(ALL_KINDS[rng() % 4]);
+}
+
+vector<string> WorkloadGenerator::generate(WorkloadKind kind) {
+    vector<string> lines;
+    lines.reserve(options.lines);
+    for (size_t i = 0; i < options.lines; i++) {
+        lines.push_back(line(kind));
+    }
+    return lines;
+}
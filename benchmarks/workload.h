@@ -0,0 +1,74 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Tipos de carga do benchmark. Todas são determinísticas: a mesma semente e
+// os mesmos parâmetros geram sempre as mesmas linhas
+enum class WorkloadKind {
+    SHORT,      // "12 * 3 + 4": poucas operações aritméticas
+    CHAIN,      // cadeias longas associativas à esquerda: "1 + 2 - 3 + ..."
+    NESTED,     // parênteses profundos: "((((1 + 2) * 3) - 4) ...)"
+    BOOLEAN,    // predicados com comparações, && e ||
+    MIXED       // sorteio entre as anteriores, com uma fração de linhas inválidas
+};
+
+const char* workload_name(WorkloadKind kind);
+// false se name não é um tipo conhecido
+bool parse_workload_kind(const string& name, WorkloadKind& kind);
+
+struct WorkloadOptions {
+    size_t lines = 100000;
+    uint32_t seed = 42;
+    // Fração de linhas inválidas (léxico, sintaxe, tipos, divisão por zero)
+    // nas cargas MIXED
+    double error_ratio = 0.1;
+    // Termos das cadeias e níveis de parênteses
+    size_t chain_length = 64;
+    size_t nesting_depth = 32;
+};
+
+class WorkloadGenerator {
+    private:
+        WorkloadOptions options;
+        mt19937 rng;
+
+        int small_int(int low, int high);
+        string short_expression();
+        string chain_expression();
+        string nested_expression();
+        string boolean_expression();
+        string invalid_expression();
+
+    public:
+        explicit WorkloadGenerator(const WorkloadOptions& options) : options(options), rng(options.seed) {}
+
+        string line(WorkloadKind kind);
+        vector<string> generate(WorkloadKind kind);
+};
+
+// Conta os bytes pedidos (pelos nós das árvores, passando-a ao Parser)
+class CountingResource : public pmr::memory_resource {
+    private:
+        pmr::memory_resource& upstream;
+
+        void* do_allocate(size_t size, size_t alignment) override {
+            bytes += size;
+            return upstream.allocate(size, alignment);
+        }
+        void do_deallocate(void* p, size_t size, size_t alignment) override { upstream.deallocate(p, size, alignment); }
+        bool do_is_equal(const pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    public:
+        size_t bytes = 0;
+
+        explicit CountingResource(pmr::memory_resource& upstream) : upstream(upstream) {}
+};
+
+#endif
@@ -0,0 +1,459 @@
+#include "bytecode.h"
+#include "profile.h"
+
+// Computed goto (extensão do GCC/Clang) quando disponível, switch caso contrário
+#if defined(__GNUC__) && !defined(EDOO_NO_COMPUTED_GOTO)
+#define EDOO_COMPUTED_GOTO 1
+#else
+#define EDOO_COMPUTED_GOTO 0
+#endif
+
+const char* opcode_name(OpCode op) {
+    switch (op) {
+        case OpCode::PUSH_INT:  return "PUSH_INT";
+        case OpCode::PUSH_BOOL: return "PUSH_BOOL";
+        case OpCode::LOAD_I:    return "LOAD_I";
+        case OpCode::LOAD_B:    return "LOAD_B";
+        case OpCode::NEG_I:     return "NEG_I";
+        case OpCode::ADD_I:     return "ADD_I";
+        case OpCode::SUB_I:     return "SUB_I";
+        case OpCode::MUL_I:     return "MUL_I";
+        case OpCode::DIV_I:     return "DIV_I";
+        case OpCode::LT_I:      return "LT_I";
+        case OpCode::GT_I:      return "GT_I";
+        case OpCode::LE_I:      return "LE_I";
+        case OpCode::GE_I:      return "GE_I";
+        case OpCode::EQ_I:      return "EQ_I";
+        case OpCode::NE_I:      return "NE_I";
+        case OpCode::AND_B:     return "AND_B";
+        case OpCode::OR_B:      return "OR_B";
+        case OpCode::EQ_B:      return "EQ_B";
+        case OpCode::NE_B:      return "NE_B";
+        case OpCode::JUMP_IF_FALSE: return "JUMP_IF_FALSE";
+        case OpCode::JUMP_IF_TRUE:  return "JUMP_IF_TRUE";
+        case OpCode::FAIL:      return "FAIL";
+        case OpCode::HALT:      return "HALT";
+    }
+    return "UNKNOWN";
+}
+
+void Program::clear() {
+    code.clear();
+    failures.clear();
+    result_type = ValueType::INVALID;
+    max_stack = 0;
+}
+
+// Para debug
+string Program::to_string() const {
+    string result;
+    for (size_t i = 0; i < code.size(); i++) {
+        result += std::to_string(i) + ": " + opcode_name(code[i].op);
+        if (code[i].op == OpCode::PUSH_INT || code[i].op == OpCode::PUSH_BOOL || code[i].op == OpCode::FAIL
+         || code[i].op == OpCode::LOAD_I || code[i].op == OpCode::LOAD_B
+         || code[i].op == OpCode::JUMP_IF_FALSE || code[i].op == OpCode::JUMP_IF_TRUE) {
+            result += " " + std::to_string(code[i].operand);
+        }
+        result += "\n";
+    }
+    return result;
+}
+
+void Compiler::emit(OpCode op, int32_t operand) {
+    program->code.push_back({op, operand});
+
+    switch (op) {
+        case OpCode::PUSH_INT:
+        case OpCode::PUSH_BOOL:
+        case OpCode::LOAD_I:
+        case OpCode::LOAD_B:
+            depth++;
+            if (depth > program->max_stack) program->max_stack = depth;
+            break;
+        case OpCode::NEG_I:
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::JUMP_IF_TRUE:
+        case OpCode::FAIL:
+        case OpCode::HALT:
+            break;
+        default:
+            // Operadores binários consomem dois valores e empilham um
+            depth--;
+            break;
+    }
+}
+
+void Compiler::fail(ErrorCode code, uint32_t offset, string_view detail) {
+    EvaluationError failure(code, offset);
+    failure.detail = string(detail);
+    program->failures.push_back(move(failure));
+    emit(OpCode::FAIL, static_cast<int32_t>(program->failures.size() - 1));
+    last_type = ValueType::INVALID;
+}
+
+// Recursão comum até RECURSION_BUDGET níveis; abaixo disso, compile_deep
+ValueType Compiler::compile_node(const Expression& expression) {
+    if (recursion >= RECURSION_BUDGET) return compile_deep(expression);
+    recursion++;
+    expression.accept(*this);
+    recursion--;
+    return last_type;
+}
+
+// A mesma pós-ordem dos visit, com uma pilha explícita, para subárvores de
+// qualquer profundidade. Se a esquerda falhou, a direita nem é compilada,
+// porque o FAIL já encerra o programa
+ValueType Compiler::compile_deep(const Expression& root) {
+    size_t base = frames.size();
+    frames.push_back({&root, 0, ValueType::INVALID, NO_JUMP});
+
+    while (frames.size() > base) {
+        CompileFrame& frame = frames.back();
+        const Expression* node = frame.node;
+
+        switch (node->get_kind()) {
+            case ExpressionKind::LITERAL:
+            case ExpressionKind::VARIABLE:
+                frames.pop_back();
+                node->accept(*this);
+                break;
+            case ExpressionKind::PRIMARY:
+                frames.pop_back();
+                frames.push_back({&static_cast<const PrimaryExpression*>(node)->get_expression(), 0, ValueType::INVALID, NO_JUMP});
+                break;
+            case ExpressionKind::UNARY: {
+                auto unary = static_cast<const UnaryExpression*>(node);
+                if (frame.stage == 0) {
+                    frame.stage = 1;
+                    frames.push_back({&unary->get_expression(), 0, ValueType::INVALID, NO_JUMP});
+                } else {
+                    frames.pop_back();
+                    if (last_type != ValueType::INVALID) finish_unary(*unary, last_type);
+                }
+                break;
+            }
+            case ExpressionKind::BINARY: {
+                auto binary = static_cast<const BinaryExpression*>(node);
+                if (frame.stage == 0) {
+                    frame.stage = 1;
+                    frames.push_back({&binary->get_left(), 0, ValueType::INVALID, NO_JUMP});
+                } else if (frame.stage == 1 && last_type != ValueType::INVALID) {
+                    frame.stage = 2;
+                    frame.left_type = last_type;
+                    frame.jump = begin_right(*binary);
+                    frames.push_back({&binary->get_right(), 0, ValueType::INVALID, NO_JUMP});
+                } else {
+                    ValueType left_type = frame.left_type;
+                    size_t jump = frame.jump;
+                    frames.pop_back();
+                    if (last_type != ValueType::INVALID) finish_binary(*binary, left_type, last_type, jump);
+                }
+                break;
+            }
+        }
+    }
+    return last_type;
+}
+
+void Compiler::visit(const Literal& expression) {
+    const auto& value = expression.get_value();
+
+    if (holds_alternative<int>(value)) {
+        emit(OpCode::PUSH_INT, get<int>(value));
+        last_type = ValueType::INTEGER;
+    } else {
+        emit(OpCode::PUSH_BOOL, get<bool>(value) ? 1 : 0);
+        last_type = ValueType::BOOLEAN;
+    }
+}
+
+void Compiler::visit(const Variable& expression) {
+    // Sem slot, o código falha no mesmo ponto em que Variable::evaluate lançaria
+    if (!expression.is_resolved()) {
+        fail(ErrorCode::UNBOUND_VARIABLE, expression.get_offset(), expression.get_name());
+        return;
+    }
+    if (expression.get_type() == ValueType::INTEGER) {
+        emit(OpCode::LOAD_I, static_cast<int32_t>(expression.get_slot()));
+    } else {
+        emit(OpCode::LOAD_B, static_cast<int32_t>(expression.get_slot()));
+    }
+    last_type = expression.get_type();
+}
+
+void Compiler::visit(const PrimaryExpression& expression) {
+    compile_node(expression.get_expression());
+}
+
+void Compiler::visit(const UnaryExpression& expression) {
+    ValueType type = compile_node(expression.get_expression());
+    // Um FAIL já foi emitido no operando: o resto do código é inalcançável
+    if (type == ValueType::INVALID) return;
+    finish_unary(expression, type);
+}
+
+// O operador, depois do operando já compilado (e válido)
+void Compiler::finish_unary(const UnaryExpression& expression, ValueType type) {
+    string_view operador = expression.get_operator();
+
+    if (type == ValueType::INTEGER) {
+        if (operador == "-") {
+            emit(OpCode::NEG_I);
+            last_type = ValueType::INTEGER;
+            return;
+        }
+        fail(ErrorCode::INVALID_INTEGER_UNARY, expression.get_offset(), operador);
+        return;
+    }
+    fail(ErrorCode::INVALID_BOOLEAN_UNARY, expression.get_offset(), operador);
+}
+
+struct BinaryOpcode {
+    const char* symbol;
+    OpCode op;
+};
+
+static const BinaryOpcode INTEGER_OPCODES[] = {
+    {"+", OpCode::ADD_I}, {"-", OpCode::SUB_I}, {"*", OpCode::MUL_I}, {"/", OpCode::DIV_I},
+    {"<", OpCode::LT_I}, {">", OpCode::GT_I}, {"<=", OpCode::LE_I}, {">=", OpCode::GE_I},
+    {"==", OpCode::EQ_I}, {"!=", OpCode::NE_I}
+};
+
+static const BinaryOpcode BOOLEAN_OPCODES[] = {
+    {"&&", OpCode::AND_B}, {"||", OpCode::OR_B}, {"==", OpCode::EQ_B}, {"!=", OpCode::NE_B}
+};
+
+template <size_t N>
+static const BinaryOpcode* find_opcode(const BinaryOpcode (&table)[N], string_view operador) {
+    for (const auto& entry : table) {
+        if (operador == entry.symbol) return &entry;
+    }
+    return nullptr;
+}
+
+void Compiler::visit(const BinaryExpression& expression) {
+    ValueType left_type = compile_node(expression.get_left());
+    if (left_type == ValueType::INVALID) return;
+    size_t jump = begin_right(expression);
+    ValueType right_type = compile_node(expression.get_right());
+    if (right_type == ValueType::INVALID) return;
+    finish_binary(expression, left_type, right_type, jump);
+}
+
+// Entre os operandos: o salto do curto-circuito, com o destino preenchido
+// por finish_binary. Só && e || bem tipados têm um, então a direita sempre
+// compila sem FAIL e o AND_B/OR_B sempre é emitido
+size_t Compiler::begin_right(const BinaryExpression& expression) {
+    if (!expression.is_short_circuit()) return NO_JUMP;
+    emit(expression.get_operator() == "&&" ? OpCode::JUMP_IF_FALSE : OpCode::JUMP_IF_TRUE);
+    return program->code.size() - 1;
+}
+
+void Compiler::finish_binary(const BinaryExpression& expression, ValueType left_type, ValueType right_type, size_t jump) {
+    string_view operador = expression.get_operator();
+
+    if (left_type == ValueType::INTEGER && right_type == ValueType::INTEGER) {
+        const BinaryOpcode* entry = find_opcode(INTEGER_OPCODES, operador);
+        if (!entry) {
+            fail(ErrorCode::UNKNOWN_ARITHMETIC_OPERATOR, expression.get_offset());
+            return;
+        }
+        emit(entry->op, entry->op == OpCode::DIV_I ? static_cast<int32_t>(expression.get_offset()) : 0);
+        bool arithmetic = entry->op == OpCode::ADD_I || entry->op == OpCode::SUB_I
+                       || entry->op == OpCode::MUL_I || entry->op == OpCode::DIV_I;
+        last_type = arithmetic ? ValueType::INTEGER : ValueType::BOOLEAN;
+    }
+    else if (left_type == ValueType::BOOLEAN && right_type == ValueType::BOOLEAN) {
+        const BinaryOpcode* entry = find_opcode(BOOLEAN_OPCODES, operador);
+        if (!entry) {
+            fail(ErrorCode::UNKNOWN_LOGICAL_OPERATOR, expression.get_offset());
+            return;
+        }
+        emit(entry->op);
+        last_type = ValueType::BOOLEAN;
+        if (jump != NO_JUMP) {
+            // Para logo depois do AND_B/OR_B, com o valor da esquerda no topo
+            program->code[jump].operand = static_cast<int32_t>(program->code.size() - jump);
+        }
+    }
+    else {
+        fail(ErrorCode::MIXED_TYPES, expression.get_offset());
+    }
+}
+
+void Compiler::compile(const Expression& expression, Program& out) {
+    EDOO_PROFILE_STAGE(ProfileStage::COMPILER);
+    out.clear();
+    program = &out;
+    depth = 0;
+    recursion = 0;
+
+    out.result_type = compile_node(expression);
+    emit(OpCode::HALT);
+    program = nullptr;
+}
+
+Program Compiler::compile(const Expression& expression) {
+    Program program;
+    compile(expression, program);
+    return program;
+}
+
+variant<int, bool> VirtualMachine::run(ProgramView program, const int32_t* slots) {
+    variant<int, bool> value;
+    EvaluationError error;
+    if (!try_run(program, slots, value, error)) error.raise();
+    return value;
+}
+
+#ifdef EDOO_PROFILE
+// Conta a instrução como avaliação do operador que ela implementa
+static void profile_instruction(OpCode op) {
+    // Mesma ordem de OpCode; nullptr para o que não é operador
+    static const char* const symbols[OPCODE_COUNT] = {
+        nullptr, nullptr, nullptr, nullptr, "-",
+        "+", "-", "*", "/", "<", ">", "<=", ">=", "==", "!=",
+        "&&", "||", "==", "!=", nullptr, nullptr, nullptr, nullptr
+    };
+    if (const char* symbol = symbols[static_cast<size_t>(op)]) {
+        Profiler::record_operator(symbol, op == OpCode::NEG_I);
+    }
+}
+#define EDOO_PROFILE_INSTRUCTION(op) profile_instruction(op)
+#else
+#define EDOO_PROFILE_INSTRUCTION(op) ((void)0)
+#endif
+
+bool VirtualMachine::try_run(ProgramView program, const int32_t* slots, variant<int, bool>& out, EvaluationError& error) {
+    EDOO_PROFILE_STAGE(ProfileStage::EVALUATE);
+    // Pilha na stack do processo para expressões comuns; as maiores usam um
+    // buffer por thread que só cresce, então avaliar de novo não aloca (o VM
+    // não chama a si mesmo, e o buffer não é usado por duas avaliações)
+    constexpr size_t INLINE_STACK = 64;
+    int32_t inline_stack[INLINE_STACK];
+    int32_t* stack = inline_stack;
+    if (program.max_stack > INLINE_STACK) {
+        thread_local vector<int32_t> heap_stack;
+        if (heap_stack.size() < program.max_stack) heap_stack.resize(program.max_stack);
+        stack = heap_stack.data();
+    }
+
+    // sp aponta para a próxima posição livre
+    int32_t* sp = stack;
+    const Instruction* ip = program.code;
+
+#if EDOO_COMPUTED_GOTO
+    // Mesma ordem de OpCode
+    static void* const dispatch_table[OPCODE_COUNT] = {
+        &&op_PUSH_INT, &&op_PUSH_BOOL, &&op_LOAD_I, &&op_LOAD_B, &&op_NEG_I,
+        &&op_ADD_I, &&op_SUB_I, &&op_MUL_I, &&op_DIV_I,
+        &&op_LT_I, &&op_GT_I, &&op_LE_I, &&op_GE_I, &&op_EQ_I, &&op_NE_I,
+        &&op_AND_B, &&op_OR_B, &&op_EQ_B, &&op_NE_B,
+        &&op_JUMP_IF_FALSE, &&op_JUMP_IF_TRUE,
+        &&op_FAIL, &&op_HALT
+    };
+    #define VM_CASE(name) op_##name:
+    #define VM_DISPATCH() do { EDOO_PROFILE_INSTRUCTION(ip->op); goto *dispatch_table[static_cast<uint8_t>(ip->op)]; } while (0)
+    #define VM_NEXT() do { ++ip; VM_DISPATCH(); } while (0)
+    #define VM_JUMP() do { ip += ip->operand; VM_DISPATCH(); } while (0)
+
+    VM_DISPATCH();
+#else
+    #define VM_CASE(name) case OpCode::name:
+    #define VM_NEXT() do { ++ip; goto dispatch; } while (0)
+    #define VM_JUMP() do { ip += ip->operand; goto dispatch; } while (0)
+
+dispatch:
+    EDOO_PROFILE_INSTRUCTION(ip->op);
+    switch (ip->op) {
+#endif
+
+    VM_CASE(PUSH_INT)
+        *sp++ = ip->operand;
+        VM_NEXT();
+    VM_CASE(PUSH_BOOL)
+        *sp++ = ip->operand;
+        VM_NEXT();
+    VM_CASE(LOAD_I)
+        *sp++ = slots[ip->operand];
+        VM_NEXT();
+    VM_CASE(LOAD_B)
+        *sp++ = slots[ip->operand] != 0;
+        VM_NEXT();
+    VM_CASE(NEG_I)
+        sp[-1] = -sp[-1];
+        VM_NEXT();
+    VM_CASE(ADD_I)
+        sp--; sp[-1] = sp[-1] + sp[0];
+        VM_NEXT();
+    VM_CASE(SUB_I)
+        sp--; sp[-1] = sp[-1] - sp[0];
+        VM_NEXT();
+    VM_CASE(MUL_I)
+        sp--; sp[-1] = sp[-1] * sp[0];
+        VM_NEXT();
+    VM_CASE(DIV_I)
+        sp--;
+        if (sp[0] == 0) {
+            error = EvaluationError(ErrorCode::DIVISION_BY_ZERO, static_cast<uint32_t>(ip->operand));
+            return false;
+        }
+        sp[-1] = sp[-1] / sp[0];
+        VM_NEXT();
+    VM_CASE(LT_I)
+        sp--; sp[-1] = sp[-1] < sp[0];
+        VM_NEXT();
+    VM_CASE(GT_I)
+        sp--; sp[-1] = sp[-1] > sp[0];
+        VM_NEXT();
+    VM_CASE(LE_I)
+        sp--; sp[-1] = sp[-1] <= sp[0];
+        VM_NEXT();
+    VM_CASE(GE_I)
+        sp--; sp[-1] = sp[-1] >= sp[0];
+        VM_NEXT();
+    VM_CASE(EQ_I)
+        sp--; sp[-1] = sp[-1] == sp[0];
+        VM_NEXT();
+    VM_CASE(NE_I)
+        sp--; sp[-1] = sp[-1] != sp[0];
+        VM_NEXT();
+    VM_CASE(AND_B)
+        sp--; sp[-1] = sp[-1] & sp[0];
+        VM_NEXT();
+    VM_CASE(OR_B)
+        sp--; sp[-1] = sp[-1] | sp[0];
+        VM_NEXT();
+    VM_CASE(EQ_B)
+        sp--; sp[-1] = sp[-1] == sp[0];
+        VM_NEXT();
+    VM_CASE(NE_B)
+        sp--; sp[-1] = sp[-1] != sp[0];
+        VM_NEXT();
+    VM_CASE(JUMP_IF_FALSE)
+        if (sp[-1] == 0) VM_JUMP();
+        VM_NEXT();
+    VM_CASE(JUMP_IF_TRUE)
+        if (sp[-1] != 0) VM_JUMP();
+        VM_NEXT();
+    VM_CASE(FAIL)
+        error = program.failures[ip->operand];
+        return false;
+    VM_CASE(HALT)
+        if (program.result_type == ValueType::BOOLEAN) {
+            out = sp[-1] != 0;
+        } else {
+            out = sp[-1];
+        }
+        return true;
+
+#if !EDOO_COMPUTED_GOTO
+    }
+    throw ExpressionError("Instrução de bytecode inválida");
+#endif
+
+    #undef VM_CASE
+    #undef VM_NEXT
+    #undef VM_JUMP
+    #undef VM_DISPATCH
+}
@@ -0,0 +1,133 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "errors.h"
+#include "expressions.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Instruções de uma máquina de pilha. Inteiros e booleanos ocupam uma
+// posição de int32_t na pilha (booleanos como 0/1); o tipo de cada operação
+// é decidido na compilação, então o VM não precisa checar tipos
+enum class OpCode : uint8_t {
+    PUSH_INT,   // operand: valor
+    PUSH_BOOL,  // operand: 0 ou 1
+    LOAD_I,     // operand: slot da variável inteira
+    LOAD_B,     // operand: slot da variável booleana (normalizado para 0/1)
+    NEG_I,
+    ADD_I,
+    SUB_I,
+    MUL_I,
+    DIV_I,      // operand: posição do operador, para o erro de divisão por zero
+    LT_I,
+    GT_I,
+    LE_I,
+    GE_I,
+    EQ_I,
+    NE_I,
+    AND_B,
+    OR_B,
+    EQ_B,
+    NE_B,
+    // && e ||: com o topo da pilha decidindo o resultado (false/true), pula
+    // a direita e o AND_B/OR_B; senão segue. Não desempilha
+    JUMP_IF_FALSE, // operand: distância até o destino (ip += operand)
+    JUMP_IF_TRUE,
+    FAIL,       // operand: índice em Program::failures
+    HALT
+};
+
+constexpr size_t OPCODE_COUNT = static_cast<size_t>(OpCode::HALT) + 1;
+
+const char* opcode_name(OpCode op);
+
+struct Instruction {
+    OpCode op;
+    int32_t operand;
+};
+
+// Programa sem dono: o código e os erros vêm de um Program ou, por
+// exemplo, dos bytes mapeados de um RuleFile
+struct ProgramView {
+    const Instruction* code;
+    const EvaluationError* failures;
+    ValueType result_type;
+    size_t max_stack;
+};
+
+class Program {
+    public:
+        vector<Instruction> code;
+        // Erros de tipo encontrados na compilação; a mensagem só é montada
+        // se alguém pedir (EvaluationError::message)
+        vector<EvaluationError> failures;
+        ValueType result_type = ValueType::INVALID;
+        size_t max_stack = 0;
+
+        void clear();
+        string to_string() const;
+        inline ProgramView view() const { return {code.data(), failures.data(), result_type, max_stack}; }
+};
+
+// Traduz a árvore para bytecode em pós-ordem. Erros de tipo viram uma
+// instrução FAIL no mesmo ponto em que BinaryExpression::evaluate lançaria,
+// depois de avaliar os operandos, para manter a ordem dos erros. && e || bem
+// tipados ganham um JUMP_IF_FALSE/JUMP_IF_TRUE entre os operandos
+class Compiler : private ExpressionVisitor {
+    private:
+        // Nó ainda sendo compilado; stage conta os operandos já compilados
+        struct CompileFrame {
+            const Expression* node;
+            uint8_t stage;
+            ValueType left_type;
+            // Índice do salto de curto-circuito, se houver
+            size_t jump;
+        };
+
+        static constexpr size_t NO_JUMP = SIZE_MAX;
+
+        Program* program = nullptr;
+        size_t depth = 0;
+        ValueType last_type = ValueType::INVALID;
+        // Níveis de visit em andamento e a pilha de compile_deep
+        size_t recursion = 0;
+        vector<CompileFrame> frames;
+
+        void emit(OpCode op, int32_t operand = 0);
+        void fail(ErrorCode code, uint32_t offset, string_view detail = {});
+        ValueType compile_node(const Expression& expression);
+        ValueType compile_deep(const Expression& root);
+        void finish_unary(const UnaryExpression& expression, ValueType type);
+        size_t begin_right(const BinaryExpression& expression);
+        void finish_binary(const BinaryExpression& expression, ValueType left_type, ValueType right_type, size_t jump);
+
+        void visit(const Literal& expression) override;
+        void visit(const Variable& expression) override;
+        void visit(const PrimaryExpression& expression) override;
+        void visit(const UnaryExpression& expression) override;
+        void visit(const BinaryExpression& expression) override;
+
+    public:
+        // Reaproveita a memória de out, que é limpo antes
+        void compile(const Expression& expression, Program& out);
+        Program compile(const Expression& expression);
+};
+
+class VirtualMachine {
+    public:
+        // slots: valores das variáveis (LOAD_I/LOAD_B), indexados pelo slot
+        static variant<int, bool> run(ProgramView program, const int32_t* slots = nullptr);
+        // Sem exceções: devolve false e preenche error em vez de lançar
+        static bool try_run(ProgramView program, const int32_t* slots, variant<int, bool>& out, EvaluationError& error);
+
+        static inline variant<int, bool> run(const Program& program, const int32_t* slots = nullptr) {
+            return run(program.view(), slots);
+        }
+        static inline bool try_run(const Program& program, const int32_t* slots, variant<int, bool>& out, EvaluationError& error) {
+            return try_run(program.view(), slots, out, error);
+        }
+};
+
+#endif
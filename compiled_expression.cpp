@@ -0,0 +1,25 @@
+#include "compiled_expression.h"
+
+variant<int, bool> CompiledExpression::evaluate(const vector<int32_t>& slots) const {
+    if (slots.size() < variables.size()) {
+        throw VariableError("Esperados " + to_string(variables.size()) + " valores de variáveis, recebidos " + to_string(slots.size()));
+    }
+    return evaluate(slots.data());
+}
+
+bool CompiledExpression::enable_jit() {
+    if (!jit) {
+        JitCode code = JitCode::compile(program);
+        if (!code) return false;
+        jit = make_shared<const JitCode>(move(code));
+    }
+    return true;
+}
+
+uint32_t CompiledExpression::slot(string_view name) const {
+    const VariableInfo* variable = variables.find(name);
+    if (!variable) {
+        throw VariableError("Variável não declarada: " + string(name));
+    }
+    return variable->slot;
+}
@@ -0,0 +1,47 @@
+#ifndef COMPILED_EXPRESSION_H
+#define COMPILED_EXPRESSION_H
+
+#include "bytecode.h"
+#include "jit.h"
+#include "variables.h"
+#include <memory>
+#include <vector>
+using namespace std;
+
+// Expressão já lida, otimizada e compilada para bytecode (ver
+// ExpressionEvaluator::compile). Avaliar não faz busca por nome nem aloca
+// memória: os valores das variáveis vêm num array indexado pelos slots
+class CompiledExpression {
+    private:
+        Program program;
+        Variables variables;
+        // Código nativo opcional (ver enable_jit), compartilhado pelas cópias
+        shared_ptr<const JitCode> jit;
+
+    public:
+        CompiledExpression(Program p, Variables v) : program(move(p)), variables(move(v)) {}
+
+        inline variant<int, bool> evaluate(const int32_t* slots) const {
+            if (jit) return jit->run(program, slots);
+            return VirtualMachine::run(program, slots);
+        }
+        variant<int, bool> evaluate(const vector<int32_t>& slots) const;
+        // Sem variáveis
+        inline variant<int, bool> evaluate() const { return evaluate(nullptr); }
+
+        // Passa a avaliar por código nativo, com os mesmos resultados e
+        // erros. Devolve false, e continua no VM, se não houver JIT para a
+        // plataforma ou a pilha passar de JitCode::MAX_STACK
+        bool enable_jit();
+        // nullptr sem enable_jit; get_function dá a função nativa
+        inline const JitCode* get_jit() const { return jit.get(); }
+
+        // Slot de uma variável, para montar o array de valores
+        uint32_t slot(string_view name) const;
+
+        inline ValueType get_type() const { return program.result_type; }
+        inline const Program& get_program() const { return program; }
+        inline const Variables& get_variables() const { return variables; }
+};
+
+#endif
@@ -0,0 +1,327 @@
+#ifndef CONSTANT_EXPRESSION_H
+#define CONSTANT_EXPRESSION_H
+
+#include "lexer.h"
+#include "operators.h"
+#include "shunting_yard.h"
+#include "expressions.h"
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <variant>
+using namespace std;
+
+// Avaliação de expressões constantes em tempo de compilação, para strings
+// fixas no código:
+//
+//     constexpr int size = "2 + 3 * 2"_expr.as_int();
+//     static_assert("( 1 < 2 ) && true"_expr.as_bool());
+//
+// Usa as mesmas regras do Lexer (scan_token), a mesma tabela de operadores
+// do Parser (operators.h) e as mesmas regras de tipo (binary_result_type),
+// e dá os mesmos valores e erros que ExpressionEvaluator::evaluate,
+// curto-circuito incluído. Num contexto constante, um erro de sintaxe, de
+// tipo ou uma divisão por zero vira erro de compilação (a chamada a uma das
+// funções *_in_constant_expression abaixo); fora dele, lança a mesma exceção
+// que evaluate lançaria. Com C++20, _expr é consteval
+
+#if defined(__cpp_consteval)
+#define EDOO_CONSTEVAL consteval
+#else
+#define EDOO_CONSTEVAL constexpr
+#endif
+
+// Os campos de EvaluationError que cabem num constexpr; detail aponta para
+// a entrada ou para um literal
+struct ConstantError {
+    ErrorCode code = ErrorCode::NONE;
+    uint32_t offset = 0;
+    TokenType expected = TokenType::END_OF_FILE;
+    TokenType found = TokenType::END_OF_FILE;
+    string_view detail;
+
+    constexpr explicit operator bool() const { return code != ErrorCode::NONE; }
+
+    inline EvaluationError to_error() const {
+        EvaluationError error(code, offset);
+        error.expected = expected;
+        error.found = found;
+        error.detail = string(detail);
+        return error;
+    }
+};
+
+// Nomes que aparecem no erro de compilação; fora de um contexto constante
+// lançam a exceção de sempre
+[[noreturn]] inline void lexical_error_in_constant_expression(const ConstantError& error) { error.to_error().raise(); }
+[[noreturn]] inline void syntax_error_in_constant_expression(const ConstantError& error) { error.to_error().raise(); }
+[[noreturn]] inline void type_error_in_constant_expression(const ConstantError& error) { error.to_error().raise(); }
+[[noreturn]] inline void division_by_zero_in_constant_expression(const ConstantError& error) { error.to_error().raise(); }
+[[noreturn]] inline void variable_in_constant_expression(const ConstantError& error) { error.to_error().raise(); }
+[[noreturn]] inline void constant_expression_too_deep() {
+    throw length_error("Expressão constante funda demais");
+}
+[[noreturn]] inline void constant_value_type_mismatch() { throw bad_variant_access(); }
+
+class ConstantValue {
+    private:
+        ValueType type = ValueType::INTEGER;
+        int32_t value = 0;
+
+    public:
+        constexpr ConstantValue() = default;
+        constexpr ConstantValue(ValueType type, int32_t value) : type(type), value(value) {}
+
+        constexpr ValueType get_type() const { return type; }
+        constexpr bool is_int() const { return type == ValueType::INTEGER; }
+        constexpr bool is_bool() const { return type == ValueType::BOOLEAN; }
+        // Como get<int>/get<bool>: o tipo errado lança bad_variant_access
+        constexpr int as_int() const {
+            if (!is_int()) constant_value_type_mismatch();
+            return value;
+        }
+        constexpr bool as_bool() const {
+            if (!is_bool()) constant_value_type_mismatch();
+            return value != 0;
+        }
+        inline variant<int, bool> to_variant() const {
+            if (is_bool()) return value != 0;
+            return value;
+        }
+
+        constexpr bool operator==(const ConstantValue& other) const { return type == other.type && value == other.value; }
+        constexpr bool operator!=(const ConstantValue& other) const { return !(*this == other); }
+};
+
+struct ConstantResult {
+    ConstantValue value;
+    ConstantError error;
+
+    constexpr bool ok() const { return !error; }
+};
+
+// Profundidade máxima de parênteses, menos unários e operadores pendentes:
+// o avaliador não aloca memória
+constexpr size_t CONSTANT_STACK_SIZE = 64;
+
+// A gramática de Parser::expression (parse_expression, shunting_yard.h),
+// avaliando em vez de montar nós. Cada operando guarda o tipo estático (o
+// que o nó da árvore teria), o valor e o primeiro erro que a avaliação dele
+// lançaria, então os erros saem na ordem de BinaryExpression::evaluate
+class ConstantParser {
+    private:
+        struct Operand {
+            ValueType type = ValueType::INVALID;
+            int32_t value = 0;
+            ConstantError error;
+        };
+        string_view text;
+        size_t pos = 0;
+        Token current_token;
+        ConstantError failure;
+
+        array<Operand, CONSTANT_STACK_SIZE> operands{};
+        array<PendingOperator, CONSTANT_STACK_SIZE> operators{};
+        size_t operand_count = 0;
+        size_t operator_count = 0;
+
+        constexpr void fail(ErrorCode code, TokenType found, TokenType expected = TokenType::END_OF_FILE) {
+            if (!failure) {
+                failure.code = code;
+                failure.offset = static_cast<uint32_t>(current_token.get_offset());
+                failure.found = found;
+                failure.expected = expected;
+            }
+        }
+
+        constexpr bool next() {
+            ScannedToken scanned = scan_token(text, pos);
+            current_token = scanned.token;
+            if (scanned.error != ErrorCode::NONE) {
+                if (!failure) {
+                    failure.code = scanned.error;
+                    failure.offset = static_cast<uint32_t>(scanned.error_offset);
+                }
+                return false;
+            }
+            return true;
+        }
+
+        constexpr bool advance(TokenType expected_type) {
+            if (current_token.get_type() != expected_type) {
+                fail(ErrorCode::EXPECTED_TOKEN, current_token.get_type(), expected_type);
+                return false;
+            }
+            return next();
+        }
+
+        constexpr void push_operand(const Operand& operand) {
+            if (operand_count == CONSTANT_STACK_SIZE) constant_expression_too_deep();
+            operands[operand_count++] = operand;
+        }
+
+        static constexpr Operand error_at(ErrorCode code, uint32_t offset, ValueType type, string_view detail = {}) {
+            Operand result;
+            result.type = type;
+            result.error.code = code;
+            result.error.offset = offset;
+            result.error.detail = detail;
+            return result;
+        }
+
+        // UnaryExpression::apply
+        static constexpr Operand apply_unary(const Operand& operand, uint32_t offset) {
+            ValueType type = unary_result_type("-", operand.type);
+            if (operand.error) return {type, 0, operand.error};
+            if (operand.type == ValueType::BOOLEAN) return error_at(ErrorCode::INVALID_BOOLEAN_UNARY, offset, type, "-");
+            return {type, static_cast<int32_t>(0u - static_cast<uint32_t>(operand.value)), {}};
+        }
+
+        // BinaryExpression::evaluate, com os dois lados já avaliados
+        static constexpr Operand apply(const Operand& left, TokenType op, uint32_t offset, const Operand& right) {
+            ValueType type = binary_result_type(binary_operator(op).symbol, left.type, right.type);
+            if (left.error) return {type, 0, left.error};
+            bool short_circuit = type == ValueType::BOOLEAN && (op == TokenType::AND || op == TokenType::OR);
+            if (short_circuit && (left.value != 0) == (op == TokenType::OR)) return {type, left.value, {}};
+            if (right.error) return {type, 0, right.error};
+
+            int32_t l = left.value;
+            int32_t r = right.value;
+            if (left.type == ValueType::INTEGER && right.type == ValueType::INTEGER) {
+                // Aritmética com a volta no overflow, como nos outros motores
+                uint32_t ul = static_cast<uint32_t>(l), ur = static_cast<uint32_t>(r);
+                switch (op) {
+                    case TokenType::PLUS:          return {type, static_cast<int32_t>(ul + ur), {}};
+                    case TokenType::MINUS:         return {type, static_cast<int32_t>(ul - ur), {}};
+                    case TokenType::MULTIPLY:      return {type, static_cast<int32_t>(ul * ur), {}};
+                    case TokenType::DIVIDE:
+                        if (r == 0) return error_at(ErrorCode::DIVISION_BY_ZERO, offset, type);
+                        return {type, l / r, {}};
+                    case TokenType::LESS:          return {type, l < r, {}};
+                    case TokenType::GREATER:       return {type, l > r, {}};
+                    case TokenType::LESS_EQUAL:    return {type, l <= r, {}};
+                    case TokenType::GREATER_EQUAL: return {type, l >= r, {}};
+                    case TokenType::EQUALS:        return {type, l == r, {}};
+                    case TokenType::NOT_EQUALS:    return {type, l != r, {}};
+                    default: return error_at(ErrorCode::UNKNOWN_ARITHMETIC_OPERATOR, offset, type);
+                }
+            }
+            if (left.type == ValueType::BOOLEAN && right.type == ValueType::BOOLEAN) {
+                switch (op) {
+                    case TokenType::AND:        return {type, l & r, {}};
+                    case TokenType::OR:         return {type, l | r, {}};
+                    case TokenType::EQUALS:     return {type, l == r, {}};
+                    case TokenType::NOT_EQUALS: return {type, l != r, {}};
+                    default: return error_at(ErrorCode::UNKNOWN_LOGICAL_OPERATOR, offset, type);
+                }
+            }
+            return error_at(ErrorCode::MIXED_TYPES, offset, type);
+        }
+
+        // Parser::primary sem variáveis declaradas: um identificador só
+        // falha quando avaliado
+        constexpr bool primary() {
+            Token token = current_token;
+            if (token.is(TokenType::INTEGER) || token.is(TokenType::BOOLEAN)) {
+                if (!advance(token.get_type())) return false;
+                ValueType type = token.is(TokenType::INTEGER) ? ValueType::INTEGER : ValueType::BOOLEAN;
+                push_operand({type, token.get_int(), {}});
+                return true;
+            }
+            if (token.is(TokenType::IDENTIFIER)) {
+                if (!advance(TokenType::IDENTIFIER)) return false;
+                push_operand(error_at(ErrorCode::UNBOUND_VARIABLE, static_cast<uint32_t>(token.get_offset()),
+                                      ValueType::INVALID, token.get_text(text)));
+                return true;
+            }
+            fail(ErrorCode::UNEXPECTED_TOKEN, token.get_type());
+            return false;
+        }
+
+        // As ações de parse_expression
+        template <typename Grammar>
+        friend constexpr bool parse_expression(Grammar& grammar, uint8_t min_binding_power, bool allow_unary);
+
+        constexpr TokenType token() const { return current_token.get_type(); }
+        constexpr uint32_t token_offset() const { return static_cast<uint32_t>(current_token.get_offset()); }
+
+        constexpr void push_pending(const PendingOperator& op) {
+            if (operator_count == CONSTANT_STACK_SIZE) constant_expression_too_deep();
+            operators[operator_count++] = op;
+        }
+        constexpr void pop_pending() { operator_count--; }
+        constexpr bool has_pending() const { return operator_count > 0; }
+        constexpr const PendingOperator& top_pending() const { return operators[operator_count - 1]; }
+
+        constexpr void reduce(const PendingOperator& op) {
+            Operand right = operands[--operand_count];
+            Operand& left = operands[operand_count - 1];
+            left = apply(left, op.op, op.offset, right);
+        }
+        constexpr void negate(uint32_t offset) {
+            Operand& operand = operands[operand_count - 1];
+            operand = apply_unary(operand, offset);
+        }
+        constexpr void group() {}
+
+    public:
+        constexpr explicit ConstantParser(string_view input) : text(input) {}
+
+        constexpr ConstantResult evaluate() {
+            ConstantResult result;
+            if (text.empty()) {
+                result.error.code = ErrorCode::EMPTY_EXPRESSION;
+                return result;
+            }
+            if (next() && parse_expression(*this) && !current_token.is(TokenType::END_OF_FILE)) {
+                fail(ErrorCode::TRAILING_TOKEN, current_token.get_type());
+            }
+            if (failure) {
+                result.error = failure;
+                return result;
+            }
+            const Operand& operand = operands[0];
+            if (operand.error) {
+                result.error = operand.error;
+            } else {
+                result.value = ConstantValue(operand.type, operand.value);
+            }
+            return result;
+        }
+};
+
+// Sem exceções: o valor ou o erro (código, posição e o que a mensagem usa)
+constexpr ConstantResult try_evaluate_constant(string_view input) {
+    return ConstantParser(input).evaluate();
+}
+
+constexpr ConstantValue evaluate_constant(string_view input) {
+    ConstantResult result = try_evaluate_constant(input);
+    switch (result.error.code) {
+        case ErrorCode::NONE:
+            return result.value;
+        case ErrorCode::EMPTY_EXPRESSION:
+        case ErrorCode::EXPECTED_TOKEN:
+        case ErrorCode::TRAILING_TOKEN:
+        case ErrorCode::UNEXPECTED_TOKEN:
+        case ErrorCode::UNDECLARED_VARIABLE:
+            syntax_error_in_constant_expression(result.error);
+        case ErrorCode::EMPTY_INPUT:
+        case ErrorCode::INTEGER_OUT_OF_RANGE:
+        case ErrorCode::INVALID_INTEGER:
+        case ErrorCode::UNKNOWN_TOKEN:
+            lexical_error_in_constant_expression(result.error);
+        case ErrorCode::DIVISION_BY_ZERO:
+            division_by_zero_in_constant_expression(result.error);
+        case ErrorCode::UNBOUND_VARIABLE:
+            variable_in_constant_expression(result.error);
+        default:
+            type_error_in_constant_expression(result.error);
+    }
+}
+
+EDOO_CONSTEVAL ConstantValue operator""_expr(const char* text, size_t length) {
+    return evaluate_constant(string_view(text, length));
+}
+
+#endif
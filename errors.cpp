@@ -0,0 +1,103 @@
+#include "errors.h"
+#include "parser.h"
+#include <stdexcept>
+
+const char* error_code_name(ErrorCode code) {
+    switch (code) {
+        case ErrorCode::NONE:                        return "NONE";
+        case ErrorCode::EMPTY_EXPRESSION:            return "EMPTY_EXPRESSION";
+        case ErrorCode::EMPTY_INPUT:                 return "EMPTY_INPUT";
+        case ErrorCode::INTEGER_OUT_OF_RANGE:        return "INTEGER_OUT_OF_RANGE";
+        case ErrorCode::INVALID_INTEGER:             return "INVALID_INTEGER";
+        case ErrorCode::UNKNOWN_TOKEN:               return "UNKNOWN_TOKEN";
+        case ErrorCode::EXPECTED_TOKEN:              return "EXPECTED_TOKEN";
+        case ErrorCode::TRAILING_TOKEN:              return "TRAILING_TOKEN";
+        case ErrorCode::UNEXPECTED_TOKEN:            return "UNEXPECTED_TOKEN";
+        case ErrorCode::UNDECLARED_VARIABLE:         return "UNDECLARED_VARIABLE";
+        case ErrorCode::UNBOUND_VARIABLE:            return "UNBOUND_VARIABLE";
+        case ErrorCode::INVALID_INTEGER_UNARY:       return "INVALID_INTEGER_UNARY";
+        case ErrorCode::INVALID_BOOLEAN_UNARY:       return "INVALID_BOOLEAN_UNARY";
+        case ErrorCode::UNKNOWN_ARITHMETIC_OPERATOR: return "UNKNOWN_ARITHMETIC_OPERATOR";
+        case ErrorCode::UNKNOWN_LOGICAL_OPERATOR:    return "UNKNOWN_LOGICAL_OPERATOR";
+        case ErrorCode::MIXED_TYPES:                 return "MIXED_TYPES";
+        case ErrorCode::DIVISION_BY_ZERO:            return "DIVISION_BY_ZERO";
+    }
+    return "UNKNOWN";
+}
+
+ErrorCategory error_code_category(ErrorCode code) {
+    if (code == ErrorCode::NONE) return ErrorCategory::NONE;
+    if (code == ErrorCode::EMPTY_EXPRESSION) return ErrorCategory::INPUT;
+    if (code <= ErrorCode::UNKNOWN_TOKEN) return ErrorCategory::LEXICAL;
+    if (code <= ErrorCode::UNDECLARED_VARIABLE) return ErrorCategory::SYNTAX;
+    return ErrorCategory::EVALUATION;
+}
+
+const char* error_category_name(ErrorCategory category) {
+    switch (category) {
+        case ErrorCategory::NONE:       return "NONE";
+        case ErrorCategory::INPUT:      return "INPUT";
+        case ErrorCategory::LEXICAL:    return "LEXICAL";
+        case ErrorCategory::SYNTAX:     return "SYNTAX";
+        case ErrorCategory::EVALUATION: return "EVALUATION";
+        case ErrorCategory::TYPE:       return "TYPE";
+    }
+    return "UNKNOWN";
+}
+
+// Texto sem o prefixo que LexerError e Parser::error acrescentam
+static string base_message(const EvaluationError& error) {
+    switch (error.code) {
+        case ErrorCode::NONE:                 return "";
+        case ErrorCode::EMPTY_EXPRESSION:     return "Expressão vazia";
+        case ErrorCode::EMPTY_INPUT:          return "Input vazio";
+        case ErrorCode::INTEGER_OUT_OF_RANGE: return "Inteiro fora do intervalo";
+        case ErrorCode::INVALID_INTEGER:      return "Inteiro inválido";
+        case ErrorCode::UNKNOWN_TOKEN:        return "Token desconhecido";
+        case ErrorCode::EXPECTED_TOKEN:
+            return string("Esperado ") + token_type_name(error.expected) + ", obteve " + token_type_name(error.found);
+        case ErrorCode::TRAILING_TOKEN:
+            return string("Token inesperado após o fim da expressão: ") + token_type_name(error.found);
+        case ErrorCode::UNEXPECTED_TOKEN:
+            return string("Token inesperado: ") + token_type_name(error.found);
+        case ErrorCode::UNDECLARED_VARIABLE:  return "Variável não declarada: " + error.detail;
+        case ErrorCode::UNBOUND_VARIABLE:     return "Variável sem valor: " + error.detail;
+        case ErrorCode::INVALID_INTEGER_UNARY:
+            return "Operador Unário para Inteiros inválido: " + error.detail;
+        case ErrorCode::INVALID_BOOLEAN_UNARY:
+            return "Operador Unário para Booleanos inválido: " + error.detail;
+        case ErrorCode::UNKNOWN_ARITHMETIC_OPERATOR:
+            return "Avaliando um operador aritmético binário desconhecido";
+        case ErrorCode::UNKNOWN_LOGICAL_OPERATOR:
+            return "Avaliando um operador lógico binário desconhecido";
+        case ErrorCode::MIXED_TYPES:          return "Avaliando operandos de tipos diferentes";
+        case ErrorCode::DIVISION_BY_ZERO:     return "Divisão por zero";
+    }
+    return "";
+}
+
+string EvaluationError::message() const {
+    switch (error_code_category(code)) {
+        case ErrorCategory::LEXICAL:
+            return "Erro léxico: " + base_message(*this);
+        case ErrorCategory::SYNTAX:
+            return "Erro de sintaxe: " + base_message(*this);
+        default:
+            return base_message(*this);
+    }
+}
+
+void EvaluationError::raise() const {
+    switch (error_code_category(code)) {
+        case ErrorCategory::INPUT:
+            throw invalid_argument(base_message(*this));
+        case ErrorCategory::LEXICAL:
+            throw LexerError(base_message(*this));
+        case ErrorCategory::SYNTAX:
+            throw ParserError(message());
+        case ErrorCategory::EVALUATION:
+            throw ExpressionError(message());
+        default:
+            throw logic_error("raise() sem erro");
+    }
+}
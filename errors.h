@@ -0,0 +1,90 @@
+#ifndef ERRORS_H
+#define ERRORS_H
+
+#include "token.h"
+#include <cstdint>
+#include <string>
+#include <variant>
+using namespace std;
+
+// Todos os erros que ler ou avaliar uma expressão pode dar
+enum class ErrorCode : uint8_t {
+    NONE,
+    EMPTY_EXPRESSION,             // invalid_argument
+    // LexerError
+    EMPTY_INPUT,
+    INTEGER_OUT_OF_RANGE,
+    INVALID_INTEGER,
+    UNKNOWN_TOKEN,
+    // ParserError
+    EXPECTED_TOKEN,
+    TRAILING_TOKEN,
+    UNEXPECTED_TOKEN,
+    UNDECLARED_VARIABLE,
+    // ExpressionError
+    UNBOUND_VARIABLE,
+    INVALID_INTEGER_UNARY,
+    INVALID_BOOLEAN_UNARY,
+    UNKNOWN_ARITHMETIC_OPERATOR,
+    UNKNOWN_LOGICAL_OPERATOR,
+    MIXED_TYPES,
+    DIVISION_BY_ZERO
+};
+
+const char* error_code_name(ErrorCode code);
+
+// Grupos de ErrorCode, na ordem em que aparecem no enum; TYPE é só dos
+// TypeError do TypeChecker e de ExpressionEvaluator::compile, que não têm
+// ErrorCode
+enum class ErrorCategory : uint8_t {
+    NONE,
+    INPUT,        // invalid_argument
+    LEXICAL,      // LexerError
+    SYNTAX,       // ParserError
+    EVALUATION,   // ExpressionError
+    TYPE          // TypeError
+};
+
+ErrorCategory error_code_category(ErrorCode code);
+const char* error_category_name(ErrorCategory category);
+
+// Erro sem exceção: o código, a posição na entrada e o mínimo para montar
+// a mensagem depois. A mensagem (a mesma das exceções) só é montada quando
+// alguém chama message()
+class EvaluationError {
+    public:
+        ErrorCode code = ErrorCode::NONE;
+        uint32_t offset = 0;
+        // Tokens envolvidos (EXPECTED_TOKEN, TRAILING_TOKEN, UNEXPECTED_TOKEN)
+        TokenType expected = TokenType::END_OF_FILE;
+        TokenType found = TokenType::END_OF_FILE;
+        // Nome da variável ou texto do operador, quando a mensagem usa
+        string detail;
+
+        EvaluationError() = default;
+        EvaluationError(ErrorCode code, size_t offset) : code(code), offset(static_cast<uint32_t>(offset)) {}
+
+        inline explicit operator bool() const { return code != ErrorCode::NONE; }
+
+        string message() const;
+        // Lança a exceção que a API com exceções lançaria para este erro
+        [[noreturn]] void raise() const;
+};
+
+// Resultado de try_evaluate: um valor ou um EvaluationError
+class EvaluationResult {
+    private:
+        variant<int, bool> value;
+        EvaluationError error;
+
+    public:
+        EvaluationResult(variant<int, bool> v = 0) : value(v) {}
+        EvaluationResult(EvaluationError e) : error(move(e)) {}
+
+        inline bool ok() const { return !error; }
+        inline explicit operator bool() const { return ok(); }
+        inline const variant<int, bool>& get_value() const { return value; }
+        inline const EvaluationError& get_error() const { return error; }
+};
+
+#endif
@@ -0,0 +1,337 @@
+#include "expression_dag.h"
+#include "operators.h"
+#include <algorithm>
+#include <functional>
+
+// O TokenType de um símbolo de operators.h, sem percorrer a tabela
+static TokenType operator_type(string_view symbol) {
+    bool twice = symbol.size() == 2;
+    switch (symbol[0]) {
+        case '+': return TokenType::PLUS;
+        case '-': return TokenType::MINUS;
+        case '*': return TokenType::MULTIPLY;
+        case '/': return TokenType::DIVIDE;
+        case '<': return twice ? TokenType::LESS_EQUAL : TokenType::LESS;
+        case '>': return twice ? TokenType::GREATER_EQUAL : TokenType::GREATER;
+        case '=': return TokenType::EQUALS;
+        case '!': return TokenType::NOT_EQUALS;
+        case '&': return TokenType::AND;
+        case '|': return TokenType::OR;
+        default:  return TokenType::END_OF_FILE;
+    }
+}
+
+// Só os campos da estrutura: o valor dos nós compostos e a posição não
+// entram, e a variável entra pelo nome
+uint64_t ExpressionDag::hash(const Node& node, string_view name) {
+    uint64_t h = static_cast<uint64_t>(node.kind) | static_cast<uint64_t>(node.op) << 8
+               | static_cast<uint64_t>(node.type) << 16;
+    switch (node.kind) {
+        case ExpressionKind::LITERAL:
+            h ^= static_cast<uint64_t>(static_cast<uint32_t>(node.value)) << 32;
+            break;
+        case ExpressionKind::VARIABLE:
+            h ^= std::hash<string_view>()(name);
+            break;
+        default:
+            h ^= static_cast<uint64_t>(node.left) << 24 ^ static_cast<uint64_t>(node.right) << 40;
+            break;
+    }
+    // Finalizador do MurmurHash3: todos os bits da entrada chegam aos
+    // bits baixos, que escolhem a posição na tabela
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    return h ^ (h >> 33);
+}
+
+bool ExpressionDag::same(const Node& node, const Node& other, string_view name) const {
+    if (node.kind != other.kind || node.op != other.op || node.type != other.type) return false;
+    switch (node.kind) {
+        case ExpressionKind::LITERAL:  return node.value == other.value;
+        case ExpressionKind::VARIABLE: return name_of(node) == name;
+        default:                       return node.left == other.left && node.right == other.right;
+    }
+}
+
+void ExpressionDag::grow() {
+    table.assign(max<size_t>(64, table.size() * 2), NO_NODE);
+    size_t mask = table.size() - 1;
+    for (uint32_t id = 0; id < nodes.size(); id++) {
+        const Node& node = nodes[id];
+        if (node.kind == ExpressionKind::LITERAL && is_small(node)) continue;
+        string_view name = node.kind == ExpressionKind::VARIABLE ? name_of(node) : string_view();
+        size_t i = hash(node, name) & mask;
+        while (table[i] != NO_NODE) i = (i + 1) & mask;
+        table[i] = id;
+    }
+}
+
+uint32_t ExpressionDag::find_or_insert(Node node, string_view name) {
+    occurrences++;
+    if ((nodes.size() + 1) * 2 > table.size()) grow();
+
+    size_t mask = table.size() - 1;
+    size_t i = hash(node, name) & mask;
+    for (; table[i] != NO_NODE; i = (i + 1) & mask) {
+        if (same(nodes[table[i]], node, name)) return table[i];
+    }
+
+    uint32_t id = static_cast<uint32_t>(nodes.size());
+    if (node.kind == ExpressionKind::VARIABLE) {
+        node.left = static_cast<uint32_t>(names.size());
+        node.right = static_cast<uint32_t>(name.size());
+        names += name;
+    }
+    evaluate(node, id);
+    nodes.push_back(node);
+    table[i] = id;
+    return id;
+}
+
+// Os filhos já foram avaliados quando entraram. Segue BinaryExpression::
+// evaluate: erro da esquerda, curto-circuito, erro da direita e então a
+// operação, com a aritmética dando a volta como nos outros motores
+void ExpressionDag::evaluate(Node& node, uint32_t self) const {
+    auto fail = [&](ErrorCode code) {
+        node.error = code;
+        node.failed = self;
+    };
+
+    switch (node.kind) {
+        case ExpressionKind::LITERAL:
+        case ExpressionKind::PRIMARY:
+            return;
+        case ExpressionKind::VARIABLE:
+            fail(ErrorCode::UNBOUND_VARIABLE);
+            return;
+        case ExpressionKind::UNARY: {
+            const Node& operand = nodes[node.left];
+            EDOO_PROFILE_OPERATOR("-", true);
+            if (operand.failed != NO_NODE) {
+                node.failed = operand.failed;
+            } else if (operand.type == ValueType::BOOLEAN) {
+                fail(ErrorCode::INVALID_BOOLEAN_UNARY);
+            } else {
+                node.value = static_cast<int32_t>(0u - static_cast<uint32_t>(operand.value));
+            }
+            return;
+        }
+        case ExpressionKind::BINARY:
+            break;
+    }
+
+    const Node& left = nodes[node.left];
+    const Node& right = nodes[node.right];
+    EDOO_PROFILE_OPERATOR(binary_operator(node.op).symbol, false);
+    if (left.failed != NO_NODE) {
+        node.failed = left.failed;
+        return;
+    }
+    bool short_circuit = node.type == ValueType::BOOLEAN && (node.op == TokenType::AND || node.op == TokenType::OR);
+    if (short_circuit && (left.value != 0) == (node.op == TokenType::OR)) {
+        node.value = left.value;
+        return;
+    }
+    if (right.failed != NO_NODE) {
+        node.failed = right.failed;
+        return;
+    }
+
+    int32_t l = left.value;
+    int32_t r = right.value;
+    if (left.type == ValueType::INTEGER && right.type == ValueType::INTEGER) {
+        uint32_t ul = static_cast<uint32_t>(l), ur = static_cast<uint32_t>(r);
+        switch (node.op) {
+            case TokenType::PLUS:          node.value = static_cast<int32_t>(ul + ur); return;
+            case TokenType::MINUS:         node.value = static_cast<int32_t>(ul - ur); return;
+            case TokenType::MULTIPLY:      node.value = static_cast<int32_t>(ul * ur); return;
+            case TokenType::DIVIDE:
+                if (r == 0) {
+                    fail(ErrorCode::DIVISION_BY_ZERO);
+                } else {
+                    node.value = l / r;
+                }
+                return;
+            case TokenType::LESS:          node.value = l < r; return;
+            case TokenType::GREATER:       node.value = l > r; return;
+            case TokenType::LESS_EQUAL:    node.value = l <= r; return;
+            case TokenType::GREATER_EQUAL: node.value = l >= r; return;
+            case TokenType::EQUALS:        node.value = l == r; return;
+            case TokenType::NOT_EQUALS:    node.value = l != r; return;
+            default: fail(ErrorCode::UNKNOWN_ARITHMETIC_OPERATOR); return;
+        }
+    }
+    if (left.type == ValueType::BOOLEAN && right.type == ValueType::BOOLEAN) {
+        switch (node.op) {
+            case TokenType::AND:        node.value = l & r; return;
+            case TokenType::OR:         node.value = l | r; return;
+            case TokenType::EQUALS:     node.value = l == r; return;
+            case TokenType::NOT_EQUALS: node.value = l != r; return;
+            default: fail(ErrorCode::UNKNOWN_LOGICAL_OPERATOR); return;
+        }
+    }
+    fail(ErrorCode::MIXED_TYPES);
+}
+
+uint32_t ExpressionDag::leaf(const Literal& literal) {
+    const auto& value = literal.get_value();
+    bool integer = holds_alternative<int>(value);
+    int32_t number = integer ? get<int>(value) : static_cast<int32_t>(get<bool>(value));
+    Node node{ExpressionKind::LITERAL, TokenType::END_OF_FILE, literal.get_type(), ErrorCode::NONE, NO_NODE, NO_NODE,
+              number, NO_NODE, 0};
+    if (!is_small(node)) return find_or_insert(node, string_view());
+
+    if (small_literals.empty()) small_literals.assign(SMALL_MAX - SMALL_MIN + 3, NO_NODE);
+    uint32_t& id = small_literals[integer ? number - SMALL_MIN : SMALL_MAX - SMALL_MIN + 1 + number];
+    occurrences++;
+    if (id == NO_NODE) {
+        id = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(node);
+    }
+    return id;
+}
+
+uint32_t ExpressionDag::leaf(const Variable& variable) {
+    Node node{ExpressionKind::VARIABLE, TokenType::END_OF_FILE, ValueType::INVALID, ErrorCode::NONE, 0, 0, 0,
+              NO_NODE, variable.get_offset()};
+    return find_or_insert(node, variable.get_name());
+}
+
+uint32_t ExpressionDag::unary(const UnaryExpression& expression, uint32_t operand) {
+    Node node{ExpressionKind::UNARY, TokenType::MINUS, expression.get_type(),
+              ErrorCode::NONE, operand, NO_NODE, 0, NO_NODE, expression.get_offset()};
+    return find_or_insert(node, string_view());
+}
+
+uint32_t ExpressionDag::binary(const BinaryExpression& expression, uint32_t left, uint32_t right) {
+    // O tipo estático do nó da árvore é o dos filhos no DAG: são as mesmas
+    // subárvores
+    Node node{ExpressionKind::BINARY, operator_type(expression.get_operator()), expression.get_type(),
+              ErrorCode::NONE, left, right, 0, NO_NODE, expression.get_offset()};
+    return find_or_insert(node, string_view());
+}
+
+// Pós-ordem com pilha explícita, como evaluate_tree: os filhos entram antes
+// do pai, então cada nó novo já encontra os filhos avaliados
+uint32_t ExpressionDag::intern(const Expression& root) {
+    EDOO_PROFILE_STAGE(ProfileStage::EVALUATE);
+    frames.clear();
+    ids.clear();
+    frames.push_back({&root, false});
+
+    while (!frames.empty()) {
+        Frame frame = frames.back();
+        frames.pop_back();
+        const Expression* expression = frame.expression;
+        while (expression->get_kind() == ExpressionKind::PRIMARY) {
+            expression = &static_cast<const PrimaryExpression*>(expression)->get_expression();
+        }
+
+        switch (expression->get_kind()) {
+            case ExpressionKind::LITERAL:
+                ids.push_back(leaf(*static_cast<const Literal*>(expression)));
+                break;
+            case ExpressionKind::VARIABLE:
+                ids.push_back(leaf(*static_cast<const Variable*>(expression)));
+                break;
+            case ExpressionKind::PRIMARY:
+                break;
+            case ExpressionKind::UNARY: {
+                auto node = static_cast<const UnaryExpression*>(expression);
+                if (frame.children_done) {
+                    ids.back() = unary(*node, ids.back());
+                } else {
+                    frames.push_back({expression, true});
+                    frames.push_back({&node->get_expression(), false});
+                }
+                break;
+            }
+            case ExpressionKind::BINARY: {
+                auto node = static_cast<const BinaryExpression*>(expression);
+                if (frame.children_done) {
+                    uint32_t right = ids.back();
+                    ids.pop_back();
+                    ids.back() = binary(*node, ids.back(), right);
+                } else {
+                    frames.push_back({expression, true});
+                    frames.push_back({&node->get_right(), false});
+                    frames.push_back({&node->get_left(), false});
+                }
+                break;
+            }
+        }
+    }
+    return ids.back();
+}
+
+EvaluationResult ExpressionDag::result(uint32_t id) const {
+    const Node& node = nodes[id];
+    if (node.failed != NO_NODE) {
+        const Node& origin = nodes[node.failed];
+        EvaluationError error(origin.error, origin.offset);
+        if (origin.kind == ExpressionKind::VARIABLE) {
+            error.detail = string(name_of(origin));
+        } else if (origin.kind == ExpressionKind::UNARY) {
+            error.detail = "-";
+        }
+        return error;
+    }
+    if (node.type == ValueType::BOOLEAN) return variant<int, bool>(node.value != 0);
+    return variant<int, bool>(node.value);
+}
+
+EvaluationResult ExpressionDag::result(uint32_t id, const Expression& root) const {
+    EvaluationResult found = result(id);
+    if (found) return found;
+
+    // A árvore e o DAG têm a mesma forma sem os parênteses: segue o filho
+    // que propagou o erro (a esquerda, se ela falhou, já que é avaliada
+    // antes) até o nó cuja operação falhou
+    const Expression* expression = &root;
+    while (true) {
+        while (expression->get_kind() == ExpressionKind::PRIMARY) {
+            expression = &static_cast<const PrimaryExpression*>(expression)->get_expression();
+        }
+        const Node& node = nodes[id];
+        if (node.failed == id) break;
+        if (expression->get_kind() == ExpressionKind::UNARY) {
+            expression = &static_cast<const UnaryExpression*>(expression)->get_expression();
+            id = node.left;
+        } else {
+            auto binary = static_cast<const BinaryExpression*>(expression);
+            bool left = nodes[node.left].failed != NO_NODE;
+            expression = left ? &binary->get_left() : &binary->get_right();
+            id = left ? node.left : node.right;
+        }
+    }
+    EvaluationError error = found.get_error();
+    switch (expression->get_kind()) {
+        case ExpressionKind::VARIABLE:
+            error.offset = static_cast<const Variable*>(expression)->get_offset();
+            break;
+        case ExpressionKind::UNARY:
+            error.offset = static_cast<const UnaryExpression*>(expression)->get_offset();
+            break;
+        case ExpressionKind::BINARY:
+            error.offset = static_cast<const BinaryExpression*>(expression)->get_offset();
+            break;
+        default:
+            break;
+    }
+    return error;
+}
+
+ExpressionDag::Statistics ExpressionDag::statistics() const {
+    return {occurrences, nodes.size(),
+            nodes.size() * sizeof(Node) + (table.size() + small_literals.size()) * sizeof(uint32_t) + names.size()};
+}
+
+void ExpressionDag::clear() {
+    nodes.clear();
+    names.clear();
+    fill(table.begin(), table.end(), NO_NODE);
+    fill(small_literals.begin(), small_literals.end(), NO_NODE);
+    occurrences = 0;
+}
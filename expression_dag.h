@@ -0,0 +1,121 @@
+#ifndef EXPRESSION_DAG_H
+#define EXPRESSION_DAG_H
+
+#include "expressions.h"
+#include "errors.h"
+#include "token.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Hash-consing das árvores de um lote de linhas: subárvores estruturalmente
+// iguais (mesmo operador e mesmos filhos, ou mesmo literal ou variável)
+// viram um nó só, compartilhado dentro da linha e entre as linhas do lote.
+// Parênteses não mudam o valor e não viram nós. Cada nó é avaliado uma vez,
+// quando entra, e guarda o valor ou o erro; a raiz de uma linha que repete
+// subexpressões já vistas sai quase só da busca na tabela.
+//
+// Os resultados são os de Expression::evaluate, curto-circuito incluído (o
+// lado direito que não seria avaliado pode ter um erro guardado, que não é
+// propagado). Variáveis não têm valor aqui, como na árvore. Os nós guardam
+// a posição da primeira ocorrência no lote, que pode ser de outra linha:
+// result(id, root) procura o nó que falhou na árvore da linha e dá a posição
+// dele, como a árvore e o bytecode dariam.
+//
+// Sem locks: um por thread. clear() entre lotes descarta os nós e mantém a
+// memória reservada
+class ExpressionDag {
+    public:
+        static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+        struct Statistics {
+            // Nós das árvores (sem os parênteses) e nós distintos
+            uint64_t occurrences;
+            uint64_t distinct;
+            // Bytes dos nós, da tabela e dos nomes do lote atual
+            size_t memory;
+
+            inline double ratio() const { return distinct ? static_cast<double>(occurrences) / distinct : 1.0; }
+        };
+
+    private:
+        struct Node {
+            ExpressionKind kind;
+            // Operador (MINUS no unário); END_OF_FILE nas folhas
+            TokenType op;
+            ValueType type;
+            // O erro da operação deste nó, quando foi ela que falhou
+            ErrorCode error;
+            // Filhos; na VARIABLE, início e tamanho do nome em names
+            uint32_t left;
+            uint32_t right;
+            // Valor do literal e, depois de avaliado, o resultado
+            int32_t value;
+            // NO_NODE, ou o nó cujo erro este propaga (ele mesmo, se a
+            // operação dele falhou)
+            uint32_t failed;
+            // Posição do operador ou da variável na primeira ocorrência
+            uint32_t offset;
+        };
+
+        struct Frame {
+            const Expression* expression;
+            bool children_done;
+        };
+
+        // Literais pequenos (metade dos nós nas cargas comuns) vão direto
+        // por índice, sem passar pela tabela
+        static constexpr int32_t SMALL_MIN = -256;
+        static constexpr int32_t SMALL_MAX = 255;
+
+        vector<Node> nodes;
+        // Endereçamento aberto com sondagem linear; NO_NODE é vazio
+        vector<uint32_t> table;
+        // Inteiros de SMALL_MIN a SMALL_MAX e depois false e true
+        vector<uint32_t> small_literals;
+        string names;
+        uint64_t occurrences = 0;
+
+        // Pilhas do percurso de intern, reaproveitadas
+        vector<Frame> frames;
+        vector<uint32_t> ids;
+
+        static inline bool is_small(const Node& literal) {
+            return literal.type == ValueType::BOOLEAN || (literal.value >= SMALL_MIN && literal.value <= SMALL_MAX);
+        }
+        static uint64_t hash(const Node& node, string_view name);
+        bool same(const Node& node, const Node& other, string_view name) const;
+        inline string_view name_of(const Node& node) const { return string_view(names).substr(node.left, node.right); }
+        void grow();
+        // O nó igual a node, já existente ou inserido e avaliado agora
+        uint32_t find_or_insert(Node node, string_view name);
+        void evaluate(Node& node, uint32_t self) const;
+
+        uint32_t leaf(const Literal& literal);
+        uint32_t leaf(const Variable& variable);
+        uint32_t unary(const UnaryExpression& expression, uint32_t operand);
+        uint32_t binary(const BinaryExpression& expression, uint32_t left, uint32_t right);
+
+    public:
+        ExpressionDag() = default;
+        ExpressionDag(const ExpressionDag&) = delete;
+        ExpressionDag& operator=(const ExpressionDag&) = delete;
+
+        // Acrescenta a árvore (de qualquer profundidade) ao DAG e devolve o
+        // nó da raiz. A árvore pode ser descartada depois
+        uint32_t intern(const Expression& root);
+        // Valor ou erro do nó, já calculado por intern; a posição do erro é
+        // a da primeira ocorrência no lote
+        EvaluationResult result(uint32_t id) const;
+        // O mesmo, para a raiz de root (a árvore passada a intern), com a
+        // posição do erro em root. Desce só pelo caminho do erro, sem recursão
+        EvaluationResult result(uint32_t id, const Expression& root) const;
+
+        inline size_t size() const { return nodes.size(); }
+        Statistics statistics() const;
+        void clear();
+};
+
+#endif
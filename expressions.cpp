@@ -0,0 +1,106 @@
+#include "expressions.h"
+#include <vector>
+
+// Pilhas reaproveitadas entre avaliações da mesma thread. Cada chamada só
+// usa o que está acima do tamanho que encontrou, e devolve as pilhas a esse
+// tamanho mesmo quando um operador lança
+namespace {
+    // stage conta os operandos já avaliados
+    struct EvaluationFrame {
+        const Expression* node;
+        uint8_t stage;
+    };
+
+    thread_local vector<EvaluationFrame> evaluation_frames;
+    thread_local vector<variant<int, bool>> evaluation_values;
+
+    struct StackGuard {
+        size_t frames_base = evaluation_frames.size();
+        size_t values_base = evaluation_values.size();
+
+        ~StackGuard() {
+            evaluation_frames.resize(frames_base);
+            evaluation_values.resize(values_base);
+        }
+    };
+}
+
+// Pós-ordem com os mesmos passos da recursão: o operando da esquerda é
+// avaliado inteiro (inclusive os erros dele) antes do da direita (que o
+// curto-circuito pode pular), e só então o operador checa os tipos
+variant<int, bool> evaluate_tree(const Expression& root) {
+    StackGuard guard;
+    auto& frames = evaluation_frames;
+    auto& values = evaluation_values;
+    frames.push_back({&root, 0});
+
+    while (frames.size() > guard.frames_base) {
+        EvaluationFrame frame = frames.back();
+        frames.pop_back();
+        const Expression* node = frame.node;
+
+        switch (node->get_kind()) {
+            case ExpressionKind::LITERAL:
+                values.push_back(static_cast<const Literal*>(node)->get_value());
+                break;
+            case ExpressionKind::VARIABLE:
+                // Lança "Variável sem valor"
+                values.push_back(node->evaluate());
+                break;
+            case ExpressionKind::PRIMARY:
+                frames.push_back({&static_cast<const PrimaryExpression*>(node)->get_expression(), 0});
+                break;
+            case ExpressionKind::UNARY: {
+                auto unary = static_cast<const UnaryExpression*>(node);
+                if (frame.stage == 1) {
+                    values.back() = unary->apply(values.back());
+                } else {
+                    frames.push_back({node, 1});
+                    frames.push_back({&unary->get_expression(), 0});
+                }
+                break;
+            }
+            case ExpressionKind::BINARY: {
+                auto binary = static_cast<const BinaryExpression*>(node);
+                if (frame.stage == 0) {
+                    frames.push_back({node, 1});
+                    frames.push_back({&binary->get_left(), 0});
+                } else if (frame.stage == 1) {
+                    // A esquerda fica na pilha: ou é o resultado, ou o
+                    // operando da esquerda do operador
+                    if (!binary->is_short_circuit() || !binary->decided_by(get<bool>(values.back()))) {
+                        frames.push_back({node, 2});
+                        frames.push_back({&binary->get_right(), 0});
+                    }
+                } else {
+                    variant<int, bool> right = values.back();
+                    values.pop_back();
+                    values.back() = binary->apply(values.back(), right);
+                }
+                break;
+            }
+        }
+    }
+    return values.back();
+}
+
+void release_tree(ExpressionPtr root) {
+    thread_local vector<Expression*> pending;
+    thread_local bool draining = false;
+
+    pending.push_back(root.release());
+    if (draining) return;
+
+    // Dentro do laço release_depth fica no limite, então cada destrutor
+    // chamado aqui só enfileira os próprios filhos
+    draining = true;
+    size_t depth = release_depth;
+    release_depth = RECURSION_BUDGET;
+    while (!pending.empty()) {
+        Expression* expression = pending.back();
+        pending.pop_back();
+        ArenaDeleter<Expression>()(expression);
+    }
+    release_depth = depth;
+    draining = false;
+}
@@ -1,7 +1,14 @@
 #ifndef EXPRESSIONS_H
 #define EXPRESSIONS_H
 
+#include "arena.h"
+#include "profile.h"
+#include <cstdint>
 #include <iostream>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <variant>
 #include <memory>
 using namespace std;
@@ -11,92 +18,260 @@ class ExpressionError : public runtime_error {
         explicit ExpressionError(const string& message) : runtime_error(message) {}
 };
 
+// Tipos dos valores da linguagem; INVALID marca uma expressão mal tipada
+enum class ValueType : uint8_t { INTEGER, BOOLEAN, INVALID };
+
+// Tipo do resultado de um operador aplicado a operandos dos tipos dados,
+// seguindo as regras de UnaryExpression/BinaryExpression::evaluate
+constexpr ValueType unary_result_type(string_view operador, ValueType operand) {
+    if (operand == ValueType::INTEGER && operador == "-") {
+        return ValueType::INTEGER;
+    }
+    return ValueType::INVALID;
+}
+
+constexpr ValueType binary_result_type(string_view operador, ValueType left, ValueType right) {
+    if (left == ValueType::INTEGER && right == ValueType::INTEGER) {
+        if (operador == "+" || operador == "-" || operador == "*" || operador == "/") {
+            return ValueType::INTEGER;
+        }
+        if (operador == "<" || operador == ">" || operador == "<=" || operador == ">="
+         || operador == "==" || operador == "!=") {
+            return ValueType::BOOLEAN;
+        }
+        return ValueType::INVALID;
+    }
+    if (left == ValueType::BOOLEAN && right == ValueType::BOOLEAN) {
+        if (operador == "&&" || operador == "||" || operador == "==" || operador == "!=") {
+            return ValueType::BOOLEAN;
+        }
+    }
+    return ValueType::INVALID;
+}
+
+class Literal;
+class Variable;
+class PrimaryExpression;
+class UnaryExpression;
+class BinaryExpression;
+
+// Usado pelos passes que percorrem a árvore (compilador, otimizador...)
+class ExpressionVisitor {
+    public:
+        virtual ~ExpressionVisitor() = default;
+
+        virtual void visit(const Literal& expression) = 0;
+        virtual void visit(const Variable& expression) = 0;
+        virtual void visit(const PrimaryExpression& expression) = 0;
+        virtual void visit(const UnaryExpression& expression) = 0;
+        virtual void visit(const BinaryExpression& expression) = 0;
+};
+
+// Tipo concreto do nó, para os laços que percorrem a árvore sem recursão
+// (e sem uma chamada virtual por nó)
+enum class ExpressionKind : uint8_t { LITERAL, VARIABLE, PRIMARY, UNARY, BINARY };
+
 class Expression {
+    private:
+        ExpressionKind kind;
+        // Tipo estático, calculado na construção a partir dos filhos.
+        // INVALID: mal tipada ou com uma variável sem declaração; avaliar
+        // uma expressão assim sempre lança
+        ValueType type;
+
     public:
-        Expression() = default;
+        Expression(ExpressionKind kind, ValueType type) : kind(kind), type(type) {}
         virtual ~Expression() = default;
 
         virtual variant<int, bool> evaluate() const = 0;
+        virtual void accept(ExpressionVisitor& visitor) const = 0;
+
+        inline ExpressionKind get_kind() const { return kind; }
+        inline ValueType get_type() const { return type; }
 };
 
+// Os nós são criados na arena do ExpressionEvaluator (ver arena_new)
+using ExpressionPtr = arena_ptr<Expression>;
+
+// Níveis de destruição feitos pela recursão comum (rápida) antes de passar o
+// resto da subárvore para um laço com fila, sem limite de profundidade.
+// Cabe com folga na pilha de qualquer thread
+constexpr size_t RECURSION_BUDGET = 1000;
+
+inline thread_local size_t release_depth = 0;
+
+// evaluate() dos nós é recursivo. evaluate_tree avalia com uma pilha
+// explícita, para árvores de qualquer profundidade (o Parser informa a
+// profundidade e o ExpressionEvaluator escolhe)
+variant<int, bool> evaluate_tree(const Expression& root);
+// Destrói a subárvore num laço, com uma fila no lugar da recursão
+void release_tree(ExpressionPtr root);
+
+// Os nós compostos destroem os filhos por aqui
+inline void release_expression(ExpressionPtr child) {
+    if (release_depth >= RECURSION_BUDGET) {
+        release_tree(move(child));
+        return;
+    }
+    release_depth++;
+    child.reset();
+    release_depth--;
+}
+
 class Literal : public Expression {
     private:
         variant<int, bool> value;
     
     public:
-        explicit Literal(variant<int, bool> v) : value(v) {}
+        explicit Literal(variant<int, bool> v)
+            : Expression(ExpressionKind::LITERAL, holds_alternative<int>(v) ? ValueType::INTEGER : ValueType::BOOLEAN), value(v) {}
 
         inline variant<int, bool> evaluate() const override { return value; }
+        inline void accept(ExpressionVisitor& visitor) const override { visitor.visit(*this); }
+
+        inline const variant<int, bool>& get_value() const { return value; }
+};
+
+// Referência a uma variável declarada. O valor não fica na árvore: quem
+// avalia (o bytecode de uma CompiledExpression) lê o slot no array de
+// valores. Sem declaração, slot fica UNRESOLVED e o tipo INVALID
+class Variable : public Expression {
+    private:
+        pmr::string name;
+        uint32_t slot;
+        uint32_t offset;
+
+    public:
+        static constexpr uint32_t UNRESOLVED = UINT32_MAX;
+
+        explicit Variable(string_view name, uint32_t slot = UNRESOLVED, ValueType type = ValueType::INVALID,
+                          pmr::memory_resource* resource = pmr::get_default_resource(), size_t offset = 0)
+            : Expression(ExpressionKind::VARIABLE, type), name(name, resource), slot(slot), offset(static_cast<uint32_t>(offset)) {}
+
+        inline variant<int, bool> evaluate() const override {
+            throw ExpressionError("Variável sem valor: " + string(name));
+        }
+        inline void accept(ExpressionVisitor& visitor) const override { visitor.visit(*this); }
+
+        inline string_view get_name() const { return name; }
+        inline uint32_t get_slot() const { return slot; }
+        inline bool is_resolved() const { return slot != UNRESOLVED; }
+        inline uint32_t get_offset() const { return offset; }
 };
 
 class PrimaryExpression : public Expression {
     private:
-        unique_ptr<Expression> expression;
+        ExpressionPtr expression;
         bool Parenthesized;
     
     public:
-        explicit PrimaryExpression(unique_ptr<Expression> expr, bool parenthesis = false) 
-            : expression(move(expr)), Parenthesized(parenthesis) {
+        explicit PrimaryExpression(ExpressionPtr expr, bool parenthesis = false) 
+            : Expression(ExpressionKind::PRIMARY, expr ? expr->get_type() : ValueType::INVALID), expression(move(expr)),
+              Parenthesized(parenthesis) {
             if (!expression) {
                 throw ExpressionError("Não é possível criar PrimaryExpression a partir de uma expressão nula");
             }
         }
+        ~PrimaryExpression() override { release_expression(move(expression)); }
 
         inline variant<int, bool> evaluate() const override { 
             return expression->evaluate(); 
         }
 
+        inline void accept(ExpressionVisitor& visitor) const override { visitor.visit(*this); }
+
         inline bool isParenthesized() const { return Parenthesized; }
+        inline const Expression& get_expression() const { return *expression; }
 };
 
 class UnaryExpression : public Expression {
     private:
-        unique_ptr<Expression> expression;
-        string operador;
+        ExpressionPtr expression;
+        pmr::string operador;
+        // Posição do operador na entrada, para os erros sem exceção
+        uint32_t offset;
 
     public:
-        explicit UnaryExpression(string operador, unique_ptr<Expression> expr) 
-            : operador(operador), expression(move(expr)) {
+        explicit UnaryExpression(string_view operador, ExpressionPtr expr, pmr::memory_resource* resource = pmr::get_default_resource(),
+                                 size_t offset = 0)
+            : Expression(ExpressionKind::UNARY, expr ? unary_result_type(operador, expr->get_type()) : ValueType::INVALID),
+              expression(move(expr)), operador(operador, resource), offset(static_cast<uint32_t>(offset)) {
             if (!expression) {
                 throw ExpressionError("Não é possível criar uma UnaryExpression a partir de uma expressão nula");
             }
         }
+        ~UnaryExpression() override { release_expression(move(expression)); }
 
-        variant<int, bool> evaluate() const override {
-            auto value = expression->evaluate();
+        inline variant<int, bool> evaluate() const override { return apply(expression->evaluate()); }
 
+        // O operador aplicado ao valor já avaliado do operando
+        variant<int, bool> apply(variant<int, bool> value) const {
+            EDOO_PROFILE_OPERATOR(operador, true);
             if (holds_alternative<int>(value)) {
                 if (operador == "-") {
                     return -get<int>(value);
                 }
-                throw ExpressionError("Operador Unário para Inteiros inválido: " + operador);
+                throw ExpressionError("Operador Unário para Inteiros inválido: " + string(operador));
             } 
             else if (holds_alternative<bool>(value)) {
-                throw ExpressionError("Operador Unário para Booleanos inválido: " + operador);
+                throw ExpressionError("Operador Unário para Booleanos inválido: " + string(operador));
             }
             return value;
         }
+        inline void accept(ExpressionVisitor& visitor) const override { visitor.visit(*this); }
+
+        inline string_view get_operator() const { return operador; }
+        inline const Expression& get_expression() const { return *expression; }
+        inline uint32_t get_offset() const { return offset; }
 };
 
 class BinaryExpression : public Expression {
     private:
-        string operador;
-        unique_ptr<Expression> left;
-        unique_ptr<Expression> right;
-    
+        pmr::string operador;
+        ExpressionPtr left;
+        ExpressionPtr right;
+        // Posição do operador na entrada, para os erros sem exceção
+        uint32_t offset;
+        // && ou || bem tipado: a direita só é avaliada se a esquerda não
+        // decidir o resultado. Mal tipado, os dois lados são avaliados antes
+        // da checagem, como nos outros operadores, para o erro continuar o mesmo
+        bool short_circuit;
+
+        static ValueType result_type(const ExpressionPtr& left, string_view operador, const ExpressionPtr& right) {
+            if (!left || !right) return ValueType::INVALID;
+            return binary_result_type(operador, left->get_type(), right->get_type());
+        }
+
     public:
         // Construtor para Expressions
-        explicit BinaryExpression(unique_ptr<Expression> left, string operador, unique_ptr<Expression> right) 
-            : left(move(left)), operador(operador), right(move(right)) {
+        explicit BinaryExpression(ExpressionPtr left, string_view operador, ExpressionPtr right, pmr::memory_resource* resource = pmr::get_default_resource(),
+                                  size_t offset = 0)
+            : Expression(ExpressionKind::BINARY, result_type(left, operador, right)), operador(operador, resource),
+              left(move(left)), right(move(right)), offset(static_cast<uint32_t>(offset)) {
             if (!this->left || !this->right){
                 throw ExpressionError("Não é possível criar uma BinaryExpression com operandos nulos");
             }
+            short_circuit = get_type() == ValueType::BOOLEAN && (operador == "&&" || operador == "||");
+        }
+        ~BinaryExpression() override {
+            release_expression(move(left));
+            release_expression(move(right));
         }
 
-        variant<int, bool> evaluate() const override {
+        inline variant<int, bool> evaluate() const override {
             auto left_value = left->evaluate();
+            if (short_circuit && decided_by(get<bool>(left_value))) return left_value;
             auto right_value = right->evaluate();
-            
+            return apply(left_value, right_value);
+        }
+
+        // Com short_circuit: o valor da esquerda já é o resultado (false no
+        // &&, true no ||)
+        inline bool decided_by(bool left_value) const { return left_value == (operador[0] == '|'); }
+
+        // O operador aplicado aos valores já avaliados dos operandos
+        variant<int, bool> apply(const variant<int, bool>& left_value, const variant<int, bool>& right_value) const {
+            EDOO_PROFILE_OPERATOR(operador, false);
             if (holds_alternative<int>(left_value) && holds_alternative<int>(right_value)) {
                 int lv = get<int>(left_value);
                 int rv = get<int>(right_value);
@@ -128,6 +303,13 @@ class BinaryExpression : public Expression {
             }
             throw ExpressionError("Avaliando operandos de tipos diferentes");
         }
+        inline void accept(ExpressionVisitor& visitor) const override { visitor.visit(*this); }
+
+        inline string_view get_operator() const { return operador; }
+        inline const Expression& get_left() const { return *left; }
+        inline const Expression& get_right() const { return *right; }
+        inline uint32_t get_offset() const { return offset; }
+        inline bool is_short_circuit() const { return short_circuit; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "fast_io.h"
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedInput::MappedInput(int fd) {
+    load(fd);
+}
+
+MappedInput::MappedInput(const string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw IOError("Não foi possível abrir " + path + ": " + strerror(errno));
+    }
+    try {
+        load(fd);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    // O mapeamento continua válido depois de fechar o descritor
+    ::close(fd);
+}
+
+void MappedInput::load(int fd) {
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        // Pode não começar no início (ex: stdin já consumido em parte)
+        off_t offset = lseek(fd, 0, SEEK_CUR);
+        if (offset < 0 || offset > info.st_size) offset = 0;
+        void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            madvise(address, info.st_size, MADV_SEQUENTIAL);
+            map_address = address;
+            map_length = info.st_size;
+            data = static_cast<const char*>(address) + offset;
+            size = info.st_size - offset;
+            mapped = true;
+            return;
+        }
+    }
+
+    constexpr size_t BLOCK = 1 << 20;
+    size_t used = 0;
+    while (true) {
+        buffer.resize(used + BLOCK);
+        ssize_t count = ::read(fd, buffer.data() + used, BLOCK);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            throw IOError(string("Erro de leitura: ") + strerror(errno));
+        }
+        if (count == 0) break;
+        used += count;
+    }
+    buffer.resize(used);
+    data = buffer.data();
+    size = used;
+}
+
+MappedInput::~MappedInput() {
+    if (mapped) munmap(map_address, map_length);
+}
+
+bool LineReader::read_int(int& value) {
+    while (position < text.size() && isspace(static_cast<unsigned char>(text[position]))) {
+        position++;
+    }
+    const char* begin = text.data() + position;
+    const char* end = text.data() + text.size();
+    // cin >> int aceita um '+' na frente; from_chars não
+    const char* digits = (begin < end && *begin == '+') ? begin + 1 : begin;
+    auto [next, error] = from_chars(digits, end, value);
+    if (error != errc()) {
+        value = 0;
+        return false;
+    }
+    position = next - text.data();
+    return true;
+}
+
+string_view LineReader::next_line() {
+    if (position >= text.size()) return {};
+    size_t end = text.find('\n', position);
+    if (end == string_view::npos) end = text.size();
+    string_view line = text.substr(position, end - position);
+    position = end + 1;
+    return line;
+}
+
+string_view LineReader::next_block(size_t bytes) {
+    if (position >= text.size()) return {};
+    size_t end = text.size();
+    if (text.size() - position > bytes) {
+        // Termina no último '\n' dentro do limite ou, sem nenhum, no
+        // primeiro depois dele
+        size_t newline = text.substr(position, bytes).rfind('\n');
+        if (newline != string_view::npos) {
+            end = position + newline + 1;
+        } else {
+            newline = text.find('\n', position + bytes);
+            if (newline != string_view::npos) end = newline + 1;
+        }
+    }
+    string_view block = text.substr(position, end - position);
+    position = end;
+    return block;
+}
+
+void append_result(string& output, const variant<int, bool>& result) {
+    if (holds_alternative<int>(result)) {
+        char digits[16];
+        auto end = to_chars(digits, digits + sizeof(digits), get<int>(result)).ptr;
+        output.append(digits, end);
+    } else {
+        output += get<bool>(result) ? "true" : "false";
+    }
+    output += '\n';
+}
+
+BufferedOutput::BufferedOutput(int fd, size_t capacity) : fd(fd), capacity(capacity) {
+    // Espaço para um resultado além do limite antes do flush
+    buffer.reserve(capacity + 64);
+}
+
+BufferedOutput::~BufferedOutput() {
+    try {
+        flush();
+    } catch (const IOError&) {
+        // Destrutores não lançam; quem precisa do erro chama flush antes
+    }
+}
+
+void BufferedOutput::flush() {
+    const char* pending = buffer.data();
+    size_t left = buffer.size();
+    while (left > 0) {
+        ssize_t written = ::write(fd, pending, left);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            buffer.clear();
+            throw IOError(string("Erro de escrita: ") + strerror(errno));
+        }
+        pending += written;
+        left -= written;
+    }
+    buffer.clear();
+}
@@ -0,0 +1,93 @@
+#ifndef FAST_IO_H
+#define FAST_IO_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+using namespace std;
+
+class IOError : public runtime_error {
+    public:
+        explicit IOError(const string& message) : runtime_error(message) {}
+};
+
+// Conteúdo inteiro de um arquivo. Arquivos comuns (inclusive stdin
+// redirecionado de um arquivo) são mapeados com mmap; pipes e terminais são
+// lidos em blocos grandes para um buffer
+class MappedInput {
+    private:
+        const char* data = nullptr;
+        size_t size = 0;
+        bool mapped = false;
+        void* map_address = nullptr;
+        size_t map_length = 0;
+        vector<char> buffer;
+
+        void load(int fd);
+
+    public:
+        explicit MappedInput(int fd);
+        explicit MappedInput(const string& path);
+        ~MappedInput();
+
+        MappedInput(const MappedInput&) = delete;
+        MappedInput& operator=(const MappedInput&) = delete;
+
+        inline string_view contents() const { return string_view(data, size); }
+        inline bool is_mapped() const { return mapped; }
+};
+
+// Lê o texto com a mesma semântica de cin >> n, cin.ignore() e getline, mas
+// devolve string_views para o próprio texto em vez de copiar as linhas
+class LineReader {
+    private:
+        string_view text;
+        size_t position = 0;
+
+    public:
+        explicit LineReader(string_view text) : text(text) {}
+
+        // Como cin >> value: pula espaços e lê um inteiro; false se falhar
+        bool read_int(int& value);
+        // Como cin.ignore(): descarta um caractere
+        inline void ignore() { if (position < text.size()) position++; }
+        // Como getline: até o '\n' (consumido, fora da linha) ou o fim.
+        // No fim do texto devolve uma linha vazia
+        string_view next_line();
+        // Linhas inteiras a partir da posição atual, com até bytes caracteres
+        // (ou só a primeira, se ela passar disso), incluindo o '\n' da
+        // última; as mesmas que next_line daria. No fim do texto devolve
+        // um bloco vazio
+        string_view next_block(size_t bytes);
+
+        inline bool at_end() const { return position >= text.size(); }
+};
+
+// Acrescenta o resultado no formato do main: o inteiro ou true/false e '\n'
+void append_result(string& output, const variant<int, bool>& result);
+
+// Acumula a saída num buffer grande e escreve com poucas chamadas a write
+class BufferedOutput {
+    private:
+        int fd;
+        size_t capacity;
+        string buffer;
+
+    public:
+        explicit BufferedOutput(int fd = 1, size_t capacity = 1 << 20);
+        ~BufferedOutput();
+
+        BufferedOutput(const BufferedOutput&) = delete;
+        BufferedOutput& operator=(const BufferedOutput&) = delete;
+
+        // Escreve direto no buffer; chame maybe_flush depois
+        inline string& data() { return buffer; }
+        inline void maybe_flush() { if (buffer.size() >= capacity) flush(); }
+        inline void append(string_view text) { buffer += text; maybe_flush(); }
+        void flush();
+};
+
+#endif
@@ -0,0 +1,257 @@
+#include "filter.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+static const char* opcode_symbol(OpCode op) {
+    switch (op) {
+        case OpCode::ADD_I: return "+";
+        case OpCode::SUB_I: return "-";
+        case OpCode::MUL_I: return "*";
+        case OpCode::DIV_I: return "/";
+        case OpCode::LT_I:  return "<";
+        case OpCode::GT_I:  return ">";
+        case OpCode::LE_I:  return "<=";
+        case OpCode::GE_I:  return ">=";
+        case OpCode::EQ_I:
+        case OpCode::EQ_B:  return "==";
+        case OpCode::NE_I:
+        case OpCode::NE_B:  return "!=";
+        case OpCode::AND_B: return "&&";
+        case OpCode::OR_B:  return "||";
+        default:            return "?";
+    }
+}
+
+// Texto de code[first, last), reconstruído a partir do bytecode pós-fixo
+static string describe(const Program& program, size_t first, size_t last, const Variables& variables) {
+    vector<string> stack;
+    for (size_t i = first; i < last; i++) {
+        const Instruction& instruction = program.code[i];
+        switch (instruction.op) {
+            case OpCode::PUSH_INT:
+                stack.push_back(to_string(instruction.operand));
+                break;
+            case OpCode::PUSH_BOOL:
+                stack.push_back(instruction.operand ? "true" : "false");
+                break;
+            case OpCode::LOAD_I:
+            case OpCode::LOAD_B:
+                stack.push_back(variables[instruction.operand].name);
+                break;
+            case OpCode::NEG_I:
+                stack.back() = "- " + stack.back();
+                break;
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE:
+                break;
+            default: {
+                string right = move(stack.back());
+                stack.pop_back();
+                string& left = stack.back();
+                left = "( " + left + " " + opcode_symbol(instruction.op) + " " + right + " )";
+                break;
+            }
+        }
+    }
+    string text = stack.empty() ? string() : stack.back();
+    // Sem os parênteses externos
+    if (text.size() > 4 && text.front() == '(' && text.back() == ')') {
+        text = text.substr(2, text.size() - 4);
+    }
+    return text;
+}
+
+string FilterResult::statistics_to_string() const {
+    string text;
+    for (const auto& stats : statistics) {
+        char percent[32];
+        snprintf(percent, sizeof(percent), "%.1f%%", stats.selectivity() * 100);
+        text += string(stats.depth * 2, ' ') + stats.predicate
+              + ": " + to_string(stats.rows_passed) + "/" + to_string(stats.rows_in)
+              + " (" + percent + ")";
+        if (stats.errors) text += ", " + to_string(stats.errors) + " erros";
+        text += "\n";
+    }
+    return text;
+}
+
+// starts[i]: primeira instrução da subexpressão que termina em i
+size_t FilterEvaluator::build(const vector<size_t>& starts, size_t last, size_t depth, const Variables& variables) {
+    size_t index = nodes.size();
+    nodes.emplace_back();
+    nodes[index].first = starts[last];
+    nodes[index].last = last + 1;
+
+    PredicateStatistics stats;
+    stats.predicate = describe(*program, starts[last], last + 1, variables);
+    stats.depth = depth;
+    result->statistics.push_back(move(stats));
+
+    OpCode op = program->code[last].op;
+    if (op == OpCode::AND_B || op == OpCode::OR_B) {
+        size_t right_last = last - 1;
+        size_t left_last = starts[right_last] - 1;
+        // Entre os operandos fica o salto do curto-circuito
+        OpCode jump = program->code[left_last].op;
+        if (jump == OpCode::JUMP_IF_FALSE || jump == OpCode::JUMP_IF_TRUE) left_last--;
+        nodes[index].kind = op == OpCode::AND_B ? Node::AND : Node::OR;
+        size_t left = build(starts, left_last, depth + 1, variables);
+        size_t right = build(starts, right_last, depth + 1, variables);
+        nodes[index].left = left;
+        nodes[index].right = right;
+    } else {
+        nodes[index].kind = Node::LEAF;
+    }
+    return index;
+}
+
+void FilterEvaluator::filter_node(size_t index, const uint32_t* rows, size_t count,
+                                  vector<uint32_t>& out, vector<uint32_t>& failed) {
+    Node& node = nodes[index];
+    PredicateStatistics& stats = result->statistics[index];
+    stats.rows_in += count;
+    out.clear();
+    failed.clear();
+
+    switch (node.kind) {
+        case Node::AND:
+            filter_node(node.left, rows, count, node.left_rows, failed);
+            filter_node(node.right, node.left_rows.data(), node.left_rows.size(), out, node.right_failed);
+            failed.insert(failed.end(), node.right_failed.begin(), node.right_failed.end());
+            break;
+
+        case Node::OR: {
+            filter_node(node.left, rows, count, node.left_rows, failed);
+            // Marca, por posição no bloco, as linhas já decididas: 1 as que
+            // passaram, 2 as que falharam. Com a marca as compactações abaixo
+            // não dependem da ordem de left_rows
+            uint8_t* decided = node.decided.data();
+            memset(decided, 0, BatchEvaluator::BLOCK_SIZE);
+            for (uint32_t row : node.left_rows) decided[row - block_begin] = 1;
+            for (uint32_t row : failed) decided[row - block_begin] = 2;
+
+            node.undecided.resize(count);
+            size_t n = 0;
+            for (size_t i = 0; i < count; i++) {
+                node.undecided[n] = rows[i];
+                n += !decided[rows[i] - block_begin];
+            }
+            node.undecided.resize(n);
+            filter_node(node.right, node.undecided.data(), node.undecided.size(), node.right_rows, node.right_failed);
+            failed.insert(failed.end(), node.right_failed.begin(), node.right_failed.end());
+
+            for (uint32_t row : node.right_rows) decided[row - block_begin] = 1;
+            out.resize(count);
+            n = 0;
+            for (size_t i = 0; i < count; i++) {
+                out[n] = rows[i];
+                n += decided[rows[i] - block_begin] == 1;
+            }
+            out.resize(n);
+            break;
+        }
+
+        case Node::LEAF: {
+            if (count == 0) break;
+            // Linhas contíguas (todas do bloco) são lidas sem gather
+            bool contiguous = rows[count - 1] - rows[0] == count - 1;
+            const int32_t* values = contiguous
+                ? batch.run_block(*program, node.first, node.last, *columns, nullptr, rows[0], count)
+                : batch.run_block(*program, node.first, node.last, *columns, rows, 0, count);
+            const uint64_t* errors = batch.block_errors.data();
+            size_t error_count = 0;
+            for (size_t w = 0; w < (count + 63) / 64; w++) error_count += __builtin_popcountll(errors[w]);
+            stats.errors += error_count;
+
+            out.resize(count);
+            size_t n = 0;
+            if (error_count == 0) {
+                for (size_t i = 0; i < count; i++) {
+                    out[n] = rows[i];
+                    n += values[i] != 0;
+                }
+            } else {
+                for (size_t i = 0; i < count; i++) {
+                    out[n] = rows[i];
+                    n += values[i] != 0 && !((errors[i / 64] >> (i % 64)) & 1);
+                }
+                for (size_t w = 0; w < (count + 63) / 64; w++) {
+                    for (uint64_t bits = errors[w]; bits; bits &= bits - 1) {
+                        failed.push_back(rows[w * 64 + __builtin_ctzll(bits)]);
+                    }
+                }
+            }
+            out.resize(n);
+            break;
+        }
+    }
+    stats.rows_passed += out.size();
+}
+
+FilterResult FilterEvaluator::filter(const CompiledExpression& expression, const ColumnBatch& columns) {
+    FilterResult result;
+    filter(expression, columns, result);
+    return result;
+}
+
+void FilterEvaluator::filter(const CompiledExpression& expression, const ColumnBatch& columns, FilterResult& out) {
+    const Program& code = expression.get_program();
+    if (code.result_type != ValueType::BOOLEAN) {
+        throw ExpressionError("O filtro precisa de uma expressão booleana");
+    }
+    BatchEvaluator::check_columns(expression, columns);
+
+    program = &code;
+    this->columns = &columns;
+    result = &out;
+    out.selection.clear();
+    out.statistics.clear();
+
+    // Limites das subexpressões, simulando a pilha do VM (sem o HALT)
+    size_t last = code.code.size() - 2;
+    vector<size_t> starts(last + 1), stack;
+    for (size_t i = 0; i <= last; i++) {
+        switch (code.code[i].op) {
+            case OpCode::PUSH_INT:
+            case OpCode::PUSH_BOOL:
+            case OpCode::LOAD_I:
+            case OpCode::LOAD_B:
+                stack.push_back(i);
+                break;
+            case OpCode::NEG_I:
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE:
+                break;
+            case OpCode::FAIL:
+            case OpCode::HALT:
+                throw ExpressionError("Bytecode inválido para filtro");
+            default:
+                // Operador binário: a subexpressão começa no operando da esquerda
+                stack.pop_back();
+                break;
+        }
+        starts[i] = stack.back();
+    }
+
+    nodes.clear();
+    build(starts, last, 0, expression.get_variables());
+    for (auto& node : nodes) {
+        if (node.kind == Node::OR) node.decided.resize(BatchEvaluator::BLOCK_SIZE);
+    }
+    batch.prepare(code);
+
+    vector<uint32_t> block_rows(BatchEvaluator::BLOCK_SIZE), block_out, block_failed;
+    for (size_t begin = 0; begin < columns.size(); begin += BatchEvaluator::BLOCK_SIZE) {
+        size_t count = min(BatchEvaluator::BLOCK_SIZE, columns.size() - begin);
+        block_begin = static_cast<uint32_t>(begin);
+        iota(block_rows.begin(), block_rows.begin() + count, block_begin);
+        filter_node(0, block_rows.data(), count, block_out, block_failed);
+        out.selection.insert(out.selection.end(), block_out.begin(), block_out.end());
+    }
+
+    program = nullptr;
+    this->columns = nullptr;
+    result = nullptr;
+}
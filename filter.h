@@ -0,0 +1,73 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "batch.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Contadores de um sub-predicado (um &&, um || ou uma folha)
+struct PredicateStatistics {
+    string predicate;
+    size_t depth = 0;
+    size_t rows_in = 0;      // linhas que chegaram ao sub-predicado
+    size_t rows_passed = 0;  // linhas em que ele foi verdadeiro
+    size_t errors = 0;       // linhas em que a avaliação falhou (só folhas)
+
+    inline double selectivity() const { return rows_in ? double(rows_passed) / rows_in : 0.0; }
+};
+
+class FilterResult {
+    public:
+        // Índices das linhas que passaram, em ordem crescente
+        vector<uint32_t> selection;
+        // Em pré-ordem: a expressão inteira primeiro
+        vector<PredicateStatistics> statistics;
+
+        string statistics_to_string() const;
+};
+
+// Filtra as linhas de um ColumnBatch por uma expressão booleana, devolvendo
+// um vetor de seleção em vez de uma coluna de resultados. Cada && e || do
+// topo da expressão divide o trabalho: o operando da direita só é avaliado
+// nas linhas que o da esquerda não decidiu (as que passaram, no &&, e as que
+// não passaram, no ||). As folhas rodam os kernels do BatchEvaluator só
+// sobre as linhas selecionadas.
+//
+// Linhas cuja avaliação falha (divisão por zero) não passam. Uma linha
+// decidida pela esquerda não avalia a direita e, como no curto-circuito do
+// VM, não falha por causa dela. Uma linha em que a esquerda falhou também
+// está decidida: a falha sobe pelos && e || acima, como a exceção no VM
+class FilterEvaluator {
+    private:
+        struct Node {
+            enum Kind { AND, OR, LEAF } kind;
+            // Instruções code[first, last) do Program
+            size_t first, last;
+            size_t left = 0, right = 0;
+            // Buffers reaproveitados entre blocos
+            vector<uint32_t> left_rows, right_rows, right_failed, undecided;
+            vector<uint8_t> decided;  // só no ||: uma posição por linha do bloco
+        };
+
+        BatchEvaluator batch;
+        vector<Node> nodes;
+        const Program* program = nullptr;
+        const ColumnBatch* columns = nullptr;
+        FilterResult* result = nullptr;
+        uint32_t block_begin = 0;
+
+        size_t build(const vector<size_t>& starts, size_t last, size_t depth, const Variables& variables);
+        // out: as linhas em que o nó é verdadeiro; failed: as linhas em que
+        // a avaliação dele falhou
+        void filter_node(size_t index, const uint32_t* rows, size_t count,
+                         vector<uint32_t>& out, vector<uint32_t>& failed);
+
+    public:
+        FilterResult filter(const CompiledExpression& expression, const ColumnBatch& columns);
+        // Reaproveita a memória de out
+        void filter(const CompiledExpression& expression, const ColumnBatch& columns, FilterResult& out);
+};
+
+#endif
@@ -0,0 +1,317 @@
+#include "flat_expression.h"
+#include "profile.h"
+#include <algorithm>
+
+const char* flat_op_name(FlatOp op) {
+    switch (op) {
+        case FlatOp::LITERAL:          return "LITERAL";
+        case FlatOp::VARIABLE:         return "VARIABLE";
+        case FlatOp::BOOLEAN_VARIABLE: return "BOOLEAN_VARIABLE";
+        case FlatOp::NEG:              return "NEG";
+        case FlatOp::ADD:              return "ADD";
+        case FlatOp::SUB:              return "SUB";
+        case FlatOp::MUL:              return "MUL";
+        case FlatOp::DIV:              return "DIV";
+        case FlatOp::LT:               return "LT";
+        case FlatOp::GT:               return "GT";
+        case FlatOp::LE:               return "LE";
+        case FlatOp::GE:               return "GE";
+        case FlatOp::EQ:               return "EQ";
+        case FlatOp::NE:               return "NE";
+        case FlatOp::AND:              return "AND";
+        case FlatOp::OR:               return "OR";
+        case FlatOp::FAIL:             return "FAIL";
+    }
+    return "UNKNOWN";
+}
+
+// O FlatOp de um operador binário bem tipado (o tipo estático já garante
+// que o símbolo combina com os tipos dos operandos)
+static FlatOp binary_op(string_view symbol) {
+    bool twice = symbol.size() == 2;
+    switch (symbol[0]) {
+        case '+': return FlatOp::ADD;
+        case '-': return FlatOp::SUB;
+        case '*': return FlatOp::MUL;
+        case '/': return FlatOp::DIV;
+        case '<': return twice ? FlatOp::LE : FlatOp::LT;
+        case '>': return twice ? FlatOp::GE : FlatOp::GT;
+        case '=': return FlatOp::EQ;
+        case '!': return FlatOp::NE;
+        case '&': return FlatOp::AND;
+        case '|': return FlatOp::OR;
+        default:  return FlatOp::FAIL;
+    }
+}
+
+uint32_t FlatExpression::push(FlatOp op, uint32_t left, uint32_t right, uint32_t offset) {
+    ops.push_back(op);
+    lhs.push_back(left);
+    rhs.push_back(right);
+    offsets.push_back(offset);
+    return static_cast<uint32_t>(ops.size() - 1);
+}
+
+uint32_t FlatExpression::leaf(const Literal& literal) {
+    const auto& value = literal.get_value();
+    literals.push_back(holds_alternative<int>(value) ? get<int>(value) : static_cast<int32_t>(get<bool>(value)));
+    return push(FlatOp::LITERAL, static_cast<uint32_t>(literals.size() - 1), NO_NODE, 0);
+}
+
+uint32_t FlatExpression::leaf(const Variable& variable) {
+    names.emplace_back(variable.get_name());
+    FlatOp op = variable.get_type() == ValueType::BOOLEAN ? FlatOp::BOOLEAN_VARIABLE : FlatOp::VARIABLE;
+    return push(op, variable.get_slot(), static_cast<uint32_t>(names.size() - 1), variable.get_offset());
+}
+
+// Os erros de tipo são os que UnaryExpression/BinaryExpression::apply
+// lançariam. Com um filho mal tipado o FAIL nunca chega ao próprio erro
+// (o filho sempre falha antes) e guarda um erro vazio
+uint32_t FlatExpression::unary(const UnaryExpression& expression, uint32_t operand) {
+    if (expression.get_type() == ValueType::INTEGER) {
+        return push(FlatOp::NEG, operand, NO_NODE, expression.get_offset());
+    }
+    uint32_t id = push(FlatOp::FAIL, operand, NO_NODE, expression.get_offset());
+    EvaluationError error;
+    switch (expression.get_expression().get_type()) {
+        case ValueType::INTEGER: error = EvaluationError(ErrorCode::INVALID_INTEGER_UNARY, expression.get_offset()); break;
+        case ValueType::BOOLEAN: error = EvaluationError(ErrorCode::INVALID_BOOLEAN_UNARY, expression.get_offset()); break;
+        case ValueType::INVALID: break;
+    }
+    if (error) error.detail = string(expression.get_operator());
+    failures.emplace_back(id, move(error));
+    return id;
+}
+
+uint32_t FlatExpression::binary(const BinaryExpression& expression, uint32_t left, uint32_t right) {
+    if (expression.get_type() != ValueType::INVALID) {
+        return push(binary_op(expression.get_operator()), left, right, expression.get_offset());
+    }
+    uint32_t id = push(FlatOp::FAIL, left, right, expression.get_offset());
+    ValueType left_type = expression.get_left().get_type();
+    ValueType right_type = expression.get_right().get_type();
+    EvaluationError error;
+    if (left_type != ValueType::INVALID && right_type != ValueType::INVALID) {
+        ErrorCode code = ErrorCode::MIXED_TYPES;
+        if (left_type == right_type) {
+            code = left_type == ValueType::INTEGER ? ErrorCode::UNKNOWN_ARITHMETIC_OPERATOR : ErrorCode::UNKNOWN_LOGICAL_OPERATOR;
+        }
+        error = EvaluationError(code, expression.get_offset());
+    }
+    failures.emplace_back(id, move(error));
+    return id;
+}
+
+void FlatExpression::clear() {
+    ops.clear();
+    lhs.clear();
+    rhs.clear();
+    offsets.clear();
+    literals.clear();
+    names.clear();
+    failures.clear();
+    type = ValueType::INVALID;
+}
+
+// Pós-ordem com pilha explícita, como ExpressionDag::intern: cada nó entra
+// depois dos filhos, então o índice dele é maior que o dos filhos
+void FlatExpression::assign(const Expression& root) {
+    clear();
+    frames.clear();
+    ids.clear();
+    frames.push_back({&root, false});
+
+    while (!frames.empty()) {
+        Frame frame = frames.back();
+        frames.pop_back();
+        const Expression* expression = frame.expression;
+        while (expression->get_kind() == ExpressionKind::PRIMARY) {
+            expression = &static_cast<const PrimaryExpression*>(expression)->get_expression();
+        }
+
+        switch (expression->get_kind()) {
+            case ExpressionKind::LITERAL:
+                ids.push_back(leaf(*static_cast<const Literal*>(expression)));
+                break;
+            case ExpressionKind::VARIABLE:
+                ids.push_back(leaf(*static_cast<const Variable*>(expression)));
+                break;
+            case ExpressionKind::PRIMARY:
+                break;
+            case ExpressionKind::UNARY: {
+                auto node = static_cast<const UnaryExpression*>(expression);
+                if (frame.children_done) {
+                    ids.back() = unary(*node, ids.back());
+                } else {
+                    frames.push_back({expression, true});
+                    frames.push_back({&node->get_expression(), false});
+                }
+                break;
+            }
+            case ExpressionKind::BINARY: {
+                auto node = static_cast<const BinaryExpression*>(expression);
+                if (frame.children_done) {
+                    uint32_t right = ids.back();
+                    ids.pop_back();
+                    ids.back() = binary(*node, ids.back(), right);
+                } else {
+                    frames.push_back({expression, true});
+                    frames.push_back({&node->get_right(), false});
+                    frames.push_back({&node->get_left(), false});
+                }
+                break;
+            }
+        }
+    }
+    type = root.get_type();
+}
+
+EvaluationError FlatExpression::error_at(uint32_t node) const {
+    switch (ops[node]) {
+        case FlatOp::DIV:
+            return EvaluationError(ErrorCode::DIVISION_BY_ZERO, offsets[node]);
+        case FlatOp::VARIABLE:
+        case FlatOp::BOOLEAN_VARIABLE: {
+            EvaluationError error(ErrorCode::UNBOUND_VARIABLE, offsets[node]);
+            error.detail = names[rhs[node]];
+            return error;
+        }
+        default: {
+            // Em ordem de nó, como foram criados
+            auto found = lower_bound(failures.begin(), failures.end(), node,
+                                     [](const pair<uint32_t, EvaluationError>& entry, uint32_t id) { return entry.first < id; });
+            return found->second;
+        }
+    }
+}
+
+// Uma passada para frente: os filhos de i já foram avaliados. Cada nó
+// propaga o erro da esquerda antes do da direita; && e || decididos pela
+// esquerda ignoram a direita, como o curto-circuito da árvore
+EvaluationResult FlatExpression::try_evaluate(const int32_t* slots) {
+    EDOO_PROFILE_STAGE(ProfileStage::EVALUATE);
+    size_t count = ops.size();
+    values.resize(count);
+    failed.resize(count);
+    int32_t* value = values.data();
+    uint32_t* failure = failed.data();
+    const FlatOp* op = ops.data();
+    const uint32_t* left = lhs.data();
+    const uint32_t* right = rhs.data();
+
+    #define FLAT_BINARY(name, expression) \
+        case FlatOp::name: { \
+            int32_t l = value[left[i]], r = value[right[i]]; \
+            uint32_t ul = static_cast<uint32_t>(l), ur = static_cast<uint32_t>(r); \
+            (void)ul; (void)ur; \
+            failure[i] = failure[left[i]] != NO_NODE ? failure[left[i]] : failure[right[i]]; \
+            value[i] = (expression); \
+            break; \
+        }
+
+    for (size_t i = 0; i < count; i++) {
+        switch (op[i]) {
+            case FlatOp::LITERAL:
+                value[i] = literals[left[i]];
+                failure[i] = NO_NODE;
+                break;
+            case FlatOp::VARIABLE:
+            case FlatOp::BOOLEAN_VARIABLE:
+                if (slots && left[i] != Variable::UNRESOLVED) {
+                    int32_t loaded = slots[left[i]];
+                    value[i] = op[i] == FlatOp::BOOLEAN_VARIABLE ? loaded != 0 : loaded;
+                    failure[i] = NO_NODE;
+                } else {
+                    value[i] = 0;
+                    failure[i] = static_cast<uint32_t>(i);
+                }
+                break;
+            case FlatOp::NEG:
+                value[i] = static_cast<int32_t>(0u - static_cast<uint32_t>(value[left[i]]));
+                failure[i] = failure[left[i]];
+                break;
+            FLAT_BINARY(ADD, static_cast<int32_t>(ul + ur))
+            FLAT_BINARY(SUB, static_cast<int32_t>(ul - ur))
+            FLAT_BINARY(MUL, static_cast<int32_t>(ul * ur))
+            FLAT_BINARY(LT, l < r)
+            FLAT_BINARY(GT, l > r)
+            FLAT_BINARY(LE, l <= r)
+            FLAT_BINARY(GE, l >= r)
+            FLAT_BINARY(EQ, l == r)
+            FLAT_BINARY(NE, l != r)
+            case FlatOp::DIV: {
+                int32_t l = value[left[i]], r = value[right[i]];
+                uint32_t origin = failure[left[i]] != NO_NODE ? failure[left[i]] : failure[right[i]];
+                if (origin == NO_NODE && r == 0) origin = static_cast<uint32_t>(i);
+                failure[i] = origin;
+                value[i] = r != 0 ? l / r : 0;
+                break;
+            }
+            case FlatOp::AND:
+            case FlatOp::OR: {
+                int32_t l = value[left[i]];
+                bool decided = (l != 0) == (op[i] == FlatOp::OR);
+                if (failure[left[i]] != NO_NODE || decided) {
+                    failure[i] = failure[left[i]];
+                    value[i] = l;
+                } else {
+                    failure[i] = failure[right[i]];
+                    value[i] = value[right[i]];
+                }
+                break;
+            }
+            case FlatOp::FAIL:
+                if (failure[left[i]] != NO_NODE) {
+                    failure[i] = failure[left[i]];
+                } else if (right[i] != NO_NODE && failure[right[i]] != NO_NODE) {
+                    failure[i] = failure[right[i]];
+                } else {
+                    failure[i] = static_cast<uint32_t>(i);
+                }
+                value[i] = 0;
+                break;
+        }
+    }
+    #undef FLAT_BINARY
+
+    uint32_t origin = failure[count - 1];
+    if (origin != NO_NODE) return error_at(origin);
+    if (type == ValueType::BOOLEAN) return variant<int, bool>(value[count - 1] != 0);
+    return variant<int, bool>(value[count - 1]);
+}
+
+variant<int, bool> FlatExpression::evaluate(const int32_t* slots) {
+    EvaluationResult result = try_evaluate(slots);
+    if (!result) result.get_error().raise();
+    return result.get_value();
+}
+
+size_t FlatExpression::memory() const {
+    size_t bytes = ops.size() * (sizeof(FlatOp) + 3 * sizeof(uint32_t)) + literals.size() * sizeof(int32_t)
+                 + failures.size() * sizeof(failures[0]);
+    for (const auto& name : names) bytes += sizeof(string) + name.size();
+    return bytes;
+}
+
+// Para debug
+string FlatExpression::to_string() const {
+    string result;
+    for (size_t i = 0; i < ops.size(); i++) {
+        result += std::to_string(i) + ": " + flat_op_name(ops[i]);
+        switch (ops[i]) {
+            case FlatOp::LITERAL:
+                result += " " + std::to_string(literals[lhs[i]]);
+                break;
+            case FlatOp::VARIABLE:
+            case FlatOp::BOOLEAN_VARIABLE:
+                result += " " + names[rhs[i]];
+                break;
+            default:
+                result += " " + std::to_string(lhs[i]);
+                if (rhs[i] != NO_NODE) result += " " + std::to_string(rhs[i]);
+                break;
+        }
+        result += "\n";
+    }
+    return result;
+}
@@ -0,0 +1,112 @@
+#ifndef FLAT_EXPRESSION_H
+#define FLAT_EXPRESSION_H
+
+#include "expressions.h"
+#include "errors.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Operação de um nó da FlatExpression. Os operadores são os da árvore já
+// resolvidos pelos tipos estáticos: o que falharia por tipo vira FAIL
+enum class FlatOp : uint8_t {
+    LITERAL,    // lhs: índice no pool de literais
+    VARIABLE,   // inteira ou sem declaração. lhs: slot (ou
+                // Variable::UNRESOLVED); rhs: índice do nome
+    BOOLEAN_VARIABLE,
+    NEG,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    LT,
+    GT,
+    LE,
+    GE,
+    EQ,
+    NE,
+    AND,        // && e || bem tipados: sempre com curto-circuito
+    OR,
+    FAIL        // erro de tipo depois dos filhos; rhs NO_NODE no unário
+};
+
+const char* flat_op_name(FlatOp op);
+
+// A árvore em arrays contíguos (structure of arrays): um opcode, dois
+// índices de 32 bits para os filhos (ou operandos das folhas) e a posição
+// na entrada por nó, mais um pool de literais. Os nós ficam em pós-ordem,
+// então os filhos vêm antes do pai e avaliar é uma varredura única para
+// frente, sem ponteiros, sem chamadas virtuais e sem recursão; a raiz é o
+// último nó. Parênteses não viram nós.
+//
+// Os resultados e erros são os de Expression::evaluate (e evaluate_tree),
+// para árvores de qualquer profundidade. Os dois lados de && e || são
+// avaliados na varredura; o erro da direita que o curto-circuito não
+// avaliaria não é propagado. Com slots, as variáveis resolvidas leem os
+// valores como o bytecode de uma CompiledExpression; sem, falham como na
+// árvore.
+//
+// Avaliar usa arrays de trabalho do objeto: um por thread
+class FlatExpression {
+    public:
+        static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    private:
+        struct Frame {
+            const Expression* expression;
+            bool children_done;
+        };
+
+        vector<FlatOp> ops;
+        vector<uint32_t> lhs;
+        vector<uint32_t> rhs;
+        // Posição do operador ou da variável, só lida para montar erros
+        vector<uint32_t> offsets;
+        vector<int32_t> literals;
+        vector<string> names;
+        // Nó FAIL e o erro de tipo dele
+        vector<pair<uint32_t, EvaluationError>> failures;
+        ValueType type = ValueType::INVALID;
+
+        // Valor de cada nó e o nó cujo erro ele propaga (NO_NODE se nenhum)
+        vector<int32_t> values;
+        vector<uint32_t> failed;
+
+        // Pilhas do percurso de assign, reaproveitadas
+        vector<Frame> frames;
+        vector<uint32_t> ids;
+
+        uint32_t push(FlatOp op, uint32_t left, uint32_t right, uint32_t offset);
+        uint32_t leaf(const Literal& literal);
+        uint32_t leaf(const Variable& variable);
+        uint32_t unary(const UnaryExpression& expression, uint32_t operand);
+        uint32_t binary(const BinaryExpression& expression, uint32_t left, uint32_t right);
+        EvaluationError error_at(uint32_t node) const;
+
+    public:
+        FlatExpression() = default;
+        explicit FlatExpression(const Expression& root) { assign(root); }
+
+        // Converte a árvore (de qualquer profundidade), descartando o que
+        // havia e reaproveitando a memória. A árvore pode ser descartada depois
+        void assign(const Expression& root);
+        void clear();
+
+        variant<int, bool> evaluate(const int32_t* slots = nullptr);
+        EvaluationResult try_evaluate(const int32_t* slots = nullptr);
+
+        inline size_t size() const { return ops.size(); }
+        inline ValueType get_type() const { return type; }
+        inline FlatOp get_op(uint32_t node) const { return ops[node]; }
+        inline uint32_t get_left(uint32_t node) const { return lhs[node]; }
+        inline uint32_t get_right(uint32_t node) const { return rhs[node]; }
+        inline const vector<int32_t>& get_literals() const { return literals; }
+        // Bytes da representação (sem os arrays de trabalho da avaliação)
+        size_t memory() const;
+        // Uma linha por nó, em pós-ordem
+        string to_string() const;
+};
+
+#endif
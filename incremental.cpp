@@ -0,0 +1,213 @@
+#include "incremental.h"
+#include "profile.h"
+#include <algorithm>
+#include <functional>
+
+// Simula a pilha do VM: cada instrução que empilha vira um nó com os nós do
+// topo como filhos. Os saltos não viram nós; marcam o AND_B/OR_B do fim da
+// direita como curto-circuito
+IncrementalExpression::IncrementalExpression(const CompiledExpression& expression)
+    : type(expression.get_type()), variables(expression.get_variables()), slots(variables.size(), 0) {
+    const Program& program = expression.get_program();
+    vector<bool> short_circuit(program.code.size() + 1, false);
+    vector<uint32_t> stack;
+    vector<uint32_t> counts(variables.size() + 1, 0);
+    nodes.reserve(program.code.size());
+
+    for (size_t i = 0; i < program.code.size(); i++) {
+        const Instruction& instruction = program.code[i];
+        Node node{instruction.op, false, instruction.operand, NO_NODE, NO_NODE, NO_NODE, 0, NO_NODE};
+        switch (instruction.op) {
+            case OpCode::PUSH_INT:
+            case OpCode::PUSH_BOOL:
+                break;
+            case OpCode::LOAD_I:
+            case OpCode::LOAD_B:
+                counts[instruction.operand + 1]++;
+                break;
+            case OpCode::NEG_I:
+                node.left = stack.back();
+                stack.pop_back();
+                break;
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE:
+                // O destino é a instrução depois do AND_B/OR_B
+                short_circuit[i + instruction.operand - 1] = true;
+                continue;
+            case OpCode::FAIL:
+                program.failures[instruction.operand].raise();
+            case OpCode::HALT:
+                i = program.code.size();
+                continue;
+            default:
+                node.right = stack.back();
+                stack.pop_back();
+                node.left = stack.back();
+                stack.pop_back();
+                if (short_circuit[i]) {
+                    node.op = instruction.op == OpCode::AND_B ? OpCode::JUMP_IF_FALSE : OpCode::JUMP_IF_TRUE;
+                }
+                break;
+        }
+        uint32_t id = static_cast<uint32_t>(nodes.size());
+        if (node.left != NO_NODE) nodes[node.left].parent = id;
+        if (node.right != NO_NODE) nodes[node.right].parent = id;
+        nodes.push_back(node);
+        stack.push_back(id);
+    }
+
+    // Os nós de cada slot, contíguos
+    for (size_t slot = 1; slot < counts.size(); slot++) counts[slot] += counts[slot - 1];
+    load_begin = counts;
+    loads.resize(counts.back());
+    for (uint32_t id = 0; id < nodes.size(); id++) {
+        if (nodes[id].op == OpCode::LOAD_I || nodes[id].op == OpCode::LOAD_B) {
+            loads[counts[nodes[id].operand]++] = id;
+        }
+    }
+
+    for (uint32_t id = 0; id < nodes.size(); id++) recompute(nodes[id], id);
+    recomputed = nodes.size();
+}
+
+void IncrementalExpression::mark(uint32_t id) {
+    if (nodes[id].queued) return;
+    nodes[id].queued = true;
+    dirty.push_back(id);
+    push_heap(dirty.begin(), dirty.end(), greater<uint32_t>());
+}
+
+// Como o VM: aritmética dando a volta, erro da esquerda antes do da direita
+// e, no curto-circuito (op JUMP_IF_FALSE para && e JUMP_IF_TRUE para ||), a
+// esquerda que decide ignora a direita
+bool IncrementalExpression::recompute(Node& node, uint32_t self) const {
+    int32_t value = 0;
+    uint32_t failed = NO_NODE;
+
+    switch (node.op) {
+        case OpCode::PUSH_INT:
+        case OpCode::PUSH_BOOL:
+            value = node.operand;
+            break;
+        case OpCode::LOAD_I:
+            value = slots[node.operand];
+            break;
+        case OpCode::LOAD_B:
+            value = slots[node.operand] != 0;
+            break;
+        case OpCode::NEG_I: {
+            const Node& operand = nodes[node.left];
+            failed = operand.failed;
+            value = static_cast<int32_t>(0u - static_cast<uint32_t>(operand.value));
+            break;
+        }
+        default: {
+            const Node& left = nodes[node.left];
+            const Node& right = nodes[node.right];
+            int32_t l = left.value, r = right.value;
+            uint32_t ul = static_cast<uint32_t>(l), ur = static_cast<uint32_t>(r);
+            if (left.failed != NO_NODE) {
+                failed = left.failed;
+                break;
+            }
+            if ((node.op == OpCode::JUMP_IF_FALSE && l == 0) || (node.op == OpCode::JUMP_IF_TRUE && l != 0)) {
+                value = l;
+                break;
+            }
+            if (right.failed != NO_NODE) {
+                failed = right.failed;
+                break;
+            }
+            switch (node.op) {
+                case OpCode::ADD_I: value = static_cast<int32_t>(ul + ur); break;
+                case OpCode::SUB_I: value = static_cast<int32_t>(ul - ur); break;
+                case OpCode::MUL_I: value = static_cast<int32_t>(ul * ur); break;
+                case OpCode::DIV_I:
+                    if (r == 0) {
+                        failed = self;
+                    } else {
+                        value = l / r;
+                    }
+                    break;
+                case OpCode::LT_I: value = l < r; break;
+                case OpCode::GT_I: value = l > r; break;
+                case OpCode::LE_I: value = l <= r; break;
+                case OpCode::GE_I: value = l >= r; break;
+                case OpCode::EQ_I:
+                case OpCode::EQ_B: value = l == r; break;
+                case OpCode::NE_I:
+                case OpCode::NE_B: value = l != r; break;
+                case OpCode::AND_B:
+                case OpCode::JUMP_IF_FALSE: value = l & r; break;
+                default: value = l | r; break;
+            }
+            break;
+        }
+    }
+
+    // Com erro o valor não importa: zerado, para não contar como mudança
+    if (failed != NO_NODE) value = 0;
+    bool changed = value != node.value || failed != node.failed;
+    node.value = value;
+    node.failed = failed;
+    return changed;
+}
+
+void IncrementalExpression::set(uint32_t slot, int32_t value) {
+    if (slot >= slots.size()) {
+        throw VariableError("Slot de variável inválido: " + to_string(slot));
+    }
+    if (slots[slot] == value) return;
+    slots[slot] = value;
+    for (uint32_t i = load_begin[slot]; i < load_begin[slot + 1]; i++) mark(loads[i]);
+}
+
+void IncrementalExpression::set(string_view name, int32_t value) {
+    const VariableInfo* variable = variables.find(name);
+    if (!variable) {
+        throw VariableError("Variável não declarada: " + string(name));
+    }
+    set(variable->slot, value);
+}
+
+void IncrementalExpression::assign(const int32_t* values) {
+    for (uint32_t slot = 0; slot < slots.size(); slot++) set(slot, values[slot]);
+}
+
+EvaluationResult IncrementalExpression::try_evaluate() {
+    EDOO_PROFILE_STAGE(ProfileStage::EVALUATE);
+    recomputed = 0;
+    while (!dirty.empty()) {
+        pop_heap(dirty.begin(), dirty.end(), greater<uint32_t>());
+        uint32_t id = dirty.back();
+        dirty.pop_back();
+        nodes[id].queued = false;
+        // Sobe direto enquanto o pai vem antes de todos os marcados (então
+        // os filhos dele já estão em dia), sem passar pelo heap
+        while (true) {
+            Node& node = nodes[id];
+            recomputed++;
+            // Valor igual: o pai não muda por causa deste nó
+            if (!recompute(node, id) || node.parent == NO_NODE) break;
+            if (!dirty.empty() && dirty.front() < node.parent) {
+                mark(node.parent);
+                break;
+            }
+            if (nodes[node.parent].queued) break;
+            id = node.parent;
+        }
+    }
+
+    const Node& root = nodes.back();
+    if (root.failed != NO_NODE) {
+        return EvaluationError(ErrorCode::DIVISION_BY_ZERO, static_cast<uint32_t>(nodes[root.failed].operand));
+    }
+    if (type == ValueType::BOOLEAN) return variant<int, bool>(root.value != 0);
+    return variant<int, bool>(root.value);
+}
+
+variant<int, bool> IncrementalExpression::evaluate() {
+    EvaluationResult result = try_evaluate();
+    if (!result) result.get_error().raise();
+    return result.get_value();
+}
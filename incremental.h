@@ -0,0 +1,88 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "compiled_expression.h"
+#include "errors.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+// Avaliação incremental de uma CompiledExpression para fluxos em que cada
+// evento muda poucas variáveis. O bytecode vira uma árvore de nós (um por
+// instrução que empilha um valor); cada nó guarda o último valor ou erro, e
+// cada variável sabe quais nós a leem. set() marca só esses nós; evaluate()
+// recalcula os marcados dos filhos para os pais e só sobe enquanto o valor
+// muda, então o custo é o do caminho alterado e não o do tamanho da regra.
+//
+// Os resultados e erros são os de CompiledExpression::evaluate com os mesmos
+// valores nos slots. Os dois lados de && e || ficam em dia (a direita que o
+// curto-circuito não avaliaria pode guardar um erro, que não é propagado),
+// para que mudar só a esquerda não obrigue a recalcular a direita.
+//
+// Sem locks: um por thread (ou por chave do fluxo)
+class IncrementalExpression {
+    public:
+        static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    private:
+        struct Node {
+            // A instrução que produz o valor; o operand dela (valor, slot ou
+            // posição do / para o erro)
+            OpCode op;
+            bool queued;
+            int32_t operand;
+            uint32_t left;
+            uint32_t right;
+            uint32_t parent;
+            int32_t value;
+            // NO_NODE, ou a divisão cujo erro este nó propaga
+            uint32_t failed;
+        };
+
+        vector<Node> nodes;
+        ValueType type;
+        Variables variables;
+        // Valores atuais, indexados pelo slot
+        vector<int32_t> slots;
+        // Nós LOAD de cada slot: loads[load_begin[s], load_begin[s + 1])
+        vector<uint32_t> load_begin;
+        vector<uint32_t> loads;
+        // Heap de mínimo dos nós marcados: os filhos vêm antes dos pais na
+        // ordem do bytecode, então o menor índice já tem os filhos em dia
+        vector<uint32_t> dirty;
+        size_t recomputed = 0;
+
+        void mark(uint32_t id);
+        // Recalcula o nó a partir dos filhos; true se o valor ou o erro mudou
+        bool recompute(Node& node, uint32_t self) const;
+
+    public:
+        // Lança o erro de compilação se o programa tiver um FAIL
+        // (ExpressionEvaluator::compile já rejeita programas mal tipados).
+        // Começa com todas as variáveis valendo zero (false), já avaliado
+        explicit IncrementalExpression(const CompiledExpression& expression);
+
+        // Muda uma variável (booleanos como 0/1). Só marca os nós; o
+        // recálculo fica para o próximo evaluate
+        void set(uint32_t slot, int32_t value);
+        // Pelo nome; lança VariableError se não houver a variável
+        void set(string_view name, int32_t value);
+        // Todos os slots de uma vez, no formato de CompiledExpression::evaluate
+        void assign(const int32_t* values);
+
+        // Recalcula os nós marcados e devolve o valor da raiz; lança como
+        // CompiledExpression::evaluate
+        variant<int, bool> evaluate();
+        EvaluationResult try_evaluate();
+
+        inline int32_t get(uint32_t slot) const { return slots[slot]; }
+        inline ValueType get_type() const { return type; }
+        inline const Variables& get_variables() const { return variables; }
+        // Nós da árvore e nós recalculados pelo último evaluate
+        inline size_t size() const { return nodes.size(); }
+        inline size_t get_recomputed() const { return recomputed; }
+};
+
+#endif
@@ -0,0 +1,363 @@
+#include "jit.h"
+#include "profile.h"
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__)) && !defined(EDOO_NO_JIT)
+#define EDOO_JIT 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define EDOO_JIT 0
+#endif
+
+JitCode::JitCode(JitCode&& other) noexcept : memory(other.memory), size(other.size), function(other.function) {
+    other.memory = nullptr;
+    other.size = 0;
+    other.function = nullptr;
+}
+
+JitCode& JitCode::operator=(JitCode&& other) noexcept {
+    swap(memory, other.memory);
+    swap(size, other.size);
+    swap(function, other.function);
+    return *this;
+}
+
+JitCode::~JitCode() {
+#if EDOO_JIT
+    if (memory) munmap(memory, size);
+#endif
+}
+
+bool JitCode::supported() {
+    return EDOO_JIT;
+}
+
+EvaluationError JitCode::error(const Program& program, uint32_t status) {
+    const Instruction& instruction = program.code[status - 1];
+    if (instruction.op == OpCode::FAIL) return program.failures[instruction.operand];
+    return EvaluationError(ErrorCode::DIVISION_BY_ZERO, static_cast<uint32_t>(instruction.operand));
+}
+
+variant<int, bool> JitCode::run(const Program& program, const int32_t* slots) const {
+    variant<int, bool> value;
+    EvaluationError e;
+    if (!try_run(program, slots, value, e)) e.raise();
+    return value;
+}
+
+#if EDOO_JIT
+
+// Números dos registradores na codificação x86-64
+enum Register : uint8_t {
+    EAX = 0, ECX = 1, EDX = 2, RSP = 4, RSI = 6, RDI = 7, R8 = 8
+};
+
+// Posições da pilha do VM que ficam em registradores (r8d a r11d); as outras
+// ficam em [rsp + 4 * (posição - STACK_REGISTERS)]
+constexpr size_t STACK_REGISTERS = 4;
+
+// Só as instruções que o gerador usa, com operandos de 32 bits
+class Assembler {
+    public:
+        vector<uint8_t> bytes;
+
+        inline void byte(uint8_t b) { bytes.push_back(b); }
+        inline void imm32(int32_t value) {
+            uint8_t raw[4];
+            memcpy(raw, &value, 4);
+            bytes.insert(bytes.end(), raw, raw + 4);
+        }
+        inline size_t here() const { return bytes.size(); }
+        // Preenche o rel32 em at para saltar até target
+        inline void patch(size_t at, size_t target) {
+            int32_t rel = static_cast<int32_t>(target - (at + 4));
+            memcpy(bytes.data() + at, &rel, 4);
+        }
+
+        // REX só quando algum registrador é r8-r15 (ou um byte baixo além de bl)
+        void rex(uint8_t reg, uint8_t rm, bool force = false) {
+            uint8_t prefix = 0x40 | ((reg >> 3) << 2) | (rm >> 3);
+            if (prefix != 0x40 || force) byte(prefix);
+        }
+        void modrm_reg(uint8_t reg, uint8_t rm) { byte(0xC0 | ((reg & 7) << 3) | (rm & 7)); }
+        // [base + disp32]
+        void modrm_mem(uint8_t reg, uint8_t base, int32_t disp) {
+            byte(0x80 | ((reg & 7) << 3) | (base & 7));
+            if ((base & 7) == RSP) byte(0x24);
+            imm32(disp);
+        }
+
+        // op r/m32, r32 (add 01, or 09, and 21, sub 29, cmp 39, mov 89, test 85)
+        void alu(uint8_t opcode, uint8_t dst, uint8_t src) {
+            rex(src, dst);
+            byte(opcode);
+            modrm_reg(src, dst);
+        }
+        void mov(uint8_t dst, uint8_t src) {
+            if (dst != src) alu(0x89, dst, src);
+        }
+        void load(uint8_t dst, uint8_t base, int32_t disp) {
+            rex(dst, base);
+            byte(0x8B);
+            modrm_mem(dst, base, disp);
+        }
+        void store(uint8_t base, int32_t disp, uint8_t src) {
+            rex(src, base);
+            byte(0x89);
+            modrm_mem(src, base, disp);
+        }
+        void mov_imm(uint8_t dst, int32_t value) {
+            rex(0, dst);
+            byte(0xB8 + (dst & 7));
+            imm32(value);
+        }
+        void imul(uint8_t dst, uint8_t src) {
+            rex(dst, src);
+            byte(0x0F);
+            byte(0xAF);
+            modrm_reg(dst, src);
+        }
+        void neg(uint8_t reg) {
+            rex(0, reg);
+            byte(0xF7);
+            modrm_reg(3, reg);
+        }
+        // dst = condição (0/1), com os flags de um cmp ou test
+        void set(uint8_t condition, uint8_t dst) {
+            rex(0, dst, dst >= RSP);
+            byte(0x0F);
+            byte(0x90 | condition);
+            modrm_reg(0, dst);
+            rex(dst, dst, dst >= RSP);
+            byte(0x0F);
+            byte(0xB6);
+            modrm_reg(dst, dst);
+        }
+        // jcc rel32 / jmp rel32; devolvem a posição do rel32
+        size_t jump_if(uint8_t condition) {
+            byte(0x0F);
+            byte(0x80 | condition);
+            imm32(0);
+            return here() - 4;
+        }
+        size_t jump() {
+            byte(0xE9);
+            imm32(0);
+            return here() - 4;
+        }
+        void stack_adjust(bool grow, int32_t amount) {
+            byte(0x48);
+            byte(0x81);
+            byte(grow ? 0xEC : 0xC4);  // sub rsp / add rsp
+            imm32(amount);
+        }
+};
+
+// Códigos de condição
+enum Condition : uint8_t {
+    CC_E = 0x4, CC_NE = 0x5, CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF
+};
+
+// Gera o código de uma instrução por vez; a posição de cada valor da pilha é
+// conhecida na compilação, como em Compiler::emit
+class CodeGenerator {
+    private:
+        const Program& program;
+        Assembler out;
+        size_t depth = 0;
+        // Saídas com status: a posição do rel32 e o status devolvido
+        vector<pair<size_t, uint32_t>> failures;
+        // Saltos do curto-circuito: a posição do rel32 e a instrução de destino
+        vector<pair<size_t, size_t>> jumps;
+
+        inline bool in_register(size_t position) const { return position < STACK_REGISTERS; }
+        inline int32_t spill(size_t position) const { return static_cast<int32_t>(4 * (position - STACK_REGISTERS)); }
+
+        // Registrador com o valor da posição; se ela estiver na memória,
+        // carrega em scratch
+        uint8_t read(size_t position, uint8_t scratch) {
+            if (in_register(position)) return static_cast<uint8_t>(R8 + position);
+            out.load(scratch, RSP, spill(position));
+            return scratch;
+        }
+        void write(size_t position, uint8_t reg) {
+            if (in_register(position)) {
+                out.mov(static_cast<uint8_t>(R8 + position), reg);
+            } else {
+                out.store(RSP, spill(position), reg);
+            }
+        }
+        // Registrador onde montar o valor novo da posição
+        inline uint8_t target(size_t position) const {
+            return in_register(position) ? static_cast<uint8_t>(R8 + position) : static_cast<uint8_t>(EAX);
+        }
+
+        void push(uint8_t reg) { write(depth++, reg); }
+
+        // a = a op b nas duas posições do topo
+        template <typename Emit>
+        void binary(Emit emit) {
+            size_t left = depth - 2;
+            uint8_t a = read(left, EAX);
+            uint8_t b = read(depth - 1, ECX);
+            emit(a, b);
+            write(left, a);
+            depth--;
+        }
+        void compare(uint8_t condition) {
+            binary([&](uint8_t a, uint8_t b) {
+                out.alu(0x39, a, b);
+                out.set(condition, a);
+            });
+        }
+
+    public:
+        explicit CodeGenerator(const Program& program) : program(program) {}
+
+        vector<uint8_t> generate();
+};
+
+vector<uint8_t> CodeGenerator::generate() {
+    const vector<Instruction>& code = program.code;
+    size_t frame = 0;
+    if (program.max_stack > STACK_REGISTERS) {
+        // O código não chama nada, então não precisa alinhar rsp
+        frame = (program.max_stack - STACK_REGISTERS) * 4;
+        out.stack_adjust(true, static_cast<int32_t>(frame));
+    }
+
+    vector<size_t> native(code.size() + 1);
+    size_t halt = SIZE_MAX;
+    for (size_t i = 0; i < code.size(); i++) {
+        native[i] = out.here();
+        const Instruction& instruction = code[i];
+        switch (instruction.op) {
+            case OpCode::PUSH_INT:
+            case OpCode::PUSH_BOOL: {
+                uint8_t reg = target(depth);
+                out.mov_imm(reg, instruction.operand);
+                push(reg);
+                break;
+            }
+            case OpCode::LOAD_I: {
+                uint8_t reg = target(depth);
+                out.load(reg, RDI, instruction.operand * 4);
+                push(reg);
+                break;
+            }
+            case OpCode::LOAD_B: {
+                uint8_t reg = target(depth);
+                out.load(reg, RDI, instruction.operand * 4);
+                out.alu(0x85, reg, reg);
+                out.set(CC_NE, reg);
+                push(reg);
+                break;
+            }
+            case OpCode::NEG_I: {
+                uint8_t reg = read(depth - 1, EAX);
+                out.neg(reg);
+                write(depth - 1, reg);
+                break;
+            }
+            case OpCode::ADD_I: binary([&](uint8_t a, uint8_t b) { out.alu(0x01, a, b); }); break;
+            case OpCode::SUB_I: binary([&](uint8_t a, uint8_t b) { out.alu(0x29, a, b); }); break;
+            case OpCode::MUL_I: binary([&](uint8_t a, uint8_t b) { out.imul(a, b); }); break;
+            case OpCode::AND_B: binary([&](uint8_t a, uint8_t b) { out.alu(0x21, a, b); }); break;
+            case OpCode::OR_B:  binary([&](uint8_t a, uint8_t b) { out.alu(0x09, a, b); }); break;
+            case OpCode::DIV_I: {
+                // idiv usa edx:eax; edx não guarda nenhuma posição
+                size_t left = depth - 2;
+                out.mov(ECX, read(depth - 1, ECX));
+                out.alu(0x85, ECX, ECX);
+                failures.push_back({out.jump_if(CC_E), static_cast<uint32_t>(i + 1)});
+                out.mov(EAX, read(left, EAX));
+                out.byte(0x99);                       // cdq
+                out.byte(0xF7);                       // idiv ecx
+                out.modrm_reg(7, ECX);
+                write(left, EAX);
+                depth--;
+                break;
+            }
+            case OpCode::LT_I: compare(CC_L); break;
+            case OpCode::GT_I: compare(CC_G); break;
+            case OpCode::LE_I: compare(CC_LE); break;
+            case OpCode::GE_I: compare(CC_GE); break;
+            case OpCode::EQ_I:
+            case OpCode::EQ_B: compare(CC_E); break;
+            case OpCode::NE_I:
+            case OpCode::NE_B: compare(CC_NE); break;
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE: {
+                uint8_t reg = read(depth - 1, EAX);
+                out.alu(0x85, reg, reg);
+                size_t at = out.jump_if(instruction.op == OpCode::JUMP_IF_FALSE ? CC_E : CC_NE);
+                jumps.push_back({at, i + instruction.operand});
+                break;
+            }
+            case OpCode::FAIL:
+                out.mov_imm(EAX, static_cast<int32_t>(i + 1));
+                failures.push_back({out.jump(), 0});
+                // O resto do programa é inalcançável
+                depth = 0;
+                break;
+            case OpCode::HALT:
+                if (depth > 0) {
+                    out.mov(EAX, read(depth - 1, EAX));
+                    out.store(RSI, 0, EAX);
+                }
+                out.alu(0x31, EAX, EAX);              // xor eax, eax
+                halt = out.here();
+                if (frame) out.stack_adjust(false, static_cast<int32_t>(frame));
+                out.byte(0xC3);                       // ret
+                break;
+        }
+    }
+    native[code.size()] = out.here();
+
+    for (const auto& [at, instruction] : jumps) {
+        out.patch(at, native[instruction]);
+    }
+    // DIV_I saltam para um mov eax, status antes da saída; FAIL já o fez
+    for (const auto& [at, status] : failures) {
+        if (status == 0) {
+            out.patch(at, halt);
+            continue;
+        }
+        out.patch(at, out.here());
+        out.mov_imm(EAX, static_cast<int32_t>(status));
+        out.patch(out.jump(), halt);
+    }
+    return move(out.bytes);
+}
+
+JitCode JitCode::compile(const Program& program) {
+    EDOO_PROFILE_STAGE(ProfileStage::COMPILER);
+    JitCode jit;
+    if (program.code.empty() || program.code.back().op != OpCode::HALT) return jit;
+    if (program.max_stack > MAX_STACK) return jit;
+
+    vector<uint8_t> bytes = CodeGenerator(program).generate();
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t size = (bytes.size() + page - 1) / page * page;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return jit;
+    memcpy(memory, bytes.data(), bytes.size());
+    // Nunca gravável e executável ao mesmo tempo
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return jit;
+    }
+    jit.memory = memory;
+    jit.size = size;
+    jit.function = reinterpret_cast<Function>(memory);
+    return jit;
+}
+
+#else
+
+JitCode JitCode::compile(const Program&) {
+    return JitCode();
+}
+
+#endif
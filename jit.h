@@ -0,0 +1,71 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "bytecode.h"
+#include <cstddef>
+#include <cstdint>
+using namespace std;
+
+// Compilação do bytecode de um Program para código de máquina x86-64, em
+// páginas obtidas com mmap (escritas e depois trocadas para só leitura e
+// execução). As posições da pilha do VM viram registradores (as quatro
+// primeiras) e espaço na pilha do processo (as outras); os saltos do
+// curto-circuito viram saltos condicionais. Sem x86-64 System V, sem mmap ou
+// com EDOO_NO_JIT, compile devolve um JitCode vazio e quem o usa fica com o
+// VirtualMachine
+class JitCode {
+    public:
+        // slots: valores das variáveis, como no VirtualMachine. Devolve 0 com o
+        // valor (booleanos como 0/1) em *out, ou 1 + o índice da instrução que
+        // falhou (DIV_I com divisor zero ou FAIL); ver error
+        using Function = uint32_t (*)(const int32_t* slots, int32_t* out);
+
+    private:
+        void* memory = nullptr;
+        size_t size = 0;
+        Function function = nullptr;
+
+    public:
+        JitCode() = default;
+        JitCode(const JitCode&) = delete;
+        JitCode& operator=(const JitCode&) = delete;
+        JitCode(JitCode&& other) noexcept;
+        JitCode& operator=(JitCode&& other) noexcept;
+        ~JitCode();
+
+        // Posições da pilha do VM que o código nativo aceita: as que não
+        // cabem nos registradores vão para a pilha da thread, reservadas de
+        // uma vez na entrada e sem sondar página a página. Até aqui são menos
+        // de 4 KB, abaixo da página de guarda; acima, compile devolve um
+        // JitCode vazio e a avaliação fica no VM, que aloca a pilha no heap
+        static constexpr size_t MAX_STACK = 1024;
+
+        // Se esta plataforma gera código
+        static bool supported();
+        static JitCode compile(const Program& program);
+
+        inline explicit operator bool() const { return function != nullptr; }
+        inline Function get_function() const { return function; }
+        inline size_t code_size() const { return size; }
+
+        // O erro que o VM daria para um status diferente de 0 da função
+        static EvaluationError error(const Program& program, uint32_t status);
+
+        // Mesmo contrato de VirtualMachine::try_run e run para o mesmo program
+        inline bool try_run(const Program& program, const int32_t* slots, variant<int, bool>& out, EvaluationError& e) const {
+            int32_t value;
+            if (uint32_t status = function(slots, &value)) {
+                e = error(program, status);
+                return false;
+            }
+            if (program.result_type == ValueType::BOOLEAN) {
+                out = value != 0;
+            } else {
+                out = value;
+            }
+            return true;
+        }
+        variant<int, bool> run(const Program& program, const int32_t* slots) const;
+};
+
+#endif
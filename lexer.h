@@ -2,6 +2,10 @@
 #define LEXER_H
 
 #include "token.h"
+#include "errors.h"
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
 using namespace std;
 
 class LexerError : public runtime_error {
@@ -9,31 +13,130 @@ class LexerError : public runtime_error {
         explicit LexerError(const string& message) : runtime_error("Erro léxico: " + message) {}
 };
 
+// Classes de caracteres do locale "C", como isspace, isdigit e isalpha, mas
+// constexpr
+constexpr bool is_space_char(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+constexpr bool is_digit_char(char c) { return c >= '0' && c <= '9'; }
+constexpr bool is_alpha_char(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+constexpr bool is_identifier_char(char c) { return is_alpha_char(c) || is_digit_char(c) || c == '_'; }
+
+struct ScannedToken {
+    Token token;
+    ErrorCode error;
+    size_t error_offset;
+};
+
+// Inteiro em text[start, pos), com o '-' opcional em start, com os mesmos
+// erros que from_chars daria
+constexpr ErrorCode scan_integer(string_view text, size_t start, size_t pos, int32_t& value) {
+    bool negative = text[start] == '-';
+    size_t first = start + (negative ? 1 : 0);
+    if (first == pos) return ErrorCode::INVALID_INTEGER;
+    int64_t magnitude = 0;
+    for (size_t i = first; i < pos; i++) {
+        magnitude = magnitude * 10 + (text[i] - '0');
+        if (magnitude > int64_t(INT32_MAX) + 1) return ErrorCode::INTEGER_OUT_OF_RANGE;
+    }
+    if (!negative && magnitude > INT32_MAX) return ErrorCode::INTEGER_OUT_OF_RANGE;
+    value = static_cast<int32_t>(negative ? -magnitude : magnitude);
+    return ErrorCode::NONE;
+}
+
+// As regras léxicas da linguagem: o próximo token de text a partir de pos,
+// que fica logo depois dele. Um '\0' encerra a entrada. Com um erro, devolve
+// END_OF_FILE e o código e a posição do erro. Usada pelo Lexer e pela
+// avaliação em tempo de compilação (constant_expression.h)
+constexpr ScannedToken scan_token(string_view text, size_t& pos) {
+    auto at = [&](size_t i) { return i < text.size() ? text[i] : '\0'; };
+    auto token = [&](TokenType type, size_t start, int32_t value = 0) {
+        return ScannedToken{Token(type, start, pos - start, value), ErrorCode::NONE, 0};
+    };
+    auto integer = [&](size_t start) {
+        while (is_digit_char(at(pos))) pos++;
+        int32_t value = 0;
+        ErrorCode error = scan_integer(text, start, pos, value);
+        if (error != ErrorCode::NONE) return ScannedToken{Token(TokenType::END_OF_FILE, pos, 0), error, start};
+        return token(TokenType::INTEGER, start, value);
+    };
+
+    while (is_space_char(at(pos))) pos++;
+    size_t start = pos;
+    char c = at(pos);
+    if (c == '\0') return token(TokenType::END_OF_FILE, start);
+
+    // Números inteiros; '-' seguido de algo que não é espaço também
+    if (is_digit_char(c)) return integer(start);
+    if (c == '-') {
+        pos++;
+        if (is_space_char(at(pos))) return token(TokenType::MINUS, start);
+        return integer(start);
+    }
+
+    // Booleanos e identificadores
+    if (is_alpha_char(c) || c == '_') {
+        while (is_identifier_char(at(pos))) pos++;
+        string_view word = text.substr(start, pos - start);
+        if (word == "true") return token(TokenType::BOOLEAN, start, 1);
+        if (word == "false") return token(TokenType::BOOLEAN, start, 0);
+        return token(TokenType::IDENTIFIER, start);
+    }
+
+    // Um caractere
+    TokenType single = TokenType::END_OF_FILE;
+    switch (c) {
+        case '+': single = TokenType::PLUS; break;
+        case '*': single = TokenType::MULTIPLY; break;
+        case '/': single = TokenType::DIVIDE; break;
+        case '(': single = TokenType::LPAREN; break;
+        case ')': single = TokenType::RPAREN; break;
+        default: break;
+    }
+    if (single != TokenType::END_OF_FILE) {
+        pos++;
+        return token(single, start);
+    }
+
+    // Dois caracteres: ||, &&, ==, != e, opcionalmente, <= e >=
+    char next = at(pos + 1);
+    TokenType pair = TokenType::END_OF_FILE;
+    if (c == '|' && next == '|') pair = TokenType::OR;
+    if (c == '&' && next == '&') pair = TokenType::AND;
+    if (c == '=' && next == '=') pair = TokenType::EQUALS;
+    if (c == '!' && next == '=') pair = TokenType::NOT_EQUALS;
+    if (c == '<') pair = next == '=' ? TokenType::LESS_EQUAL : TokenType::LESS;
+    if (c == '>') pair = next == '=' ? TokenType::GREATER_EQUAL : TokenType::GREATER;
+    if (pair != TokenType::END_OF_FILE) {
+        pos += (pair == TokenType::LESS || pair == TokenType::GREATER) ? 1 : 2;
+        return token(pair, start);
+    }
+
+    return ScannedToken{Token(TokenType::END_OF_FILE, pos, 0), ErrorCode::UNKNOWN_TOKEN, start};
+}
+
+// O Lexer não copia a entrada: o texto apontado pelo string_view
+// precisa continuar vivo enquanto houver tokens sendo lidos.
+// get_next_token lança LexerError; next_token não lança: no primeiro erro
+// guarda o EvaluationError e passa a devolver END_OF_FILE
 class Lexer {
     private:
-        string text;
+        string_view text;
         size_t pos;
-        char current_char;
-
-        void error(const string& message);
-        void advance();
-        void skip_whitespace();
-        int integer(string result = "");
-        bool boolean();
-        inline bool is_end() { return current_char == '\0'; }
-        inline bool next_char(char expected) {
-            if (pos + 1 >= text.length()) return false;
-            return text[pos + 1] == expected;
-        }
+        EvaluationError failure;
+
+        void fail(ErrorCode code, size_t offset);
 
     public:
-        explicit Lexer(string input) : text(input), pos(0) {
-            current_char = (text.empty()) ? '\0' : text[0];
+        explicit Lexer(string_view input) : text(input), pos(0) {
             if (text.empty()){
-                error("Input vazio");
+                fail(ErrorCode::EMPTY_INPUT, 0);
+                failure.raise();
             }
         }
         Token get_next_token();
+        Token next_token();
+        inline bool failed() const { return static_cast<bool>(failure); }
+        inline const EvaluationError& get_error() const { return failure; }
+        inline string_view get_text() const { return text; }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,30 +1,383 @@
 #include "parser.h"
+#include "thread_pool.h"
+#include "fast_io.h"
+#include "stream.h"
+#include "profile.h"
+#include "rule_file.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <mutex>
 using namespace std;
 
-int main(){
-    int cases; cin >> cases;
+// Avalia uma linha (o texto ou os tokens dela num TokenBuffer) e acrescenta
+// a saída dela em output. Com o bytecode ou o ExpressionDag e sem cache,
+// linhas inválidas não passam por exceções (try_evaluate)
+template <typename Input>
+static void evaluate_line(ExpressionEvaluator& evaluator, const Input& input, string& output) {
+    try{
+        if ((evaluator.get_engine() == Engine::BYTECODE || evaluator.get_dag()) && !evaluator.get_cache()) {
+            EvaluationResult result = evaluator.try_evaluate(input);
+            if (result) {
+                append_result(output, result.get_value());
+            } else {
+                output += "error\n";
+            }
+        } else {
+            append_result(output, evaluator.evaluate(input));
+        }
+    } catch(exception&){
+        output += "error\n";
+    }
+    evaluator.reset();
+}
+
+// Totais do --dedup, somados ao fim de cada lote
+struct DedupTotals {
+    uint64_t occurrences = 0;
+    uint64_t distinct = 0;
+    size_t peak_memory = 0;
+
+    void add(const DedupTotals& other) {
+        occurrences += other.occurrences;
+        distinct += other.distinct;
+        peak_memory = max(peak_memory, other.peak_memory);
+    }
+};
+
+// Fecha o lote do ExpressionDag do avaliador, se houver: cada lote
+// compartilha as subexpressões só dentro dele
+static void end_batch(ExpressionEvaluator& evaluator, DedupTotals& totals) {
+    if (const auto& dag = evaluator.get_dag()) {
+        ExpressionDag::Statistics statistics = dag->statistics();
+        totals.add({statistics.occurrences, statistics.distinct, statistics.memory});
+        dag->clear();
+    }
+}
+
+static shared_ptr<ExpressionDag> make_dag(bool dedup) {
+    return dedup ? make_shared<ExpressionDag>() : nullptr;
+}
+
+// Linhas por tarefa do pool (e por lote do --dedup)
+constexpr size_t CHUNK_LINES = 1024;
+// Bytes da entrada tokenizados de uma vez no --fast-io sequencial
+constexpr size_t BLOCK_BYTES = 1 << 16;
+
+// Divide as linhas em blocos avaliados pelo pool, cada thread com o próprio
+// ExpressionEvaluator (e arena) e TokenBuffer, que tokeniza o bloco inteiro
+// antes de avaliá-lo. As saídas dos blocos vão para write na ordem da
+// entrada assim que ficam prontas, então a saída é igual à sequencial. Se
+// um bloco lança, a escrita para nele e a exceção sai de pool.wait()
+static void evaluate_parallel(const vector<string_view>& lines, size_t threads, Engine engine, bool optimize,
+                              const shared_ptr<ResultCache>& cache, bool dedup, DedupTotals& totals,
+                              const function<void(const string&)>& write) {
+    WorkStealingPool pool(threads);
+    vector<unique_ptr<ExpressionEvaluator>> evaluators;
+    for (size_t i = 0; i < pool.size(); i++) {
+        evaluators.push_back(make_unique<ExpressionEvaluator>(engine, optimize));
+        evaluators.back()->set_cache(cache);
+        evaluators.back()->set_dag(make_dag(dedup));
+    }
+    vector<TokenBuffer> buffers(pool.size());
+    vector<DedupTotals> worker_totals(pool.size());
+
+    size_t chunks = (lines.size() + CHUNK_LINES - 1) / CHUNK_LINES;
+    vector<string> outputs(chunks);
+    vector<char> done(chunks, false);
+    bool failed = false;
+    mutex lock;
+    condition_variable ready;
+
+    // Marca o bloco como pronto ao sair da tarefa, também por exceção, para
+    // o laço de escrita não esperar para sempre
+    struct ChunkDone {
+        size_t chunk;
+        vector<char>& done;
+        bool& failed;
+        mutex& lock;
+        condition_variable& ready;
+        int exceptions = uncaught_exceptions();
+
+        ~ChunkDone() {
+            {
+                lock_guard<mutex> guard(lock);
+                done[chunk] = true;
+                if (uncaught_exceptions() > exceptions) failed = true;
+            }
+            ready.notify_all();
+        }
+    };
+
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        pool.submit([&, chunk](size_t worker) {
+            ChunkDone finish{chunk, done, failed, lock, ready};
+            EDOO_PROFILE_TRACE("bloco");
+            size_t begin = chunk * CHUNK_LINES;
+            size_t end = min(begin + CHUNK_LINES, lines.size());
+            TokenBuffer& tokens = buffers[worker];
+            tokens.clear();
+            for (size_t i = begin; i < end; i++) {
+                tokens.add_line(lines[i]);
+            }
+            string output;
+            for (size_t i = 0; i < tokens.size(); i++) {
+                evaluate_line(*evaluators[worker], tokens.line(i), output);
+            }
+            end_batch(*evaluators[worker], worker_totals[worker]);
+            lock_guard<mutex> guard(lock);
+            outputs[chunk] = move(output);
+        });
+    }
+
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        string output;
+        {
+            unique_lock<mutex> guard(lock);
+            ready.wait(guard, [&] { return done[chunk] || failed; });
+            if (failed) break;
+            output = move(outputs[chunk]);
+        }
+        write(output);
+    }
+    pool.wait();
+    for (const auto& worker : worker_totals) totals.add(worker);
+}
+
+// Lê a entrada inteira de uma vez (mmap ou blocos grandes), tokeniza blocos
+// de linhas dela com o TokenBuffer e escreve a saída com poucas chamadas a
+// write
+static void evaluate_fast_io(const string& path, bool parallel, size_t threads, Engine engine, bool optimize,
+                             const shared_ptr<ResultCache>& cache, bool dedup, DedupTotals& totals) {
+    unique_ptr<MappedInput> input = path.empty() ? make_unique<MappedInput>(0) : make_unique<MappedInput>(path);
+    LineReader reader(input->contents());
+    BufferedOutput output;
+
+    int cases = 0;
+    reader.read_int(cases);
     // Ignora a newline ao ler cases
-    cin.ignore();
+    reader.ignore();
+
+    if (parallel) {
+        vector<string_view> lines(max(cases, 0));
+        for (auto& line : lines) line = reader.next_line();
+        evaluate_parallel(lines, threads, engine, optimize, cache, dedup, totals,
+                          [&](const string& text) { output.append(text); });
+    } else {
+        ExpressionEvaluator evaluator(engine, optimize);
+        evaluator.set_cache(cache);
+        evaluator.set_dag(make_dag(dedup));
+        TokenBuffer tokens;
+        size_t left = max(cases, 0);
+        while (left > 0) {
+            EDOO_PROFILE_TRACE("bloco");
+            tokens.clear();
+            tokens.add_lines(reader.next_block(BLOCK_BYTES));
+            if (tokens.size() == 0) {
+                // Acabou o texto antes dos casos: como getline, linhas vazias
+                for (; left > 0; left--) {
+                    evaluate_line(evaluator, string_view(), output.data());
+                    output.maybe_flush();
+                }
+                break;
+            }
+            size_t count = min(tokens.size(), left);
+            for (size_t i = 0; i < count; i++) {
+                evaluate_line(evaluator, tokens.line(i), output.data());
+                output.maybe_flush();
+            }
+            end_batch(evaluator, totals);
+            left -= count;
+        }
+    }
+    output.flush();
+}
+
+// Escreve o resumo do profiler (stderr) e o trace quando main termina, por
+// qualquer caminho. A taxa do --dedup não precisa do build instrumentado
+class ProfileReport {
+    private:
+        bool summary;
+        string trace_path;
+        const DedupTotals* dedup;
 
-    ExpressionEvaluator evaluator;
-    
-    for (int i = 1; i <= cases; i++){
-        string input; getline(cin, input);
+    public:
+        ProfileReport(bool summary, string trace_path, const DedupTotals* dedup)
+            : summary(summary), trace_path(move(trace_path)), dedup(dedup) {
+#ifndef EDOO_PROFILE
+            if (this->summary || !this->trace_path.empty()) {
+                cerr << "--profile e --trace precisam de um build com -DEDOO_PROFILE\n";
+            }
+#endif
+        }
+        ~ProfileReport() {
+            if (summary && dedup) {
+                cerr << "Subexpressões: " << dedup->occurrences << " nós, " << dedup->distinct << " distintos ("
+                     << (dedup->distinct ? static_cast<double>(dedup->occurrences) / dedup->distinct : 1.0)
+                     << "x), até " << dedup->peak_memory << " bytes por lote\n";
+            }
+#ifdef EDOO_PROFILE
+            if (summary) Profiler::write_summary(cerr);
+            if (!trace_path.empty()) {
+                ofstream file(trace_path);
+                if (file) {
+                    Profiler::write_trace(file);
+                } else {
+                    cerr << "Não foi possível escrever " << trace_path << '\n';
+                }
+            }
+#endif
+        }
+};
 
-        try{
-            auto result = evaluator.evaluate(input);
+// Mais threads que isso só disputam os núcleos e a memória das saídas
+constexpr size_t MAX_THREADS = 256;
 
-            if (holds_alternative<int>(result)) {
-                cout << get<int>(result);
+// Argumento de --threads: só dígitos, limitado a MAX_THREADS
+static bool parse_threads(const string& text, size_t& threads) {
+    if (text.empty() || text.find_first_not_of("0123456789") != string::npos) return false;
+    // Sem stoul em números enormes, que lançaria out_of_range
+    threads = text.size() > 9 ? MAX_THREADS : min<size_t>(stoul(text), MAX_THREADS);
+    return true;
+}
+
+// Compila um arquivo de regras em texto (formato de RuleFileWriter::add_source)
+// para o formato binário lido por RuleFile
+static int compile_rules(const string& source, const string& output) {
+    try {
+        MappedInput input(source);
+        RuleFileWriter writer;
+        writer.add_source(input.contents());
+        writer.write(output);
+        cout << writer.size() << " regras e " << writer.get_variables().size() << " variáveis em " << output << '\n';
+    } catch (const exception& e) {
+        cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]){
+    // --bytecode avalia pelo VirtualMachine em vez da árvore
+    // --typed checa os tipos antes e avalia pelos nós tipados
+    // --flat avalia pela FlatExpression (a árvore em arrays, em pós-ordem)
+    // --optimize passa a árvore pelo Optimizer antes
+    // --cache guarda os resultados de expressões repetidas
+    // --dedup avalia cada lote de linhas por um ExpressionDag, uma vez por
+    // subexpressão distinta (com --profile, a taxa de deduplicação vai para
+    // stderr)
+    // --threads N avalia em blocos por N threads (0: uma por núcleo; no
+    // máximo MAX_THREADS)
+    // --fast-io lê a entrada com mmap e escreve em blocos (--input arquivo
+    // lê do arquivo em vez de stdin)
+    // --stream lê linhas até o fim da entrada, sem o número de casos
+    // --profile escreve contadores por estágio, operador e erro em stderr
+    // no final; --trace arquivo grava os blocos avaliados no formato
+    // trace-event do Chrome (os dois só num build com -DEDOO_PROFILE)
+    // --compile fonte saida compila as regras de fonte para um arquivo
+    // binário carregado por RuleFile, e sai
+    Engine engine = Engine::TREE;
+    bool optimize = false;
+    bool cached = false;
+    bool dedup = false;
+    bool parallel = false;
+    size_t threads = 0;
+    bool fast_io = false;
+    bool streaming = false;
+    string path;
+    bool profile = false;
+    string trace_path;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--bytecode") engine = Engine::BYTECODE;
+        if (arg == "--typed") engine = Engine::TYPED;
+        if (arg == "--flat") engine = Engine::FLAT;
+        if (arg == "--optimize") optimize = true;
+        if (arg == "--cache") cached = true;
+        if (arg == "--dedup") dedup = true;
+        if (arg == "--threads" && i + 1 < argc) {
+            parallel = true;
+            if (!parse_threads(argv[++i], threads)) {
+                cerr << "--threads espera um número de threads (0: uma por núcleo)\n";
+                return 1;
             }
-            else if (holds_alternative<bool>(result)) {
-                cout << (get<bool>(result) ? "true" : "false");
+        }
+        if (arg == "--fast-io") fast_io = true;
+        if (arg == "--stream") streaming = true;
+        if (arg == "--input" && i + 1 < argc) {
+            fast_io = true;
+            path = argv[++i];
+        }
+        if (arg == "--profile") profile = true;
+        if (arg == "--trace" && i + 1 < argc) trace_path = argv[++i];
+        if (arg == "--compile" && i + 2 < argc) return compile_rules(argv[i + 1], argv[i + 2]);
+    }
+    DedupTotals totals;
+    ProfileReport report(profile, trace_path, dedup ? &totals : nullptr);
+
+    shared_ptr<ResultCache> cache;
+    if (cached) {
+        cache = make_shared<ResultCache>();
+    }
+
+    if (streaming) {
+        try {
+            int fd = 0;
+            if (!path.empty()) {
+                fd = open(path.c_str(), O_RDONLY);
+                if (fd < 0) throw IOError("Não foi possível abrir " + path);
             }
-            cout << '\n';
+            BufferedOutput output;
+            StreamPipeline(optimize).run(fd, output);
+            if (fd != 0) close(fd);
+        } catch (const IOError& e) {
+            cerr << e.what() << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    if (fast_io) {
+        try {
+            evaluate_fast_io(path, parallel, threads, engine, optimize, cache, dedup, totals);
+        } catch (const IOError& e) {
+            cerr << e.what() << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    int cases; cin >> cases;
+    // Ignora a newline ao ler cases
+    cin.ignore();
+
+    if (parallel) {
+        vector<string> lines(max(cases, 0));
+        for (auto& line : lines) getline(cin, line);
+        vector<string_view> views(lines.begin(), lines.end());
+        evaluate_parallel(views, threads, engine, optimize, cache, dedup, totals, [](const string& text) { cout << text; });
+        return 0;
+    }
+
+    ExpressionEvaluator evaluator(engine, optimize);
+    evaluator.set_cache(cache);
+    evaluator.set_dag(make_dag(dedup));
+
+    string output;
+    for (int begin = 0; begin < cases; begin += CHUNK_LINES) {
+        EDOO_PROFILE_TRACE("bloco");
+        int end = min<int>(begin + CHUNK_LINES, cases);
+        for (int i = begin; i < end; i++){
+            string input; getline(cin, input);
 
-        } catch(exception&){
-            cout << "error" << '\n';
-        }   
+            output.clear();
+            evaluate_line(evaluator, input, output);
+            cout << output;
+        }
+        end_batch(evaluator, totals);
     }
     return 0;
-}
\ No newline at end of file
+}
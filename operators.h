@@ -0,0 +1,52 @@
+#ifndef OPERATORS_H
+#define OPERATORS_H
+
+#include "token.h"
+#include <array>
+#include <cstdint>
+using namespace std;
+
+enum class Associativity : uint8_t { LEFT, RIGHT };
+
+// Linha da tabela de operadores binários. binding_power == 0 indica que
+// o token não é um operador binário (e encerra o laço do parser)
+struct BinaryOperatorInfo {
+    const char* symbol;
+    uint8_t binding_power;
+    Associativity associativity;
+};
+
+constexpr size_t TOKEN_TYPE_COUNT = static_cast<size_t>(TokenType::END_OF_FILE) + 1;
+
+// Precedência, da menor para a maior:
+// ||  <  &&  <  == !=  <  < > <= >=  <  + -  <  * /
+constexpr array<BinaryOperatorInfo, TOKEN_TYPE_COUNT> make_binary_operator_table() {
+    array<BinaryOperatorInfo, TOKEN_TYPE_COUNT> table{};
+    for (auto& entry : table) {
+        entry = {"", 0, Associativity::LEFT};
+    }
+    table[static_cast<size_t>(TokenType::OR)]            = {"||", 1, Associativity::LEFT};
+    table[static_cast<size_t>(TokenType::AND)]           = {"&&", 2, Associativity::LEFT};
+    table[static_cast<size_t>(TokenType::EQUALS)]        = {"==", 3, Associativity::LEFT};
+    table[static_cast<size_t>(TokenType::NOT_EQUALS)]    = {"!=", 3, Associativity::LEFT};
+    table[static_cast<size_t>(TokenType::LESS)]          = {"<",  4, Associativity::LEFT};
+    table[static_cast<size_t>(TokenType::GREATER)]       = {">",  4, Associativity::LEFT};
+    table[static_cast<size_t>(TokenType::LESS_EQUAL)]    = {"<=", 4, Associativity::LEFT};
+    table[static_cast<size_t>(TokenType::GREATER_EQUAL)] = {">=", 4, Associativity::LEFT};
+    table[static_cast<size_t>(TokenType::PLUS)]          = {"+",  5, Associativity::LEFT};
+    table[static_cast<size_t>(TokenType::MINUS)]         = {"-",  5, Associativity::LEFT};
+    table[static_cast<size_t>(TokenType::MULTIPLY)]      = {"*",  6, Associativity::LEFT};
+    table[static_cast<size_t>(TokenType::DIVIDE)]        = {"/",  6, Associativity::LEFT};
+    return table;
+}
+
+inline constexpr auto BINARY_OPERATORS = make_binary_operator_table();
+
+constexpr const BinaryOperatorInfo& binary_operator(TokenType type) {
+    return BINARY_OPERATORS[static_cast<size_t>(type)];
+}
+
+// Menor binding power aceito por parse_exp (qualquer operador binário)
+constexpr uint8_t LOWEST_BINDING_POWER = 1;
+
+#endif
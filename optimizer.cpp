@@ -0,0 +1,142 @@
+#include "optimizer.h"
+#include "profile.h"
+
+static const Expression& unwrap(const Expression& expression) {
+    const Expression* current = &expression;
+    while (auto primary = dynamic_cast<const PrimaryExpression*>(current)) {
+        current = &primary->get_expression();
+    }
+    return *current;
+}
+
+static const Literal* as_literal(const ExpressionPtr& expression) {
+    return dynamic_cast<const Literal*>(expression.get());
+}
+
+static bool is_int_literal(const ExpressionPtr& expression, int value) {
+    auto literal = as_literal(expression);
+    return literal && holds_alternative<int>(literal->get_value()) && get<int>(literal->get_value()) == value;
+}
+
+static bool is_bool_literal(const ExpressionPtr& expression, bool value) {
+    auto literal = as_literal(expression);
+    return literal && holds_alternative<bool>(literal->get_value()) && get<bool>(literal->get_value()) == value;
+}
+
+ExpressionPtr Optimizer::optimize(const Expression& expression) {
+    EDOO_PROFILE_STAGE(ProfileStage::OPTIMIZER);
+    ValueType type;
+    return rewrite(expression, type);
+}
+
+ExpressionPtr Optimizer::rewrite(const Expression& expression, ValueType& type) {
+    expression.accept(*this);
+    type = result_type;
+    return move(result);
+}
+
+ExpressionPtr Optimizer::make_literal(variant<int, bool> value) {
+    return arena_new<Literal>(arena, value);
+}
+
+// Só é chamado quando todos os filhos já são literais: avaliar custa O(1).
+// Expressões que dariam erro (tipo inválido, divisão por zero) ficam como
+// estão, para o erro aparecer na avaliação; assim otimizar não lança
+ExpressionPtr Optimizer::fold(ExpressionPtr expression, bool valid) {
+    if (!valid || result_type == ValueType::INVALID) {
+        return expression;
+    }
+    return make_literal(expression->evaluate());
+}
+
+void Optimizer::visit(const Literal& expression) {
+    const auto& value = expression.get_value();
+    result_type = holds_alternative<int>(value) ? ValueType::INTEGER : ValueType::BOOLEAN;
+    result = make_literal(value);
+}
+
+void Optimizer::visit(const Variable& expression) {
+    result_type = expression.get_type();
+    result = arena_new<Variable>(arena, expression.get_name(), expression.get_slot(), expression.get_type(), &arena,
+                                 expression.get_offset());
+}
+
+void Optimizer::visit(const PrimaryExpression& expression) {
+    ValueType type;
+    result = rewrite(expression.get_expression(), type);
+    result_type = type;
+}
+
+void Optimizer::visit(const UnaryExpression& expression) {
+    string_view operador = expression.get_operator();
+
+    // - ( - x ) com x inteiro
+    if (operador == "-") {
+        auto inner = dynamic_cast<const UnaryExpression*>(&unwrap(expression.get_expression()));
+        if (inner && inner->get_operator() == "-") {
+            ValueType type;
+            auto operand = rewrite(inner->get_expression(), type);
+            if (type == ValueType::INTEGER) {
+                result = move(operand);
+                result_type = ValueType::INTEGER;
+                return;
+            }
+            auto negated = arena_new<UnaryExpression>(arena, "-", move(operand), &arena, inner->get_offset());
+            result = arena_new<UnaryExpression>(arena, "-", move(negated), &arena, expression.get_offset());
+            result_type = ValueType::INVALID;
+            return;
+        }
+    }
+
+    ValueType type;
+    auto operand = rewrite(expression.get_expression(), type);
+    bool constant = as_literal(operand) != nullptr;
+
+    result_type = unary_result_type(operador, type);
+    result = arena_new<UnaryExpression>(arena, operador, move(operand), &arena, expression.get_offset());
+    if (constant) {
+        result = fold(move(result), true);
+    }
+}
+
+void Optimizer::visit(const BinaryExpression& expression) {
+    string_view operador = expression.get_operator();
+
+    ValueType left_type, right_type;
+    auto left = rewrite(expression.get_left(), left_type);
+    auto right = rewrite(expression.get_right(), right_type);
+    result_type = binary_result_type(operador, left_type, right_type);
+
+    if (as_literal(left) && as_literal(right)) {
+        bool valid = !(operador == "/" && is_int_literal(right, 0));
+        result = fold(arena_new<BinaryExpression>(arena, move(left), operador, move(right), &arena, expression.get_offset()), valid);
+        return;
+    }
+
+    // Identidades: só quando os tipos batem, para não esconder erros de tipo
+    if (result_type != ValueType::INVALID) {
+        if ((operador == "*" && is_int_literal(right, 1))
+         || (operador == "/" && is_int_literal(right, 1))
+         || (operador == "+" && is_int_literal(right, 0))
+         || (operador == "-" && is_int_literal(right, 0))
+         || (operador == "&&" && is_bool_literal(right, true))
+         || (operador == "||" && is_bool_literal(right, false))) {
+            result = move(left);
+            return;
+        }
+        // Curto-circuito: a direita nem seria avaliada
+        if ((operador == "&&" && is_bool_literal(left, false))
+         || (operador == "||" && is_bool_literal(left, true))) {
+            result = move(left);
+            return;
+        }
+        if ((operador == "*" && is_int_literal(left, 1))
+         || (operador == "+" && is_int_literal(left, 0))
+         || (operador == "&&" && is_bool_literal(left, true))
+         || (operador == "||" && is_bool_literal(left, false))) {
+            result = move(right);
+            return;
+        }
+    }
+    result = arena_new<BinaryExpression>(arena, move(left), operador, move(right), &arena, expression.get_offset());
+}
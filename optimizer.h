@@ -0,0 +1,37 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "expressions.h"
+using namespace std;
+
+// Reescreve a árvore em uma nova, alocada na arena:
+// - subárvores constantes viram um Literal
+// - PrimaryExpression (parênteses) some
+// - - ( - x ) vira x
+// - x * 1, x / 1, x + 0, x - 0, true && x, false || x (e simétricos) viram x
+// - false && x e true || x, com x booleano, viram o literal (curto-circuito)
+// Subárvores cuja avaliação falha (ex: 1 / 0) não são dobradas, então o
+// erro continua acontecendo na avaliação, com a mesma mensagem
+class Optimizer : private ExpressionVisitor {
+    private:
+        pmr::memory_resource& arena;
+        ExpressionPtr result;
+        ValueType result_type = ValueType::INVALID;
+
+        ExpressionPtr rewrite(const Expression& expression, ValueType& type);
+        ExpressionPtr make_literal(variant<int, bool> value);
+        ExpressionPtr fold(ExpressionPtr expression, bool valid);
+
+        void visit(const Literal& expression) override;
+        void visit(const Variable& expression) override;
+        void visit(const PrimaryExpression& expression) override;
+        void visit(const UnaryExpression& expression) override;
+        void visit(const BinaryExpression& expression) override;
+
+    public:
+        explicit Optimizer(pmr::memory_resource& arena) : arena(arena) {}
+
+        ExpressionPtr optimize(const Expression& expression);
+};
+
+#endif
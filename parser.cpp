@@ -1,162 +1,366 @@
 #include "parser.h"
+#include "profile.h"
+#include "shunting_yard.h"
+#include <algorithm>
+#ifdef __linux__
+#include <pthread.h>
+#endif
 
-void Parser::error(const string& message) {
-    throw ParserError("Erro de sintaxe: " + message);
+#ifdef EDOO_PROFILE
+static ErrorCategory exception_category(const exception& e) {
+    if (dynamic_cast<const LexerError*>(&e)) return ErrorCategory::LEXICAL;
+    if (dynamic_cast<const ParserError*>(&e)) return ErrorCategory::SYNTAX;
+    if (dynamic_cast<const TypeError*>(&e)) return ErrorCategory::TYPE;
+    if (dynamic_cast<const ExpressionError*>(&e)) return ErrorCategory::EVALUATION;
+    return ErrorCategory::INPUT;
 }
+#endif
 
-void Parser::advance(const string& expected_type) {
-    if (current_token.get_type() != expected_type) {
-        error("Esperado " + expected_type + ", obteve " + current_token.get_type());
+ExpressionPtr Parser::fail(ErrorCode code, TokenType found, TokenType expected) {
+    if (!failure) {
+        failure = EvaluationError(code, current_token.get_offset());
+        failure.found = found;
+        failure.expected = expected;
     }
-    current_token = lexer.get_next_token();
+    return nullptr;
 }
 
-variant<int, bool> Parser::evaluate() {
-    auto expr = parse_exp();
-    return expr->evaluate();
+Parser::Parser(const TokenLine& line, pmr::memory_resource& arena, const Variables* variables)
+    : lexer(line.text), current_token(*line.tokens), arena(arena), variables(variables), cursor(line.tokens), last(line.last) {
+    if (line.error != ErrorCode::NONE) {
+        line_error = EvaluationError(line.error, line.error_offset);
+    }
+    // O erro já no primeiro token, como o Lexer daria no construtor
+    if (cursor == last) failure = line_error;
 }
 
-unique_ptr<Expression> Parser::parse_exp() {
-    return parse_or_exp();
+bool Parser::advance(TokenType expected_type) {
+    if (current_token.get_type() != expected_type) {
+        fail(ErrorCode::EXPECTED_TOKEN, current_token.get_type(), expected_type);
+        return false;
+    }
+    if (cursor) {
+        if (cursor != last) ++cursor;
+        current_token = *cursor;
+        if (cursor == last && line_error) {
+            if (!failure) failure = line_error;
+            return false;
+        }
+    } else {
+        current_token = lexer.next_token();
+        if (lexer.failed()) {
+            if (!failure) failure = lexer.get_error();
+            return false;
+        }
+    }
+    EDOO_PROFILE_TOKEN();
+    return true;
 }
 
-unique_ptr<Expression> Parser::parse_or_exp() {
-    auto e1 = parse_and_exp();
+// A API com exceções lança o erro que o núcleo guardou
+ExpressionPtr Parser::checked(ExpressionPtr expr) {
+    if (!expr) failure.raise();
+    return expr;
+}
 
-    if (current_token.get_type() == "OR") {
-        advance("OR");
-        auto e2 = parse_and_exp();
-        return make_unique<BinaryExpression>(move(e1), "||", move(e2));
-    }
-    return e1;
+size_t recursive_depth_limit() {
+#ifdef __linux__
+    // Fim da pilha da thread, uma vez por thread (na principal, pelo
+    // RLIMIT_STACK); 0 se não der para saber
+    thread_local const char* stack_end = [] {
+        const char* end = nullptr;
+        pthread_attr_t attr;
+        if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+            void* address;
+            size_t size;
+            if (pthread_attr_getstack(&attr, &address, &size) == 0) end = static_cast<const char*>(address);
+            pthread_attr_destroy(&attr);
+        }
+        return end;
+    }();
+    if (!stack_end) return MAX_RECURSIVE_DEPTH;
+    // Folga para o que roda na ponta da recursão (lançar exceções, alocar)
+    constexpr size_t RESERVE = 64 * 1024;
+    char here;
+    size_t available = static_cast<size_t>(&here - stack_end);
+    if (available <= RESERVE) return 0;
+    return min(MAX_RECURSIVE_DEPTH, (available - RESERVE) / STACK_PER_LEVEL);
+#else
+    return MAX_RECURSIVE_DEPTH;
+#endif
+}
+
+variant<int, bool> Parser::evaluate() {
+    auto expr = parse();
+    return depth <= recursive_depth_limit() ? expr->evaluate() : evaluate_tree(*expr);
 }
 
-unique_ptr<Expression> Parser::parse_and_exp() {
-    auto e1 = parse_eq_exp();
+ExpressionPtr Parser::parse() {
+    return checked(try_parse());
+}
 
-    if (current_token.get_type() == "AND") {
-        advance("AND");
-        auto e2 = parse_eq_exp();
-        return make_unique<BinaryExpression>(move(e1), "&&", move(e2));
+ExpressionPtr Parser::try_parse() {
+    EDOO_PROFILE_STAGE(ProfileStage::PARSER);
+    auto expr = expression(LOWEST_BINDING_POWER, true);
+    if (expr && current_token.get_type() != TokenType::END_OF_FILE) {
+        expr = fail(ErrorCode::TRAILING_TOKEN, current_token.get_type());
     }
-    return e1;
+    EDOO_PROFILE_TOKENS();
+    if (expr) EDOO_PROFILE_DEPTH(operator_depth);
+    return expr;
 }
 
-unique_ptr<Expression> Parser::parse_eq_exp() {
-    auto e1 = parse_rel_exp();
+ExpressionPtr Parser::parse_exp() {
+    return checked(expression(LOWEST_BINDING_POWER, true));
+}
 
-    map<string, string> operadores = {
-        {"EQUALS", "=="},
-        {"NOT_EQUALS", "!="}
-    };
+ExpressionPtr Parser::parse_binary_exp(uint8_t min_binding_power) {
+    return checked(expression(min_binding_power, true));
+}
 
-    if (operadores.find(current_token.get_type()) != operadores.end()) {
-        string operador = operadores[current_token.get_type()];
-        advance(current_token.get_type());
+// Sem operadores binários fora de parênteses
+ExpressionPtr Parser::parse_unary_exp() {
+    return checked(expression(UINT8_MAX, true));
+}
 
-        auto e2 = parse_rel_exp();
-        return make_unique<BinaryExpression>(move(e1), operador, move(e2));
-    }
-    return e1;
+ExpressionPtr Parser::parse_primary_exp() {
+    return checked(expression(UINT8_MAX, false));
 }
 
-unique_ptr<Expression> Parser::parse_rel_exp() {
-    auto e1 = parse_add_exp();
+// parse_expression (shunting_yard.h) com ações que montam os nós na arena
+ExpressionPtr Parser::expression(uint8_t min_binding_power, bool allow_unary) {
+    if (failure) return nullptr;
 
-    map<string, string> operadores = {
-        {"LESS", "<"},
-        {"GREATER", ">"},
-        {"LESS_EQUAL", "<="},
-        {"GREATER_EQUAL", ">="}
+    // depth conta todos os nós do caminho; operator_depth só os operadores
+    // (folha = 1), que é a profundidade que o profiler mostra
+    struct Operand {
+        ExpressionPtr expression;
+        uint32_t depth;
+        uint32_t operator_depth;
     };
+    // As pilhas ficam num buffer local e só passam para a arena em entradas
+    // profundas, para não intercalar a memória delas com a dos nós
+    alignas(max_align_t) byte buffer[2048];
+    pmr::monotonic_buffer_resource stacks(buffer, sizeof(buffer), &arena);
 
-    if (operadores.find(current_token.get_type()) != operadores.end()) {
-        string operador = operadores[current_token.get_type()];
-        advance(current_token.get_type());
+    struct TreeGrammar {
+        Parser& parser;
+        pmr::vector<Operand> operands;
+        pmr::vector<PendingOperator> pending;
 
-        auto e2 = parse_add_exp();
-        return make_unique<BinaryExpression>(move(e1), operador, move(e2));
-    }
-    return e1;
-}
+        TokenType token() const { return parser.current_token.get_type(); }
+        uint32_t token_offset() const { return static_cast<uint32_t>(parser.current_token.get_offset()); }
+        bool advance(TokenType type) { return parser.advance(type); }
+        bool primary() {
+            auto leaf = parser.primary();
+            if (!leaf) return false;
+            operands.push_back({move(leaf), 2, 1});
+            return true;
+        }
 
-unique_ptr<Expression> Parser::parse_add_exp() {
-    auto e1 = parse_mul_exp();
+        void push_pending(const PendingOperator& op) { pending.push_back(op); }
+        void pop_pending() { pending.pop_back(); }
+        bool has_pending() const { return !pending.empty(); }
+        const PendingOperator& top_pending() const { return pending.back(); }
 
-    map<string, string> operadores = {
-        {"PLUS", "+"},
-        {"MINUS", "-"}
-    };
+        void reduce(const PendingOperator& op) {
+            Operand right = move(operands.back());
+            operands.pop_back();
+            Operand& left = operands.back();
+            left.expression = arena_new<BinaryExpression>(parser.arena, move(left.expression), binary_operator(op.op).symbol,
+                                                          move(right.expression), &parser.arena, op.offset);
+            left.depth = max(left.depth, right.depth) + 1;
+            left.operator_depth = max(left.operator_depth, right.operator_depth) + 1;
+        }
+        void negate(uint32_t offset) {
+            Operand& operand = operands.back();
+            operand.expression = arena_new<UnaryExpression>(parser.arena, "-", move(operand.expression), &parser.arena, offset);
+            operand.depth++;
+            operand.operator_depth++;
+        }
+        void group() {
+            Operand& group = operands.back();
+            group.expression = arena_new<PrimaryExpression>(parser.arena, move(group.expression), true);
+            group.depth++;
+        }
+    } grammar{*this, pmr::vector<Operand>(&stacks), pmr::vector<PendingOperator>(&stacks)};
+    grammar.operands.reserve(32);
+    grammar.pending.reserve(32);
+
+    if (!parse_expression(grammar, min_binding_power, allow_unary)) return nullptr;
+    depth = grammar.operands.back().depth;
+    operator_depth = grammar.operands.back().operator_depth;
+    return move(grammar.operands.back().expression);
+}
+
+// Só os primários sem parênteses: literais e variáveis
+ExpressionPtr Parser::primary() {
+    Token token = current_token;
 
-    if (operadores.find(current_token.get_type()) != operadores.end()) {
-        string operador = operadores[current_token.get_type()];
-        advance(current_token.get_type());
+    if (token.get_type() == TokenType::INTEGER) {
+        if (!advance(TokenType::INTEGER)) return nullptr;
+        return arena_new<PrimaryExpression>(arena, arena_new<Literal>(arena, token.get_int()));
+    }
+    if (token.get_type() == TokenType::BOOLEAN) {
+        if (!advance(TokenType::BOOLEAN)) return nullptr;
+        return arena_new<PrimaryExpression>(arena, arena_new<Literal>(arena, token.get_bool()));
+    }
 
-        auto e2 = parse_mul_exp();
-        return make_unique<BinaryExpression>(move(e1), operador, move(e2));
+    if (token.get_type() == TokenType::IDENTIFIER) {
+        if (!advance(TokenType::IDENTIFIER)) return nullptr;
+        string_view name = token.get_text(lexer.get_text());
+        size_t offset = token.get_offset();
+        if (!variables) {
+            return arena_new<PrimaryExpression>(arena, arena_new<Variable>(arena, name, Variable::UNRESOLVED, ValueType::INVALID, &arena, offset));
+        }
+        const VariableInfo* variable = variables->find(name);
+        if (!variable) {
+            fail(ErrorCode::UNDECLARED_VARIABLE, token.get_type());
+            failure.offset = static_cast<uint32_t>(offset);
+            failure.detail = string(name);
+            return nullptr;
+        }
+        return arena_new<PrimaryExpression>(arena, arena_new<Variable>(arena, name, variable->slot, variable->type, &arena, offset));
     }
-    return e1;
+
+    return fail(ErrorCode::UNEXPECTED_TOKEN, token.get_type());
 }
 
-unique_ptr<Expression> Parser::parse_mul_exp() {
-    auto e1 = parse_unary_exp();
+variant<int, bool> ExpressionEvaluator::evaluate(string_view input_expression) {
+    return evaluate_input(input_expression, nullptr);
+}
 
-    map<string, string> operadores = {
-        {"MULTIPLY", "*"},
-        {"DIVIDE", "/"}
-    };
+variant<int, bool> ExpressionEvaluator::evaluate(const TokenLine& line) {
+    return evaluate_input(line.text, &line);
+}
 
-    if (operadores.find(current_token.get_type()) != operadores.end()) {
-        string operador = operadores[current_token.get_type()];
-        advance(current_token.get_type());
+variant<int, bool> ExpressionEvaluator::evaluate_input(string_view input_expression, const TokenLine* line) {
+#ifdef EDOO_PROFILE
+    try {
+        return evaluate_cached(input_expression, line);
+    } catch (const exception& e) {
+        Profiler::record_error(exception_category(e));
+        throw;
+    }
+#else
+    return evaluate_cached(input_expression, line);
+#endif
+}
 
-        auto e2 = parse_unary_exp();
-        return make_unique<BinaryExpression>(move(e1), operador, move(e2));
+variant<int, bool> ExpressionEvaluator::evaluate_cached(string_view input_expression, const TokenLine* line) {
+    if (input_expression.empty()) {
+        throw invalid_argument("Expressão vazia");
+    }
+    if (!cache) {
+        return evaluate_uncached(input_expression, line);
+    }
+
+    // Erros também vão para o cache e são relançados nas próximas vezes
+    string key = ResultCache::canonical_key(input_expression);
+    CachedResult cached;
+    if (cache->lookup(key, cached)) {
+        if (cached.error) rethrow_exception(cached.error);
+        return cached.value;
+    }
+    try {
+        auto value = evaluate_uncached(input_expression, line);
+        cache->insert(key, {value, nullptr});
+        return value;
+    } catch (const exception&) {
+        cache->insert(key, {0, current_exception()});
+        throw;
     }
-    return e1;
 }
 
-unique_ptr<Expression> Parser::parse_unary_exp() {
-    if (current_token.get_type() == "MINUS") {
-        advance("MINUS");
-        auto e1 = parse_primary_exp();
-        return make_unique<UnaryExpression>("-", move(e1));
+variant<int, bool> ExpressionEvaluator::evaluate_uncached(string_view input_expression, const TokenLine* line) {
+    Parser parser = line ? Parser(*line, arena) : Parser(Lexer(input_expression), arena);
+
+    auto expr = parser.parse();
+    if (dag) {
+        EvaluationResult result = dag->result(dag->intern(*expr), *expr);
+        if (!result) result.get_error().raise();
+        return result.get_value();
+    }
+    bool shallow = parser.get_depth() <= recursive_depth_limit();
+    if (optimize && shallow) {
+        expr = Optimizer(arena).optimize(*expr);
     }
-    return parse_primary_exp();
+    if (engine == Engine::BYTECODE) {
+        compiler.compile(*expr, program);
+        return VirtualMachine::run(program);
+    }
+    if (engine == Engine::FLAT) {
+        flat.assign(*expr);
+        return flat.evaluate();
+    }
+    if (engine == Engine::TYPED && shallow) {
+        TypedExpression typed = [&] {
+            EDOO_PROFILE_STAGE(ProfileStage::COMPILER);
+            return TypeChecker(arena).check_and_rewrite(*expr);
+        }();
+        EDOO_PROFILE_STAGE(ProfileStage::EVALUATE);
+        return typed.evaluate();
+    }
+    EDOO_PROFILE_STAGE(ProfileStage::EVALUATE);
+    return shallow ? expr->evaluate() : evaluate_tree(*expr);
 }
 
-unique_ptr<Expression> Parser::parse_primary_exp() {
-    Token token = current_token;
+EvaluationResult ExpressionEvaluator::try_evaluate(string_view input_expression) {
+    return try_evaluate_input(input_expression, nullptr);
+}
 
-    if (token.get_type() == "INTEGER" || token.get_type() == "BOOLEAN") {
-        advance(token.get_type());
-        auto value = token.get_value();
+EvaluationResult ExpressionEvaluator::try_evaluate(const TokenLine& line) {
+    return try_evaluate_input(line.text, &line);
+}
 
-        if (holds_alternative<int>(value)) {
-            return make_unique<PrimaryExpression>(make_unique<Literal>(get<int>(value)));
-        } 
-        else if (holds_alternative<bool>(value)) {
-            return make_unique<PrimaryExpression>(make_unique<Literal>(get<bool>(value)));
-        }
-        throw ParserError("Tipo de Literal não suportado");
+EvaluationResult ExpressionEvaluator::try_evaluate_input(string_view input_expression, const TokenLine* line) {
+    if (input_expression.empty()) {
+        EDOO_PROFILE_ERROR(ErrorCode::EMPTY_EXPRESSION);
+        return EvaluationError(ErrorCode::EMPTY_EXPRESSION, 0);
     }
+    Parser parser = line ? Parser(*line, arena) : Parser(Lexer(input_expression), arena);
 
-    if (token.get_type() == "LPAREN") {
-        advance("LPAREN");
-        auto e1 = parse_exp();
-        advance("RPAREN");
-        return make_unique<PrimaryExpression>(move(e1));
+    auto expr = parser.try_parse();
+    if (!expr) {
+        EDOO_PROFILE_ERROR(parser.get_error().code);
+        return parser.get_error();
     }
+    if (dag) {
+        EvaluationResult result = dag->result(dag->intern(*expr), *expr);
+        if (!result) EDOO_PROFILE_ERROR(result.get_error().code);
+        return result;
+    }
+    if (optimize && parser.get_depth() <= recursive_depth_limit()) {
+        expr = Optimizer(arena).optimize(*expr);
+    }
+    compiler.compile(*expr, program);
 
-    error("Token inesperado: " + token.get_type());
-    return nullptr;
+    variant<int, bool> value;
+    EvaluationError error;
+    if (!VirtualMachine::try_run(program, nullptr, value, error)) {
+        EDOO_PROFILE_ERROR(error.code);
+        return error;
+    }
+    return value;
 }
 
-variant<int, bool> ExpressionEvaluator::evaluate(const string& input_expression) {
+CompiledExpression ExpressionEvaluator::compile(string_view input_expression, const Variables& variables) {
     if (input_expression.empty()) {
         throw invalid_argument("Expressão vazia");
     }
     Lexer lexer(input_expression);
-    Parser parser(lexer);
-    return parser.evaluate();
+    Parser parser(lexer, arena, &variables);
+
+    auto expr = parser.parse();
+    if (parser.get_depth() <= recursive_depth_limit()) {
+        expr = Optimizer(arena).optimize(*expr);
+    }
+    Program compiled = compiler.compile(*expr);
+    expr.reset();
+    reset();
+
+    if (compiled.result_type == ValueType::INVALID) {
+        throw TypeError(compiled.failures.front().message());
+    }
+    return CompiledExpression(move(compiled), variables);
 }
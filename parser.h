@@ -2,8 +2,18 @@
 #define PARSER_H
 
 #include "lexer.h"
+#include "token_buffer.h"
 #include "expressions.h"
-#include <map>
+#include "bytecode.h"
+#include "optimizer.h"
+#include "typecheck.h"
+#include "result_cache.h"
+#include "variables.h"
+#include "compiled_expression.h"
+#include "expression_dag.h"
+#include "flat_expression.h"
+#include "errors.h"
+#include "operators.h"
 #include <memory>
 
 class ParserError : public runtime_error {
@@ -11,35 +21,139 @@ class ParserError : public runtime_error {
         explicit ParserError(const string& message) : runtime_error(message) {}
 };
 
+// O Parser, o Compiler e a destruição da árvore não usam a pilha do processo
+// para a profundidade. O evaluate() dos nós, Optimizer e TypeChecker são
+// recursivos e só recebem árvores até recursive_depth_limit() (em nós);
+// acima dela a árvore é avaliada por evaluate_tree, sem otimização e, no
+// motor tipado, sem a checagem de tipos. O limite sai da pilha que ainda
+// resta na thread que chama, a STACK_PER_LEVEL bytes por nível (o pior dos
+// passes: TypeChecker mais a avaliação tipada, medido com ulimit -s), e
+// nunca passa de MAX_RECURSIVE_DEPTH
+constexpr size_t MAX_RECURSIVE_DEPTH = 10000;
+#ifdef __OPTIMIZE__
+constexpr size_t STACK_PER_LEVEL = 256;
+#else
+constexpr size_t STACK_PER_LEVEL = 1024;
+#endif
+size_t recursive_depth_limit();
+
+// parse_* lançam LexerError/ParserError. try_parse não lança: devolve
+// nullptr e deixa o erro (o primeiro, do Lexer ou do Parser) em get_error.
+// Os tokens vêm do Lexer, um por vez, ou de uma linha já tokenizada de um
+// TokenBuffer; os dois dão as mesmas árvores e os mesmos erros
 class Parser {
     private:
         Lexer lexer;
         Token current_token;
+        pmr::memory_resource& arena;
+        const Variables* variables;
+        EvaluationError failure;
+
+        // Com uma TokenLine: o token atual, o END_OF_FILE do fim e o erro
+        // léxico que o Lexer daria ao chegar nele
+        const Token* cursor = nullptr;
+        const Token* last = nullptr;
+        EvaluationError line_error;
+
+        // Profundidade da última árvore lida: nós do caminho mais longo e,
+        // para o profiler, só os operadores desse caminho
+        size_t depth = 0;
+        size_t operator_depth = 0;
 
-        void error(const string& message);
-        void advance(const string& expected_type);
+        // Núcleo sem exceções e sem recursão: nullptr depois do primeiro erro
+        ExpressionPtr fail(ErrorCode code, TokenType found, TokenType expected = TokenType::END_OF_FILE);
+        bool advance(TokenType expected_type);
+        ExpressionPtr expression(uint8_t min_binding_power, bool allow_unary);
+        ExpressionPtr primary();
+        ExpressionPtr checked(ExpressionPtr expr);
 
     public:
-        explicit Parser(const Lexer& l) : lexer(l), current_token(lexer.get_next_token()) {}
+        // Os nós da árvore são alocados em arena, que deve sobreviver a eles.
+        // Com variables, identificadores são resolvidos para slots e tipos
+        // (e um nome não declarado é erro de sintaxe)
+        explicit Parser(const Lexer& l, pmr::memory_resource& arena, const Variables* variables = nullptr)
+            : lexer(l), current_token(lexer.next_token()), arena(arena), variables(variables), failure(lexer.get_error()) {}
+        // Lê de uma linha de um TokenBuffer, que deve sobreviver ao Parser.
+        // Como o Lexer, lança LexerError se a linha for vazia
+        explicit Parser(const TokenLine& line, pmr::memory_resource& arena, const Variables* variables = nullptr);
         ~Parser() = default;
 
         variant<int, bool> evaluate();
-        unique_ptr<Expression> parse_exp();
-        unique_ptr<Expression> parse_or_exp();
-        unique_ptr<Expression> parse_and_exp();
-        unique_ptr<Expression> parse_eq_exp();
-        unique_ptr<Expression> parse_rel_exp();
-        unique_ptr<Expression> parse_add_exp();
-        unique_ptr<Expression> parse_mul_exp();
-        unique_ptr<Expression> parse_unary_exp();
-        unique_ptr<Expression> parse_primary_exp();
+        // Expressão completa: rejeita tokens depois do fim da expressão
+        ExpressionPtr parse();
+        ExpressionPtr try_parse();
+        ExpressionPtr parse_exp();
+        ExpressionPtr parse_binary_exp(uint8_t min_binding_power);
+        ExpressionPtr parse_unary_exp();
+        ExpressionPtr parse_primary_exp();
+
+        inline const EvaluationError& get_error() const { return failure; }
+        inline size_t get_depth() const { return depth; }
+};
+
+// Motor usado por ExpressionEvaluator::evaluate
+enum class Engine {
+    TREE,       // Expression::evaluate sobre a árvore
+    BYTECODE,   // Compiler + VirtualMachine
+    TYPED,      // TypeChecker + nós monomórficos
+    FLAT        // FlatExpression: a árvore em arrays, numa varredura
 };
 
 class ExpressionEvaluator {
+    private:
+        Arena arena;
+        Engine engine;
+        bool optimize;
+        Compiler compiler;
+        Program program;
+        FlatExpression flat;
+        shared_ptr<ResultCache> cache;
+        shared_ptr<ExpressionDag> dag;
+
+        // Com line, os tokens vêm dela em vez do Lexer
+        variant<int, bool> evaluate_input(string_view input_expression, const TokenLine* line);
+        variant<int, bool> evaluate_cached(string_view input_expression, const TokenLine* line);
+        variant<int, bool> evaluate_uncached(string_view input_expression, const TokenLine* line);
+        EvaluationResult try_evaluate_input(string_view input_expression, const TokenLine* line);
+
     public:
-        ExpressionEvaluator() {}
+        explicit ExpressionEvaluator(Engine engine = Engine::TREE, bool optimize = false)
+            : engine(engine), optimize(optimize) {}
         ~ExpressionEvaluator() = default;
-        static variant<int, bool> evaluate(const string& input_expression);
+        variant<int, bool> evaluate(string_view input_expression);
+        // Como evaluate, mas sem exceções: erros de leitura e de avaliação
+        // voltam no resultado com código e posição, e a mensagem só é montada
+        // se pedida. Sempre avalia pelo bytecode (mesmos resultados e erros
+        // dos outros motores, ou pelo ExpressionDag, se houver) e não usa o
+        // cache
+        EvaluationResult try_evaluate(string_view input_expression);
+        // O mesmo para uma linha já tokenizada por um TokenBuffer
+        variant<int, bool> evaluate(const TokenLine& line);
+        EvaluationResult try_evaluate(const TokenLine& line);
+
+        // Lê, otimiza e compila uma vez; a CompiledExpression resultante não
+        // depende da arena (que é liberada no final) e pode ser avaliada
+        // muitas vezes. Lança TypeError se a expressão for mal tipada
+        CompiledExpression compile(string_view input_expression, const Variables& variables);
+
+        inline Engine get_engine() const { return engine; }
+        inline void set_engine(Engine e) { engine = e; }
+        // Passa a árvore pelo Optimizer antes de avaliar/compilar
+        inline bool get_optimize() const { return optimize; }
+        inline void set_optimize(bool o) { optimize = o; }
+        // Cache de resultados opcional, que pode ser compartilhado entre
+        // avaliadores de threads diferentes; nullptr desliga
+        inline const shared_ptr<ResultCache>& get_cache() const { return cache; }
+        inline void set_cache(shared_ptr<ResultCache> c) { cache = move(c); }
+        // Com um ExpressionDag, as árvores lidas entram nele e o resultado
+        // sai dos nós compartilhados, no lugar do motor (e do Optimizer). Quem
+        // o passa chama clear() entre lotes; nullptr desliga
+        inline const shared_ptr<ExpressionDag>& get_dag() const { return dag; }
+        inline void set_dag(shared_ptr<ExpressionDag> d) { dag = move(d); }
+
+        // Descarta de uma vez tudo o que foi alocado desde o último reset;
+        // deve ser chamado entre linhas (ou lotes) de entrada
+        inline void reset() { arena.reset(); }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "profile.h"
+
+// Sem -DEDOO_PROFILE nada aqui é chamado; nem entra no binário
+#ifdef EDOO_PROFILE
+
+#include <iomanip>
+#include <mutex>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Mesma ordem de ProfileStage
+static const char* const STAGE_NAMES[PROFILE_STAGE_COUNT] = {
+    "outros", "lexer", "parser", "optimizer", "compilador", "avaliação"
+};
+
+// O menos unário fica no fim, separado do binário
+static const char* const OPERATOR_SYMBOLS[PROFILE_OPERATOR_COUNT] = {
+    "+", "-", "*", "/", "<", ">", "<=", ">=", "==", "!=", "&&", "||", "- (unário)"
+};
+
+const char* profile_stage_name(ProfileStage stage) {
+    return STAGE_NAMES[static_cast<size_t>(stage)];
+}
+
+static mutex registry_mutex;
+static vector<unique_ptr<ProfileData>> registry;
+static const uint64_t start_time_us = Profiler::now_us();
+
+ProfileData& Profiler::local() {
+    thread_local ProfileData* data = [] {
+        lock_guard<mutex> lock(registry_mutex);
+        registry.push_back(make_unique<ProfileData>());
+        registry.back()->thread_id = static_cast<uint32_t>(registry.size());
+        return registry.back().get();
+    }();
+    return *data;
+}
+
+uint64_t Profiler::cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+uint64_t Profiler::now_us() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// O estágio interrompido para de contar até o novo terminar
+void Profiler::enter(ProfileStage stage) {
+    ProfileData& data = local();
+    uint64_t now = cycles();
+    data.stage_cycles[static_cast<size_t>(data.current)] += now - data.last_timestamp;
+    if (data.stack_size < sizeof(data.stack) / sizeof(data.stack[0])) {
+        data.stack[data.stack_size] = data.current;
+    }
+    data.stack_size++;
+    data.current = stage;
+    data.stage_calls[static_cast<size_t>(stage)]++;
+    data.last_timestamp = now;
+}
+
+void Profiler::leave() {
+    ProfileData& data = local();
+    uint64_t now = cycles();
+    data.stage_cycles[static_cast<size_t>(data.current)] += now - data.last_timestamp;
+    data.stack_size--;
+    data.current = (data.stack_size < sizeof(data.stack) / sizeof(data.stack[0]))
+        ? data.stack[data.stack_size]
+        : ProfileStage::NONE;
+    data.last_timestamp = now;
+}
+
+static size_t bucket(size_t value) {
+    size_t index = 0;
+    while (value > 0 && index + 1 < PROFILE_BUCKET_COUNT) {
+        value >>= 1;
+        index++;
+    }
+    return index;
+}
+
+void Profiler::record_tokens() {
+    ProfileData& data = local();
+    data.tokens_histogram[bucket(data.pending_tokens)]++;
+    data.pending_tokens = 0;
+}
+
+void Profiler::record_depth(size_t depth) {
+    local().depth_histogram[bucket(depth)]++;
+}
+
+void Profiler::record_operator(string_view symbol, bool unary) {
+    if (unary) {
+        local().operator_counts[PROFILE_OPERATOR_COUNT - 1]++;
+        return;
+    }
+    for (size_t i = 0; i + 1 < PROFILE_OPERATOR_COUNT; i++) {
+        if (symbol == OPERATOR_SYMBOLS[i]) {
+            local().operator_counts[i]++;
+            return;
+        }
+    }
+}
+
+void Profiler::record_error(ErrorCode code) {
+    ProfileData& data = local();
+    data.error_codes[static_cast<size_t>(code)]++;
+    data.error_categories[static_cast<size_t>(error_code_category(code))]++;
+}
+
+void Profiler::record_error(ErrorCategory category) {
+    local().error_categories[static_cast<size_t>(category)]++;
+}
+
+static ProfileData merged() {
+    ProfileData total;
+    lock_guard<mutex> lock(registry_mutex);
+    for (const auto& data : registry) {
+        for (size_t i = 0; i < PROFILE_STAGE_COUNT; i++) {
+            total.stage_cycles[i] += data->stage_cycles[i];
+            total.stage_calls[i] += data->stage_calls[i];
+        }
+        for (size_t i = 0; i < PROFILE_BUCKET_COUNT; i++) {
+            total.tokens_histogram[i] += data->tokens_histogram[i];
+            total.depth_histogram[i] += data->depth_histogram[i];
+        }
+        for (size_t i = 0; i < PROFILE_OPERATOR_COUNT; i++) total.operator_counts[i] += data->operator_counts[i];
+        for (size_t i = 0; i < PROFILE_ERROR_CODE_COUNT; i++) total.error_codes[i] += data->error_codes[i];
+        for (size_t i = 0; i < PROFILE_ERROR_CATEGORY_COUNT; i++) total.error_categories[i] += data->error_categories[i];
+    }
+    return total;
+}
+
+// setw conta bytes; os nomes têm acentos em UTF-8
+static string pad(const string& text, size_t width) {
+    size_t characters = 0;
+    for (unsigned char c : text) characters += (c & 0xC0) != 0x80;
+    return text + string(width > characters ? width - characters : 0, ' ');
+}
+
+static void write_histogram(ostream& out, const char* title, const uint64_t (&histogram)[PROFILE_BUCKET_COUNT]) {
+    out << title << "\n";
+    for (size_t i = 0; i < PROFILE_BUCKET_COUNT; i++) {
+        if (histogram[i] == 0) continue;
+        size_t low = i == 0 ? 0 : size_t(1) << (i - 1);
+        size_t high = i == 0 ? 0 : (size_t(1) << i) - 1;
+        string range = (low == high) ? to_string(low) : to_string(low) + "-" + to_string(high);
+        if (i + 1 == PROFILE_BUCKET_COUNT) range = to_string(low) + "+";
+        out << "  " << setw(12) << range << "  " << histogram[i] << "\n";
+    }
+}
+
+void Profiler::write_summary(ostream& out) {
+    ProfileData total = merged();
+
+    // "outros" é o tempo fora dos estágios instrumentados
+    uint64_t cycles_sum = 0;
+    for (size_t i = 1; i < PROFILE_STAGE_COUNT; i++) cycles_sum += total.stage_cycles[i];
+    out << "Estágios (ciclos exclusivos)\n";
+    for (size_t i = 1; i < PROFILE_STAGE_COUNT; i++) {
+        if (total.stage_calls[i] == 0) continue;
+        out << "  " << pad(STAGE_NAMES[i], 12)
+            << setw(16) << total.stage_cycles[i]
+            << setw(8) << fixed << setprecision(1) << (cycles_sum ? 100.0 * total.stage_cycles[i] / cycles_sum : 0.0) << "%"
+            << setw(12) << total.stage_calls[i] << " chamadas"
+            << setw(10) << setprecision(1) << static_cast<double>(total.stage_cycles[i]) / total.stage_calls[i] << " ciclos/chamada\n";
+    }
+
+    write_histogram(out, "Tokens por expressão", total.tokens_histogram);
+    write_histogram(out, "Profundidade da árvore", total.depth_histogram);
+
+    out << "Avaliações por operador\n";
+    for (size_t i = 0; i < PROFILE_OPERATOR_COUNT; i++) {
+        if (total.operator_counts[i] == 0) continue;
+        out << "  " << pad(OPERATOR_SYMBOLS[i], 12) << setw(14) << total.operator_counts[i] << "\n";
+    }
+
+    out << "Erros por categoria\n";
+    for (size_t i = 1; i < PROFILE_ERROR_CATEGORY_COUNT; i++) {
+        if (total.error_categories[i] == 0) continue;
+        out << "  " << pad(error_category_name(static_cast<ErrorCategory>(i)), 12)
+            << setw(14) << total.error_categories[i] << "\n";
+    }
+    out << "Erros por código (caminho sem exceções)\n";
+    for (size_t i = 1; i < PROFILE_ERROR_CODE_COUNT; i++) {
+        if (total.error_codes[i] == 0) continue;
+        out << "  " << pad(error_code_name(static_cast<ErrorCode>(i)), 28)
+            << setw(14) << total.error_codes[i] << "\n";
+    }
+    out.flush();
+}
+
+// Formato "JSON Object" de trace-event: eventos completos ("ph":"X") em
+// microssegundos, um tid por thread registrada
+void Profiler::write_trace(ostream& out) {
+    lock_guard<mutex> lock(registry_mutex);
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (const auto& data : registry) {
+        if (!first) out << ",";
+        first = false;
+        out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << data->thread_id
+            << ",\"args\":{\"name\":\"thread " << data->thread_id << "\"}}";
+        for (const auto& event : data->events) {
+            out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << data->thread_id
+                << ",\"ts\":" << event.start_us - start_time_us << ",\"dur\":" << event.duration_us << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    out.flush();
+}
+
+void Profiler::reset() {
+    lock_guard<mutex> lock(registry_mutex);
+    for (const auto& data : registry) {
+        uint32_t id = data->thread_id;
+        *data = ProfileData();
+        data->thread_id = id;
+    }
+}
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// Instrumentação dos pontos quentes, ligada só com -DEDOO_PROFILE. Sem a
+// flag, as macros EDOO_PROFILE_* não geram código e nada deste arquivo
+// além das macros é usado.
+//
+// Com a flag, cada thread acumula nos próprios contadores (sem locks nem
+// atômicos no caminho quente):
+//   - ciclos por estágio (lexer, parser, optimizer, compilador, avaliação),
+//     exclusivos: o tempo do Lexer chamado pelo Parser conta só no Lexer
+//   - histogramas de tokens por expressão e de profundidade da árvore
+//   - avaliações por operador (árvore e bytecode)
+//   - erros por código e categoria
+//   - eventos com início e duração, exportados no formato trace-event do
+//     Chrome (chrome://tracing, Perfetto)
+
+#include "errors.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+enum class ProfileStage : uint8_t {
+    NONE,
+    LEXER,
+    PARSER,
+    OPTIMIZER,
+    COMPILER,
+    EVALUATE
+};
+
+constexpr size_t PROFILE_STAGE_COUNT = static_cast<size_t>(ProfileStage::EVALUATE) + 1;
+// Operadores contados: os binários de operators.h e o menos unário
+constexpr size_t PROFILE_OPERATOR_COUNT = 13;
+// Histogramas em potências de 2: [0], [1], [2,3], [4,7], ...
+constexpr size_t PROFILE_BUCKET_COUNT = 16;
+constexpr size_t PROFILE_ERROR_CODE_COUNT = static_cast<size_t>(ErrorCode::DIVISION_BY_ZERO) + 1;
+constexpr size_t PROFILE_ERROR_CATEGORY_COUNT = static_cast<size_t>(ErrorCategory::TYPE) + 1;
+
+const char* profile_stage_name(ProfileStage stage);
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start_us;
+    uint64_t duration_us;
+};
+
+// Contadores de uma thread
+struct ProfileData {
+    uint32_t thread_id = 0;
+    uint64_t stage_cycles[PROFILE_STAGE_COUNT] = {};
+    uint64_t stage_calls[PROFILE_STAGE_COUNT] = {};
+    uint64_t tokens_histogram[PROFILE_BUCKET_COUNT] = {};
+    uint64_t depth_histogram[PROFILE_BUCKET_COUNT] = {};
+    uint64_t operator_counts[PROFILE_OPERATOR_COUNT] = {};
+    uint64_t error_codes[PROFILE_ERROR_CODE_COUNT] = {};
+    uint64_t error_categories[PROFILE_ERROR_CATEGORY_COUNT] = {};
+    vector<TraceEvent> events;
+    // Tokens consumidos pelo Parser desde o último record_tokens
+    size_t pending_tokens = 0;
+
+    // Estágio atual e os que ele interrompeu
+    ProfileStage current = ProfileStage::NONE;
+    ProfileStage stack[16];
+    size_t stack_size = 0;
+    uint64_t last_timestamp = 0;
+};
+
+class Profiler {
+    public:
+        // Contadores da thread atual, registrados no primeiro uso e mantidos
+        // depois que a thread termina
+        static ProfileData& local();
+
+        static uint64_t cycles();
+        static uint64_t now_us();
+
+        static void enter(ProfileStage stage);
+        static void leave();
+
+        static void count_token() { local().pending_tokens++; }
+        // Fecha o histograma de tokens da expressão atual
+        static void record_tokens();
+        static void record_depth(size_t depth);
+        // symbol como em operators.h; unary para o menos unário
+        static void record_operator(string_view symbol, bool unary = false);
+        static void record_error(ErrorCode code);
+        static void record_error(ErrorCategory category);
+
+        // Somam todas as threads; chamar depois que elas terminaram
+        static void write_summary(ostream& out);
+        static void write_trace(ostream& out);
+        // Zera tudo; só sem outras threads instrumentadas rodando
+        static void reset();
+};
+
+// Um estágio enquanto o objeto existe
+class ProfileStageScope {
+    public:
+        explicit ProfileStageScope(ProfileStage stage) { Profiler::enter(stage); }
+        ~ProfileStageScope() { Profiler::leave(); }
+        ProfileStageScope(const ProfileStageScope&) = delete;
+        ProfileStageScope& operator=(const ProfileStageScope&) = delete;
+};
+
+// Um evento do trace com a duração do escopo; name deve ser um literal
+class TraceScope {
+    private:
+        const char* name;
+        uint64_t start;
+
+    public:
+        explicit TraceScope(const char* name) : name(name), start(Profiler::now_us()) {}
+        ~TraceScope() { Profiler::local().events.push_back({name, start, Profiler::now_us() - start}); }
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+};
+
+#define EDOO_PROFILE_CONCAT_(a, b) a##b
+#define EDOO_PROFILE_CONCAT(a, b) EDOO_PROFILE_CONCAT_(a, b)
+
+#ifdef EDOO_PROFILE
+#define EDOO_PROFILE_STAGE(stage) ProfileStageScope EDOO_PROFILE_CONCAT(profile_stage_, __LINE__)(stage)
+#define EDOO_PROFILE_TRACE(name) TraceScope EDOO_PROFILE_CONCAT(profile_trace_, __LINE__)(name)
+#define EDOO_PROFILE_TOKEN() Profiler::count_token()
+#define EDOO_PROFILE_TOKENS() Profiler::record_tokens()
+#define EDOO_PROFILE_DEPTH(depth) Profiler::record_depth(depth)
+#define EDOO_PROFILE_OPERATOR(symbol, unary) Profiler::record_operator(symbol, unary)
+#define EDOO_PROFILE_ERROR(error) Profiler::record_error(error)
+#else
+#define EDOO_PROFILE_STAGE(stage) ((void)0)
+#define EDOO_PROFILE_TRACE(name) ((void)0)
+#define EDOO_PROFILE_TOKEN() ((void)0)
+#define EDOO_PROFILE_TOKENS() ((void)0)
+#define EDOO_PROFILE_DEPTH(depth) ((void)0)
+#define EDOO_PROFILE_OPERATOR(symbol, unary) ((void)0)
+#define EDOO_PROFILE_ERROR(error) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,164 @@
+#include "result_cache.h"
+#include "lexer.h"
+#include <functional>
+
+ResultCache::ResultCache(size_t memory_limit, size_t shard_count)
+    : memory_limit(memory_limit) {
+    if (shard_count == 0) shard_count = 1;
+    shard_limit = memory_limit / shard_count;
+    shards.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; i++) {
+        shards.push_back(make_unique<Shard>());
+    }
+}
+
+ResultCache::Shard& ResultCache::shard_for(const string& key) {
+    return *shards[hash<string>{}(key) % shards.size()];
+}
+
+// Estimativa do custo de uma entrada: a chave e os nós da lista e do mapa
+size_t ResultCache::entry_cost(const string& key) {
+    return key.capacity() + sizeof(Entry) + 4 * sizeof(void*) + sizeof(string_view) + sizeof(list<Entry>::iterator);
+}
+
+bool ResultCache::lookup(const string& key, CachedResult& out) {
+    Shard& shard = shard_for(key);
+    lock_guard<mutex> guard(shard.lock);
+
+    auto found = shard.index.find(key);
+    if (found == shard.index.end()) {
+        misses.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    // Move para a frente da lista (mais recente)
+    shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+    out = found->second->result;
+    hits.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+void ResultCache::insert(const string& key, CachedResult result) {
+    size_t cost = entry_cost(key);
+    if (cost > shard_limit) return;
+
+    Shard& shard = shard_for(key);
+    lock_guard<mutex> guard(shard.lock);
+
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
+        found->second->result = move(result);
+        shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+        return;
+    }
+
+    while (!shard.lru.empty() && shard.memory + cost > shard_limit) {
+        Entry& oldest = shard.lru.back();
+        shard.memory -= oldest.cost;
+        shard.index.erase(oldest.key);
+        shard.lru.pop_back();
+        evictions.fetch_add(1, memory_order_relaxed);
+    }
+
+    shard.lru.push_front({key, move(result), cost});
+    shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+    shard.memory += cost;
+}
+
+void ResultCache::clear() {
+    for (auto& shard : shards) {
+        lock_guard<mutex> guard(shard->lock);
+        shard->index.clear();
+        shard->lru.clear();
+        shard->memory = 0;
+    }
+}
+
+ResultCache::Statistics ResultCache::statistics() const {
+    Statistics stats{hits.load(), misses.load(), evictions.load(), 0, 0};
+    for (const auto& shard : shards) {
+        lock_guard<mutex> guard(shard->lock);
+        stats.entries += shard->lru.size();
+        stats.memory += shard->memory;
+    }
+    return stats;
+}
+
+// Átomos: um parêntese em volta deles é sempre redundante
+static bool is_literal(TokenType type) {
+    return type == TokenType::INTEGER || type == TokenType::BOOLEAN || type == TokenType::IDENTIFIER;
+}
+
+string ResultCache::canonical_key(string_view input) {
+    // Reaproveitados entre chamadas da mesma thread
+    thread_local vector<Token> tokens;
+    thread_local vector<size_t> matching;
+    thread_local vector<size_t> open;
+    tokens.clear();
+
+    try {
+        Lexer lexer(input);
+        for (Token token = lexer.get_next_token(); !token.is(TokenType::END_OF_FILE); token = lexer.get_next_token()) {
+            tokens.push_back(token);
+        }
+    } catch (const LexerError&) {
+        return "\x01" + string(input);
+    }
+
+    // Casa os parênteses; se não estiverem balanceados, nenhum é removido
+    size_t n = tokens.size();
+    matching.assign(n, n);
+    open.clear();
+    bool balanced = true;
+    for (size_t i = 0; i < n && balanced; i++) {
+        if (tokens[i].is(TokenType::LPAREN)) {
+            open.push_back(i);
+        } else if (tokens[i].is(TokenType::RPAREN)) {
+            if (open.empty()) {
+                balanced = false;
+                break;
+            }
+            matching[open.back()] = i;
+            matching[i] = open.back();
+            open.pop_back();
+        }
+    }
+    balanced = balanced && open.empty();
+
+    // Parênteses em volta da expressão inteira, quantos forem
+    size_t lo = 0, hi = n;
+    if (balanced) {
+        while (hi - lo >= 2 && tokens[lo].is(TokenType::LPAREN) && matching[lo] == hi - 1) {
+            lo++;
+            hi--;
+        }
+    }
+
+    string key;
+    key.reserve(n * 2);
+    for (size_t i = lo; i < hi; i++) {
+        const Token& token = tokens[i];
+
+        if (balanced && (token.is(TokenType::LPAREN) || token.is(TokenType::RPAREN))) {
+            size_t first = token.is(TokenType::LPAREN) ? i : matching[i];
+            size_t last = matching[first];
+            bool redundant = (last == first + 2 && is_literal(tokens[first + 1].get_type()))
+                          || (first + 1 < last && matching[first + 1] == last - 1 && tokens[first + 1].is(TokenType::LPAREN));
+            if (redundant) continue;
+        }
+
+        key += static_cast<char>(token.get_type());
+        if (token.is(TokenType::INTEGER)) {
+            uint32_t value = static_cast<uint32_t>(token.get_int());
+            for (int byte = 0; byte < 4; byte++) {
+                key += static_cast<char>((value >> (8 * byte)) & 0xff);
+            }
+        } else if (token.is(TokenType::BOOLEAN)) {
+            key += token.get_bool() ? '\x01' : '\x00';
+        } else if (token.is(TokenType::IDENTIFIER)) {
+            // Nome terminado por um byte que não aparece em identificadores
+            key += token.get_text(input);
+            key += '\x00';
+        }
+    }
+    return key;
+}
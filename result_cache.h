@@ -0,0 +1,82 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+using namespace std;
+
+// Resultado guardado no cache: um valor ou o erro lançado ao avaliar
+struct CachedResult {
+    variant<int, bool> value;
+    exception_ptr error;
+};
+
+// Cache LRU limitado por memória, dividido em shards com um mutex cada,
+// para ser compartilhado entre vários ExpressionEvaluator/threads.
+// A chave é a sequência de tokens canonizada (ver canonical_key)
+class ResultCache {
+    public:
+        struct Statistics {
+            uint64_t hits;
+            uint64_t misses;
+            uint64_t evictions;
+            size_t entries;
+            size_t memory;
+        };
+
+        static constexpr size_t DEFAULT_MEMORY_LIMIT = 64 * 1024 * 1024;
+        static constexpr size_t DEFAULT_SHARDS = 16;
+
+        explicit ResultCache(size_t memory_limit = DEFAULT_MEMORY_LIMIT, size_t shards = DEFAULT_SHARDS);
+        ResultCache(const ResultCache&) = delete;
+        ResultCache& operator=(const ResultCache&) = delete;
+
+        bool lookup(const string& key, CachedResult& out);
+        void insert(const string& key, CachedResult result);
+        void clear();
+
+        Statistics statistics() const;
+        inline size_t get_memory_limit() const { return memory_limit; }
+
+        // Codifica os tokens da expressão ignorando espaços e parênteses
+        // redundantes: em volta de um único literal, duplicados "(( e ))"
+        // e em volta da expressão inteira. Entradas com erro léxico usam o
+        // próprio texto como chave
+        static string canonical_key(string_view input);
+
+    private:
+        struct Entry {
+            string key;
+            CachedResult result;
+            size_t cost;
+        };
+
+        struct Shard {
+            mutable mutex lock;
+            list<Entry> lru;  // mais recente na frente
+            unordered_map<string_view, list<Entry>::iterator> index;
+            size_t memory = 0;
+        };
+
+        size_t memory_limit;
+        size_t shard_limit;
+        vector<unique_ptr<Shard>> shards;
+
+        atomic<uint64_t> hits{0};
+        atomic<uint64_t> misses{0};
+        atomic<uint64_t> evictions{0};
+
+        Shard& shard_for(const string& key);
+        static size_t entry_cost(const string& key);
+};
+
+#endif
@@ -0,0 +1,341 @@
+#include "rule_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+static inline size_t align8(size_t offset) { return (offset + 7) & ~static_cast<size_t>(7); }
+
+// Seção [offset, offset + count * size) dentro do arquivo e alinhada
+static bool fits(uint64_t offset, uint64_t count, size_t size, size_t alignment, size_t length) {
+    if (offset % alignment != 0 || offset > length) return false;
+    return count <= (length - offset) / size;
+}
+
+void RuleFile::check_header() const {
+    string_view bytes = input.contents();
+    if (bytes.size() < sizeof(RuleFileHeader)) {
+        throw RuleFileError("Arquivo de regras truncado");
+    }
+    if (memcmp(header->magic, RULE_FILE_MAGIC, sizeof(RULE_FILE_MAGIC)) != 0) {
+        throw RuleFileError("Não é um arquivo de regras");
+    }
+    if (header->byte_order != RULE_FILE_BYTE_ORDER) {
+        throw RuleFileError("Arquivo de regras com outra ordem de bytes");
+    }
+    if (header->version != RULE_FILE_VERSION) {
+        throw RuleFileError("Versão do arquivo de regras não suportada: " + to_string(header->version)
+                            + " (esperada " + to_string(RULE_FILE_VERSION) + ")");
+    }
+    size_t length = bytes.size();
+    if (header->instruction_size != sizeof(Instruction) || header->file_size != length
+     || !fits(header->variables_offset, header->variable_count, sizeof(RuleVariableRecord), alignof(RuleVariableRecord), length)
+     || !fits(header->rules_offset, header->rule_count, sizeof(RuleRecord), alignof(RuleRecord), length)
+     || !fits(header->index_offset, header->rule_count, sizeof(uint32_t), alignof(uint32_t), length)
+     || !fits(header->code_offset, header->instruction_count, sizeof(Instruction), alignof(Instruction), length)
+     || !fits(header->names_offset, header->names_size, 1, 1, length)) {
+        throw RuleFileError("Arquivo de regras corrompido");
+    }
+}
+
+RuleFile::RuleFile(const string& path) : input(path) {
+    const char* bytes = input.contents().data();
+    header = reinterpret_cast<const RuleFileHeader*>(bytes);
+    check_header();
+    variable_records = reinterpret_cast<const RuleVariableRecord*>(bytes + header->variables_offset);
+    rules = reinterpret_cast<const RuleRecord*>(bytes + header->rules_offset);
+    index = reinterpret_cast<const uint32_t*>(bytes + header->index_offset);
+    code = reinterpret_cast<const Instruction*>(bytes + header->code_offset);
+    names = bytes + header->names_offset;
+}
+
+string_view RuleFile::name_at(uint32_t offset, uint32_t size) const {
+    if (offset > header->names_size || size > header->names_size - offset) {
+        throw RuleFileError("Arquivo de regras corrompido: nome fora da tabela");
+    }
+    return string_view(names + offset, size);
+}
+
+const RuleRecord& RuleFile::record(size_t position) const {
+    if (position >= header->rule_count) {
+        throw RuleFileError("Regra inexistente: " + to_string(position));
+    }
+    const RuleRecord& rule = rules[position];
+    if (rule.code_size == 0 || rule.code_begin > header->instruction_count
+     || rule.code_size > header->instruction_count - rule.code_begin || rule.result_type > static_cast<uint8_t>(ValueType::BOOLEAN)) {
+        throw RuleFileError("Arquivo de regras corrompido: regra " + to_string(position));
+    }
+    return rule;
+}
+
+MappedRule RuleFile::rule(size_t position) const {
+    const RuleRecord& rule = record(position);
+    ProgramView program{code + rule.code_begin, nullptr, static_cast<ValueType>(rule.result_type), rule.max_stack};
+    return MappedRule(program, name_at(rule.name_offset, rule.name_length));
+}
+
+size_t RuleFile::find(string_view name) const {
+    size_t low = 0, high = header->rule_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        size_t position = index[middle];
+        const RuleRecord& rule = record(position);
+        string_view found = name_at(rule.name_offset, rule.name_length);
+        if (found == name) return position;
+        if (found < name) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return NO_RULE;
+}
+
+MappedRule RuleFile::rule(string_view name) const {
+    size_t position = find(name);
+    if (position == NO_RULE) {
+        throw RuleFileError("Regra inexistente: " + string(name));
+    }
+    return rule(position);
+}
+
+uint32_t RuleFile::slot(string_view name) const {
+    for (uint32_t slot = 0; slot < header->variable_count; slot++) {
+        const RuleVariableRecord& variable = variable_records[slot];
+        if (name_at(variable.name_offset, variable.name_length) == name) return slot;
+    }
+    throw VariableError("Variável não declarada: " + string(name));
+}
+
+Variables RuleFile::variables() const {
+    Variables result;
+    for (uint32_t slot = 0; slot < header->variable_count; slot++) {
+        const RuleVariableRecord& variable = variable_records[slot];
+        if (variable.type > static_cast<uint8_t>(ValueType::BOOLEAN)) {
+            throw RuleFileError("Arquivo de regras corrompido: tipo da variável " + to_string(slot));
+        }
+        result.declare(name_at(variable.name_offset, variable.name_length), static_cast<ValueType>(variable.type));
+    }
+    return result;
+}
+
+// Simula a pilha como Compiler::emit: cada destino de salto tem que ser
+// alcançado com a mesma altura do salto, e o programa termina num HALT com
+// um valor só
+void RuleFile::verify() const {
+    Variables declared = variables();
+    if (declared.size() != header->variable_count) {
+        throw RuleFileError("Arquivo de regras corrompido: variável repetida");
+    }
+    vector<bool> seen(header->rule_count, false);
+    vector<size_t> target_depth;
+    for (size_t position = 0; position < header->rule_count; position++) {
+        const RuleRecord& rule = record(position);
+        name_at(rule.name_offset, rule.name_length);
+        auto corrupted = [&](const string& what) {
+            return RuleFileError("Arquivo de regras corrompido: regra " + to_string(position) + ", " + what);
+        };
+
+        const Instruction* program = code + rule.code_begin;
+        target_depth.assign(rule.code_size + 1, SIZE_MAX);
+        size_t depth = 0;
+        for (uint32_t i = 0; i < rule.code_size; i++) {
+            const Instruction& instruction = program[i];
+            if (static_cast<size_t>(instruction.op) >= OPCODE_COUNT || instruction.op == OpCode::FAIL) {
+                throw corrupted("instrução inválida em " + to_string(i));
+            }
+            if (target_depth[i] != SIZE_MAX && target_depth[i] != depth) {
+                throw corrupted("salto para " + to_string(i) + " com outra pilha");
+            }
+            switch (instruction.op) {
+                case OpCode::PUSH_INT:
+                case OpCode::PUSH_BOOL:
+                    depth++;
+                    break;
+                case OpCode::LOAD_I:
+                case OpCode::LOAD_B:
+                    if (instruction.operand < 0 || static_cast<uint32_t>(instruction.operand) >= header->variable_count) {
+                        throw corrupted("slot inválido em " + to_string(i));
+                    }
+                    depth++;
+                    break;
+                case OpCode::NEG_I:
+                    if (depth < 1) throw corrupted("pilha vazia em " + to_string(i));
+                    break;
+                case OpCode::JUMP_IF_FALSE:
+                case OpCode::JUMP_IF_TRUE: {
+                    // Como Compiler emite: o destino fica logo depois do
+                    // AND_B/OR_B do mesmo operador, ainda dentro da regra
+                    OpCode closing = instruction.op == OpCode::JUMP_IF_FALSE ? OpCode::AND_B : OpCode::OR_B;
+                    if (depth < 1 || instruction.operand <= 1 || static_cast<uint32_t>(instruction.operand) >= rule.code_size - i
+                     || program[i + instruction.operand - 1].op != closing) {
+                        throw corrupted("salto inválido em " + to_string(i));
+                    }
+                    size_t& expected = target_depth[i + instruction.operand];
+                    if (expected != SIZE_MAX && expected != depth) throw corrupted("saltos com pilhas diferentes");
+                    expected = depth;
+                    break;
+                }
+                case OpCode::HALT:
+                    if (depth != 1 || i + 1 != rule.code_size) throw corrupted("HALT inválido em " + to_string(i));
+                    break;
+                default:
+                    if (depth < 2) throw corrupted("pilha vazia em " + to_string(i));
+                    depth--;
+                    break;
+            }
+            if (depth > rule.max_stack) throw corrupted("max_stack menor que a pilha");
+        }
+        if (program[rule.code_size - 1].op != OpCode::HALT) throw corrupted("sem HALT no fim");
+    }
+
+    // O índice é uma permutação das regras, em ordem de nome
+    for (size_t i = 0; i < header->rule_count; i++) {
+        if (index[i] >= header->rule_count || seen[index[i]]) {
+            throw RuleFileError("Arquivo de regras corrompido: índice de nomes");
+        }
+        seen[index[i]] = true;
+        if (i > 0) {
+            const RuleRecord& previous = rules[index[i - 1]];
+            const RuleRecord& current = rules[index[i]];
+            if (name_at(previous.name_offset, previous.name_length) >= name_at(current.name_offset, current.name_length)) {
+                throw RuleFileError("Arquivo de regras corrompido: índice de nomes fora de ordem");
+            }
+        }
+    }
+}
+
+void RuleFileWriter::add(string_view name, string_view expression) {
+    if (name.empty()) {
+        throw RuleFileError("Regra sem nome");
+    }
+    if (names.count(string(name))) {
+        throw RuleFileError("Regra repetida: " + string(name));
+    }
+    CompiledExpression compiled = evaluator.compile(expression, declared);
+    names.insert(string(name));
+    entries.push_back({string(name), compiled.get_program()});
+}
+
+static string_view trim(string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == string_view::npos) return string_view();
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+void RuleFileWriter::add_source(string_view source) {
+    size_t number = 0;
+    while (!source.empty()) {
+        size_t end = source.find('\n');
+        string_view line = trim(source.substr(0, end));
+        source = end == string_view::npos ? string_view() : source.substr(end + 1);
+        number++;
+        if (line.empty() || line[0] == '#') continue;
+
+        try {
+            size_t colon = line.find(':');
+            if (colon != string_view::npos) {
+                add(trim(line.substr(0, colon)), trim(line.substr(colon + 1)));
+                continue;
+            }
+            size_t space = line.find_first_of(" \t");
+            string_view type = line.substr(0, space);
+            string_view name = space == string_view::npos ? string_view() : trim(line.substr(space));
+            if ((type != "int" && type != "bool") || name.empty() || name.find_first_of(" \t") != string_view::npos) {
+                throw RuleFileError("esperado 'int nome', 'bool nome' ou 'nome: expressão'");
+            }
+            declare(name, type == "int" ? ValueType::INTEGER : ValueType::BOOLEAN);
+        } catch (const exception& e) {
+            throw RuleFileError("Linha " + to_string(number) + ": " + e.what());
+        }
+    }
+}
+
+string RuleFileWriter::serialize() const {
+    size_t instruction_count = 0;
+    size_t names_size = 0;
+    for (const auto& variable : declared) names_size += variable.name.size();
+    for (const auto& entry : entries) {
+        instruction_count += entry.program.code.size();
+        names_size += entry.name.size();
+    }
+
+    RuleFileHeader header{};
+    memcpy(header.magic, RULE_FILE_MAGIC, sizeof(RULE_FILE_MAGIC));
+    header.version = RULE_FILE_VERSION;
+    header.byte_order = RULE_FILE_BYTE_ORDER;
+    header.instruction_size = sizeof(Instruction);
+    header.rule_count = static_cast<uint32_t>(entries.size());
+    header.variable_count = static_cast<uint32_t>(declared.size());
+    header.instruction_count = static_cast<uint32_t>(instruction_count);
+    header.variables_offset = align8(sizeof(RuleFileHeader));
+    header.rules_offset = align8(header.variables_offset + declared.size() * sizeof(RuleVariableRecord));
+    header.index_offset = align8(header.rules_offset + entries.size() * sizeof(RuleRecord));
+    header.code_offset = align8(header.index_offset + entries.size() * sizeof(uint32_t));
+    header.names_offset = header.code_offset + instruction_count * sizeof(Instruction);
+    header.names_size = names_size;
+    header.file_size = header.names_offset + names_size;
+
+    // Zerado: os paddings saem sempre iguais
+    string bytes(header.file_size, '\0');
+    memcpy(&bytes[0], &header, sizeof(header));
+    size_t name_offset = 0;
+    auto put_name = [&](const string& name) {
+        memcpy(&bytes[header.names_offset + name_offset], name.data(), name.size());
+        name_offset += name.size();
+        return static_cast<uint32_t>(name_offset - name.size());
+    };
+
+    for (const auto& variable : declared) {
+        RuleVariableRecord record{};
+        record.name_length = static_cast<uint32_t>(variable.name.size());
+        record.name_offset = put_name(variable.name);
+        record.type = static_cast<uint8_t>(variable.type);
+        memcpy(&bytes[header.variables_offset + variable.slot * sizeof(record)], &record, sizeof(record));
+    }
+
+    size_t code_begin = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Entry& entry = entries[i];
+        RuleRecord record{};
+        record.name_length = static_cast<uint32_t>(entry.name.size());
+        record.name_offset = put_name(entry.name);
+        record.code_begin = static_cast<uint32_t>(code_begin);
+        record.code_size = static_cast<uint32_t>(entry.program.code.size());
+        record.max_stack = static_cast<uint32_t>(entry.program.max_stack);
+        record.result_type = static_cast<uint8_t>(entry.program.result_type);
+        memcpy(&bytes[header.rules_offset + i * sizeof(record)], &record, sizeof(record));
+
+        for (const Instruction& instruction : entry.program.code) {
+            char* out = &bytes[header.code_offset + code_begin * sizeof(Instruction)];
+            out[0] = static_cast<char>(instruction.op);
+            memcpy(out + offsetof(Instruction, operand), &instruction.operand, sizeof(instruction.operand));
+            code_begin++;
+        }
+    }
+
+    vector<uint32_t> order(entries.size());
+    for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+    sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return entries[a].name < entries[b].name; });
+    memcpy(&bytes[header.index_offset], order.data(), order.size() * sizeof(uint32_t));
+    return bytes;
+}
+
+void RuleFileWriter::write(const string& path) const {
+    string bytes = serialize();
+    string temporary = path + ".tmp";
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        file.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+        if (!file.flush()) {
+            throw IOError("Não foi possível escrever " + temporary);
+        }
+    }
+    if (rename(temporary.c_str(), path.c_str()) != 0) {
+        string reason = strerror(errno);
+        remove(temporary.c_str());
+        throw IOError("Não foi possível criar " + path + ": " + reason);
+    }
+}
@@ -0,0 +1,190 @@
+#ifndef RULE_FILE_H
+#define RULE_FILE_H
+
+#include "bytecode.h"
+#include "compiled_expression.h"
+#include "fast_io.h"
+#include "parser.h"
+#include "variables.h"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+using namespace std;
+
+class RuleFileError : public runtime_error {
+    public:
+        explicit RuleFileError(const string& message) : runtime_error(message) {}
+};
+
+// Arquivo binário de regras já compiladas para bytecode. Os números ficam
+// na ordem de bytes de quem escreveu (conferida por byte_order ao abrir) e
+// alinhados ao próprio tamanho; as seções, alinhadas a 8 bytes, na ordem:
+//
+//   RuleFileHeader
+//   RuleVariableRecord[variable_count]   variáveis, na ordem dos slots
+//   RuleRecord[rule_count]               regras, na ordem da fonte
+//   uint32_t[rule_count]                 índices das regras por nome
+//   Instruction[...]                     o código de todas as regras
+//   char[...]                            nomes (sem terminador)
+//
+// As instruções têm o layout de Instruction (opcode, 3 bytes zerados e o
+// operando), para o VM executar direto dos bytes mapeados. RULE_FILE_VERSION
+// muda sempre que OpCode ou algum desses layouts mudar
+constexpr char RULE_FILE_MAGIC[8] = {'E', 'D', 'O', 'O', 'R', 'U', 'L', 'E'};
+constexpr uint32_t RULE_FILE_VERSION = 1;
+// Escrito como uint32_t: lido com outra ordem de bytes, não confere
+constexpr uint32_t RULE_FILE_BYTE_ORDER = 0x01020304;
+
+struct RuleFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t instruction_size;
+    uint32_t rule_count;
+    uint32_t variable_count;
+    uint32_t instruction_count;
+    uint64_t variables_offset;
+    uint64_t rules_offset;
+    uint64_t index_offset;
+    uint64_t code_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+    uint64_t file_size;
+};
+
+struct RuleVariableRecord {
+    uint32_t name_offset;
+    uint32_t name_length;
+    uint8_t type;
+    uint8_t padding[3];
+};
+
+struct RuleRecord {
+    uint32_t name_offset;
+    uint32_t name_length;
+    // Em instruções, a partir de code_offset
+    uint32_t code_begin;
+    uint32_t code_size;
+    uint32_t max_stack;
+    uint8_t result_type;
+    uint8_t padding[3];
+};
+
+static_assert(sizeof(Instruction) == 8 && offsetof(Instruction, operand) == 4, "layout de Instruction no arquivo");
+static_assert(sizeof(RuleFileHeader) == 88 && sizeof(RuleVariableRecord) == 12 && sizeof(RuleRecord) == 24,
+              "layout dos registros do arquivo");
+
+// Uma regra do arquivo: só ponteiros para os bytes mapeados, que devem
+// viver (o RuleFile aberto) enquanto ela for usada. Avaliar não lê texto
+// nem aloca memória (regras com max_stack acima de 64 só na primeira vez
+// em cada thread, para a pilha do VM)
+class MappedRule {
+    private:
+        ProgramView program;
+        string_view name;
+
+    public:
+        MappedRule(ProgramView program, string_view name) : program(program), name(name) {}
+
+        inline variant<int, bool> evaluate(const int32_t* slots) const { return VirtualMachine::run(program, slots); }
+        inline bool try_evaluate(const int32_t* slots, variant<int, bool>& out, EvaluationError& error) const {
+            return VirtualMachine::try_run(program, slots, out, error);
+        }
+
+        inline string_view get_name() const { return name; }
+        inline ValueType get_type() const { return program.result_type; }
+        inline const ProgramView& get_program() const { return program; }
+};
+
+// Abre um arquivo de regras com mmap. Abrir só confere o cabeçalho e os
+// limites das tabelas, em tempo constante: as páginas das regras são lidas
+// pelo sistema quando usadas, e o custo de abrir não depende do número de
+// regras. verify() confere o código de todas as regras (opcodes, slots,
+// saltos e pilha), para arquivos que não vieram de um RuleFileWriter
+// confiável. Só leitura: pode ser compartilhado entre threads
+class RuleFile {
+    public:
+        static constexpr size_t NO_RULE = SIZE_MAX;
+
+    private:
+        MappedInput input;
+        const RuleFileHeader* header = nullptr;
+        const RuleVariableRecord* variable_records = nullptr;
+        const RuleRecord* rules = nullptr;
+        const uint32_t* index = nullptr;
+        const Instruction* code = nullptr;
+        const char* names = nullptr;
+
+        // Lançam RuleFileError se o registro apontar para fora do arquivo
+        string_view name_at(uint32_t offset, uint32_t size) const;
+        const RuleRecord& record(size_t position) const;
+        void check_header() const;
+
+    public:
+        // Lança IOError se não conseguir ler o arquivo e RuleFileError se
+        // ele não for um arquivo de regras desta versão
+        explicit RuleFile(const string& path);
+
+        inline size_t size() const { return header->rule_count; }
+        MappedRule rule(size_t position) const;
+        // Busca binária pelo nome; NO_RULE se não houver
+        size_t find(string_view name) const;
+        MappedRule rule(string_view name) const;
+
+        inline size_t variable_count() const { return header->variable_count; }
+        // Slot de uma variável, para montar o array de valores; lança
+        // VariableError se não houver
+        uint32_t slot(string_view name) const;
+        // As declarações, na ordem dos slots (aloca: para quem precisa de um
+        // Variables, não para avaliar)
+        Variables variables() const;
+
+        void verify() const;
+};
+
+// Monta o arquivo: as variáveis são declaradas (com slots na ordem de
+// declaração) e as regras compiladas por ExpressionEvaluator::compile com
+// as variáveis declaradas até ali
+class RuleFileWriter {
+    private:
+        struct Entry {
+            string name;
+            Program program;
+        };
+
+        Variables declared;
+        vector<Entry> entries;
+        unordered_set<string> names;
+        ExpressionEvaluator evaluator;
+
+    public:
+        RuleFileWriter() = default;
+
+        inline uint32_t declare(string_view name, ValueType type) { return declared.declare(name, type); }
+        // Lança ParserError/LexerError, TypeError ou RuleFileError (nome
+        // repetido ou vazio)
+        void add(string_view name, string_view expression);
+
+        // Fonte em texto, uma declaração ou regra por linha:
+        //     int preco
+        //     bool ativo
+        //     grande: preco * 2 > 100 && ativo
+        // Linhas vazias e começando com # são ignoradas. Os erros viram
+        // RuleFileError com o número da linha
+        void add_source(string_view source);
+
+        inline size_t size() const { return entries.size(); }
+        inline const Variables& get_variables() const { return declared; }
+
+        // Os bytes do arquivo. write grava num temporário ao lado e renomeia
+        // para path, sem mexer nas páginas de quem tem o arquivo antigo
+        // mapeado (lança IOError)
+        string serialize() const;
+        void write(const string& path) const;
+};
+
+#endif
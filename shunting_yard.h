@@ -0,0 +1,113 @@
+#ifndef SHUNTING_YARD_H
+#define SHUNTING_YARD_H
+
+#include "operators.h"
+#include "token.h"
+#include <cstddef>
+#include <cstdint>
+using namespace std;
+
+// A gramática das expressões, uma vez só, para o Parser (que monta nós) e o
+// ConstantParser (que avalia em tempo de compilação) não divergirem:
+//
+//     expressão := operando (binário operando)*
+//     operando  := '-' operando | '(' expressão ')' | primário
+//
+// com a precedência e a associatividade de operators.h e um '-' unário só
+// no começo de um operando e nunca seguido de outro ('- - 3' é erro).
+//
+// Shunting-yard com pilhas explícitas, no lugar da descida recursiva:
+// parênteses e menos unários viram entradas na pilha de operadores, então a
+// profundidade da entrada não usa a pilha do processo. Dá a mesma árvore e
+// os mesmos erros, na mesma ordem, que o precedence climbing: um operador
+// da pilha é reduzido quando liga mais forte que o que chegou (ou igual, se
+// o que chegou é associativo à esquerda).
+
+enum class PendingKind : uint8_t { PAREN, UNARY, BINARY };
+
+struct PendingOperator {
+    PendingKind kind = PendingKind::PAREN;
+    TokenType op = TokenType::END_OF_FILE;
+    uint32_t offset = 0;
+};
+
+// Grammar guarda as duas pilhas e faz as ações:
+//     TokenType token() const; uint32_t token_offset() const
+//     bool advance(TokenType)      consome o token atual, que deve ser esse
+//     bool primary()               lê um literal ou variável e o empilha
+//     void push_pending(const PendingOperator&), void pop_pending()
+//     bool has_pending() const; const PendingOperator& top_pending() const
+//     void reduce(const PendingOperator&)  junta os dois operandos do topo
+//     void negate(uint32_t offset)         menos unário no operando do topo
+//     void group()                         parênteses no operando do topo
+// advance e primary devolvem false no primeiro erro, que a Grammar guarda.
+// min_binding_power só vale fora de parênteses; allow_unary diz se a
+// expressão pode começar com '-'
+template <typename Grammar>
+constexpr bool parse_expression(Grammar& grammar, uint8_t min_binding_power = LOWEST_BINDING_POWER, bool allow_unary = true) {
+    auto top_is = [&](PendingKind kind) { return grammar.has_pending() && grammar.top_pending().kind == kind; };
+    auto pop = [&]() {
+        PendingOperator pending = grammar.top_pending();
+        grammar.pop_pending();
+        return pending;
+    };
+    // Um operando completo recebe o menos unário que o precedia
+    auto finish_operand = [&]() {
+        if (top_is(PendingKind::UNARY)) grammar.negate(pop().offset);
+    };
+
+    bool expecting_operand = true;
+    bool unary_allowed = allow_unary;
+    size_t open_parens = 0;
+    while (true) {
+        TokenType type = grammar.token();
+        if (expecting_operand) {
+            if (type == TokenType::MINUS && unary_allowed) {
+                uint32_t offset = grammar.token_offset();
+                if (!grammar.advance(TokenType::MINUS)) return false;
+                grammar.push_pending({PendingKind::UNARY, TokenType::MINUS, offset});
+                unary_allowed = false;
+                continue;
+            }
+            if (type == TokenType::LPAREN) {
+                if (!grammar.advance(TokenType::LPAREN)) return false;
+                grammar.push_pending({PendingKind::PAREN, TokenType::LPAREN, 0});
+                open_parens++;
+                unary_allowed = true;
+                continue;
+            }
+            if (!grammar.primary()) return false;
+            finish_operand();
+            expecting_operand = false;
+            continue;
+        }
+
+        const BinaryOperatorInfo& op = binary_operator(type);
+        if (op.binding_power != 0 && (open_parens > 0 || op.binding_power >= min_binding_power)) {
+            while (top_is(PendingKind::BINARY)) {
+                const BinaryOperatorInfo& top = binary_operator(grammar.top_pending().op);
+                if (!(top.binding_power > op.binding_power
+                   || (top.binding_power == op.binding_power && op.associativity == Associativity::LEFT))) break;
+                grammar.reduce(pop());
+            }
+            uint32_t offset = grammar.token_offset();
+            if (!grammar.advance(type)) return false;
+            grammar.push_pending({PendingKind::BINARY, type, offset});
+            expecting_operand = true;
+            unary_allowed = true;
+            continue;
+        }
+
+        // Fim de um grupo: fecha o parêntese aberto mais recente ou, fora
+        // de parênteses, a expressão inteira
+        while (top_is(PendingKind::BINARY)) grammar.reduce(pop());
+        if (open_parens == 0) return true;
+        if (!grammar.advance(TokenType::RPAREN)) return false;
+        grammar.pop_pending();
+        open_parens--;
+        grammar.group();
+        finish_operand();
+    }
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+using namespace std;
+
+// Fila circular limitada para exatamente um produtor e um consumidor, sem
+// locks: cada lado só escreve o próprio índice. Cheia, push espera (é o
+// que segura um estágio mais rápido que o seguinte); vazia, pop espera.
+// A espera gira um pouco e depois dorme numa condition_variable, para um
+// estágio parado (ex: entrada de um pipe sem dados) não ocupar um núcleo. O
+// mutex só é usado quando um dos lados está dormindo
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity precisa ser potência de 2");
+
+    private:
+        array<T, Capacity> items;
+        // Em linhas de cache separadas para os dois lados não disputarem
+        alignas(64) atomic<size_t> head{0};  // próximo a ler (consumidor)
+        alignas(64) atomic<size_t> tail{0};  // próximo a escrever (produtor)
+
+        static constexpr int SPINS = 64;
+        // Cheia e vazia ao mesmo tempo não acontece: dorme no máximo um lado
+        alignas(64) atomic<bool> sleeping{false};
+        mutex lock;
+        condition_variable changed;
+
+        // Os fences seq_cst impedem que quem mudou o índice não veja
+        // sleeping e quem vai dormir não veja o índice novo
+        void wake() {
+            atomic_thread_fence(memory_order_seq_cst);
+            if (sleeping.load(memory_order_relaxed)) {
+                lock_guard<mutex> guard(lock);
+                changed.notify_one();
+            }
+        }
+
+        template <typename Ready>
+        void wait(Ready ready) {
+            for (int i = 0; i < SPINS; i++) {
+                if (ready()) return;
+                this_thread::yield();
+            }
+            unique_lock<mutex> guard(lock);
+            sleeping.store(true, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            changed.wait(guard, ready);
+            sleeping.store(false, memory_order_relaxed);
+        }
+
+        bool full() const { return tail.load(memory_order_relaxed) - head.load(memory_order_acquire) == Capacity; }
+        bool empty() const { return head.load(memory_order_relaxed) == tail.load(memory_order_acquire); }
+
+    public:
+        bool try_push(const T& item) {
+            size_t position = tail.load(memory_order_relaxed);
+            if (position - head.load(memory_order_acquire) == Capacity) return false;
+            items[position & (Capacity - 1)] = item;
+            tail.store(position + 1, memory_order_release);
+            wake();
+            return true;
+        }
+
+        bool try_pop(T& item) {
+            size_t position = head.load(memory_order_relaxed);
+            if (position == tail.load(memory_order_acquire)) return false;
+            item = items[position & (Capacity - 1)];
+            head.store(position + 1, memory_order_release);
+            wake();
+            return true;
+        }
+
+        void push(const T& item) {
+            while (!try_push(item)) wait([this] { return !full(); });
+        }
+
+        T pop() {
+            T item;
+            while (!try_pop(item)) wait([this] { return !empty(); });
+            return item;
+        }
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "stream.h"
+#include "parser.h"
+#include "profile.h"
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+
+void StreamBatch::clear() {
+    text.clear();
+    lines.clear();
+    last = false;
+}
+
+StreamPipeline::StreamPipeline(bool optimize) : optimize(optimize) {
+    for (size_t i = 0; i < BATCH_COUNT; i++) {
+        batches.push_back(make_unique<StreamBatch>());
+    }
+}
+
+void StreamPipeline::read_stage(int fd) {
+    EDOO_PROFILE_TRACE("leitura");
+    constexpr size_t CHUNK = 64 * 1024;
+    vector<char> chunk(CHUNK);
+    // Começo de uma linha que ainda não terminou no último read
+    string partial;
+
+    StreamBatch* batch = free_batches.pop();
+    batch->clear();
+    auto add_line = [&](const char* begin, size_t length) {
+        batch->lines.push_back({static_cast<uint32_t>(batch->text.size()), static_cast<uint32_t>(partial.size() + length)});
+        batch->text += partial;
+        batch->text.append(begin, length);
+        partial.clear();
+    };
+    auto send = [&]() {
+        read_batches.push(batch);
+        batch = free_batches.pop();
+        batch->clear();
+    };
+
+    try {
+        while (true) {
+            ssize_t count = ::read(fd, chunk.data(), CHUNK);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                throw IOError(string("Erro de leitura: ") + strerror(errno));
+            }
+            if (count == 0) break;
+
+            const char* position = chunk.data();
+            const char* end = position + count;
+            while (const char* newline = static_cast<const char*>(memchr(position, '\n', end - position))) {
+                add_line(position, newline - position);
+                position = newline + 1;
+                if (batch->lines.size() == BATCH_LINES) send();
+            }
+            partial.append(position, end);
+
+            // Entrada lenta (ex: outro processo escrevendo aos poucos): manda
+            // o que já chegou em vez de esperar o lote encher
+            if (!batch->lines.empty()) send();
+        }
+    } catch (...) {
+        read_error = current_exception();
+    }
+
+    // Como getline, a última linha vale mesmo sem '\n'
+    if (!partial.empty()) add_line("", 0);
+    batch->last = true;
+    read_batches.push(batch);
+}
+
+void StreamPipeline::compile_stage() {
+    Arena arena;
+    Compiler compiler;
+
+    while (true) {
+        StreamBatch* batch = read_batches.pop();
+        EDOO_PROFILE_TRACE("compilação");
+        size_t count = batch->lines.size();
+        if (batch->programs.size() < count) batch->programs.resize(count);
+        batch->compiled.assign(count, false);
+
+        for (size_t i = 0; i < count; i++) {
+            string_view line(batch->text.data() + batch->lines[i].first, batch->lines[i].second);
+            // Linha vazia (EMPTY_EXPRESSION, como no parser): compiled fica
+            // false e a linha sai como "error"
+            if (line.empty()) {
+                EDOO_PROFILE_ERROR(ErrorCode::EMPTY_EXPRESSION);
+            } else {
+                Lexer lexer(line);
+                Parser parser(lexer, arena);
+                auto expr = parser.try_parse();
+                if (!expr) {
+                    EDOO_PROFILE_ERROR(parser.get_error().code);
+                } else {
+                    if (optimize && parser.get_depth() <= recursive_depth_limit()) {
+                        expr = Optimizer(arena).optimize(*expr);
+                    }
+                    compiler.compile(*expr, batch->programs[i]);
+                    batch->compiled[i] = true;
+                }
+            }
+            arena.reset();
+        }
+
+        bool last = batch->last;
+        compiled_batches.push(batch);
+        if (last) return;
+    }
+}
+
+void StreamPipeline::evaluate_stage(BufferedOutput& output) {
+    exception_ptr write_error;
+    EvaluationError error;
+
+    while (true) {
+        StreamBatch* batch = compiled_batches.pop();
+
+        // Depois de um erro de escrita só esvazia o pipeline
+        if (!write_error) {
+            EDOO_PROFILE_TRACE("avaliação");
+            string& text = output.data();
+            for (size_t i = 0; i < batch->lines.size(); i++) {
+                if (!batch->compiled[i]) {
+                    text += "error\n";
+                    continue;
+                }
+                variant<int, bool> value;
+                if (VirtualMachine::try_run(batch->programs[i], nullptr, value, error)) {
+                    append_result(text, value);
+                } else {
+                    EDOO_PROFILE_ERROR(error.code);
+                    text += "error\n";
+                }
+            }
+            try {
+                output.flush();
+            } catch (const IOError&) {
+                write_error = current_exception();
+            }
+        }
+
+        bool last = batch->last;
+        free_batches.push(batch);
+        if (last) break;
+    }
+    if (write_error) rethrow_exception(write_error);
+}
+
+void StreamPipeline::run(int fd, BufferedOutput& output) {
+    read_error = nullptr;
+    for (auto& batch : batches) {
+        free_batches.push(batch.get());
+    }
+
+    thread reader(&StreamPipeline::read_stage, this, fd);
+    thread compiler(&StreamPipeline::compile_stage, this);
+    exception_ptr error;
+    try {
+        evaluate_stage(output);
+    } catch (...) {
+        error = current_exception();
+    }
+    reader.join();
+    compiler.join();
+
+    // Os lotes voltam para free_batches; tira para a próxima chamada
+    StreamBatch* batch;
+    while (free_batches.try_pop(batch)) {}
+
+    if (error) rethrow_exception(error);
+    if (read_error) rethrow_exception(read_error);
+}
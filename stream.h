@@ -0,0 +1,61 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "bytecode.h"
+#include "fast_io.h"
+#include "spsc_queue.h"
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Lote de linhas que passa pelos estágios do StreamPipeline
+struct StreamBatch {
+    string text;
+    // Início e tamanho de cada linha em text
+    vector<pair<uint32_t, uint32_t>> lines;
+    // Um Program por linha, reaproveitados entre lotes
+    vector<Program> programs;
+    vector<char> compiled;
+    bool last = false;
+
+    void clear();
+};
+
+// Avalia linhas até o fim da entrada, sem o número de casos na frente. Três
+// threads formam um pipeline:
+//   leitura -> lexer/parser/compilação -> VM e formatação da saída
+// ligadas por SpscQueue. Um número fixo de lotes circula entre os estágios
+// (o último devolve ao primeiro), então a memória não cresce com o tamanho
+// da entrada e a leitura para quando os estágios seguintes estão atrasados.
+// A saída de cada lote é escrita assim que ele é avaliado.
+//
+// Todas as linhas são avaliadas pelo bytecode, que dá os mesmos resultados
+// (e erros) da árvore; linhas vazias dão "error", como no modo normal
+class StreamPipeline {
+    public:
+        static constexpr size_t BATCH_COUNT = 8;
+        static constexpr size_t BATCH_LINES = 512;
+
+    private:
+        bool optimize;
+        vector<unique_ptr<StreamBatch>> batches;
+        SpscQueue<StreamBatch*, BATCH_COUNT> free_batches;
+        SpscQueue<StreamBatch*, BATCH_COUNT> read_batches;
+        SpscQueue<StreamBatch*, BATCH_COUNT> compiled_batches;
+        exception_ptr read_error;
+
+        void read_stage(int fd);
+        void compile_stage();
+        void evaluate_stage(BufferedOutput& output);
+
+    public:
+        explicit StreamPipeline(bool optimize = false);
+
+        // Lê de fd até o fim e escreve um resultado por linha em output
+        void run(int fd, BufferedOutput& output);
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+#include <variant>
+#include <vector>
+#include "parser.h"
+#include "batch.h"
+using namespace std;
+
+// Compara cada linha da coluna de saída com a avaliação linha a linha
+static void check_against_rows(const CompiledExpression& rule, const BatchResult& result,
+                               const vector<vector<int32_t>>& rows) {
+    for (size_t row = 0; row < rows.size(); row++) {
+        bool row_failed = false;
+        variant<int, bool> expected;
+        try {
+            expected = rule.evaluate(rows[row]);
+        } catch (const ExpressionError&) {
+            row_failed = true;
+        }
+        assert(result.has_error(row) == row_failed);
+        if (!row_failed) {
+            assert(result.get(row) == expected);
+        }
+    }
+}
+
+void test_all_operators() {
+    cout << "Testando kernels contra a avaliação por linha..." << endl;
+
+    Variables variables;
+    uint32_t x = variables.declare("x", ValueType::INTEGER);
+    uint32_t y = variables.declare("y", ValueType::INTEGER);
+    uint32_t p = variables.declare("p", ValueType::BOOLEAN);
+    uint32_t q = variables.declare("q", ValueType::BOOLEAN);
+
+    // Tamanho que não é múltiplo do bloco nem do número de lanes
+    const size_t ROWS = 3 * BatchEvaluator::BLOCK_SIZE + 13;
+    mt19937 rng(7);
+    uniform_int_distribution<int32_t> small(-5, 5);
+    vector<int32_t> xs(ROWS), ys(ROWS);
+    unique_ptr<bool[]> ps(new bool[ROWS]), qs(new bool[ROWS]);
+    vector<vector<int32_t>> rows(ROWS, vector<int32_t>(variables.size()));
+    for (size_t i = 0; i < ROWS; i++) {
+        xs[i] = (i % 100 == 0) ? INT32_MAX : small(rng);
+        ys[i] = small(rng);
+        ps[i] = rng() & 1;
+        qs[i] = rng() & 1;
+        rows[i][x] = xs[i];
+        rows[i][y] = ys[i];
+        rows[i][p] = ps[i];
+        rows[i][q] = qs[i];
+    }
+
+    ColumnBatch columns(ROWS);
+    columns.bind(x, xs.data());
+    columns.bind(y, ys.data());
+    columns.bind(p, ps.get());
+    columns.bind(q, qs.get());
+
+    const char* inputs[] = {
+        "x + y", "x - y", "x * y", "x / y", "- x", "x * 3 - y / 2",
+        "x < y", "x > y", "x <= y", "x >= y", "x == y", "x != y",
+        "p && q", "p || q", "p == q", "p != q",
+        "( x / y > 0 ) == p || q", "10 / ( x - y ) + 1 < 3 && p",
+        // Curto-circuito: a divisão só falha nas linhas que a esquerda não decidiu
+        "p || 10 / ( x - y ) > 2", "x > 2147483646 && 1 / y > 0", "p && ( q || 1 / y > 0 ) || 10 / x > 1",
+        "x", "p", "7", "true"
+    };
+
+    ExpressionEvaluator evaluator;
+    BatchEvaluator batch;
+    for (const char* input : inputs) {
+        CompiledExpression rule = evaluator.compile(input, variables);
+        BatchResult result = batch.evaluate(rule, columns);
+        assert(result.size() == ROWS);
+        assert(result.type == rule.get_type());
+        check_against_rows(rule, result, rows);
+        cout << "Teste: " << input << " OK (" << result.error_count() << " erros)" << endl;
+    }
+}
+
+void test_division_errors() {
+    cout << "Testando bitmap de erros..." << endl;
+
+    Variables variables;
+    uint32_t d = variables.declare("d", ValueType::INTEGER);
+    ExpressionEvaluator evaluator;
+    CompiledExpression rule = evaluator.compile("100 / d", variables);
+
+    vector<int32_t> ds = {1, 0, 4, 0, 5};
+    ColumnBatch columns(ds.size());
+    columns.bind(d, ds.data());
+    BatchResult result = BatchEvaluator().evaluate(rule, columns);
+
+    assert(result.error_count() == 2);
+    assert(!result.has_error(0) && result.has_error(1) && result.has_error(3));
+    assert(get<int>(result.get(2)) == 25);
+    try {
+        result.get(1);
+        assert(false);
+    } catch (const ExpressionError& e) {
+        assert(string(e.what()) == "Divisão por zero");
+    }
+}
+
+void test_missing_columns() {
+    cout << "Testando colunas ausentes..." << endl;
+
+    Variables variables;
+    uint32_t x = variables.declare("x", ValueType::INTEGER);
+    variables.declare("p", ValueType::BOOLEAN);
+    ExpressionEvaluator evaluator;
+    CompiledExpression rule = evaluator.compile("x > 0 && p", variables);
+
+    vector<int32_t> xs(10, 1);
+    ColumnBatch columns(xs.size());
+    columns.bind(x, xs.data());
+    try {
+        BatchEvaluator().evaluate(rule, columns);
+        assert(false);
+    } catch (const VariableError& e) {
+        cout << e.what() << endl;
+    }
+
+    // Coluna inteira onde a variável é booleana
+    columns.bind(rule.slot("p"), xs.data());
+    try {
+        BatchEvaluator().evaluate(rule, columns);
+        assert(false);
+    } catch (const VariableError& e) {
+        cout << e.what() << endl;
+    }
+}
+
+int main() {
+    cout << "Kernels: " << BatchEvaluator::instruction_set() << endl;
+    test_all_operators();
+    test_division_errors();
+    test_missing_columns();
+
+    cout << "Todos os testes de avaliação em colunas passaram!" << endl;
+    return 0;
+}
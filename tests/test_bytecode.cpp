@@ -0,0 +1,188 @@
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <variant>
+#include "parser.h"
+#include "bytecode.h"
+using namespace std;
+
+// Conta as alocações do processo, para ver que o VM não aloca ao avaliar
+static size_t allocation_count = 0;
+
+void* operator new(size_t size) {
+    allocation_count++;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void* operator new(size_t size, align_val_t alignment) {
+    allocation_count++;
+    size_t a = static_cast<size_t>(alignment);
+    if (void* p = aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, align_val_t) noexcept { free(p); }
+
+// Resultado de uma avaliação: valor ou mensagem de erro
+struct Outcome {
+    bool ok;
+    variant<int, bool> value;
+    string message;
+};
+
+static Outcome run(ExpressionEvaluator& evaluator, const string& input) {
+    try {
+        return {true, evaluator.evaluate(input), ""};
+    } catch (const exception& e) {
+        return {false, 0, e.what()};
+    }
+}
+
+// Os dois motores devem concordar em valores e em mensagens de erro
+void test_engines_agree() {
+    cout << "Comparando árvore e bytecode..." << endl;
+
+    ExpressionEvaluator tree(Engine::TREE);
+    ExpressionEvaluator bytecode(Engine::BYTECODE);
+
+    const char* cases[] = {
+        "1", "-7", "2 + 3 * 2", "( 2 - - -3 ) * 2", "3 / 2", "1 + 2 + 3 - 4",
+        "true || false == false", "( true || false ) == false", "true + 3",
+        "42 >= ( ( 6 * ( 8 - 1 ) ) + 1 )", "( ( 43 <= 42 ) || false ) != true",
+        "5 / 0", "( 1 / 0 ) + true", "true + ( 1 / 0 )", "- true", "- ( 4 * 2 )",
+        "false == ( 7 > 10 )", "true && 2 > 1", "0 == false", "3 || 3",
+        "( 50 >= ( 25 * ( 4 / 2 ) ) && ( false == false ) )", "1 2", "( 1 + 2"
+    };
+
+    for (const char* input : cases) {
+        Outcome expected = run(tree, input);
+        Outcome actual = run(bytecode, input);
+        assert(expected.ok == actual.ok);
+        if (expected.ok) {
+            assert(expected.value == actual.value);
+        } else {
+            assert(expected.message == actual.message);
+        }
+        tree.reset();
+        bytecode.reset();
+        cout << "Teste: " << input << " OK" << endl;
+    }
+}
+
+void test_program_layout() {
+    cout << "Testando o bytecode gerado..." << endl;
+
+    Arena arena;
+    Lexer lexer("( 1 + 2 ) < 4 && true");
+    Parser parser(lexer, arena);
+    auto expr = parser.parse();
+
+    Compiler compiler;
+    Program program = compiler.compile(*expr);
+
+    OpCode expected[] = {
+        OpCode::PUSH_INT, OpCode::PUSH_INT, OpCode::ADD_I, OpCode::PUSH_INT,
+        OpCode::LT_I, OpCode::JUMP_IF_FALSE, OpCode::PUSH_BOOL, OpCode::AND_B, OpCode::HALT
+    };
+    assert(program.code.size() == sizeof(expected) / sizeof(expected[0]));
+    for (size_t i = 0; i < program.code.size(); i++) {
+        assert(program.code[i].op == expected[i]);
+    }
+    // O salto cai logo depois do AND_B
+    assert(program.code[5].operand == 3);
+    assert(program.result_type == ValueType::BOOLEAN);
+    assert(program.max_stack == 2);
+    assert(get<bool>(VirtualMachine::run(program)) == true);
+    cout << program.to_string();
+}
+
+// && e || não avaliam a direita quando a esquerda decide, em todos os
+// motores, mas uma direita mal tipada continua sendo um erro
+void test_short_circuit() {
+    cout << "Testando curto-circuito..." << endl;
+
+    struct Case {
+        const char* input;
+        bool ok;
+        bool value;
+    };
+    const Case cases[] = {
+        {"false && 1 / 0 == 1", true, false},
+        {"true || 1 / 0 == 1", true, true},
+        {"true && 1 / 0 == 1", false, false},
+        {"false || 1 / 0 == 1", false, false},
+        {"( 1 > 2 && 1 / 0 > 0 ) == false", true, true},
+        {"false && ( true || 1 / 0 > 0 ) || 2 / 0 > 0", false, false},
+        {"true || ( false && 3 > 1 ) == ( 1 / 0 > 0 )", true, true},
+        {"false && 3", false, false},
+        {"true || 3", false, false},
+        {"false && ( 1 + true )", false, false},
+    };
+
+    for (Engine engine : {Engine::TREE, Engine::BYTECODE, Engine::TYPED}) {
+        for (bool optimize : {false, true}) {
+            ExpressionEvaluator evaluator(engine, optimize);
+            ExpressionEvaluator reference(Engine::TREE);
+            for (const Case& c : cases) {
+                Outcome actual = run(evaluator, c.input);
+                assert(actual.ok == c.ok);
+                if (c.ok) {
+                    assert(get<bool>(actual.value) == c.value);
+                } else if (engine != Engine::TYPED) {
+                    assert(actual.message == run(reference, c.input).message);
+                }
+                evaluator.reset();
+                reference.reset();
+
+                EvaluationResult result = evaluator.try_evaluate(c.input);
+                assert(result.ok() == c.ok);
+                if (c.ok) assert(get<bool>(result.get_value()) == c.value);
+                evaluator.reset();
+            }
+        }
+    }
+
+    // Cadeia funda o bastante para a avaliação sem recursão
+    string input = "false";
+    for (int i = 0; i < 50000; i++) input += " && 1 / 0 > 0";
+    ExpressionEvaluator tree(Engine::TREE);
+    assert(get<bool>(tree.evaluate(input)) == false);
+    ExpressionEvaluator bytecode(Engine::BYTECODE);
+    assert(get<bool>(bytecode.evaluate(input)) == false);
+    cout << "Curto-circuito OK" << endl;
+}
+
+// Pilhas acima das 64 posições na stack: o buffer da thread é alocado na
+// primeira avaliação e reaproveitado nas seguintes
+void test_large_stack() {
+    cout << "Testando pilhas grandes..." << endl;
+
+    string input = "1";
+    for (int i = 0; i < 200; i++) input = "1 + ( " + input + " )";
+    Arena arena;
+    Program program = Compiler().compile(*Parser(Lexer(input), arena).parse());
+    assert(program.max_stack > 64);
+
+    variant<int, bool> value;
+    EvaluationError error;
+    assert(VirtualMachine::try_run(program, nullptr, value, error) && get<int>(value) == 201);
+    size_t before = allocation_count;
+    for (int i = 0; i < 1000; i++) {
+        assert(VirtualMachine::try_run(program, nullptr, value, error) && get<int>(value) == 201);
+    }
+    assert(allocation_count == before);
+}
+
+int main() {
+    test_engines_agree();
+    test_program_layout();
+    test_short_circuit();
+    test_large_stack();
+
+    cout << "Todos os testes de bytecode passaram!" << endl;
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <variant>
+#include <vector>
+#include "parser.h"
+#include "compiled_expression.h"
+using namespace std;
+
+void test_identifiers() {
+    cout << "Testando identificadores no Lexer..." << endl;
+
+    string input = "x1 + _y == true && falsey";
+    Lexer lexer(input);
+    TokenType expected[] = {
+        TokenType::IDENTIFIER, TokenType::PLUS, TokenType::IDENTIFIER, TokenType::EQUALS,
+        TokenType::BOOLEAN, TokenType::AND, TokenType::IDENTIFIER, TokenType::END_OF_FILE
+    };
+    for (TokenType type : expected) {
+        Token token = lexer.get_next_token();
+        assert(token.get_type() == type);
+        cout << token.to_string(input) << " ";
+    }
+    cout << endl;
+
+    // Sem declarações, avaliar uma variável é erro
+    ExpressionEvaluator evaluator;
+    try {
+        evaluator.evaluate("abc");
+        assert(false);
+    } catch (const ExpressionError& e) {
+        assert(string(e.what()) == "Variável sem valor: abc");
+    }
+}
+
+void test_compile_once_evaluate_many() {
+    cout << "Testando compilar uma vez e avaliar muitas..." << endl;
+
+    Variables variables;
+    uint32_t x = variables.declare("x", ValueType::INTEGER);
+    uint32_t y = variables.declare("y", ValueType::INTEGER);
+    uint32_t flag = variables.declare("flag", ValueType::BOOLEAN);
+
+    ExpressionEvaluator evaluator;
+    CompiledExpression rule = evaluator.compile("x * 2 + y > 10 && flag", variables);
+    assert(rule.get_type() == ValueType::BOOLEAN);
+    assert(rule.slot("y") == y);
+
+    vector<int32_t> slots(variables.size());
+    for (int i = -20; i <= 20; i++) {
+        for (int f = 0; f <= 1; f++) {
+            slots[x] = i;
+            slots[y] = 3;
+            slots[flag] = f;
+            assert(get<bool>(rule.evaluate(slots)) == (i * 2 + 3 > 10 && f));
+        }
+    }
+
+    CompiledExpression division = evaluator.compile("( x + 1 ) / y", variables);
+    slots[x] = 9;
+    slots[y] = 2;
+    assert(get<int>(division.evaluate(slots)) == 5);
+    slots[y] = 0;
+    try {
+        division.evaluate(slots);
+        assert(false);
+    } catch (const ExpressionError& e) {
+        assert(string(e.what()) == "Divisão por zero");
+    }
+}
+
+void test_identities_with_variables() {
+    cout << "Testando identidades com variáveis..." << endl;
+
+    Variables variables;
+    variables.declare("x", ValueType::INTEGER);
+    variables.declare("b", ValueType::BOOLEAN);
+
+    ExpressionEvaluator evaluator;
+    const char* integer_rules[] = {"x * 1", "1 * x", "x + 0", "0 + x", "x - 0", "x / 1", "- ( - x )", "( ( x ) )"};
+    for (const char* input : integer_rules) {
+        auto rule = evaluator.compile(input, variables);
+        const auto& code = rule.get_program().code;
+        assert(code.size() == 2 && code[0].op == OpCode::LOAD_I);
+        cout << "Teste: " << input << " OK" << endl;
+    }
+    const char* boolean_rules[] = {"true && b", "b && true", "false || b", "b || false"};
+    for (const char* input : boolean_rules) {
+        auto rule = evaluator.compile(input, variables);
+        const auto& code = rule.get_program().code;
+        assert(code.size() == 2 && code[0].op == OpCode::LOAD_B);
+        cout << "Teste: " << input << " OK" << endl;
+    }
+}
+
+void test_compile_errors() {
+    cout << "Testando erros de compilação..." << endl;
+
+    Variables variables;
+    variables.declare("x", ValueType::INTEGER);
+    variables.declare("b", ValueType::BOOLEAN);
+
+    ExpressionEvaluator evaluator;
+    try {
+        evaluator.compile("x + z", variables);
+        assert(false);
+    } catch (const ParserError& e) {
+        cout << e.what() << endl;
+    }
+    try {
+        evaluator.compile("x + b", variables);
+        assert(false);
+    } catch (const TypeError& e) {
+        cout << e.what() << endl;
+    }
+    try {
+        variables.declare("x", ValueType::BOOLEAN);
+        assert(false);
+    } catch (const VariableError& e) {
+        cout << e.what() << endl;
+    }
+}
+
+int main() {
+    test_identifiers();
+    test_compile_once_evaluate_many();
+    test_identities_with_variables();
+    test_compile_errors();
+
+    cout << "Todos os testes de expressões compiladas passaram!" << endl;
+    return 0;
+}
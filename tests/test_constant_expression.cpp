@@ -0,0 +1,161 @@
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+#include <variant>
+#include "constant_expression.h"
+#include "parser.h"
+using namespace std;
+
+// Avaliadas pelo compilador: se alguma delas não fosse constante, o arquivo
+// não compilaria
+static_assert("1 + 2 * 3"_expr.as_int() == 7);
+static_assert("( 1 + 2 ) * 3"_expr.as_int() == 9);
+static_assert("10 - 4 - 3"_expr.as_int() == 3);
+static_assert("-7 / 2"_expr.as_int() == -3);
+static_assert("- ( 2 + 3 )"_expr.as_int() == -5);
+static_assert("2147483647 + 1"_expr.as_int() == -2147483647 - 1);
+static_assert("1 < 2 && 3 >= 3"_expr.as_bool());
+static_assert("true == false || 4 != 4"_expr.as_bool() == false);
+static_assert("  ( ( 42 ) )\t"_expr.is_int());
+// O lado direito não é avaliado, e a divisão por zero não acontece
+static_assert("false && 1 / 0 > 0"_expr.as_bool() == false);
+static_assert("true || 2 / 0 == 1"_expr.as_bool());
+
+constexpr int TABLE_SIZE = "4 * 16"_expr.as_int();
+static_assert(TABLE_SIZE == 64);
+
+// Erros pelo try_evaluate_constant, sem sair do constexpr
+static_assert(try_evaluate_constant("1 / 0").error.code == ErrorCode::DIVISION_BY_ZERO);
+static_assert(try_evaluate_constant("1 + true").error.code == ErrorCode::MIXED_TYPES);
+static_assert(try_evaluate_constant("1 +").error.code == ErrorCode::UNEXPECTED_TOKEN);
+static_assert(try_evaluate_constant("1 @ 2").error.offset == 2);
+static_assert(try_evaluate_constant("").error.code == ErrorCode::EMPTY_EXPRESSION);
+
+// Um erro de compilação, por exemplo
+//     constexpr int n = "1 / 0"_expr.as_int();
+// aponta para division_by_zero_in_constant_expression
+
+static string describe(const EvaluationResult& result) {
+    if (!result.ok()) return "erro: " + result.get_error().message();
+    const auto& value = result.get_value();
+    return holds_alternative<int>(value) ? to_string(get<int>(value)) : (get<bool>(value) ? "true" : "false");
+}
+
+static string describe(const ConstantResult& result) {
+    if (!result.ok()) return "erro: " + result.error.to_error().message();
+    return result.value.is_int() ? to_string(result.value.as_int()) : (result.value.as_bool() ? "true" : "false");
+}
+
+// O mesmo código, posição e mensagem que ExpressionEvaluator::try_evaluate
+static void check(ExpressionEvaluator& evaluator, const string& input) {
+    EvaluationResult expected = evaluator.try_evaluate(input);
+    ConstantResult found = try_evaluate_constant(input);
+    if (describe(expected) != describe(found)) {
+        cout << "'" << input << "': " << describe(expected) << " != " << describe(found) << endl;
+    }
+    assert(expected.ok() == found.ok());
+    if (expected.ok()) {
+        assert(found.value.to_variant() == expected.get_value());
+    } else {
+        assert(found.error.code == expected.get_error().code);
+        assert(found.error.offset == expected.get_error().offset);
+        assert(found.error.to_error().message() == expected.get_error().message());
+    }
+}
+
+void test_fixed_inputs() {
+    cout << "Testando entradas fixas..." << endl;
+
+    ExpressionEvaluator evaluator;
+    const string inputs[] = {
+        "", " ", "1", "-1", "- 1", "- - 1", "-(1)", "( 1", "1 )", "1 2", "( )",
+        "2147483647", "2147483648", "-2147483648", "-2147483649", "12a", "1 @ 2",
+        "1 & 2", "1 | 2", "1 = 2", "1 ! 2", "true", "- true", "- x", "x", "x + 1",
+        "1 + x", "false && x", "true && x", "x || true", "1 && 2", "true + false",
+        "true < false", "1 == true", "1 / 0", "1 / 0 + ( true + 1 )", "( true + 1 ) + 1 / 0",
+        "1 / ( 2 - 2 )", "false || 1 / 0 == 0", "true || 1 / 0 == 0", "1 <= 2 == ( 3 >= 4 )",
+        "1 < 2 < 3", "2 * 3 + 4 * 5 - 6 / 2", "2147483647 * 2", "-2147483648 - 1",
+        string("1 + 2\0 + 3", 10), "1\n+\t2",
+    };
+    for (const string& input : inputs) {
+        check(evaluator, input);
+    }
+}
+
+// Expressões aleatórias, bem e mal formadas, com variáveis
+void test_random_inputs() {
+    cout << "Testando entradas aleatórias..." << endl;
+
+    static const char* pieces[] = {
+        "1", "0", "7", "-3", "true", "false", "x", "+", "-", "*", "/", "<", ">", "<=", ">=",
+        "==", "!=", "&&", "||", "(", ")", "( 2 )", "- 2", "@"
+    };
+    constexpr size_t piece_count = sizeof(pieces) / sizeof(pieces[0]);
+    mt19937 rng(17);
+    ExpressionEvaluator evaluator;
+    size_t values = 0;
+    for (int i = 0; i < 20000; i++) {
+        string input;
+        // Operando e operador alternados na maior parte das vezes, para
+        // chegar na avaliação e não só em erros de sintaxe
+        size_t length = 1 + rng() % 9;
+        for (size_t j = 0; j < length; j++) {
+            if (j) input += " ";
+            if (rng() % 5 == 0) {
+                input += pieces[rng() % piece_count];
+            } else if (j % 2 == 0) {
+                input += pieces[rng() % 7];
+            } else {
+                input += pieces[7 + rng() % 12];
+            }
+        }
+        check(evaluator, input);
+        values += evaluator.try_evaluate(input).ok();
+    }
+    cout << "Aleatórias OK (" << values << " com valor)" << endl;
+}
+
+void test_exceptions() {
+    cout << "Testando exceções fora de um contexto constante..." << endl;
+
+    ExpressionEvaluator evaluator;
+    for (const char* input : {"1 / 0", "1 + true", "1 +", "1 @ 2", "x", "- true"}) {
+        string expected;
+        try {
+            evaluator.evaluate(input);
+            assert(false);
+        } catch (const exception& e) {
+            expected = e.what();
+        }
+        try {
+            evaluate_constant(input);
+            assert(false);
+        } catch (const ExpressionError& e) {
+            assert(e.what() == expected);
+        } catch (const ParserError& e) {
+            assert(e.what() == expected);
+        } catch (const LexerError& e) {
+            assert(e.what() == expected);
+        }
+    }
+
+    try {
+        evaluate_constant("1").as_bool();
+        assert(false);
+    } catch (const bad_variant_access&) {
+    }
+
+    // Com uma string de tempo de execução, evaluate_constant roda normalmente
+    string input = "3 * 3";
+    assert(evaluate_constant(input).as_int() == 9);
+}
+
+int main() {
+    test_fixed_inputs();
+    test_random_inputs();
+    test_exceptions();
+
+    cout << "Todos os testes de expressões constantes passaram!" << endl;
+    return 0;
+}
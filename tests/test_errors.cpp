@@ -0,0 +1,162 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <typeinfo>
+#include "parser.h"
+using namespace std;
+
+// Exceção que evaluate lança para input (tipo e mensagem)
+static pair<string, string> thrown_by(ExpressionEvaluator& evaluator, const string& input) {
+    try {
+        evaluator.evaluate(input);
+    } catch (const exception& e) {
+        evaluator.reset();
+        return {typeid(e).name(), e.what()};
+    }
+    evaluator.reset();
+    return {"", ""};
+}
+
+static pair<string, string> raised_by(const EvaluationError& error) {
+    try {
+        error.raise();
+    } catch (const exception& e) {
+        return {typeid(e).name(), e.what()};
+    }
+    return {"", ""};
+}
+
+void test_error_codes_and_offsets() {
+    cout << "Testando códigos e posições dos erros..." << endl;
+
+    struct TestCase {
+        string input;
+        ErrorCode code;
+        uint32_t offset;
+    };
+    TestCase cases[] = {
+        {"", ErrorCode::EMPTY_EXPRESSION, 0},
+        {"1 + 99999999999", ErrorCode::INTEGER_OUT_OF_RANGE, 4},
+        {"1 + -", ErrorCode::INVALID_INTEGER, 4},
+        {"1 $ 2", ErrorCode::UNKNOWN_TOKEN, 2},
+        {"(1 + 2", ErrorCode::EXPECTED_TOKEN, 6},
+        {"1 2", ErrorCode::TRAILING_TOKEN, 2},
+        {"1 + * 2", ErrorCode::UNEXPECTED_TOKEN, 4},
+        {"x + 1", ErrorCode::UNBOUND_VARIABLE, 0},
+        {"- true", ErrorCode::INVALID_BOOLEAN_UNARY, 0},
+        {"true + false", ErrorCode::UNKNOWN_LOGICAL_OPERATOR, 5},
+        {"true && 1 < 2 * false", ErrorCode::MIXED_TYPES, 14},
+        {"10 / (3 - 3)", ErrorCode::DIVISION_BY_ZERO, 3},
+    };
+
+    ExpressionEvaluator evaluator;
+    for (const auto& test : cases) {
+        EvaluationResult result = evaluator.try_evaluate(test.input);
+        evaluator.reset();
+        assert(!result.ok());
+        assert(result.get_error().code == test.code);
+        assert(result.get_error().offset == test.offset);
+        cout << "Teste: \"" << test.input << "\" -> " << error_code_name(test.code) << " OK" << endl;
+    }
+}
+
+// try_evaluate e evaluate concordam em tudo: valor, ou tipo e mensagem do erro
+void test_same_results_as_exceptions() {
+    cout << "Testando try_evaluate contra evaluate..." << endl;
+
+    const string inputs[] = {
+        "1 + 2 * 3", "- 5", "(4 + 5) * 6 > 50", "true && (3 < 4)", "false == (1 != 1)",
+        "", "1 +", "(1 + 2", "((1)", "1 2", ")", "1 + * 2", "1 $ 2", "1 + -", "99999999999",
+        "- true", "true + false", "1 + true", "true && 1", "1 / 0", "10 / (3 - 3)",
+        "x", "1 + y * 2", "(1 / 0) + true", "1 + true + (1 / 0)", "- - 3", "- (- true)"
+    };
+
+    // TYPED fica de fora: rejeita erros de tipo antes de avaliar, com TypeError
+    ExpressionEvaluator evaluators[] = {
+        ExpressionEvaluator(Engine::TREE), ExpressionEvaluator(Engine::BYTECODE),
+        ExpressionEvaluator(Engine::TREE, true), ExpressionEvaluator(Engine::BYTECODE, true)
+    };
+    for (auto& evaluator : evaluators) {
+        for (const auto& input : inputs) {
+            EvaluationResult result = evaluator.try_evaluate(input);
+            evaluator.reset();
+            if (result) {
+                assert(evaluator.evaluate(input) == result.get_value());
+                evaluator.reset();
+            } else {
+                auto expected = thrown_by(evaluator, input);
+                assert(raised_by(result.get_error()) == expected);
+                if (result.get_error().code != ErrorCode::EMPTY_EXPRESSION) {
+                    // EMPTY_EXPRESSION é invalid_argument, cujo what() é a mensagem crua
+                    assert(result.get_error().message() == expected.second
+                        || expected.second == "Erro léxico: " + result.get_error().message());
+                }
+            }
+        }
+    }
+    cout << "Resultados iguais aos da API com exceções OK" << endl;
+}
+
+// O Parser sozinho: try_parse não lança e guarda o primeiro erro
+void test_try_parse() {
+    cout << "Testando Parser::try_parse..." << endl;
+
+    Arena arena;
+    Lexer lexer("(1 + 2 $");
+    Parser parser(lexer, arena);
+    assert(!parser.try_parse());
+    assert(parser.get_error().code == ErrorCode::UNKNOWN_TOKEN);
+    assert(parser.get_error().offset == 7);
+    assert(parser.get_error().message() == "Erro léxico: Token desconhecido");
+
+    Variables variables;
+    variables.declare("x", ValueType::INTEGER);
+    Lexer declared("x + y");
+    Parser with_variables(declared, arena, &variables);
+    assert(!with_variables.try_parse());
+    assert(with_variables.get_error().code == ErrorCode::UNDECLARED_VARIABLE);
+    assert(with_variables.get_error().offset == 4);
+    assert(with_variables.get_error().message() == "Erro de sintaxe: Variável não declarada: y");
+
+    Lexer valid("1 + 2");
+    Parser ok(valid, arena);
+    auto expr = ok.try_parse();
+    assert(expr && !ok.get_error());
+    assert(get<int>(expr->evaluate()) == 3);
+    cout << "try_parse OK" << endl;
+}
+
+// Programas compilados guardam os erros sem montar mensagens
+void test_virtual_machine() {
+    cout << "Testando VirtualMachine::try_run..." << endl;
+
+    Arena arena;
+    Compiler compiler;
+    Lexer lexer("1 + true");
+    Parser parser(lexer, arena);
+    Program program = compiler.compile(*parser.parse());
+    assert(program.failures.size() == 1);
+    assert(program.failures[0].code == ErrorCode::MIXED_TYPES);
+
+    variant<int, bool> value;
+    EvaluationError error;
+    assert(!VirtualMachine::try_run(program, nullptr, value, error));
+    assert(error.code == ErrorCode::MIXED_TYPES && error.offset == 2);
+    assert(error.message() == "Avaliando operandos de tipos diferentes");
+
+    Lexer valid("6 * 7");
+    Parser valid_parser(valid, arena);
+    Program answer = compiler.compile(*valid_parser.parse());
+    assert(VirtualMachine::try_run(answer, nullptr, value, error));
+    assert(get<int>(value) == 42);
+    cout << "try_run OK" << endl;
+}
+
+int main() {
+    test_error_codes_and_offsets();
+    test_same_results_as_exceptions();
+    test_try_parse();
+    test_virtual_machine();
+    cout << "Todos os testes de erros passaram!" << endl;
+    return 0;
+}
@@ -4,6 +4,9 @@
 
 using namespace std;
 
+// Arena compartilhada pelos nós criados nos testes
+static Arena arena;
+
 // Função auxiliar para imprimir resultados de testes
 void printTestResult(const string& testName, bool passed) {
     cout << (passed ? "[PASS]" : "[FAIL]") << " " << testName << endl;
@@ -20,52 +23,45 @@ void testLiteral() {
 
 // Teste para Expressões Primárias
 void testPrimaryExpression() {
-    Literal* literal = new Literal(99);
-    PrimaryExpression expr(literal);
+    PrimaryExpression expr(arena_new<Literal>(arena, 99));
     printTestResult("Primary Expression Integer", std::get<int>(expr.evaluate()) == 99);
 
-    Literal* literalBool = new Literal(false);
-    PrimaryExpression exprBool(literalBool, true);
+    PrimaryExpression exprBool(arena_new<Literal>(arena, false), true);
     printTestResult("Primary Expression Boolean (Parenthesized)", std::get<bool>(exprBool.evaluate()) == false);
 
-    Literal* literaInt = new Literal(10);
-    PrimaryExpression exprInt(literaInt, true);
+    PrimaryExpression exprInt(arena_new<Literal>(arena, 10), true);
     printTestResult("Primary Expression Integer (Parenthesized)", std::get<int>(exprInt.evaluate()) == 10);
 }
 
 // Teste para Expressões Unárias
 void testUnaryExpression() {
-    Literal* literal = new Literal(5);
-    PrimaryExpression* primary = new PrimaryExpression(literal);
-    UnaryExpression negateExpr(primary, "-");
+    auto primary = arena_new<PrimaryExpression>(arena, arena_new<Literal>(arena, 5));
+    UnaryExpression negateExpr("-", move(primary));
     printTestResult("Unary Expression Negate Integer", std::get<int>(negateExpr.evaluate()) == -5);
 
-    Literal* literalNoOp = new Literal(10);
-    PrimaryExpression* primaryNoOp = new PrimaryExpression(literalNoOp);
-    UnaryExpression noOpExpr(primaryNoOp, "");
-    printTestResult("Unary Expression No Operation", std::get<int>(noOpExpr.evaluate()) == 10);
+    auto primaryNoOp = arena_new<PrimaryExpression>(arena, arena_new<Literal>(arena, 10));
+    UnaryExpression noOpExpr("", move(primaryNoOp));
+    try {
+        noOpExpr.evaluate();
+        printTestResult("Unary Expression Unknown Operator", false); // Deve lançar exceção
+    } catch (const ExpressionError&) {
+        printTestResult("Unary Expression Unknown Operator", true); // Exceção esperada
+    }
 
-    Literal* literalNeg = new Literal(-10);
-    PrimaryExpression* primaryNeg = new PrimaryExpression(literalNeg);
-    UnaryExpression negExpr(primaryNeg, "-");
+    auto primaryNeg = arena_new<PrimaryExpression>(arena, arena_new<Literal>(arena, -10));
+    UnaryExpression negExpr("-", move(primaryNeg));
     printTestResult("Unary Expression Negate", std::get<int>(negExpr.evaluate()) == 10);
 }
 
 // Teste para Expressões Binárias
 void testBinaryExpression() {
-    Literal* left = new Literal(3);
-    Literal* right = new Literal(4);
-    BinaryExpression addExpr("+", left, right);
+    BinaryExpression addExpr(arena_new<Literal>(arena, 3), "+", arena_new<Literal>(arena, 4));
     printTestResult("Binary Expression Addition", std::get<int>(addExpr.evaluate()) == 7);
 
-    Literal* leftBool = new Literal(true);
-    Literal* rightBool = new Literal(false);
-    BinaryExpression andExpr("&&", leftBool, rightBool);
+    BinaryExpression andExpr(arena_new<Literal>(arena, true), "&&", arena_new<Literal>(arena, false));
     printTestResult("Binary Expression AND", std::get<bool>(andExpr.evaluate()) == false);
 
-    Literal* leftDiv = new Literal(10);
-    Literal* rightZero = new Literal(0);
-    BinaryExpression divExpr("/", leftDiv, rightZero);
+    BinaryExpression divExpr(arena_new<Literal>(arena, 10), "/", arena_new<Literal>(arena, 0));
     try {
         divExpr.evaluate();
         printTestResult("Binary Expression Division by Zero", false); // Deve lançar exceção
@@ -73,9 +69,7 @@ void testBinaryExpression() {
         printTestResult("Binary Expression Division by Zero", true); // Exceção esperada
     }
 
-    Literal* leftUnknown = new Literal(10);
-    Literal* rightUnknown = new Literal(20);
-    BinaryExpression unknownExpr("%", leftUnknown, rightUnknown);
+    BinaryExpression unknownExpr(arena_new<Literal>(arena, 10), "%", arena_new<Literal>(arena, 20));
     try {
         unknownExpr.evaluate();
         printTestResult("Binary Expression Unknown Operator", false); // Deve lançar exceção
@@ -86,12 +80,8 @@ void testBinaryExpression() {
 
 // Teste para Expressões Complexas
 void testComplexExpression() {
-    Literal* leftLiteral = new Literal(2);
-    Literal* rightLiteral = new Literal(3);
-    BinaryExpression* innerExpr = new BinaryExpression("*", leftLiteral, rightLiteral);
-
-    Literal* outerLiteral = new Literal(5);
-    BinaryExpression expr("+", innerExpr, outerLiteral);
+    auto innerExpr = arena_new<BinaryExpression>(arena, arena_new<Literal>(arena, 2), "*", arena_new<Literal>(arena, 3));
+    BinaryExpression expr(move(innerExpr), "+", arena_new<Literal>(arena, 5));
 
     printTestResult("Complex Expression Nested Binary", std::get<int>(expr.evaluate()) == 11);
 }
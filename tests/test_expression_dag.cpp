@@ -0,0 +1,201 @@
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <variant>
+#include "parser.h"
+using namespace std;
+
+static uint32_t intern(ExpressionDag& dag, Arena& arena, const string& input) {
+    Lexer lexer(input);
+    Parser parser(lexer, arena);
+    auto expr = parser.parse();
+    uint32_t id = dag.intern(*expr);
+    expr.reset();
+    arena.reset();
+    return id;
+}
+
+// O resultado com a posição do erro na própria linha
+static EvaluationResult located(ExpressionDag& dag, Arena& arena, const string& input) {
+    Lexer lexer(input);
+    Parser parser(lexer, arena);
+    auto expr = parser.parse();
+    EvaluationResult result = dag.result(dag.intern(*expr), *expr);
+    expr.reset();
+    arena.reset();
+    return result;
+}
+
+static string describe(const EvaluationResult& result) {
+    if (!result.ok()) return "erro: " + result.get_error().message();
+    const auto& value = result.get_value();
+    return holds_alternative<int>(value) ? to_string(get<int>(value)) : (get<bool>(value) ? "true" : "false");
+}
+
+void test_sharing() {
+    cout << "Testando compartilhamento de subárvores..." << endl;
+
+    ExpressionDag dag;
+    Arena arena;
+    // 5, 3, > e &&: os parênteses não viram nós
+    uint32_t root = intern(dag, arena, "( 5 > 3 ) && ( 5 > 3 )");
+    assert(dag.size() == 4);
+    assert(get<bool>(dag.result(root).get_value()) == true);
+    ExpressionDag::Statistics statistics = dag.statistics();
+    assert(statistics.occurrences == 7 && statistics.distinct == 4);
+
+    // Entre linhas: a mesma expressão devolve a mesma raiz, e só o que é
+    // novo entra
+    assert(intern(dag, arena, "5 > 3 && 5 > 3") == root);
+    assert(dag.size() == 4);
+    uint32_t other = intern(dag, arena, "( 5 > 3 ) || 2 * ( 5 > 3 ) == 0");
+    assert(dag.size() == 9);
+    assert(describe(dag.result(other)) == "erro: Avaliando operandos de tipos diferentes");
+    assert(dag.statistics().ratio() > 2.0);
+
+    // Mesma estrutura, tipos diferentes: 1 e true não se confundem
+    uint32_t one = intern(dag, arena, "1");
+    uint32_t yes = intern(dag, arena, "true");
+    assert(one != yes);
+    // Variáveis pelo nome
+    assert(intern(dag, arena, "x") == intern(dag, arena, "( x )"));
+    assert(intern(dag, arena, "x") != intern(dag, arena, "y"));
+
+    dag.clear();
+    assert(dag.size() == 0 && dag.statistics().occurrences == 0);
+    assert(intern(dag, arena, "2 + 2") == 1);
+}
+
+void test_short_circuit() {
+    cout << "Testando curto-circuito..." << endl;
+
+    ExpressionDag dag;
+    Arena arena;
+    // O lado direito entra (com o erro guardado) mas não é propagado
+    uint32_t decided = intern(dag, arena, "false && 1 / 0 > 0");
+    assert(describe(dag.result(decided)) == "false");
+    uint32_t alone = intern(dag, arena, "1 / 0 > 0");
+    assert(describe(dag.result(alone)) == "erro: Divisão por zero");
+    // Pelo id, a posição é a da primeira ocorrência no lote (a da linha
+    // anterior); com a árvore da linha, a do '/' nela
+    assert(dag.result(alone).get_error().offset == 11);
+    assert(located(dag, arena, "1 / 0 > 0").get_error().offset == 2);
+    // Na mesma linha: o erro é o do lado que a árvore avalia, não o da
+    // primeira ocorrência
+    assert(located(dag, arena, "( false && 1 / 0 > 0 ) || 1 / 0 > 0").get_error().offset == 28);
+    assert(describe(dag.result(intern(dag, arena, "true || 1 / 0 > 0"))) == "true");
+    assert(describe(dag.result(intern(dag, arena, "true && 1 / 0 > 0"))) == "erro: Divisão por zero");
+    // Mal tipado: sem curto-circuito, como na árvore
+    assert(describe(dag.result(intern(dag, arena, "true || x"))) == "erro: Variável sem valor: x");
+    assert(describe(dag.result(intern(dag, arena, "- ( 1 < 2 )"))) == "erro: Operador Unário para Booleanos inválido: -");
+}
+
+// Expressões aleatórias num DAG que acumula muitas linhas por lote: o mesmo
+// valor ou o mesmo erro que a árvore
+void test_against_tree() {
+    cout << "Testando DAG contra a árvore..." << endl;
+
+    static const char* operators[] = {"+", "-", "*", "/", "<", ">", "<=", ">=", "==", "!=", "&&", "||"};
+    mt19937 rng(31);
+    auto pick = [&](size_t n) { return static_cast<size_t>(rng() % n); };
+    auto operand = [&]() -> string {
+        switch (pick(6)) {
+            case 0:  return pick(2) ? "true" : "false";
+            case 1:  return "x";
+            case 2:  return "2147483647";
+            default: return to_string(static_cast<int>(pick(7)) - 3);
+        }
+    };
+    function<string(size_t)> expression = [&](size_t depth) -> string {
+        if (depth == 0 || pick(4) == 0) return operand();
+        switch (pick(5)) {
+            case 0:  return pick(2) ? "- " + operand() : "- ( " + expression(depth - 1) + " )";
+            case 1:  return "( " + expression(depth - 1) + " )";
+            case 2:  return expression(depth - 1) + " " + operators[4 + pick(8)] + " " + expression(depth - 1);
+            default: return expression(depth - 1) + " " + operators[pick(12)] + " ( " + expression(depth - 1) + " )";
+        }
+    };
+
+    ExpressionDag dag;
+    Arena arena;
+    ExpressionEvaluator tree(Engine::TREE);
+    ExpressionEvaluator bytecode(Engine::BYTECODE);
+    for (int i = 0; i < 20000; i++) {
+        if (i % 500 == 0) dag.clear();
+        string input = expression(1 + i % 5);
+        string expected;
+        try {
+            expected = describe(tree.evaluate(input));
+        } catch (const exception& e) {
+            expected = string("erro: ") + e.what();
+        }
+        tree.reset();
+        EvaluationResult result = located(dag, arena, input);
+        string found = describe(result);
+        if (found != expected) cout << input << ": " << expected << " != " << found << endl;
+        assert(found == expected);
+        // A posição do erro também, na própria linha
+        if (!result) {
+            EvaluationResult reference = bytecode.try_evaluate(input);
+            bytecode.reset();
+            assert(result.get_error().offset == reference.get_error().offset);
+        }
+    }
+    assert(dag.statistics().ratio() > 1.5);
+    cout << "Árvore OK (" << dag.statistics().ratio() << "x no último lote)" << endl;
+}
+
+void test_evaluator() {
+    cout << "Testando ExpressionEvaluator com DAG..." << endl;
+
+    auto dag = make_shared<ExpressionDag>();
+    ExpressionEvaluator evaluator;
+    evaluator.set_dag(dag);
+    assert(get<int>(evaluator.evaluate("( 1 + 2 ) * ( 1 + 2 )")) == 9);
+    evaluator.reset();
+    assert(dag->size() == 4);
+
+    try {
+        evaluator.evaluate("1 / ( 1 - 1 )");
+        assert(false);
+    } catch (const ExpressionError& e) {
+        assert(string(e.what()) == "Divisão por zero");
+    }
+    evaluator.reset();
+
+    // Erros de leitura não passam pelo DAG
+    EvaluationResult result = evaluator.try_evaluate("1 +");
+    assert(!result && result.get_error().code == ErrorCode::UNEXPECTED_TOKEN);
+    size_t before = dag->size();
+    result = evaluator.try_evaluate("1 + 2 == 3");
+    assert(result && get<bool>(result.get_value()));
+    assert(dag->size() == before + 2);
+
+    // A posição do erro é a desta linha, mesmo com a subexpressão vinda de
+    // outra
+    result = evaluator.try_evaluate("false && 7 / 0 > 0");
+    assert(result && !get<bool>(result.get_value()));
+    result = evaluator.try_evaluate("7 / 0 > 0");
+    assert(!result && result.get_error().code == ErrorCode::DIVISION_BY_ZERO);
+    assert(result.get_error().offset == 2);
+    evaluator.reset();
+
+    // Profundidade sem limite, como evaluate_tree
+    string deep = "1";
+    for (int i = 0; i < 100000; i++) deep = "( " + deep + " + 1 )";
+    evaluator.reset();
+    assert(get<int>(evaluator.evaluate(deep)) == 100001);
+    evaluator.reset();
+}
+
+int main() {
+    test_sharing();
+    test_short_circuit();
+    test_against_tree();
+    test_evaluator();
+
+    cout << "Todos os testes do DAG passaram!" << endl;
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include "fast_io.h"
+using namespace std;
+
+// LineReader precisa ler exatamente o que cin >> n, cin.ignore() e getline leriam
+static void check_like_iostream(const string& text, int lines) {
+    istringstream stream(text);
+    int expected_cases = 0;
+    stream >> expected_cases;
+    stream.ignore();
+
+    LineReader reader(text);
+    int cases = 0;
+    reader.read_int(cases);
+    reader.ignore();
+    assert(cases == expected_cases);
+
+    for (int i = 0; i < lines; i++) {
+        string expected;
+        getline(stream, expected);
+        assert(reader.next_line() == expected);
+    }
+}
+
+void test_line_reader() {
+    cout << "Testando LineReader contra iostream..." << endl;
+
+    check_like_iostream("3\n1 + 2\n( 3 )\ntrue\n", 3);
+    // Sem newline no final, linha vazia, \r preservado, faltando linhas
+    check_like_iostream("  4\n1\n\n2 * 3\r\n5", 4);
+    check_like_iostream("2\n1\n", 4);
+    check_like_iostream("+7\nx\n", 1);
+    check_like_iostream("", 2);
+}
+
+// next_block precisa devolver as mesmas linhas que next_line, em blocos
+static void check_blocks(const string& text, size_t bytes) {
+    LineReader lines(text);
+    LineReader blocks(text);
+    string_view block;
+    while (!(block = blocks.next_block(bytes)).empty()) {
+        // Passa do limite só com uma linha
+        size_t newline = block.find('\n');
+        assert(block.size() <= bytes || newline == string_view::npos || newline + 1 == block.size());
+        LineReader inside(block);
+        while (!inside.at_end()) {
+            assert(inside.next_line() == lines.next_line());
+        }
+    }
+    assert(lines.at_end());
+}
+
+void test_next_block() {
+    cout << "Testando LineReader::next_block..." << endl;
+
+    string text;
+    for (int i = 0; i < 200; i++) text += string(i % 17, 'x') + "\n";
+    for (size_t bytes : {1, 5, 16, 17, 64, 1000, 100000}) {
+        check_blocks(text, bytes);
+        check_blocks(text + "sem newline", bytes);
+        check_blocks("\n\n" + text + "\n\n", bytes);
+    }
+    // Uma linha maior que o limite vai inteira num bloco só
+    LineReader reader("abcdef\ng\n");
+    assert(reader.next_block(3) == "abcdef\n");
+    assert(reader.next_block(3) == "g\n");
+    assert(reader.next_block(3).empty());
+}
+
+void test_mapped_input() {
+    cout << "Testando MappedInput..." << endl;
+
+    char path[] = "/tmp/edoo_fast_io_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    string text = "2\n1 + 1\n2 * 2\n";
+    assert(write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size()));
+    close(fd);
+
+    {
+        MappedInput input{string(path)};
+        assert(input.is_mapped());
+        assert(input.contents() == text);
+    }
+
+    // stdin redirecionado de um arquivo, já lido em parte
+    fd = open(path, O_RDONLY);
+    assert(lseek(fd, 2, SEEK_SET) == 2);
+    {
+        MappedInput input(fd);
+        assert(input.contents() == text.substr(2));
+    }
+    close(fd);
+
+    // Pipe: lido em blocos
+    int pipe_fds[2];
+    assert(pipe(pipe_fds) == 0);
+    assert(write(pipe_fds[1], text.data(), text.size()) == static_cast<ssize_t>(text.size()));
+    close(pipe_fds[1]);
+    {
+        MappedInput input(pipe_fds[0]);
+        assert(!input.is_mapped());
+        assert(input.contents() == text);
+    }
+    close(pipe_fds[0]);
+
+    try {
+        MappedInput input{string("/tmp/edoo_arquivo_que_nao_existe")};
+        assert(false);
+    } catch (const IOError& e) {
+        cout << e.what() << endl;
+    }
+    unlink(path);
+}
+
+void test_buffered_output() {
+    cout << "Testando BufferedOutput..." << endl;
+
+    char path[] = "/tmp/edoo_fast_io_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+
+    string expected;
+    {
+        // Capacidade pequena para forçar vários flushes
+        BufferedOutput output(fd, 16);
+        for (int i = 0; i < 100; i++) {
+            string line = to_string(i * 37) + "\n";
+            output.data() += line;
+            output.maybe_flush();
+            expected += line;
+        }
+        output.append("error\n");
+        expected += "error\n";
+    }
+    close(fd);
+
+    ifstream file(path);
+    stringstream contents;
+    contents << file.rdbuf();
+    assert(contents.str() == expected);
+    unlink(path);
+}
+
+int main() {
+    test_line_reader();
+    test_next_block();
+    test_mapped_input();
+    test_buffered_output();
+
+    cout << "Todos os testes de I/O passaram!" << endl;
+    return 0;
+}
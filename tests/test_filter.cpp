@@ -0,0 +1,170 @@
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <variant>
+#include <vector>
+#include "parser.h"
+#include "filter.h"
+using namespace std;
+
+struct Table {
+    Variables variables;
+    vector<int32_t> xs, ys;
+    unique_ptr<bool[]> ps;
+    vector<vector<int32_t>> rows;
+    ColumnBatch columns;
+
+    explicit Table(size_t size) : xs(size), ys(size), ps(new bool[size]), rows(size), columns(size) {
+        uint32_t x = variables.declare("x", ValueType::INTEGER);
+        uint32_t y = variables.declare("y", ValueType::INTEGER);
+        uint32_t p = variables.declare("p", ValueType::BOOLEAN);
+        mt19937 rng(11);
+        for (size_t i = 0; i < size; i++) {
+            xs[i] = rng() % 100;
+            ys[i] = static_cast<int32_t>(rng() % 7) - 3;
+            ps[i] = rng() % 4 == 0;
+            rows[i] = {xs[i], ys[i], ps[i]};
+        }
+        columns.bind(x, xs.data());
+        columns.bind(y, ys.data());
+        columns.bind(p, ps.get());
+    }
+};
+
+void test_selection_matches_rows() {
+    cout << "Testando vetor de seleção contra a avaliação por linha..." << endl;
+
+    Table table(5 * BatchEvaluator::BLOCK_SIZE + 77);
+    const char* inputs[] = {
+        "x < 50", "x == 7", "p", "x > 10 && x < 20", "x < 5 || x > 95",
+        "p && x >= 50 || y == 0", "( x < 30 || p ) && ( y != 1 && x * 2 > 10 )",
+        "p == ( x > 50 )", "true", "false && p"
+    };
+
+    ExpressionEvaluator evaluator;
+    FilterEvaluator filter;
+    for (const char* input : inputs) {
+        CompiledExpression rule = evaluator.compile(input, table.variables);
+        FilterResult result = filter.filter(rule, table.columns);
+
+        vector<uint32_t> expected;
+        for (size_t row = 0; row < table.rows.size(); row++) {
+            if (get<bool>(rule.evaluate(table.rows[row]))) expected.push_back(row);
+        }
+        assert(result.selection == expected);
+        assert(result.statistics[0].rows_in == table.rows.size());
+        assert(result.statistics[0].rows_passed == expected.size());
+        cout << "Teste: " << input << " OK" << endl;
+    }
+}
+
+void test_short_circuit() {
+    cout << "Testando curto-circuito por linha..." << endl;
+
+    Table table(3000);
+    ExpressionEvaluator evaluator;
+    FilterEvaluator filter;
+
+    // O lado direito só roda onde p é falso; lá a divisão falha quando y == 0
+    CompiledExpression rule = evaluator.compile("p || 10 / y > 2", table.variables);
+    FilterResult result = filter.filter(rule, table.columns);
+    cout << result.statistics_to_string();
+
+    size_t p_rows = 0, errors = 0;
+    vector<uint32_t> expected;
+    for (size_t row = 0; row < table.rows.size(); row++) {
+        bool p = table.ps[row];
+        p_rows += p;
+        errors += !p && table.ys[row] == 0;
+        if (p || (table.ys[row] != 0 && 10 / table.ys[row] > 2)) expected.push_back(row);
+    }
+    assert(result.selection == expected);
+    assert(result.statistics.size() == 3);
+    assert(result.statistics[0].predicate == "p || ( ( 10 / y ) > 2 )");
+    assert(result.statistics[1].predicate == "p");
+    assert(result.statistics[1].rows_passed == p_rows);
+    assert(result.statistics[2].rows_in == table.rows.size() - p_rows);
+    assert(result.statistics[2].errors == errors);
+
+    // && encadeado: cada nível só vê as linhas que passaram no anterior
+    rule = evaluator.compile("x < 50 && y > 0 && p", table.variables);
+    result = filter.filter(rule, table.columns);
+    cout << result.statistics_to_string();
+    const auto& stats = result.statistics;
+    assert(stats.size() == 5 && stats[2].predicate == "x < 50");
+    assert(stats[3].rows_in == stats[2].rows_passed);
+    assert(stats[4].rows_in == stats[1].rows_passed);
+    assert(stats[0].rows_passed == result.selection.size());
+}
+
+// Seleção esperada pelo VM, linha a linha: uma linha que lança não passa
+static vector<uint32_t> expected_rows(const CompiledExpression& rule, const Table& table) {
+    vector<uint32_t> expected;
+    for (size_t row = 0; row < table.rows.size(); row++) {
+        try {
+            if (get<bool>(rule.evaluate(table.rows[row]))) expected.push_back(row);
+        } catch (const ExpressionError&) {
+        }
+    }
+    return expected;
+}
+
+void test_failed_operand() {
+    cout << "Testando operando que falha sob || e &&..." << endl;
+
+    Table table(3 * BatchEvaluator::BLOCK_SIZE + 5);
+    ExpressionEvaluator evaluator;
+    FilterEvaluator filter;
+
+    // Onde y == 0 a esquerda falha: a linha não passa, mesmo com p
+    // verdadeiro, e continua falha nos && e || de cima
+    const char* inputs[] = {
+        "10 / y > 0 || p", "( 10 / y > 0 || p ) && p", "p && ( 10 / y > 0 || p )",
+        "( 10 / y > 0 && p ) || true", "( 10 / y > 0 || p ) || x >= 0"
+    };
+    for (const char* input : inputs) {
+        CompiledExpression rule = evaluator.compile(input, table.variables);
+        FilterResult result = filter.filter(rule, table.columns);
+        assert(result.selection == expected_rows(rule, table));
+        for (uint32_t row : result.selection) assert(table.ys[row] != 0 || string(input)[0] == 'p');
+        cout << "Teste: " << input << " OK" << endl;
+    }
+
+    // Expressões aleatórias de && e || sobre folhas que podem falhar
+    static const char* leaves[] = {"p", "x < 50", "10 / y > 0", "x / y == 1", "y != 0", "true", "false"};
+    mt19937 rng(5);
+    function<string(int)> expression = [&](int depth) -> string {
+        if (depth == 0 || rng() % 3 == 0) return leaves[rng() % 7];
+        return "( " + expression(depth - 1) + (rng() % 2 ? " && " : " || ") + expression(depth - 1) + " )";
+    };
+    for (int i = 0; i < 300; i++) {
+        CompiledExpression rule = evaluator.compile(expression(4), table.variables);
+        assert(filter.filter(rule, table.columns).selection == expected_rows(rule, table));
+    }
+}
+
+void test_errors() {
+    cout << "Testando erros do filtro..." << endl;
+
+    Table table(10);
+    ExpressionEvaluator evaluator;
+    FilterEvaluator filter;
+    try {
+        filter.filter(evaluator.compile("x + 1", table.variables), table.columns);
+        assert(false);
+    } catch (const ExpressionError& e) {
+        cout << e.what() << endl;
+    }
+}
+
+int main() {
+    test_selection_matches_rows();
+    test_short_circuit();
+    test_failed_operand();
+    test_errors();
+
+    cout << "Todos os testes de filtro passaram!" << endl;
+    return 0;
+}
@@ -0,0 +1,196 @@
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <variant>
+#include "parser.h"
+using namespace std;
+
+static FlatExpression flatten(Arena& arena, const string& input, const Variables* variables = nullptr) {
+    Lexer lexer(input);
+    Parser parser(lexer, arena, variables);
+    auto expr = parser.parse();
+    FlatExpression flat(*expr);
+    expr.reset();
+    arena.reset();
+    return flat;
+}
+
+static string describe(const EvaluationResult& result) {
+    if (!result.ok()) {
+        return "erro: " + result.get_error().message() + " em " + to_string(result.get_error().offset);
+    }
+    const auto& value = result.get_value();
+    return holds_alternative<int>(value) ? to_string(get<int>(value)) : (get<bool>(value) ? "true" : "false");
+}
+
+void test_layout() {
+    cout << "Testando o layout em pós-ordem..." << endl;
+
+    Variables variables;
+    variables.declare("x", ValueType::INTEGER);
+    Arena arena;
+    FlatExpression flat = flatten(arena, "( 1 + 2 ) * - x", &variables);
+    cout << flat.to_string();
+    // Parênteses não viram nós; os filhos vêm antes do pai e a raiz é o último
+    assert(flat.size() == 6);
+    assert(flat.get_op(0) == FlatOp::LITERAL && flat.get_op(1) == FlatOp::LITERAL);
+    assert(flat.get_op(2) == FlatOp::ADD && flat.get_left(2) == 0 && flat.get_right(2) == 1);
+    assert(flat.get_op(3) == FlatOp::VARIABLE);
+    assert(flat.get_op(4) == FlatOp::NEG && flat.get_left(4) == 3);
+    assert(flat.get_op(5) == FlatOp::MUL && flat.get_left(5) == 2 && flat.get_right(5) == 4);
+    for (uint32_t i = 0; i < flat.size(); i++) {
+        if (flat.get_op(i) == FlatOp::LITERAL || flat.get_op(i) == FlatOp::VARIABLE) continue;
+        assert(flat.get_left(i) < i);
+        assert(flat.get_right(i) == FlatExpression::NO_NODE || flat.get_right(i) < i);
+    }
+    assert((flat.get_literals() == vector<int32_t>{1, 2}));
+    // Bem menos que os nós da árvore, com vtable e o operador em cada um
+    assert(flat.memory() < 6 * 24 + 64);
+
+    // Reaproveita os arrays
+    flat.assign(*Parser(Lexer("true"), arena).parse());
+    assert(flat.size() == 1 && get<bool>(flat.evaluate()) == true);
+    arena.reset();
+}
+
+void test_errors() {
+    cout << "Testando erros e curto-circuito..." << endl;
+
+    Arena arena;
+    FlatExpression flat = flatten(arena, "1 + 2 / ( 3 - 3 )");
+    EvaluationResult result = flat.try_evaluate();
+    assert(!result && result.get_error().code == ErrorCode::DIVISION_BY_ZERO && result.get_error().offset == 6);
+    try {
+        flat.evaluate();
+        assert(false);
+    } catch (const ExpressionError& e) {
+        assert(string(e.what()) == "Divisão por zero");
+    }
+
+    // A direita falharia, mas a esquerda decide
+    assert(get<bool>(flatten(arena, "false && 1 / 0 > 0").evaluate()) == false);
+    assert(get<bool>(flatten(arena, "true || 1 / 0 > 0").evaluate()) == true);
+    assert(describe(flatten(arena, "true && 1 / 0 > 0").try_evaluate()) == "erro: Divisão por zero em 10");
+    // Mal tipado: sem curto-circuito, e o erro da esquerda vem primeiro
+    assert(describe(flatten(arena, "true || x").try_evaluate()) == "erro: Variável sem valor: x em 8");
+    assert(describe(flatten(arena, "1 / 0 + ( true + 1 )").try_evaluate()) == "erro: Divisão por zero em 2");
+    assert(describe(flatten(arena, "( true + 1 ) + 1 / 0").try_evaluate()) == "erro: Avaliando operandos de tipos diferentes em 7");
+    assert(describe(flatten(arena, "- ( 1 < 2 )").try_evaluate()) == "erro: Operador Unário para Booleanos inválido: - em 0");
+    assert(describe(flatten(arena, "true < false").try_evaluate()) == "erro: Avaliando um operador lógico binário desconhecido em 5");
+    assert(describe(flatten(arena, "1 && 2").try_evaluate()) == "erro: Avaliando um operador aritmético binário desconhecido em 2");
+}
+
+void test_variables() {
+    cout << "Testando variáveis com slots..." << endl;
+
+    Variables variables;
+    uint32_t x = variables.declare("x", ValueType::INTEGER);
+    uint32_t flag = variables.declare("flag", ValueType::BOOLEAN);
+    Arena arena;
+    FlatExpression flat = flatten(arena, "x * 2 + 1 > 10 && flag", &variables);
+    ExpressionEvaluator evaluator;
+    CompiledExpression compiled = evaluator.compile("x * 2 + 1 > 10 && flag", variables);
+
+    int32_t slots[2];
+    for (int i = -10; i <= 10; i++) {
+        for (int f = 0; f <= 2; f++) {
+            slots[x] = i;
+            slots[flag] = f;
+            assert(flat.evaluate(slots) == compiled.evaluate(slots));
+        }
+    }
+    // Sem os valores, como na árvore
+    assert(describe(flat.try_evaluate()) == "erro: Variável sem valor: x em 0");
+}
+
+// Expressões aleatórias, bem e mal tipadas: o mesmo valor ou a mesma
+// exceção que a árvore, e o mesmo código e posição que try_evaluate
+void test_against_tree() {
+    cout << "Testando contra a árvore e o bytecode..." << endl;
+
+    static const char* operators[] = {"+", "-", "*", "/", "<", ">", "<=", ">=", "==", "!=", "&&", "||"};
+    mt19937 rng(37);
+    auto pick = [&](size_t n) { return static_cast<size_t>(rng() % n); };
+    auto operand = [&]() -> string {
+        switch (pick(6)) {
+            case 0:  return pick(2) ? "true" : "false";
+            case 1:  return "x";
+            case 2:  return "46341";
+            default: return to_string(static_cast<int>(pick(7)) - 3);
+        }
+    };
+    function<string(size_t)> expression = [&](size_t depth) -> string {
+        if (depth == 0 || pick(4) == 0) return operand();
+        switch (pick(5)) {
+            case 0:  return pick(2) ? "- " + operand() : "- ( " + expression(depth - 1) + " )";
+            case 1:  return "( " + expression(depth - 1) + " )";
+            case 2:  return expression(depth - 1) + " " + operators[4 + pick(8)] + " " + expression(depth - 1);
+            default: return expression(depth - 1) + " " + operators[pick(12)] + " ( " + expression(depth - 1) + " )";
+        }
+    };
+
+    Arena arena;
+    ExpressionEvaluator tree(Engine::TREE);
+    ExpressionEvaluator bytecode(Engine::BYTECODE);
+    size_t errors = 0;
+    for (int i = 0; i < 20000; i++) {
+        string input = expression(1 + i % 6);
+        string expected;
+        try {
+            const auto& value = tree.evaluate(input);
+            expected = holds_alternative<int>(value) ? to_string(get<int>(value)) : (get<bool>(value) ? "true" : "false");
+        } catch (const exception& e) {
+            expected = string("erro: ") + e.what();
+        }
+        tree.reset();
+        FlatExpression flat = flatten(arena, input);
+        EvaluationResult result = flat.try_evaluate();
+        string found = result ? describe(result) : "erro: " + result.get_error().message();
+        if (found != expected) cout << input << ": " << expected << " != " << found << "\n" << flat.to_string();
+        assert(found == expected);
+
+        EvaluationResult reference = bytecode.try_evaluate(input);
+        bytecode.reset();
+        assert(describe(result) == describe(reference));
+        errors += !result;
+    }
+    cout << "Árvore OK (" << errors << " com erro)" << endl;
+}
+
+void test_engine() {
+    cout << "Testando Engine::FLAT..." << endl;
+
+    ExpressionEvaluator evaluator(Engine::FLAT);
+    assert(get<int>(evaluator.evaluate("( 1 + 2 ) * 3")) == 9);
+    evaluator.reset();
+    try {
+        evaluator.evaluate("1 + true");
+        assert(false);
+    } catch (const ExpressionError& e) {
+        assert(string(e.what()) == "Avaliando operandos de tipos diferentes");
+    }
+    evaluator.reset();
+
+    // Profundidade sem limite, sem recursão
+    string deep = "1";
+    for (int i = 0; i < 100000; i++) deep = "( " + deep + " + 1 )";
+    assert(get<int>(evaluator.evaluate(deep)) == 100001);
+    evaluator.reset();
+    deep = "1";
+    for (int i = 0; i < 100000; i++) deep = "- ( " + deep + " )";
+    assert(get<int>(evaluator.evaluate(deep)) == 1);
+    evaluator.reset();
+}
+
+int main() {
+    test_layout();
+    test_errors();
+    test_variables();
+    test_against_tree();
+    test_engine();
+
+    cout << "Todos os testes da FlatExpression passaram!" << endl;
+    return 0;
+}
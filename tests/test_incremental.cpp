@@ -0,0 +1,249 @@
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <variant>
+#include <vector>
+#include "parser.h"
+#include "incremental.h"
+using namespace std;
+
+static string describe(const EvaluationResult& result) {
+    if (!result.ok()) {
+        return "erro: " + result.get_error().message() + " em " + to_string(result.get_error().offset);
+    }
+    const auto& value = result.get_value();
+    return holds_alternative<int>(value) ? to_string(get<int>(value)) : (get<bool>(value) ? "true" : "false");
+}
+
+static string expected(const CompiledExpression& rule, const vector<int32_t>& slots) {
+    variant<int, bool> value;
+    EvaluationError error;
+    if (!VirtualMachine::try_run(rule.get_program(), slots.data(), value, error)) return describe(error);
+    return describe(value);
+}
+
+void test_updates() {
+    cout << "Testando atualizações de variáveis..." << endl;
+
+    Variables variables;
+    uint32_t x = variables.declare("x", ValueType::INTEGER);
+    uint32_t y = variables.declare("y", ValueType::INTEGER);
+    uint32_t flag = variables.declare("flag", ValueType::BOOLEAN);
+    ExpressionEvaluator evaluator;
+    CompiledExpression rule = evaluator.compile("x * 2 + y > 10 && flag", variables);
+
+    // Tudo zerado no início
+    IncrementalExpression incremental(rule);
+    assert(incremental.get_type() == ValueType::BOOLEAN);
+    assert(get<bool>(incremental.evaluate()) == false);
+
+    incremental.set(x, 5);
+    incremental.set(y, 1);
+    assert(get<bool>(incremental.evaluate()) == false);
+    incremental.set(flag, 1);
+    assert(get<bool>(incremental.evaluate()) == true);
+    // Booleanos diferentes de zero valem true, como no VM
+    incremental.set(flag, 7);
+    assert(get<bool>(incremental.evaluate()) == true);
+    assert(incremental.get(flag) == 7);
+
+    // Sem mudanças, nada é recalculado
+    incremental.set(x, 5);
+    assert(get<bool>(incremental.evaluate()) == true);
+    assert(incremental.get_recomputed() == 0);
+
+    int32_t slots[] = {1, 2, 1};
+    incremental.assign(slots);
+    assert(get<bool>(incremental.evaluate()) == false);
+
+    try {
+        incremental.set("z", 1);
+        assert(false);
+    } catch (const VariableError& e) {
+        assert(string(e.what()) == "Variável não declarada: z");
+    }
+    try {
+        incremental.set(3, 1);
+        assert(false);
+    } catch (const VariableError&) {
+    }
+
+    // Sem variáveis
+    IncrementalExpression constant(evaluator.compile("2 * 21", Variables()));
+    assert(get<int>(constant.evaluate()) == 42);
+}
+
+void test_errors() {
+    cout << "Testando divisão por zero e curto-circuito..." << endl;
+
+    Variables variables;
+    uint32_t x = variables.declare("x", ValueType::INTEGER);
+    uint32_t stop = variables.declare("stop", ValueType::BOOLEAN);
+    ExpressionEvaluator evaluator;
+
+    IncrementalExpression division(evaluator.compile("( x + 1 ) / x", variables));
+    try {
+        division.evaluate();
+        assert(false);
+    } catch (const ExpressionError& e) {
+        assert(string(e.what()) == "Divisão por zero");
+    }
+    EvaluationResult result = division.try_evaluate();
+    assert(!result && result.get_error().code == ErrorCode::DIVISION_BY_ZERO && result.get_error().offset == 10);
+    division.set(x, 2);
+    assert(get<int>(division.evaluate()) == 1);
+
+    // A direita guarda o erro, que só aparece quando a esquerda não decide
+    IncrementalExpression guarded(evaluator.compile("stop || 10 / x > 1", variables));
+    assert(!guarded.try_evaluate());
+    guarded.set(stop, 1);
+    assert(get<bool>(guarded.evaluate()) == true);
+    guarded.set(x, 3);
+    assert(get<bool>(guarded.evaluate()) == true);
+    guarded.set(stop, 0);
+    assert(get<bool>(guarded.evaluate()) == true);
+    guarded.set(x, 0);
+    assert(guarded.try_evaluate().get_error().code == ErrorCode::DIVISION_BY_ZERO);
+}
+
+// Só o caminho da variável até a raiz, e só enquanto o valor muda
+void test_recomputed_path() {
+    cout << "Testando o tamanho do recálculo..." << endl;
+
+    Variables variables;
+    function<string(size_t, size_t)> sum = [&](size_t first, size_t count) -> string {
+        if (count == 1) {
+            string name = "v" + to_string(first);
+            variables.declare(name, ValueType::INTEGER);
+            return name;
+        }
+        return "( " + sum(first, count / 2) + " + " + sum(first + count / 2, count - count / 2) + " )";
+    };
+    string input = sum(0, 256) + " > 1000";
+    ExpressionEvaluator evaluator;
+    IncrementalExpression incremental(evaluator.compile(input, variables));
+    assert(incremental.size() == 2 * 256 + 1);
+    assert(incremental.get_recomputed() == incremental.size());
+
+    // LOAD, 8 somas e a comparação
+    incremental.set("v100", 2000);
+    assert(get<bool>(incremental.evaluate()) == true);
+    assert(incremental.get_recomputed() == 10);
+    // A soma muda, a comparação não: o recálculo para nela
+    incremental.set("v7", 5);
+    assert(get<bool>(incremental.evaluate()) == true);
+    assert(incremental.get_recomputed() == 10);
+    // Dois campos no mesmo evento: os caminhos se juntam na raiz
+    incremental.set("v0", 1);
+    incremental.set("v255", 1);
+    assert(get<bool>(incremental.evaluate()) == true);
+    assert(incremental.get_recomputed() == 18);
+
+    // Um valor que não muda o nó de cima corta o resto do caminho
+    Variables flags;
+    flags.declare("a", ValueType::INTEGER);
+    flags.declare("b", ValueType::INTEGER);
+    IncrementalExpression cutoff(evaluator.compile("a > 100 || b * b + b > 100", flags));
+    cutoff.set("a", 1);
+    assert(get<bool>(cutoff.evaluate()) == false);
+    assert(cutoff.get_recomputed() == 2);
+}
+
+// Regras aleatórias bem tipadas com variáveis e eventos que mudam uma ou
+// duas por vez: o mesmo valor ou o mesmo erro (e posição) que o VM
+void test_against_vm() {
+    cout << "Testando contra o VM..." << endl;
+
+    static const char* integer_operators[] = {"+", "-", "*", "/"};
+    static const char* comparisons[] = {"<", ">", "<=", ">=", "==", "!="};
+    static const char* names[] = {"a", "b", "c", "p", "q"};
+    mt19937 rng(23);
+    auto pick = [&](size_t n) { return static_cast<size_t>(rng() % n); };
+    function<string(size_t)> integer;
+    function<string(size_t)> boolean;
+    integer = [&](size_t depth) -> string {
+        if (depth == 0 || pick(4) == 0) {
+            // 46341 * 46341 dá a volta; valores perto de INT_MIN dariam
+            // INT_MIN / -1, que derruba todos os motores
+            switch (pick(4)) {
+                case 0:  return to_string(static_cast<int>(pick(5)) - 2);
+                case 1:  return "46341";
+                default: return names[pick(3)];
+            }
+        }
+        switch (pick(4)) {
+            case 0:  return "- ( " + integer(depth - 1) + " )";
+            default: return "( " + integer(depth - 1) + " " + integer_operators[pick(4)] + " " + integer(depth - 1) + " )";
+        }
+    };
+    boolean = [&](size_t depth) -> string {
+        if (depth == 0 || pick(5) == 0) {
+            switch (pick(3)) {
+                case 0:  return pick(2) ? "true" : "false";
+                default: return names[3 + pick(2)];
+            }
+        }
+        switch (pick(4)) {
+            case 0:  return "( " + integer(depth - 1) + " " + comparisons[pick(6)] + " " + integer(depth - 1) + " )";
+            case 1:  return "( " + boolean(depth - 1) + " " + (pick(2) ? "==" : "!=") + " " + boolean(depth - 1) + " )";
+            default: return "( " + boolean(depth - 1) + " " + (pick(2) ? "&&" : "||") + " " + boolean(depth - 1) + " )";
+        }
+    };
+
+    Variables variables;
+    for (size_t i = 0; i < 5; i++) variables.declare(names[i], i < 3 ? ValueType::INTEGER : ValueType::BOOLEAN);
+    ExpressionEvaluator evaluator;
+    size_t errors = 0, checks = 0;
+    for (int i = 0; i < 2000; i++) {
+        string input = pick(2) ? boolean(2 + i % 5) : integer(2 + i % 5);
+        CompiledExpression rule = evaluator.compile(input, variables);
+        evaluator.reset();
+        IncrementalExpression incremental(rule);
+        vector<int32_t> slots(variables.size(), 0);
+        for (int event = 0; event < 50; event++) {
+            size_t changes = 1 + pick(2);
+            for (size_t j = 0; j < changes; j++) {
+                uint32_t slot = static_cast<uint32_t>(pick(5));
+                int32_t value = slot < 3 ? static_cast<int32_t>(pick(7)) - 3 : static_cast<int32_t>(pick(3));
+                slots[slot] = value;
+                incremental.set(slot, value);
+            }
+            string want = expected(rule, slots);
+            string found = describe(incremental.try_evaluate());
+            if (found != want) cout << input << ": " << want << " != " << found << endl;
+            assert(found == want);
+            assert(incremental.get_recomputed() <= incremental.size());
+            errors += want.compare(0, 5, "erro:") == 0;
+            checks++;
+        }
+    }
+    cout << "VM OK (" << checks << " eventos, " << errors << " com erro)" << endl;
+}
+
+void test_ill_typed() {
+    cout << "Testando programa mal tipado..." << endl;
+
+    // compile rejeita; um Program com FAIL montado à mão também
+    Program program;
+    program.failures.push_back(EvaluationError(ErrorCode::MIXED_TYPES, 2));
+    program.code = {{OpCode::PUSH_INT, 1}, {OpCode::PUSH_BOOL, 1}, {OpCode::FAIL, 0}, {OpCode::HALT, 0}};
+    try {
+        IncrementalExpression incremental(CompiledExpression(program, Variables()));
+        assert(false);
+    } catch (const ExpressionError& e) {
+        assert(string(e.what()) == "Avaliando operandos de tipos diferentes");
+    }
+}
+
+int main() {
+    test_updates();
+    test_errors();
+    test_recomputed_path();
+    test_against_vm();
+    test_ill_typed();
+
+    cout << "Todos os testes da avaliação incremental passaram!" << endl;
+    return 0;
+}
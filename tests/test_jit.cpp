@@ -0,0 +1,263 @@
+#include <cassert>
+#include <iostream>
+#include <pthread.h>
+#include <random>
+#include <string>
+#include <variant>
+#include <vector>
+#include "parser.h"
+#include "jit.h"
+using namespace std;
+
+// Expressões aleatórias com inteiros pequenos (divisões por zero aparecem),
+// booleanos, variáveis e todos os operadores, bem e mal tipadas
+class RandomExpressions {
+    private:
+        mt19937 rng;
+        bool variables;
+
+        size_t pick(size_t n) { return rng() % n; }
+
+    public:
+        RandomExpressions(unsigned seed, bool variables) : rng(seed), variables(variables) {}
+
+        string operand() {
+            switch (pick(variables ? 5 : 3)) {
+                case 0:  return to_string(static_cast<int>(pick(9)) - 4);
+                case 1:  return pick(2) ? "true" : "false";
+                case 2:  return to_string(pick(3));
+                case 3:  return pick(2) ? "x" : "y";
+                default: return "p";
+            }
+        }
+
+        string expression(size_t depth) {
+            static const char* operators[] = {
+                "+", "-", "*", "/", "<", ">", "<=", ">=", "==", "!=", "&&", "||"
+            };
+            if (depth == 0 || pick(4) == 0) return operand();
+            switch (pick(6)) {
+                // "- - 3" não é aceito pelo parser
+                case 0:  return pick(2) ? "- " + operand() : "- ( " + expression(depth - 1) + " )";
+                case 1:  return "( " + expression(depth - 1) + " )";
+                // Mais comparações e conectivos, para ter expressões bem tipadas
+                case 2:  return expression(depth - 1) + " " + operators[4 + pick(6)] + " " + expression(depth - 1);
+                case 3:  return "( " + expression(depth - 1) + " " + operators[10 + pick(2)] + " " + expression(depth - 1) + " )";
+                case 4:  return expression(depth - 1) + " " + operators[pick(12)] + " " + expression(depth - 1);
+                // Direita entre parênteses: a pilha cresce com a profundidade
+                default: return expression(depth - 1) + " " + operators[pick(12)] + " ( " + expression(depth - 1) + " )";
+            }
+        }
+};
+
+static string describe(const EvaluationResult& result) {
+    if (!result.ok()) return "erro: " + result.get_error().message();
+    const auto& value = result.get_value();
+    return holds_alternative<int>(value) ? to_string(get<int>(value)) : (get<bool>(value) ? "true" : "false");
+}
+
+static EvaluationResult run_jit(const JitCode& jit, const Program& program, const int32_t* slots) {
+    variant<int, bool> value;
+    EvaluationError error;
+    if (!jit.try_run(program, slots, value, error)) return error;
+    return value;
+}
+
+// Sem variáveis: o código nativo contra BinaryExpression::evaluate e os
+// outros nós da árvore, com as mesmas mensagens de erro
+void test_against_tree() {
+    cout << "Testando JIT contra a árvore..." << endl;
+
+    RandomExpressions random(11, false);
+    ExpressionEvaluator tree(Engine::TREE);
+    Compiler compiler;
+    size_t errors = 0;
+    for (int i = 0; i < 3000; i++) {
+        string input = random.expression(5);
+        string expected;
+        try {
+            auto value = tree.evaluate(input);
+            expected = describe(value);
+        } catch (const exception& e) {
+            expected = string("erro: ") + e.what();
+            errors++;
+        }
+        tree.reset();
+
+        Arena arena;
+        Lexer lexer(input);
+        Parser parser(lexer, arena);
+        auto expr = parser.parse();
+        Program program = compiler.compile(*expr);
+        JitCode jit = JitCode::compile(program);
+        assert(jit);
+        string found = describe(run_jit(jit, program, nullptr));
+        if (found != expected) {
+            cout << input << "\n" << program.to_string() << expected << " != " << found << endl;
+        }
+        assert(found == expected);
+    }
+    cout << "Árvore OK (" << errors << " erros)" << endl;
+}
+
+// Com variáveis: contra o VirtualMachine, com os mesmos códigos e posições
+// de erro, para vários valores das variáveis
+void test_against_vm() {
+    cout << "Testando JIT contra o VM..." << endl;
+
+    Variables variables;
+    variables.declare("x", ValueType::INTEGER);
+    variables.declare("y", ValueType::INTEGER);
+    variables.declare("p", ValueType::BOOLEAN);
+
+    RandomExpressions random(23, true);
+    mt19937 rng(5);
+    Compiler compiler;
+    for (int i = 0; i < 3000; i++) {
+        // Mais funda: passa das posições da pilha em registradores
+        string input = random.expression(i % 2 ? 7 : 4);
+        Arena arena;
+        Lexer lexer(input);
+        Parser parser(lexer, arena, &variables);
+        auto expr = parser.parse();
+        Program program = compiler.compile(*expr);
+        JitCode jit = JitCode::compile(program);
+        assert(jit);
+
+        for (int round = 0; round < 8; round++) {
+            // p fora de 0/1 precisa ser normalizado como no LOAD_B
+            int32_t slots[] = {static_cast<int32_t>(rng() % 7) - 3, static_cast<int32_t>(rng() % 7) - 3,
+                               static_cast<int32_t>(rng() % 3) * 7};
+            variant<int, bool> value;
+            EvaluationError error;
+            bool ok = VirtualMachine::try_run(program, slots, value, error);
+            EvaluationResult found = run_jit(jit, program, slots);
+            assert(found.ok() == ok);
+            if (ok) {
+                assert(found.get_value() == value);
+            } else {
+                assert(found.get_error().code == error.code);
+                assert(found.get_error().offset == error.offset);
+                assert(found.get_error().message() == error.message());
+            }
+        }
+    }
+    cout << "VM OK" << endl;
+}
+
+void test_compiled_expression() {
+    cout << "Testando CompiledExpression com JIT..." << endl;
+
+    Variables variables;
+    uint32_t x = variables.declare("x", ValueType::INTEGER);
+    uint32_t d = variables.declare("d", ValueType::INTEGER);
+    ExpressionEvaluator evaluator;
+    CompiledExpression rule = evaluator.compile("x / d > 2 || x == 0", variables);
+    assert(rule.enable_jit());
+    assert(rule.get_jit() && rule.get_jit()->code_size() > 0);
+
+    vector<int32_t> slots(2);
+    slots[x] = 10;
+    slots[d] = 3;
+    assert(get<bool>(rule.evaluate(slots)) == true);
+    // Chamada direta da função nativa
+    int32_t out = -1;
+    assert(rule.get_jit()->get_function()(slots.data(), &out) == 0 && out == 1);
+
+    slots[d] = 0;
+    try {
+        rule.evaluate(slots);
+        assert(false);
+    } catch (const ExpressionError& e) {
+        assert(string(e.what()) == "Divisão por zero");
+    }
+    assert(rule.get_jit()->get_function()(slots.data(), &out) != 0);
+
+    // Pilha de 31 posições, quase todas fora dos registradores
+    string nested = "x / d";
+    for (int i = 0; i < 30; i++) nested = "x - ( " + nested + " )";
+    CompiledExpression deep = evaluator.compile(nested + " == 7", variables);
+    assert(deep.enable_jit());
+    for (int32_t divisor : {1, 2, -3, 0}) {
+        slots[x] = 10;
+        slots[d] = divisor;
+        variant<int, bool> expected;
+        EvaluationError error;
+        bool ok = VirtualMachine::try_run(deep.get_program(), slots.data(), expected, error);
+        EvaluationResult found = run_jit(*deep.get_jit(), deep.get_program(), slots.data());
+        assert(found.ok() == ok && ok == (divisor != 0));
+        if (ok) assert(found.get_value() == expected);
+    }
+
+    // As cópias compartilham o código
+    CompiledExpression copy = rule;
+    assert(copy.get_jit() == rule.get_jit());
+    slots[x] = 0;
+    slots[d] = 1;
+    assert(get<bool>(copy.evaluate(slots)) == true);
+}
+
+// Roda function numa thread com pilha de stack_size bytes
+template <typename Function>
+static void run_with_stack(size_t stack_size, Function function) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    assert(pthread_attr_setstacksize(&attr, stack_size) == 0);
+    pthread_t thread;
+    auto start = [](void* argument) -> void* {
+        (*static_cast<Function*>(argument))();
+        return nullptr;
+    };
+    assert(pthread_create(&thread, &attr, start, &function) == 0);
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+}
+
+void test_deep_stack() {
+    cout << "Testando pilhas acima de MAX_STACK..." << endl;
+
+    Variables variables;
+    uint32_t x = variables.declare("x", ValueType::INTEGER);
+    ExpressionEvaluator evaluator;
+    // x + ( x + ( ... x ) ): a pilha cresce uma posição por nível
+    auto nested = [](size_t depth) {
+        string input;
+        for (size_t i = 0; i < depth; i++) input += "x + ( ";
+        input += "x";
+        for (size_t i = 0; i < depth; i++) input += " )";
+        return input;
+    };
+
+    // No limite ainda compila
+    CompiledExpression limit = evaluator.compile(nested(JitCode::MAX_STACK - 1), variables);
+    assert(limit.get_program().max_stack == JitCode::MAX_STACK);
+    assert(limit.enable_jit());
+    vector<int32_t> slots(1);
+    slots[x] = 2;
+    assert(get<int>(limit.evaluate(slots)) == static_cast<int>(2 * JitCode::MAX_STACK));
+
+    // 300000 níveis numa thread com 1 MB de pilha: fica no VM, que não usa a
+    // pilha da thread
+    const size_t depth = 300000;
+    CompiledExpression deep = evaluator.compile(nested(depth), variables);
+    assert(deep.get_program().max_stack > JitCode::MAX_STACK);
+    assert(!deep.enable_jit() && !deep.get_jit());
+    int result = 0;
+    run_with_stack(1 << 20, [&] { result = get<int>(deep.evaluate(slots)); });
+    assert(result == static_cast<int>(2 * (depth + 1)));
+}
+
+int main() {
+    if (!JitCode::supported()) {
+        cout << "Sem JIT nesta plataforma" << endl;
+        assert(!JitCode::compile(Program()));
+        return 0;
+    }
+    test_against_tree();
+    test_against_vm();
+    test_compiled_expression();
+    test_deep_stack();
+
+    cout << "Todos os testes do JIT passaram!" << endl;
+    return 0;
+}
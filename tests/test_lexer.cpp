@@ -30,7 +30,7 @@ void test_expression(const string& expression) {
         vector<Token> tokens;
         while (true) {
             Token token = lexer.get_next_token();
-            if (token.get_type() == "EOF") break;
+            if (token.get_type() == TokenType::END_OF_FILE) break;
             tokens.push_back(token);
         }
         
@@ -0,0 +1,124 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <variant>
+#include "parser.h"
+#include "optimizer.h"
+using namespace std;
+
+static Arena arena;
+
+static ExpressionPtr optimize(const string& input) {
+    Lexer lexer(input);
+    Parser parser(lexer, arena);
+    auto expr = parser.parse();
+    return Optimizer(arena).optimize(*expr);
+}
+
+template <typename T>
+static bool is(const ExpressionPtr& expression) {
+    return dynamic_cast<const T*>(expression.get()) != nullptr;
+}
+
+void test_constant_folding() {
+    cout << "Testando dobra de constantes..." << endl;
+
+    struct TestCase {
+        string input;
+        variant<int, bool> expected;
+    };
+
+    TestCase cases[] = {
+        {"( 2 - - -3 ) * 2", -2},
+        {"( 5 > 3 ) && ( 2 < 4 )", true},
+        {"( ( 3 * ( 4 + 3 ) )  * 1 ) == ( ( 21 * 1 ) + ( 1 - 1 ) )", true},
+        {"- ( - 7 )", 7},
+        {"( ( ( -3 ) ) )", -3}
+    };
+
+    for (const auto& test : cases) {
+        auto expr = optimize(test.input);
+        assert(is<Literal>(expr));
+        assert(expr->evaluate() == test.expected);
+        cout << "Teste: " << test.input << " OK" << endl;
+    }
+}
+
+void test_errors_preserved() {
+    cout << "Testando erros depois da otimização..." << endl;
+
+    struct TestCase {
+        string input;
+        string message;
+    };
+
+    TestCase cases[] = {
+        {"1 / 0", "Divisão por zero"},
+        {"( 1 / 0 ) * 1", "Divisão por zero"},
+        {"0 + ( 1 / 0 )", "Divisão por zero"},
+        {"- ( - ( 4 / ( 2 - 2 ) ) )", "Divisão por zero"},
+        {"( 1 / 0 ) + true", "Divisão por zero"},
+        {"2 + true", "Avaliando operandos de tipos diferentes"},
+        {"- true", "Operador Unário para Booleanos inválido: -"},
+        {"- ( - true )", "Operador Unário para Booleanos inválido: -"}
+    };
+
+    for (const auto& test : cases) {
+        auto expr = optimize(test.input);
+        try {
+            expr->evaluate();
+            assert(false);
+        } catch (const ExpressionError& e) {
+            assert(e.what() == test.message);
+        }
+        cout << "Teste: " << test.input << " OK" << endl;
+    }
+}
+
+void test_identities() {
+    cout << "Testando identidades..." << endl;
+
+    // O operando que sobra é a divisão que não pôde ser dobrada
+    const char* inputs[] = {
+        "( 1 / 0 ) * 1", "1 * ( 1 / 0 )", "( 1 / 0 ) + 0", "0 + ( 1 / 0 )",
+        "( 1 / 0 ) - 0", "( 1 / 0 ) / 1", "- ( - ( 1 / 0 ) )"
+    };
+    for (const char* input : inputs) {
+        auto expr = optimize(input);
+        auto binary = dynamic_cast<const BinaryExpression*>(expr.get());
+        assert(binary && binary->get_operator() == "/");
+        cout << "Teste: " << input << " OK" << endl;
+    }
+
+    const char* logical[] = {
+        "true && ( 1 / 0 == 1 )", "( 1 / 0 == 1 ) && true",
+        "false || ( 1 / 0 == 1 )", "( 1 / 0 == 1 ) || false"
+    };
+    for (const char* input : logical) {
+        auto expr = optimize(input);
+        auto binary = dynamic_cast<const BinaryExpression*>(expr.get());
+        assert(binary && binary->get_operator() == "==");
+        cout << "Teste: " << input << " OK" << endl;
+    }
+
+    // Curto-circuito: a direita some, com a divisão junto
+    for (const char* input : {"false && ( 1 / 0 == 1 )", "true || ( 1 / 0 == 1 )"}) {
+        auto expr = optimize(input);
+        assert(is<Literal>(expr));
+        cout << "Teste: " << input << " OK" << endl;
+    }
+
+    // Tipos diferentes: a identidade não pode esconder o erro
+    auto mixed = optimize("( 1 / 0 == 1 ) * 1");
+    assert(is<BinaryExpression>(mixed));
+    assert(is<BinaryExpression>(optimize("false && 3")));
+}
+
+int main() {
+    test_constant_folding();
+    test_errors_preserved();
+    test_identities();
+
+    cout << "Todos os testes do otimizador passaram!" << endl;
+    return 0;
+}
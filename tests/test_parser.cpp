@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cassert>
+#include <pthread.h>
 #include <stdexcept>
 #include <variant>
 #include "parser.h"
@@ -102,6 +103,171 @@ void test_complex_expressions() {
     std::cout << "Testes de expressões complexas concluídos com sucesso!" << std::endl;
 }
 
+// Função para testar cadeias de operadores e tokens sobrando
+void test_operator_chains() {
+    std::cout << "Testando cadeias de operadores..." << std::endl;
+    
+    ExpressionEvaluator evaluator;
+
+    struct TestCase {
+        std::string input;
+        std::variant<int, bool> expected;
+    };
+
+    TestCase cases[] = {
+        {"1 + 2 + 3", 6},
+        {"10 - 4 - 3", 3},
+        {"100 / 10 / 5", 2},
+        {"2 * 3 + 4 * 5 - 6", 20},
+        {"1 < 2 == 3 < 4", true},
+        {"false || false || true", true},
+        {"true && true && false", false},
+        {"1 - - 2 - 3", 0}
+    };
+
+    for (const auto& test : cases) {
+        auto result = evaluator.evaluate(test.input);
+        assert(compareVariant(result, test.expected));
+        std::cout << "Teste: " << test.input << " OK" << std::endl;
+    }
+
+    const char* invalid[] = {"1 2", "( 1 + 2 ) 3", "1 + 2 )", "true false"};
+    for (const char* input : invalid) {
+        try {
+            evaluator.evaluate(input);
+            std::cerr << "Erro: tokens sobrando não detectados em " << input << std::endl;
+            assert(false);
+        } catch (const ParserError& e) {
+            std::cout << "Teste: " << input << " rejeitado OK" << std::endl;
+        }
+    }
+
+    std::cout << "Testes de cadeias de operadores concluídos com sucesso!" << std::endl;
+}
+
+// Repete prefix n vezes, põe middle e fecha com suffix n vezes
+static std::string nested(const std::string& prefix, const std::string& middle, const std::string& suffix, int n) {
+    std::string text;
+    for (int i = 0; i < n; i++) text += prefix;
+    text += middle;
+    for (int i = 0; i < n; i++) text += suffix;
+    return text;
+}
+
+// Função para testar entradas muito mais profundas que a pilha aguentaria
+// com recursão, em todos os motores
+void test_deep_nesting() {
+    std::cout << "Testando aninhamento profundo..." << std::endl;
+
+    const int DEPTH = 200000;
+    std::string chain = "1";
+    for (int i = 0; i < DEPTH; i++) chain += " + 1";
+
+    struct TestCase {
+        std::string name;
+        std::string input;
+        std::variant<int, bool> expected;
+    };
+
+    TestCase cases[] = {
+        {"parênteses", nested("( ", "1 + 2", " )", DEPTH), 3},
+        {"menos unário", nested("- ( ", "7", " )", DEPTH + 1), -7},
+        {"cadeia", chain, DEPTH + 1},
+        {"subtração à direita", nested("1 - ( ", "1", " )", DEPTH), 1},
+        {"booleano", nested("true && ( ", "1 < 2", " )", DEPTH), true}
+    };
+
+    Engine engines[] = {Engine::TREE, Engine::BYTECODE, Engine::TYPED};
+    for (Engine engine : engines) {
+        for (bool optimize : {false, true}) {
+            ExpressionEvaluator evaluator(engine, optimize);
+            for (const auto& test : cases) {
+                assert(compareVariant(evaluator.evaluate(test.input), test.expected));
+                evaluator.reset();
+                std::cout << "Teste: " << test.name << " OK" << std::endl;
+            }
+
+            // Erros no fundo da árvore e parênteses sem fechar
+            try {
+                evaluator.evaluate(nested("( ", "1 / 0", " )", DEPTH));
+                assert(false);
+            } catch (const std::runtime_error& e) {
+                std::cout << "Divisão por zero no fundo: " << e.what() << std::endl;
+            }
+            evaluator.reset();
+            try {
+                evaluator.evaluate(nested("( ", "1", " )", DEPTH) + " )");
+                assert(false);
+            } catch (const ParserError& e) {
+                std::cout << "Parêntese sobrando: " << e.what() << std::endl;
+            }
+            evaluator.reset();
+        }
+    }
+
+    // Sem exceções, e a profundidade que o Parser informa
+    ExpressionEvaluator evaluator(Engine::BYTECODE);
+    assert(compareVariant(evaluator.try_evaluate(chain).get_value(), DEPTH + 1));
+    std::string unclosed = nested("( ", "1", " )", DEPTH);
+    unclosed.resize(unclosed.size() - 2);
+    EvaluationResult result = evaluator.try_evaluate(unclosed);
+    assert(!result && result.get_error().code == ErrorCode::EXPECTED_TOKEN);
+
+    Arena arena;
+    std::string parens = nested("( ", "1", " )", DEPTH);
+    Lexer lexer(parens);
+    Parser parser(lexer, arena);
+    auto expr = parser.try_parse();
+    assert(expr && parser.get_depth() == static_cast<size_t>(DEPTH) + 2);
+    assert(compareVariant(evaluate_tree(*expr), 1));
+
+    std::cout << "Testes de aninhamento profundo concluídos com sucesso!" << std::endl;
+}
+
+// Função para testar linhas abaixo de MAX_RECURSIVE_DEPTH numa thread com
+// pilha de 1 MB: o limite sai da pilha que a thread tem, e os motores
+// recursivos passam para evaluate_tree antes de estourar
+void test_small_stack() {
+    std::cout << "Testando pilha de 1 MB..." << std::endl;
+
+    static const int TERMS = 9991;
+    std::string chain = "1";
+    for (int i = 1; i < TERMS; i++) chain += " + 1";
+
+    struct Run {
+        std::string chain;
+        size_t limit = 0;
+        bool ok = true;
+    } run{chain};
+    auto body = [](void* argument) -> void* {
+        Run& run = *static_cast<Run*>(argument);
+        run.limit = recursive_depth_limit();
+        for (Engine engine : {Engine::TREE, Engine::BYTECODE, Engine::TYPED, Engine::FLAT}) {
+            for (bool optimize : {false, true}) {
+                ExpressionEvaluator evaluator(engine, optimize);
+                run.ok = run.ok && compareVariant(evaluator.evaluate(run.chain), TERMS);
+                evaluator.reset();
+                run.ok = run.ok && compareVariant(evaluator.evaluate(nested("- ( ", "7", " )", 5001)), -7);
+                evaluator.reset();
+            }
+        }
+        return nullptr;
+    };
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    assert(pthread_attr_setstacksize(&attr, 1 << 20) == 0);
+    pthread_t thread;
+    assert(pthread_create(&thread, &attr, body, &run) == 0);
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+
+    std::cout << "Limite com 1 MB: " << run.limit << std::endl;
+    assert(run.ok);
+    assert(run.limit < MAX_RECURSIVE_DEPTH);
+    assert(recursive_depth_limit() <= MAX_RECURSIVE_DEPTH);
+}
+
 // Função para testar tratamento de erros
 void test_error_handling() {
     std::cout << "Testando tratamento de erros..." << std::endl;
@@ -134,6 +300,9 @@ int main() {
         test_arithmetic_expressions();
         test_boolean_expressions();
         test_complex_expressions();
+        test_operator_chains();
+        test_deep_nesting();
+        test_small_stack();
         test_error_handling();
 
         std::cout << "Todos os testes foram concluídos com sucesso!" << std::endl;
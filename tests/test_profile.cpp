@@ -0,0 +1,89 @@
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "parser.h"
+#include "profile.h"
+using namespace std;
+
+#ifdef EDOO_PROFILE
+void test_counters() {
+    cout << "Testando contadores do profiler..." << endl;
+    Profiler::reset();
+
+    ExpressionEvaluator evaluator(Engine::BYTECODE);
+    assert(evaluator.try_evaluate("1 + 2 * 3").ok());
+    evaluator.reset();
+    assert(!evaluator.try_evaluate("1 / 0").ok());
+    evaluator.reset();
+    assert(!evaluator.try_evaluate("(1 + 2").ok());
+    evaluator.reset();
+
+    ExpressionEvaluator tree;
+    try {
+        tree.evaluate("true + 1");
+        assert(false);
+    } catch (const ExpressionError&) {}
+    tree.reset();
+
+    const ProfileData& data = Profiler::local();
+    assert(data.stage_calls[static_cast<size_t>(ProfileStage::PARSER)] == 4);
+    assert(data.stage_calls[static_cast<size_t>(ProfileStage::LEXER)] > 0);
+    assert(data.stage_calls[static_cast<size_t>(ProfileStage::EVALUATE)] == 3);
+    // 5 tokens em "1 + 2 * 3" e 3 em "1 / 0"
+    assert(data.tokens_histogram[3] == 2);
+    assert(data.depth_histogram[2] == 3);
+    assert(data.operator_counts[0] == 2);   // + (bytecode e árvore)
+    assert(data.operator_counts[2] == 1);   // *
+    assert(data.operator_counts[3] == 1);   // /
+    assert(data.error_codes[static_cast<size_t>(ErrorCode::DIVISION_BY_ZERO)] == 1);
+    assert(data.error_codes[static_cast<size_t>(ErrorCode::EXPECTED_TOKEN)] == 1);
+    assert(data.error_categories[static_cast<size_t>(ErrorCategory::SYNTAX)] == 1);
+    assert(data.error_categories[static_cast<size_t>(ErrorCategory::EVALUATION)] == 2);
+    cout << "Contadores OK" << endl;
+}
+
+void test_reports() {
+    cout << "Testando resumo e trace..." << endl;
+    Profiler::reset();
+
+    thread worker([] {
+        EDOO_PROFILE_TRACE("bloco");
+        ExpressionEvaluator evaluator;
+        evaluator.evaluate("4 < 5 && true");
+    });
+    worker.join();
+    {
+        EDOO_PROFILE_TRACE("principal");
+    }
+
+    ostringstream summary;
+    Profiler::write_summary(summary);
+    assert(summary.str().find("parser") != string::npos);
+    assert(summary.str().find("&&") != string::npos);
+
+    ostringstream trace;
+    Profiler::write_trace(trace);
+    assert(trace.str().find("\"traceEvents\"") != string::npos);
+    assert(trace.str().find("\"name\":\"bloco\",\"ph\":\"X\"") != string::npos);
+    assert(trace.str().find("\"name\":\"principal\",\"ph\":\"X\"") != string::npos);
+    cout << "Resumo e trace OK" << endl;
+}
+#endif
+
+int main() {
+#ifdef EDOO_PROFILE
+    test_counters();
+    test_reports();
+#else
+    // Sem a flag as macros não geram código nem avaliam os argumentos
+    int evaluated = 0;
+    EDOO_PROFILE_STAGE(ProfileStage::PARSER);
+    EDOO_PROFILE_DEPTH(++evaluated);
+    EDOO_PROFILE_OPERATOR((++evaluated, "+"), false);
+    assert(evaluated == 0);
+    cout << "Build sem EDOO_PROFILE: nada a medir" << endl;
+#endif
+    cout << "Todos os testes do profiler passaram!" << endl;
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+#include "parser.h"
+#include "result_cache.h"
+using namespace std;
+
+void test_canonical_keys() {
+    cout << "Testando chaves canônicas..." << endl;
+
+    auto key = ResultCache::canonical_key;
+
+    assert(key("1 + 2") == key("1+2"));
+    assert(key("1 + 2") == key("  1   +\t2 "));
+    assert(key("1 + 2") == key("( 1 + 2 )"));
+    assert(key("1 + 2") == key("( ( 1 + 2 ) )"));
+    assert(key("( 3 ) * 2") == key("3 * 2"));
+    assert(key("( ( ( -3 ) ) )") == key("-3"));
+    assert(key("( 1 + 2 ) * 3") == key("((1 + 2)) * 3"));
+
+    // Parênteses que mudam o significado continuam na chave
+    assert(key("( 1 + 2 ) * 3") != key("1 + 2 * 3"));
+    assert(key("( 1 ) + ( 2 )") == key("1 + 2"));
+    assert(key("true") != key("false"));
+    assert(key("1") != key("2"));
+    assert(key("1 @ 2") != key("1 # 2"));
+    cout << "Chaves canônicas OK" << endl;
+}
+
+void test_hits_and_errors() {
+    cout << "Testando acertos e erros no cache..." << endl;
+
+    auto cache = make_shared<ResultCache>();
+    ExpressionEvaluator evaluator;
+    evaluator.set_cache(cache);
+
+    assert(get<int>(evaluator.evaluate("2 + 3 * 2")) == 8);
+    assert(get<int>(evaluator.evaluate("( 2 + ( 3 * 2 ) )")) == 8);
+    assert(get<int>(evaluator.evaluate("2+3*2")) == 8);
+
+    for (int i = 0; i < 2; i++) {
+        try {
+            evaluator.evaluate("5 / 0");
+            assert(false);
+        } catch (const ExpressionError& e) {
+            assert(string(e.what()) == "Divisão por zero");
+        }
+    }
+
+    auto stats = cache->statistics();
+    assert(stats.misses == 3);
+    assert(stats.hits == 2);
+    assert(stats.entries == 3);
+    cout << "Acertos: " << stats.hits << ", faltas: " << stats.misses << endl;
+}
+
+void test_eviction() {
+    cout << "Testando o limite de memória..." << endl;
+
+    // Um shard pequeno: só cabem poucas entradas
+    auto cache = make_shared<ResultCache>(1024, 1);
+    ExpressionEvaluator evaluator;
+    evaluator.set_cache(cache);
+
+    for (int i = 0; i < 100; i++) {
+        assert(get<int>(evaluator.evaluate(to_string(i) + " + 1")) == i + 1);
+        evaluator.reset();
+    }
+    auto stats = cache->statistics();
+    assert(stats.evictions > 0);
+    assert(stats.memory <= cache->get_memory_limit());
+    assert(stats.entries + stats.evictions == 100);
+
+    // A mais recente ainda está lá
+    assert(get<int>(evaluator.evaluate("99 + 1")) == 100);
+    assert(cache->statistics().hits == 1);
+    cout << "Remoções: " << stats.evictions << ", memória: " << stats.memory << endl;
+}
+
+void test_threads() {
+    cout << "Testando o cache compartilhado entre threads..." << endl;
+
+    auto cache = make_shared<ResultCache>(64 * 1024, 8);
+    vector<thread> workers;
+    for (int t = 0; t < 8; t++) {
+        workers.emplace_back([cache, t]() {
+            ExpressionEvaluator evaluator(Engine::BYTECODE);
+            evaluator.set_cache(cache);
+            for (int i = 0; i < 5000; i++) {
+                int n = (i * 7 + t) % 300;
+                string input = "( " + to_string(n) + " * 2 ) - 1";
+                assert(get<int>(evaluator.evaluate(input)) == n * 2 - 1);
+                try {
+                    evaluator.evaluate(to_string(n) + " / 0");
+                    assert(false);
+                } catch (const ExpressionError&) {}
+                evaluator.reset();
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    auto stats = cache->statistics();
+    assert(stats.hits + stats.misses == 8 * 5000 * 2);
+    cout << "Acertos: " << stats.hits << ", faltas: " << stats.misses << ", remoções: " << stats.evictions << endl;
+}
+
+int main() {
+    test_canonical_keys();
+    test_hits_and_errors();
+    test_eviction();
+    test_threads();
+
+    cout << "Todos os testes do cache passaram!" << endl;
+    return 0;
+}
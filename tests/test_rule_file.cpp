@@ -0,0 +1,259 @@
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <variant>
+#include "rule_file.h"
+using namespace std;
+
+static string temporary_path() {
+    char path[] = "/tmp/edoo_rule_file_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    return path;
+}
+
+static void write_bytes(const string& path, const string& bytes) {
+    ofstream file(path, ios::binary | ios::trunc);
+    file.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+}
+
+// Abre e confere; a mensagem do RuleFileError, ou "" se abriu
+static string open_error(const string& path) {
+    try {
+        RuleFile rules(path);
+        rules.verify();
+    } catch (const RuleFileError& e) {
+        return e.what();
+    }
+    return "";
+}
+
+void test_round_trip() {
+    cout << "Testando escrita e leitura..." << endl;
+
+    RuleFileWriter writer;
+    writer.add_source(
+        "# preços\n"
+        "int preco\n"
+        "int quantidade\n"
+        "bool ativo\n"
+        "\n"
+        "total_grande: preco * quantidade > 1000\n"
+        "  ativo_barato : ativo && preco < 10  \n"
+        "desconto: ( preco - 5 ) * 2\n"
+        "constante: 1 + 2 * 3\n");
+    assert(writer.size() == 4 && writer.get_variables().size() == 3);
+    string path = temporary_path();
+    writer.write(path);
+
+    RuleFile rules(path);
+    rules.verify();
+    assert(rules.size() == 4 && rules.variable_count() == 3);
+    assert(rules.slot("preco") == 0 && rules.slot("quantidade") == 1 && rules.slot("ativo") == 2);
+    try {
+        rules.slot("peso");
+        assert(false);
+    } catch (const VariableError& e) {
+        cout << e.what() << endl;
+    }
+    Variables variables = rules.variables();
+    assert(variables.size() == 3 && variables[2].name == "ativo" && variables[2].type == ValueType::BOOLEAN);
+
+    // Na ordem da fonte, e pelo nome
+    assert(rules.rule(0).get_name() == "total_grande" && rules.rule(1).get_name() == "ativo_barato");
+    assert(rules.find("desconto") == 2 && rules.find("constante") == 3 && rules.find("outra") == RuleFile::NO_RULE);
+    assert(rules.rule("desconto").get_type() == ValueType::INTEGER);
+    assert(rules.rule("ativo_barato").get_type() == ValueType::BOOLEAN);
+
+    // O mesmo resultado que a expressão compilada em memória
+    ExpressionEvaluator evaluator;
+    const char* sources[] = {"preco * quantidade > 1000", "ativo && preco < 10", "( preco - 5 ) * 2", "1 + 2 * 3"};
+    int32_t slots[3];
+    for (int preco = -20; preco <= 40; preco += 3) {
+        for (int quantidade = 0; quantidade <= 100; quantidade += 25) {
+            for (int ativo = 0; ativo <= 1; ativo++) {
+                slots[0] = preco;
+                slots[1] = quantidade;
+                slots[2] = ativo;
+                for (size_t i = 0; i < rules.size(); i++) {
+                    CompiledExpression compiled = evaluator.compile(sources[i], variables);
+                    assert(rules.rule(i).evaluate(slots) == compiled.evaluate(slots));
+                }
+            }
+        }
+    }
+    assert(get<int>(rules.rule("constante").evaluate(nullptr)) == 7);
+
+    // Erros de avaliação, como no VM
+    RuleFileWriter division;
+    division.declare("x", ValueType::INTEGER);
+    division.add("inverso", "100 / x");
+    division.write(path);
+    RuleFile reopened(path);
+    int32_t zero = 0;
+    variant<int, bool> value;
+    EvaluationError error;
+    assert(!reopened.rule("inverso").try_evaluate(&zero, value, error) && error.code == ErrorCode::DIVISION_BY_ZERO);
+    unlink(path.c_str());
+}
+
+void test_source_errors() {
+    cout << "Testando erros na fonte..." << endl;
+
+    const char* sources[] = {
+        "int x\nbool x\n",
+        "int x\nregra: x +\n",
+        "regra: y > 1\n",
+        "int x\nregra: x > 1\nregra: x < 1\n",
+        "int x\n: x > 1\n",
+        "float x\n",
+        "int x y\n",
+        "int x\nregra: x && true\n",
+    };
+    for (const char* source : sources) {
+        RuleFileWriter writer;
+        try {
+            writer.add_source(source);
+            assert(false);
+        } catch (const RuleFileError& e) {
+            cout << e.what() << endl;
+            assert(string(e.what()).rfind("Linha ", 0) == 0);
+        }
+    }
+}
+
+void test_corrupted() {
+    cout << "Testando arquivos inválidos..." << endl;
+
+    RuleFileWriter writer;
+    writer.declare("x", ValueType::INTEGER);
+    writer.add("a", "x > 1 && x < 10");
+    writer.add("b", "x * 2");
+    string bytes = writer.serialize();
+    string path = temporary_path();
+
+    write_bytes(path, bytes);
+    assert(open_error(path) == "");
+
+    string other = bytes;
+    other[0] = 'X';
+    write_bytes(path, other);
+    assert(open_error(path) == "Não é um arquivo de regras");
+
+    other = bytes;
+    uint32_t version = RULE_FILE_VERSION + 1;
+    memcpy(&other[offsetof(RuleFileHeader, version)], &version, sizeof(version));
+    write_bytes(path, other);
+    assert(open_error(path).find("Versão") == 0);
+
+    other = bytes;
+    uint32_t swapped = __builtin_bswap32(RULE_FILE_BYTE_ORDER);
+    memcpy(&other[offsetof(RuleFileHeader, byte_order)], &swapped, sizeof(swapped));
+    write_bytes(path, other);
+    assert(open_error(path) == "Arquivo de regras com outra ordem de bytes");
+
+    write_bytes(path, bytes.substr(0, bytes.size() - 1));
+    assert(open_error(path) == "Arquivo de regras corrompido");
+    write_bytes(path, bytes.substr(0, 20));
+    assert(open_error(path) == "Arquivo de regras truncado");
+
+    // Cabeçalho certo, código errado: só verify percebe
+    RuleFileHeader header;
+    memcpy(&header, bytes.data(), sizeof(header));
+    other = bytes;
+    other[header.code_offset] = static_cast<char>(OPCODE_COUNT);
+    write_bytes(path, other);
+    {
+        RuleFile rules(path);
+        assert(rules.size() == 2);
+    }
+    assert(open_error(path).find("instrução inválida") != string::npos);
+
+    // LOAD_I de um slot que não existe
+    other = bytes;
+    int32_t slot = 5;
+    memcpy(&other[header.code_offset + offsetof(Instruction, operand)], &slot, sizeof(slot));
+    write_bytes(path, other);
+    assert(open_error(path).find("slot inválido") != string::npos);
+
+    // Salto para fora da regra
+    other = bytes;
+    for (uint32_t i = 0; i < header.instruction_count; i++) {
+        size_t at = header.code_offset + i * sizeof(Instruction);
+        if (static_cast<OpCode>(other[at]) == OpCode::JUMP_IF_FALSE) {
+            int32_t target = 1000;
+            memcpy(&other[at + offsetof(Instruction, operand)], &target, sizeof(target));
+        }
+    }
+    write_bytes(path, other);
+    assert(open_error(path).find("salto inválido") != string::npos);
+
+    // Saltos dentro da regra, mas para o HALT ou para o meio da direita: só
+    // o destino logo depois do OR_B passa
+    RuleFileWriter jumps;
+    jumps.declare("a", ValueType::BOOLEAN);
+    jumps.declare("b", ValueType::BOOLEAN);
+    jumps.add("r", "a || b");
+    string jump_bytes = jumps.serialize();
+    memcpy(&header, jump_bytes.data(), sizeof(header));
+    size_t jump = header.code_offset;
+    while (static_cast<OpCode>(jump_bytes[jump]) != OpCode::JUMP_IF_TRUE) jump += sizeof(Instruction);
+    int32_t operand;
+    memcpy(&operand, &jump_bytes[jump + offsetof(Instruction, operand)], sizeof(operand));
+    for (int32_t delta : {1, -1}) {
+        other = jump_bytes;
+        int32_t changed = operand + delta;
+        memcpy(&other[jump + offsetof(Instruction, operand)], &changed, sizeof(changed));
+        write_bytes(path, other);
+        assert(open_error(path).find("salto inválido") != string::npos);
+    }
+    write_bytes(path, jump_bytes);
+    assert(open_error(path) == "");
+
+    try {
+        RuleFile missing("/tmp/edoo_arquivo_que_nao_existe");
+        assert(false);
+    } catch (const IOError& e) {
+        cout << e.what() << endl;
+    }
+    unlink(path.c_str());
+}
+
+void test_many_rules() {
+    cout << "Testando muitas regras..." << endl;
+
+    RuleFileWriter writer;
+    writer.declare("x", ValueType::INTEGER);
+    writer.declare("y", ValueType::INTEGER);
+    const int count = 5000;
+    for (int i = 0; i < count; i++) {
+        writer.add("regra_" + to_string(i), "x * " + to_string(i % 17) + " + y > " + to_string(i));
+    }
+    string path = temporary_path();
+    writer.write(path);
+
+    RuleFile rules(path);
+    rules.verify();
+    assert(rules.size() == count);
+    int32_t slots[2] = {100, 7};
+    for (int i = 0; i < count; i++) {
+        MappedRule rule = rules.rule("regra_" + to_string(i));
+        assert(rule.get_name() == "regra_" + to_string(i));
+        assert(get<bool>(rule.evaluate(slots)) == (100 * (i % 17) + 7 > i));
+    }
+    unlink(path.c_str());
+}
+
+int main() {
+    test_round_trip();
+    test_source_errors();
+    test_corrupted();
+    test_many_rules();
+
+    cout << "Todos os testes do RuleFile passaram!" << endl;
+    return 0;
+}
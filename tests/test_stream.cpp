@@ -0,0 +1,111 @@
+#include <cassert>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "parser.h"
+#include "stream.h"
+using namespace std;
+
+void test_spsc_queue() {
+    cout << "Testando SpscQueue..." << endl;
+
+    SpscQueue<int, 4> queue;
+    int value;
+    assert(!queue.try_pop(value));
+    for (int i = 0; i < 4; i++) assert(queue.try_push(i));
+    assert(!queue.try_push(4));
+    assert(queue.try_pop(value) && value == 0);
+
+    // Um produtor e um consumidor: tudo chega, em ordem
+    SpscQueue<int, 8> channel;
+    const int COUNT = 100000;
+    thread producer([&] {
+        for (int i = 0; i < COUNT; i++) channel.push(i);
+    });
+    for (int i = 0; i < COUNT; i++) {
+        assert(channel.pop() == i);
+    }
+    producer.join();
+}
+
+// Roda o pipeline lendo de um pipe e escrevendo num arquivo temporário
+static string run_pipeline(const string& input, bool optimize = false) {
+    int pipe_fds[2];
+    assert(pipe(pipe_fds) == 0);
+    thread writer([&] {
+        // Em pedaços pequenos, como um produtor lento
+        for (size_t i = 0; i < input.size(); i += 7) {
+            size_t count = min<size_t>(7, input.size() - i);
+            assert(write(pipe_fds[1], input.data() + i, count) == static_cast<ssize_t>(count));
+        }
+        close(pipe_fds[1]);
+    });
+
+    char path[] = "/tmp/edoo_stream_XXXXXX";
+    int out = mkstemp(path);
+    {
+        BufferedOutput output(out);
+        StreamPipeline(optimize).run(pipe_fds[0], output);
+    }
+    writer.join();
+    close(pipe_fds[0]);
+    close(out);
+
+    ifstream file(path);
+    stringstream contents;
+    contents << file.rdbuf();
+    unlink(path);
+    return contents.str();
+}
+
+static string expected_output(const string& input) {
+    ExpressionEvaluator evaluator;
+    istringstream stream(input);
+    string line, output;
+    while (getline(stream, line)) {
+        try {
+            auto result = evaluator.evaluate(line);
+            if (holds_alternative<int>(result)) output += to_string(get<int>(result));
+            else output += get<bool>(result) ? "true" : "false";
+        } catch (const exception&) {
+            output += "error";
+        }
+        output += "\n";
+        evaluator.reset();
+    }
+    return output;
+}
+
+void test_pipeline() {
+    cout << "Testando o pipeline..." << endl;
+
+    string input = "1 + 2\n( 3 * 4 ) == 12\n\n1 / 0\ntrue && 3\n- 5\n2 * ( 3 + 4 )";
+    string output = run_pipeline(input);
+    cout << output;
+    assert(output == "3\ntrue\nerror\nerror\nerror\n-5\n14\n");
+    assert(output == expected_output(input));
+    assert(run_pipeline(input, true) == output);
+    assert(run_pipeline("") == "");
+
+    // Mais linhas que lotes * linhas por lote, para os lotes circularem
+    string big;
+    const char* lines[] = {"1 + 1", "2 < 3 || false", "( 7 / 0 )", "abc", "10 - -3", "( ( 1 ) )"};
+    size_t count = StreamPipeline::BATCH_COUNT * StreamPipeline::BATCH_LINES * 3 + 5;
+    for (size_t i = 0; i < count; i++) {
+        big += lines[i % 6];
+        big += "\n";
+    }
+    assert(run_pipeline(big) == expected_output(big));
+}
+
+int main() {
+    test_spsc_queue();
+    test_pipeline();
+
+    cout << "Todos os testes de streaming passaram!" << endl;
+    return 0;
+}
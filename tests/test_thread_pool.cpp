@@ -0,0 +1,101 @@
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include "thread_pool.h"
+using namespace std;
+
+void test_all_tasks_run() {
+    cout << "Testando execução de todas as tarefas..." << endl;
+
+    WorkStealingPool pool(4);
+    assert(pool.size() == 4);
+
+    vector<int> results(10000, 0);
+    for (size_t i = 0; i < results.size(); i++) {
+        pool.submit([&results, i](size_t worker) {
+            assert(worker < 4);
+            results[i] = static_cast<int>(i) * 2;
+        });
+    }
+    pool.wait();
+    for (size_t i = 0; i < results.size(); i++) {
+        assert(results[i] == static_cast<int>(i) * 2);
+    }
+
+    // O pool continua utilizável depois de wait
+    atomic<int> count{0};
+    for (int i = 0; i < 100; i++) {
+        pool.submit([&count](size_t) { count++; });
+    }
+    pool.wait();
+    assert(count == 100);
+}
+
+void test_stealing() {
+    cout << "Testando roubo de tarefas..." << endl;
+
+    // Todas as tarefas lentas caem na fila da thread 0 (rodízio com 2
+    // filas, índices pares); as outras threads precisam roubá-las
+    WorkStealingPool pool(2);
+    atomic<int> ran_elsewhere{0};
+    for (int i = 0; i < 16; i++) {
+        if (i % 2 == 0) {
+            pool.submit([&ran_elsewhere](size_t worker) {
+                this_thread::sleep_for(chrono::milliseconds(5));
+                if (worker != 0) ran_elsewhere++;
+            });
+        } else {
+            pool.submit([](size_t) {});
+        }
+    }
+    pool.wait();
+    cout << "Tarefas roubadas: " << ran_elsewhere << endl;
+    assert(ran_elsewhere > 0);
+}
+
+void test_order() {
+    cout << "Testando a ordem das tarefas..." << endl;
+
+    // Uma thread só: a própria fila sai na ordem de submit
+    WorkStealingPool pool(1);
+    vector<int> order;
+    for (int i = 0; i < 100; i++) {
+        pool.submit([&order, i](size_t) { order.push_back(i); });
+    }
+    pool.wait();
+    for (int i = 0; i < 100; i++) assert(order[i] == i);
+}
+
+void test_exceptions() {
+    cout << "Testando exceções nas tarefas..." << endl;
+
+    WorkStealingPool pool(3);
+    atomic<int> count{0};
+    for (int i = 0; i < 50; i++) {
+        pool.submit([&count, i](size_t) {
+            count++;
+            if (i == 25) throw runtime_error("falha na tarefa");
+        });
+    }
+    try {
+        pool.wait();
+        assert(false);
+    } catch (const runtime_error& e) {
+        assert(string(e.what()) == "falha na tarefa");
+    }
+    assert(count == 50);
+    pool.wait();
+}
+
+int main() {
+    test_all_tasks_run();
+    test_stealing();
+    test_order();
+    test_exceptions();
+
+    cout << "Todos os testes do pool de threads passaram!" << endl;
+    return 0;
+}
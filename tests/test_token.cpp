@@ -6,7 +6,7 @@ using namespace std;
 int main() {
     string s = "2+4";
 
-    Token t("INTEGER", "2");
+    Token t(TokenType::INTEGER, 0, 1, 2);
     cout << t.to_string() << " ";
 
     return 0;
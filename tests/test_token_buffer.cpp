@@ -0,0 +1,197 @@
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "fast_io.h"
+#include "parser.h"
+#include "token_buffer.h"
+using namespace std;
+
+static bool same_token(const Token& a, const Token& b) {
+    return a.get_type() == b.get_type() && a.get_offset() == b.get_offset()
+        && a.get_length() == b.get_length() && a.get_int() == b.get_int();
+}
+
+// Os tokens da linha precisam ser os que o Lexer daria, com o mesmo erro
+static void check_like_lexer(const TokenLine& line) {
+    if (line.text.empty()) {
+        assert(line.error == ErrorCode::EMPTY_INPUT);
+        assert(line.tokens == line.last && line.last->is(TokenType::END_OF_FILE));
+        return;
+    }
+    Lexer lexer(line.text);
+    const Token* token = line.tokens;
+    while (true) {
+        Token expected = lexer.next_token();
+        assert(same_token(*token, expected));
+        if (expected.is(TokenType::END_OF_FILE)) break;
+        token++;
+    }
+    assert(token == line.last);
+    assert(line.error == lexer.get_error().code);
+    if (lexer.failed()) assert(line.error_offset == lexer.get_error().offset);
+}
+
+static void check_line(const string& text) {
+    TokenBuffer tokens;
+    tokens.add_line(text);
+    assert(tokens.size() == 1);
+    check_like_lexer(tokens.line(0));
+}
+
+// add_lines precisa separar as linhas como getline e tokenizar cada uma
+static void check_lines(const string& text) {
+    TokenBuffer tokens;
+    tokens.add_lines(text);
+    LineReader reader(text);
+    size_t count = 0;
+    while (!reader.at_end()) {
+        string_view expected = reader.next_line();
+        assert(count < tokens.size());
+        TokenLine line = tokens.line(count++);
+        assert(line.text == expected);
+        assert(line.text.data() == expected.data());
+        check_like_lexer(line);
+    }
+    assert(count == tokens.size());
+}
+
+void test_like_lexer() {
+    cout << "Testando TokenBuffer contra o Lexer (" << TokenBuffer::instruction_set() << ")..." << endl;
+
+    vector<string> cases = {
+        "7", "2 + 3 * 2", "( 2 - - -3 ) * 2", "true || false == false", "x_1 <= y2 && _z != 0",
+        "1<2", "1<=2", "1>2", "1>=2", "1==2", "1!=2", "a||b", "a&&b",
+        // '-' sem espaço depois: inteiro (ou erro)
+        "-", "- ", "-5", "--5", "-(1)", "3 -2", "3 - 2", "-\t1", "-a",
+        // Operadores incompletos
+        "|", "&", "=", "!", "1 | 2", "&&&", "!!=", "= =",
+        // Inteiros nos limites e fora deles
+        "2147483647", "-2147483648", "2147483648", "-2147483649", "99999999999999999999",
+        "007", "12abc", "abc12", "truex", "true_", "falsehood", "True",
+        // Espaços, '\r', '\v', '\f', '\n' e bytes de fora do ASCII
+        "\t1 +\t2\r", "1\v+\f2", "  \t  ", "1 +\n2", "\n", string("1 + \0 2", 7), string("\0", 1),
+        "1 + \xc3\xa9", "\x80", "1 # 2", "@", "1 $",
+    };
+    // Tokens e espaços atravessando as fronteiras de 64 bytes
+    for (size_t pad = 0; pad < 140; pad++) {
+        cases.push_back(string(pad, ' ') + "123456789 + abc_def");
+        cases.push_back(string(pad, '1'));
+        cases.push_back(string(pad, 'x') + " - 3");
+        cases.push_back("1" + string(pad, ' ') + "-" + string(pad % 3, ' ') + "2");
+        cases.push_back(string(pad, '(') + "1" + string(pad, ')'));
+    }
+
+    string all;
+    for (const auto& text : cases) {
+        check_line(text);
+        if (text.find('\n') == string::npos) all += text + "\n";
+    }
+    check_lines(all);
+    check_lines(all + "sem newline no fim");
+    check_lines("");
+    check_lines("\n\n1\n\n");
+    cout << "Casos fixos OK" << endl;
+
+    // Linhas aleatórias com os caracteres que mais importam
+    static const char characters[] = "0123456789 -+*/()<>=!|&_abtruefalsxyz\t\r\x80\0";
+    const string alphabet(characters, sizeof(characters) - 1);
+    mt19937 rng(7);
+    for (int round = 0; round < 400; round++) {
+        string text;
+        size_t lines = rng() % 40;
+        for (size_t i = 0; i < lines; i++) {
+            size_t length = rng() % 90;
+            // Na metade das rodadas, sequências longas do mesmo caractere,
+            // que atravessam os blocos de 64 bytes
+            for (size_t j = 0; j < length; j++) text.append(round % 2 ? 1 + rng() % 70 : 1, alphabet[rng() % alphabet.size()]);
+            text += '\n';
+        }
+        check_lines(text);
+        check_line(text);
+    }
+    cout << "Linhas aleatórias OK" << endl;
+}
+
+void test_reuse() {
+    cout << "Testando clear e várias chamadas..." << endl;
+
+    TokenBuffer tokens;
+    string first = "1 + 2\ntrue";
+    string second = "(3)";
+    tokens.add_lines(first);
+    tokens.add_line(second);
+    assert(tokens.size() == 3);
+    assert(tokens.token_count() == 4 + 2 + 4);
+    assert(tokens.line(2).text == "(3)");
+    assert(tokens.line(2).tokens->is(TokenType::LPAREN));
+    assert(tokens.line(2).tokens->get_offset() == 0);
+
+    tokens.clear();
+    assert(tokens.size() == 0 && tokens.token_count() == 0);
+    tokens.add_line("x");
+    assert(tokens.size() == 1);
+    check_like_lexer(tokens.line(0));
+}
+
+// Avaliar pelos tokens do TokenBuffer dá o mesmo que avaliar o texto, com
+// os mesmos erros, em todos os motores
+void test_same_results() {
+    cout << "Testando avaliação pelos tokens do TokenBuffer..." << endl;
+
+    string text =
+        "1 + 2 * 3\n( 2 - - -3 ) * 2\ntrue || false == false\n10 / 0\n1 + true\n"
+        "1 +\n(1\n1 2\n\n-\n1 @ 2\n2147483648\n--5\n3 -2\n1 < 2 && 2 < 3\n"
+        "-(4 * 5)\n1 & 2\nx + 1\n)\n";
+    TokenBuffer tokens;
+    tokens.add_lines(text);
+
+    for (Engine engine : {Engine::TREE, Engine::BYTECODE, Engine::TYPED}) {
+        for (bool optimize : {false, true}) {
+            ExpressionEvaluator from_text(engine, optimize);
+            ExpressionEvaluator from_tokens(engine, optimize);
+            for (size_t i = 0; i < tokens.size(); i++) {
+                TokenLine line = tokens.line(i);
+                string expected, found;
+                try {
+                    auto value = from_text.evaluate(line.text);
+                    expected = holds_alternative<int>(value) ? to_string(get<int>(value)) : to_string(get<bool>(value));
+                } catch (const exception& e) {
+                    expected = e.what();
+                }
+                try {
+                    auto value = from_tokens.evaluate(line);
+                    found = holds_alternative<int>(value) ? to_string(get<int>(value)) : to_string(get<bool>(value));
+                } catch (const exception& e) {
+                    found = e.what();
+                }
+                assert(expected == found);
+                from_text.reset();
+                from_tokens.reset();
+
+                EvaluationResult a = from_text.try_evaluate(line.text);
+                EvaluationResult b = from_tokens.try_evaluate(line);
+                assert(a.ok() == b.ok());
+                if (a.ok()) {
+                    assert(a.get_value() == b.get_value());
+                } else {
+                    assert(a.get_error().code == b.get_error().code);
+                    assert(a.get_error().offset == b.get_error().offset);
+                    assert(a.get_error().message() == b.get_error().message());
+                }
+                from_text.reset();
+                from_tokens.reset();
+            }
+        }
+    }
+    cout << "Mesmos resultados OK" << endl;
+}
+
+int main() {
+    test_like_lexer();
+    test_reuse();
+    test_same_results();
+    cout << "Todos os testes do TokenBuffer passaram!" << endl;
+    return 0;
+}
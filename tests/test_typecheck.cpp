@@ -0,0 +1,79 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <variant>
+#include "parser.h"
+#include "typecheck.h"
+using namespace std;
+
+static Arena arena;
+
+static TypedExpression check(const string& input) {
+    Lexer lexer(input);
+    Parser parser(lexer, arena);
+    auto expr = parser.parse();
+    return TypeChecker(arena).check_and_rewrite(*expr);
+}
+
+void test_typed_results() {
+    cout << "Comparando nós tipados com a árvore..." << endl;
+
+    ExpressionEvaluator tree(Engine::TREE);
+
+    const char* cases[] = {
+        "1", "-7", "2 + 3 * 2", "( 2 - - -3 ) * 2", "3 / 2", "1 + 2 + 3 - 4",
+        "true || false == false", "( true || false ) == false",
+        "42 >= ( ( 6 * ( 8 - 1 ) ) + 1 )", "( ( 43 <= 42 ) || false ) != true",
+        "- ( 4 * 2 )", "false == ( 7 > 10 )", "true && 2 > 1", "8 != 8",
+        "( 50 >= ( 25 * ( 4 / 2 ) ) && ( false == false ) )"
+    };
+
+    for (const char* input : cases) {
+        auto typed = check(input);
+        auto expected = tree.evaluate(input);
+        assert(typed.evaluate() == expected);
+        assert((typed.get_type() == ValueType::INTEGER) == holds_alternative<int>(expected));
+        tree.reset();
+        cout << "Teste: " << input << " OK" << endl;
+    }
+}
+
+void test_type_errors() {
+    cout << "Testando erros de tipo antes da avaliação..." << endl;
+
+    // ( 1 / 0 ) + true: o erro de tipo aparece antes da divisão por zero
+    const char* cases[] = {
+        "2 + true", "true + 3", "- true", "3 || 3", "0 == false",
+        "( 1 / 0 ) + true", "true && ( 1 + 2 )", "false < ( 12 - 1 )"
+    };
+
+    for (const char* input : cases) {
+        try {
+            check(input);
+            assert(false);
+        } catch (const TypeError& e) {
+            cout << "Teste: " << input << " -> " << e.what() << endl;
+        }
+    }
+}
+
+void test_runtime_errors() {
+    cout << "Testando divisão por zero nos nós tipados..." << endl;
+
+    auto typed = check("( 4 / ( 2 - 2 ) ) == 1");
+    try {
+        typed.evaluate();
+        assert(false);
+    } catch (const ExpressionError& e) {
+        assert(string(e.what()) == "Divisão por zero");
+    }
+}
+
+int main() {
+    test_typed_results();
+    test_type_errors();
+    test_runtime_errors();
+
+    cout << "Todos os testes de tipos passaram!" << endl;
+    return 0;
+}
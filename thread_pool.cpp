@@ -0,0 +1,94 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(size_t count) {
+    if (count == 0) count = max(1u, thread::hardware_concurrency());
+    for (size_t i = 0; i < count; i++) {
+        queues.push_back(make_unique<Queue>());
+    }
+    for (size_t i = 0; i < count; i++) {
+        threads.emplace_back(&WorkStealingPool::run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : threads) worker.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+    pending++;
+    Queue& queue = *queues[next++ % queues.size()];
+    {
+        lock_guard<mutex> guard(queue.lock);
+        queue.tasks.push_back(move(task));
+    }
+    {
+        // Sob o lock, para a thread não perder o aviso entre checar e dormir
+        lock_guard<mutex> guard(lock);
+        queued++;
+    }
+    wake.notify_one();
+}
+
+bool WorkStealingPool::pop(size_t worker, Task& task) {
+    {
+        Queue& own = *queues[worker];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = move(own.tasks.front());
+            own.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues.size(); i++) {
+        Queue& victim = *queues[(worker + i) % queues.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(size_t worker) {
+    Task task;
+    while (true) {
+        if (pop(worker, task)) {
+            try {
+                task(worker);
+            } catch (...) {
+                lock_guard<mutex> guard(lock);
+                if (!error) error = current_exception();
+            }
+            task = nullptr;
+            if (--pending == 0) {
+                lock_guard<mutex> guard(lock);
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        unique_lock<mutex> guard(lock);
+        wake.wait(guard, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
+
+void WorkStealingPool::wait() {
+    unique_lock<mutex> guard(lock);
+    idle.wait(guard, [this] { return pending == 0; });
+    if (error) {
+        exception_ptr failed = error;
+        error = nullptr;
+        rethrow_exception(failed);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Pool com uma fila por thread. Cada thread tira tarefas do começo da
+// própria fila e, quando ela esvazia, rouba do começo da fila das outras,
+// então um bloco mais lento não deixa as demais paradas. As tarefas saem
+// na ordem de submit (de cada fila), para quem consome os resultados em
+// ordem não esperar pela primeira tarefa. A tarefa recebe o índice da
+// thread, para usar estado próprio (ex: um ExpressionEvaluator por thread)
+class WorkStealingPool {
+    public:
+        using Task = function<void(size_t worker)>;
+
+    private:
+        struct Queue {
+            mutex lock;
+            deque<Task> tasks;
+        };
+
+        vector<unique_ptr<Queue>> queues;
+        vector<thread> threads;
+
+        mutex lock;
+        condition_variable wake;
+        condition_variable idle;
+        // queued: nas filas; pending: ainda não terminadas
+        atomic<size_t> queued{0};
+        atomic<size_t> pending{0};
+        size_t next = 0;
+        bool stopping = false;
+        exception_ptr error;
+
+        bool pop(size_t worker, Task& task);
+        void run(size_t worker);
+
+    public:
+        // threads == 0 usa thread::hardware_concurrency()
+        explicit WorkStealingPool(size_t threads = 0);
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        // Distribui as tarefas entre as filas em rodízio
+        void submit(Task task);
+        // Espera todas as tarefas; relança a primeira exceção de uma tarefa
+        void wait();
+
+        inline size_t size() const { return threads.size(); }
+};
+
+#endif
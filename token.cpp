@@ -1,17 +1,72 @@
 #include "token.h"
+#include <string>
+
+const char* token_type_name(TokenType type) {
+    switch (type) {
+        case TokenType::INTEGER:       return "INTEGER";
+        case TokenType::BOOLEAN:       return "BOOLEAN";
+        case TokenType::PLUS:          return "PLUS";
+        case TokenType::MINUS:         return "MINUS";
+        case TokenType::MULTIPLY:      return "MULTIPLY";
+        case TokenType::DIVIDE:        return "DIVIDE";
+        case TokenType::OR:            return "OR";
+        case TokenType::AND:           return "AND";
+        case TokenType::EQUALS:        return "EQUALS";
+        case TokenType::NOT_EQUALS:    return "NOT_EQUALS";
+        case TokenType::LESS:          return "LESS";
+        case TokenType::GREATER:       return "GREATER";
+        case TokenType::LESS_EQUAL:    return "LESS_EQUAL";
+        case TokenType::GREATER_EQUAL: return "GREATER_EQUAL";
+        case TokenType::LPAREN:        return "LPAREN";
+        case TokenType::RPAREN:        return "RPAREN";
+        case TokenType::IDENTIFIER:    return "IDENTIFIER";
+        case TokenType::END_OF_FILE:   return "EOF";
+    }
+    return "UNKNOWN";
+}
+
+// Símbolo dos operadores e parênteses, para o to_string
+static const char* token_type_symbol(TokenType type) {
+    switch (type) {
+        case TokenType::PLUS:          return "+";
+        case TokenType::MINUS:         return "-";
+        case TokenType::MULTIPLY:      return "*";
+        case TokenType::DIVIDE:        return "/";
+        case TokenType::OR:            return "||";
+        case TokenType::AND:           return "&&";
+        case TokenType::EQUALS:        return "==";
+        case TokenType::NOT_EQUALS:    return "!=";
+        case TokenType::LESS:          return "<";
+        case TokenType::GREATER:       return ">";
+        case TokenType::LESS_EQUAL:    return "<=";
+        case TokenType::GREATER_EQUAL: return ">=";
+        case TokenType::LPAREN:        return "(";
+        case TokenType::RPAREN:        return ")";
+        default:                       return "";
+    }
+}
+
+variant<int, bool> Token::get_value() const {
+    if (type == TokenType::BOOLEAN) {
+        return get_bool();
+    }
+    return get_int();
+}
 
 // Para debug
-string Token::to_string() {
-    string result = "Token(" + type + ", ";
+string Token::to_string(string_view source) const {
+    string result = string("Token(") + token_type_name(type) + ", ";
 
-    if (holds_alternative<int>(value)) {
-        result += std::to_string(get<int>(value));
-    } else if (holds_alternative<bool>(value)) {
-        result += get<bool>(value) ? "true" : "false";
+    if (type == TokenType::INTEGER) {
+        result += std::to_string(get_int());
+    } else if (type == TokenType::BOOLEAN) {
+        result += get_bool() ? "true" : "false";
+    } else if (type == TokenType::IDENTIFIER) {
+        result += source.empty() ? "@" + std::to_string(offset) : string(get_text(source));
     } else {
-        result += get<string>(value);
+        result += token_type_symbol(type);
     }
     result += ")";
-    
+
     return result;
 }
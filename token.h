@@ -2,21 +2,63 @@
 #define TOKEN_H
 
 #include <iostream>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
 #include <variant>
 using namespace std;
 
+enum class TokenType : uint8_t {
+    INTEGER,
+    BOOLEAN,
+    PLUS,
+    MINUS,
+    MULTIPLY,
+    DIVIDE,
+    OR,
+    AND,
+    EQUALS,
+    NOT_EQUALS,
+    LESS,
+    GREATER,
+    LESS_EQUAL,
+    GREATER_EQUAL,
+    LPAREN,
+    RPAREN,
+    IDENTIFIER,
+    END_OF_FILE
+};
+
+// Nome do tipo, usado nas mensagens de erro e no to_string
+const char* token_type_name(TokenType type);
+
+// Token pequeno e trivialmente copiável: o texto fica na entrada original
+// e é referenciado pela posição (offset) e tamanho
 class Token {
     private:
-        string type;
-        variant <int, bool, string> value;
-    
+        TokenType type;
+        uint32_t offset;
+        uint32_t length;
+        int32_t value;
+
     public:
-        Token(string t, variant<int, bool, string> v) : type(t), value(v) {}
-        ~Token() = default;
+        constexpr Token(TokenType t = TokenType::END_OF_FILE, size_t o = 0, size_t l = 0, int32_t v = 0)
+            : type(t), offset(static_cast<uint32_t>(o)), length(static_cast<uint32_t>(l)), value(v) {}
+
+        constexpr TokenType get_type() const { return this->type; }
+        constexpr size_t get_offset() const { return this->offset; }
+        constexpr size_t get_length() const { return this->length; }
+        constexpr int get_int() const { return this->value; }
+        constexpr bool get_bool() const { return this->value != 0; }
+        constexpr bool is(TokenType t) const { return this->type == t; }
 
-        inline string& get_type() { return this->type; }
-        inline auto& get_value() { return this->value; }
-        string to_string();
+        // Texto do token dentro da entrada de onde ele foi lido
+        constexpr string_view get_text(string_view source) const { return source.substr(offset, length); }
+        variant<int, bool> get_value() const;
+        // Com a entrada original, identificadores mostram o próprio nome
+        string to_string(string_view source = {}) const;
 };
 
-#endif
\ No newline at end of file
+static_assert(is_trivially_copyable_v<Token>, "Token deve ser trivialmente copiável");
+
+#endif
@@ -0,0 +1,310 @@
+#include "token_buffer.h"
+#include "profile.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#if !defined(EDOO_NO_SIMD) && defined(__AVX2__)
+#define EDOO_SIMD_AVX2 1
+#include <immintrin.h>
+#elif !defined(EDOO_NO_SIMD) && defined(__SSE2__)
+#define EDOO_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// BYTES caracteres por vez e as operações usadas na classificação. As
+// comparações são com sinal: bytes a partir de 0x80 não caem em nenhuma
+// faixa, como nos is* do locale "C"
+#if EDOO_SIMD_AVX2
+using Bytes = __m256i;
+constexpr size_t BYTES = 32;
+static inline Bytes bytes_load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const Bytes*>(p)); }
+static inline Bytes bytes_set1(char c) { return _mm256_set1_epi8(c); }
+static inline Bytes bytes_and(Bytes a, Bytes b) { return _mm256_and_si256(a, b); }
+static inline Bytes bytes_or(Bytes a, Bytes b) { return _mm256_or_si256(a, b); }
+static inline Bytes bytes_andnot(Bytes a, Bytes b) { return _mm256_andnot_si256(a, b); }
+static inline Bytes bytes_eq(Bytes a, Bytes b) { return _mm256_cmpeq_epi8(a, b); }
+static inline Bytes bytes_gt(Bytes a, Bytes b) { return _mm256_cmpgt_epi8(a, b); }
+static inline uint64_t bytes_mask(Bytes a) { return static_cast<uint32_t>(_mm256_movemask_epi8(a)); }
+#elif EDOO_SIMD_SSE2
+using Bytes = __m128i;
+constexpr size_t BYTES = 16;
+static inline Bytes bytes_load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const Bytes*>(p)); }
+static inline Bytes bytes_set1(char c) { return _mm_set1_epi8(c); }
+static inline Bytes bytes_and(Bytes a, Bytes b) { return _mm_and_si128(a, b); }
+static inline Bytes bytes_or(Bytes a, Bytes b) { return _mm_or_si128(a, b); }
+static inline Bytes bytes_andnot(Bytes a, Bytes b) { return _mm_andnot_si128(a, b); }
+static inline Bytes bytes_eq(Bytes a, Bytes b) { return _mm_cmpeq_epi8(a, b); }
+static inline Bytes bytes_gt(Bytes a, Bytes b) { return _mm_cmpgt_epi8(a, b); }
+static inline uint64_t bytes_mask(Bytes a) { return static_cast<uint16_t>(_mm_movemask_epi8(a)); }
+#endif
+
+#if EDOO_SIMD_AVX2 || EDOO_SIMD_SSE2
+// low <= c <= high
+static inline Bytes bytes_in_range(Bytes c, char low, char high) {
+    return bytes_and(bytes_gt(c, bytes_set1(static_cast<char>(low - 1))), bytes_gt(bytes_set1(static_cast<char>(high + 1)), c));
+}
+#endif
+
+const char* TokenBuffer::instruction_set() {
+#if EDOO_SIMD_AVX2
+    return "AVX2";
+#elif EDOO_SIMD_SSE2
+    return "SSE2";
+#else
+    return "escalar";
+#endif
+}
+
+// Classifica os 64 bytes a partir de p, um bit por byte
+static inline void classify_block(const char* p, uint64_t& space, uint64_t& digit, uint64_t& word, uint64_t& newline,
+                                  uint64_t& minus) {
+    space = digit = word = newline = minus = 0;
+#if EDOO_SIMD_AVX2 || EDOO_SIMD_SSE2
+    for (size_t i = 0; i < 64; i += BYTES) {
+        Bytes c = bytes_load(p + i);
+        Bytes is_newline = bytes_eq(c, bytes_set1('\n'));
+        // ' ' e '\t' a '\r', menos o '\n'
+        Bytes is_space = bytes_andnot(is_newline, bytes_or(bytes_eq(c, bytes_set1(' ')), bytes_in_range(c, '\t', '\r')));
+        Bytes is_digit = bytes_in_range(c, '0', '9');
+        // c | 0x20 leva 'A'-'Z' para 'a'-'z' sem trazer mais nada para a faixa
+        Bytes is_letter = bytes_in_range(bytes_or(c, bytes_set1(0x20)), 'a', 'z');
+        Bytes is_word = bytes_or(bytes_or(is_digit, is_letter), bytes_eq(c, bytes_set1('_')));
+        space |= bytes_mask(is_space) << i;
+        digit |= bytes_mask(is_digit) << i;
+        word |= bytes_mask(is_word) << i;
+        newline |= bytes_mask(is_newline) << i;
+        minus |= bytes_mask(bytes_eq(c, bytes_set1('-'))) << i;
+    }
+#else
+    for (size_t i = 0; i < 64; i++) {
+        unsigned char c = static_cast<unsigned char>(p[i]);
+        uint64_t bit = uint64_t(1) << i;
+        bool is_digit = static_cast<unsigned>(c - '0') < 10;
+        bool is_letter = static_cast<unsigned>((c | 0x20) - 'a') < 26;
+        if (c == ' ' || (c >= '\t' && c <= '\r' && c != '\n')) space |= bit;
+        if (is_digit) digit |= bit;
+        if (is_digit || is_letter || c == '_') word |= bit;
+        if (c == '\n') newline |= bit;
+        if (c == '-') minus |= bit;
+    }
+#endif
+}
+
+// Tipo do token que começa com o operador c ('<' dá LESS, '|' dá OR...);
+// END_OF_FILE para o que não começa operador. Uma tabela, para os
+// operadores de uma linha não virarem desvios imprevisíveis
+struct OperatorTable {
+    TokenType types[256];
+
+    constexpr OperatorTable() : types() {
+        for (auto& type : types) type = TokenType::END_OF_FILE;
+        types[static_cast<unsigned char>('+')] = TokenType::PLUS;
+        types[static_cast<unsigned char>('-')] = TokenType::MINUS;
+        types[static_cast<unsigned char>('*')] = TokenType::MULTIPLY;
+        types[static_cast<unsigned char>('/')] = TokenType::DIVIDE;
+        types[static_cast<unsigned char>('(')] = TokenType::LPAREN;
+        types[static_cast<unsigned char>(')')] = TokenType::RPAREN;
+        types[static_cast<unsigned char>('<')] = TokenType::LESS;
+        types[static_cast<unsigned char>('>')] = TokenType::GREATER;
+        types[static_cast<unsigned char>('|')] = TokenType::OR;
+        types[static_cast<unsigned char>('&')] = TokenType::AND;
+        types[static_cast<unsigned char>('=')] = TokenType::EQUALS;
+        types[static_cast<unsigned char>('!')] = TokenType::NOT_EQUALS;
+    }
+};
+
+static constexpr OperatorTable OPERATORS;
+// Os operadores de dois caracteres vêm juntos em TokenType, de OR a GREATER
+static_assert(TokenType::AND > TokenType::OR && TokenType::EQUALS > TokenType::AND
+           && TokenType::NOT_EQUALS > TokenType::EQUALS && TokenType::LESS > TokenType::NOT_EQUALS
+           && TokenType::GREATER > TokenType::LESS, "ordem dos operadores em TokenType");
+
+static inline bool is_digit_byte(char c) { return static_cast<unsigned>(c - '0') < 10; }
+
+static inline bool is_word_byte(char c) {
+    return is_digit_byte(c) || static_cast<unsigned>((c | 0x20) - 'a') < 26 || c == '_';
+}
+
+static inline bool is_space_byte(char c, bool spaced_newline) {
+    return c == ' ' || (c >= '\t' && c <= '\r' && (c != '\n' || spaced_newline));
+}
+
+// Fim da sequência de bytes da classe de mask que começa em pos, no bloco
+// que começa em base. Quase sempre termina no próprio bloco; senão segue um
+// caractere por vez, sem classificar o bloco seguinte
+template <bool (*Member)(char)>
+static inline size_t run_end(const char* data, size_t size, size_t base, uint64_t mask, size_t pos) {
+    if (pos < base + 64) {
+        uint64_t bits = ~mask >> (pos - base);
+        if (bits) return pos + __builtin_ctzll(bits);
+        pos = base + 64;
+    }
+    while (pos < size && Member(data[pos])) pos++;
+    return pos;
+}
+
+// Tokeniza text numa passada só, um bloco de 64 bytes por vez: o bloco é
+// classificado e, das máscaras, sai de uma vez o começo de todos os tokens
+// dele (o primeiro byte de cada palavra e cada byte que não é espaço nem de
+// palavra), percorrido com ctz. O fim de inteiros e palavras também vem das
+// máscaras, e o primeiro caractere escolhe o caso, como em Lexer::next_token,
+// para dar os mesmos tokens e erros. Com split_lines cada '\n' fecha uma
+// linha (um '\n' no fim não abre uma linha vazia); sem, o texto é uma linha
+// só e o '\n' é espaço
+void TokenBuffer::scan(string_view text, bool split_lines) {
+    const char* data = text.data();
+    size_t size = text.size();
+
+    // A linha atual. Depois de um erro (ou de um '\0') o resto dela é pulado
+    // e stop guarda onde o Lexer teria parado
+    size_t begin = 0;
+    uint32_t first = static_cast<uint32_t>(tokens.size());
+    ErrorCode error = ErrorCode::NONE;
+    size_t error_at = 0;
+    bool stopped = false;
+    size_t stop = 0;
+    auto finish_line = [&](size_t end) {
+        if (!stopped) stop = end;
+        if (begin == end) error = ErrorCode::EMPTY_INPUT;
+        tokens.emplace_back(TokenType::END_OF_FILE, stop - begin, 0);
+        lines.push_back({text.substr(begin, end - begin), first, static_cast<uint32_t>(tokens.size() - 1), error,
+                         static_cast<uint32_t>(error_at - begin)});
+        begin = end + 1;
+        first = static_cast<uint32_t>(tokens.size());
+        error = ErrorCode::NONE;
+        error_at = begin;
+        stopped = false;
+    };
+    auto fail = [&](ErrorCode code, size_t at, size_t where) {
+        error = code;
+        error_at = at;
+        stopped = true;
+        stop = where;
+    };
+
+    // pos: o primeiro byte ainda não consumido. resume: um inteiro terminou
+    // colado numa letra ("12abc") no bloco seguinte; a letra começa um token
+    // sem ser começo de palavra nas máscaras
+    size_t pos = 0;
+    bool resume = false;
+    for (size_t base = 0; base < size; base = max(base + 64, pos & ~size_t(63))) {
+        uint64_t space, digit, word, newline, minus;
+        if (size - base >= 64) {
+            classify_block(data + base, space, digit, word, newline, minus);
+        } else {
+            // O último bloco incompleto vai por uma cópia completada com
+            // '\0', que não é de nenhuma classe
+            char tail[64] = {};
+            memcpy(tail, data + base, size - base);
+            classify_block(tail, space, digit, word, newline, minus);
+        }
+        if (!split_lines) space |= newline;
+        uint64_t valid = size - base >= 64 ? ~uint64_t(0) : (uint64_t(1) << (size - base)) - 1;
+        uint64_t carry = base > 0 && is_word_byte(data[base - 1]);
+        uint64_t word_starts = word & ~(word << 1 | carry);
+        // Começos de inteiro: palavras que começam com dígito e '-' seguido
+        // de algo que não é espaço (o byte depois do bloco vem do texto)
+        uint64_t next_space = space >> 1;
+        if (base + 64 < size && is_space_byte(data[base + 64], !split_lines)) next_space |= uint64_t(1) << 63;
+        uint64_t numbers = (word_starts & digit) | (minus & ~next_space);
+        // Os começos de token do bloco ainda não consumidos
+        uint64_t left = (word_starts | ~(space | word)) & valid;
+        if (pos > base) left &= ~uint64_t(0) << (pos - base);
+        if (resume) {
+            left |= uint64_t(1) << (pos - base);
+            resume = false;
+        }
+
+        while (left) {
+            size_t start = base + __builtin_ctzll(left);
+            left &= left - 1;
+            char c = data[start];
+            if (c == '\n' && split_lines) {
+                finish_line(start);
+                pos = start + 1;
+                continue;
+            }
+            pos = start + 1;
+            if (stopped) continue;
+
+            TokenType type;
+            int32_t value = 0;
+
+            if ((numbers >> (start - base)) & 1) {
+                size_t digits = start + (c == '-');
+                pos = run_end<is_digit_byte>(data, size, base, digit, digits);
+                if (pos > digits && pos - digits <= 9) {
+                    // Até 9 dígitos não estouram um int: convertidos aqui mesmo
+                    for (size_t i = digits; i < pos; i++) value = value * 10 + (data[i] - '0');
+                    if (c == '-') value = -value;
+                } else {
+                    auto [last, ec] = from_chars(data + start, data + pos, value);
+                    if (ec == errc::result_out_of_range) {
+                        fail(ErrorCode::INTEGER_OUT_OF_RANGE, start, pos);
+                    } else if (ec != errc() || last != data + pos) {
+                        fail(ErrorCode::INVALID_INTEGER, start, pos);
+                    }
+                    if (stopped) continue;
+                }
+                type = TokenType::INTEGER;
+                if (pos < size && is_word_byte(data[pos])) {
+                    if (pos < base + 64) left |= uint64_t(1) << (pos - base);
+                    else resume = true;
+                }
+            } else if ((word >> (start - base)) & 1) {
+                pos = run_end<is_word_byte>(data, size, base, word, start);
+                string_view name(data + start, pos - start);
+                type = TokenType::IDENTIFIER;
+                if (name == "true") { type = TokenType::BOOLEAN; value = 1; }
+                else if (name == "false") type = TokenType::BOOLEAN;
+            } else if ((type = OPERATORS.types[static_cast<unsigned char>(c)]) == TokenType::END_OF_FILE) {
+                // '\0' encerra a linha como no Lexer; o resto é desconhecido
+                if (c != '\0') fail(ErrorCode::UNKNOWN_TOKEN, start, start);
+                stopped = true;
+                stop = start;
+                continue;
+            } else if (type >= TokenType::OR && type <= TokenType::GREATER) {
+                char next = pos < size && !(data[pos] == '\n' && split_lines) ? data[pos] : '\0';
+                if (type == TokenType::LESS || type == TokenType::GREATER) {
+                    if (next == '=') {
+                        type = type == TokenType::LESS ? TokenType::LESS_EQUAL : TokenType::GREATER_EQUAL;
+                        pos++;
+                    }
+                } else {
+                    // ||, &&, == e != precisam do segundo caractere
+                    if (next != (c == '!' ? '=' : c)) {
+                        fail(ErrorCode::UNKNOWN_TOKEN, start, start);
+                        continue;
+                    }
+                    pos++;
+                }
+            }
+            tokens.emplace_back(type, start - begin, pos - start, value);
+            // Os começos dentro do token (o segundo '|' de um ||, por
+            // exemplo) já foram consumidos
+            if (pos > start + 1) left &= pos - base < 64 ? ~uint64_t(0) << (pos - base) : 0;
+        }
+    }
+    if (!split_lines || begin < size) finish_line(size);
+}
+
+void TokenBuffer::add_line(string_view line) {
+    EDOO_PROFILE_STAGE(ProfileStage::LEXER);
+    scan(line, false);
+}
+
+void TokenBuffer::add_lines(string_view text) {
+    EDOO_PROFILE_STAGE(ProfileStage::LEXER);
+    if (!text.empty()) scan(text, true);
+}
+
+void TokenBuffer::clear() {
+    tokens.clear();
+    lines.clear();
+}
+
+TokenLine TokenBuffer::line(size_t index) const {
+    const LineRecord& record = lines[index];
+    return {record.text, tokens.data() + record.first, tokens.data() + record.last, record.error, record.error_offset};
+}
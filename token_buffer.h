@@ -0,0 +1,62 @@
+#ifndef TOKEN_BUFFER_H
+#define TOKEN_BUFFER_H
+
+#include "token.h"
+#include "errors.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+// Os tokens de uma linha dentro de um TokenBuffer. tokens vai até last, que
+// é sempre um END_OF_FILE; com um erro léxico, last fica onde o Lexer teria
+// parado e error/error_offset dizem qual foi (o Parser só o vê ao chegar lá)
+struct TokenLine {
+    string_view text;
+    const Token* tokens;
+    const Token* last;
+    ErrorCode error;
+    uint32_t error_offset;
+};
+
+// Tokenização em bloco: classifica a entrada 64 bytes por vez (AVX2 ou SSE2
+// quando o compilador permite; EDOO_NO_SIMD força o escalar) em máscaras de
+// espaço, dígito, palavra e '\n', e acha o fim de cada token com operações
+// de bits em vez de olhar um caractere por vez. Cada bloco é classificado
+// quando a varredura chega nele, e os tokens saem dele ainda no cache. Os
+// tokens de todas as linhas ficam num único vetor, na ordem da entrada; os
+// offsets são relativos à linha, como os do Lexer, e a sequência (erros
+// incluídos) é a mesma que Lexer::next_token daria. O texto precisa
+// continuar vivo
+class TokenBuffer {
+    private:
+        struct LineRecord {
+            string_view text;
+            uint32_t first;
+            uint32_t last;
+            ErrorCode error;
+            uint32_t error_offset;
+        };
+
+        vector<Token> tokens;
+        vector<LineRecord> lines;
+
+        void scan(string_view text, bool split_lines);
+
+    public:
+        // Uma linha inteira; '\n' dentro dela conta como espaço, como no Lexer
+        void add_line(string_view line);
+        // Várias linhas separadas por '\n', como LineReader::next_line as
+        // separaria (um '\n' no fim não abre uma linha vazia)
+        void add_lines(string_view text);
+        void clear();
+
+        inline size_t size() const { return lines.size(); }
+        inline size_t token_count() const { return tokens.size(); }
+        TokenLine line(size_t index) const;
+
+        // "AVX2", "SSE2" ou "escalar"
+        static const char* instruction_set();
+};
+
+#endif
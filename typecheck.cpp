@@ -0,0 +1,90 @@
+#include "typecheck.h"
+
+void TypeChecker::error(const string& message) {
+    throw TypeError(message);
+}
+
+ValueType TypeChecker::check(const Expression& expression) {
+    expression.accept(*this);
+    return result_type;
+}
+
+TypedExpression TypeChecker::check_and_rewrite(const Expression& expression) {
+    if (check(expression) == ValueType::INTEGER) {
+        return TypedExpression(move(int_result));
+    }
+    return TypedExpression(move(bool_result));
+}
+
+void TypeChecker::visit(const Literal& expression) {
+    const auto& value = expression.get_value();
+
+    if (holds_alternative<int>(value)) {
+        int_result = arena_new<IntConstant>(arena, get<int>(value));
+        result_type = ValueType::INTEGER;
+    } else {
+        bool_result = arena_new<BoolConstant>(arena, get<bool>(value));
+        result_type = ValueType::BOOLEAN;
+    }
+}
+
+void TypeChecker::visit(const Variable& expression) {
+    error("variável fora de uma expressão compilada: " + string(expression.get_name()));
+}
+
+void TypeChecker::visit(const PrimaryExpression& expression) {
+    check(expression.get_expression());
+}
+
+void TypeChecker::visit(const UnaryExpression& expression) {
+    string_view operador = expression.get_operator();
+
+    if (check(expression.get_expression()) != ValueType::INTEGER) {
+        error("operador unário " + string(operador) + " aplicado a um booleano");
+    }
+    if (operador != "-") {
+        error("operador unário desconhecido: " + string(operador));
+    }
+    int_result = arena_new<IntNegate>(arena, move(int_result));
+    result_type = ValueType::INTEGER;
+}
+
+void TypeChecker::visit(const BinaryExpression& expression) {
+    string_view operador = expression.get_operator();
+
+    ValueType left_type = check(expression.get_left());
+    IntNodePtr int_left = move(int_result);
+    BoolNodePtr bool_left = move(bool_result);
+
+    ValueType right_type = check(expression.get_right());
+    IntNodePtr int_right = move(int_result);
+    BoolNodePtr bool_right = move(bool_result);
+
+    if (left_type != right_type) {
+        error("operandos de tipos diferentes para " + string(operador));
+    }
+
+    if (left_type == ValueType::INTEGER) {
+        result_type = ValueType::INTEGER;
+        if (operador == "+")  { int_result = arena_new<IntAdd>(arena, move(int_left), move(int_right)); return; }
+        if (operador == "-")  { int_result = arena_new<IntSub>(arena, move(int_left), move(int_right)); return; }
+        if (operador == "*")  { int_result = arena_new<IntMul>(arena, move(int_left), move(int_right)); return; }
+        if (operador == "/")  { int_result = arena_new<IntDiv>(arena, move(int_left), move(int_right)); return; }
+
+        result_type = ValueType::BOOLEAN;
+        if (operador == "<")  { bool_result = arena_new<IntLess>(arena, move(int_left), move(int_right)); return; }
+        if (operador == ">")  { bool_result = arena_new<IntGreater>(arena, move(int_left), move(int_right)); return; }
+        if (operador == "<=") { bool_result = arena_new<IntLessEqual>(arena, move(int_left), move(int_right)); return; }
+        if (operador == ">=") { bool_result = arena_new<IntGreaterEqual>(arena, move(int_left), move(int_right)); return; }
+        if (operador == "==") { bool_result = arena_new<IntEqual>(arena, move(int_left), move(int_right)); return; }
+        if (operador == "!=") { bool_result = arena_new<IntNotEqual>(arena, move(int_left), move(int_right)); return; }
+        error("operador " + string(operador) + " não se aplica a inteiros");
+    }
+
+    result_type = ValueType::BOOLEAN;
+    if (operador == "&&") { bool_result = arena_new<BoolAnd>(arena, move(bool_left), move(bool_right)); return; }
+    if (operador == "||") { bool_result = arena_new<BoolOr>(arena, move(bool_left), move(bool_right)); return; }
+    if (operador == "==") { bool_result = arena_new<BoolEqual>(arena, move(bool_left), move(bool_right)); return; }
+    if (operador == "!=") { bool_result = arena_new<BoolNotEqual>(arena, move(bool_left), move(bool_right)); return; }
+    error("operador " + string(operador) + " não se aplica a booleanos");
+}
@@ -0,0 +1,40 @@
+#ifndef TYPECHECK_H
+#define TYPECHECK_H
+
+#include "expressions.h"
+#include "typed_expressions.h"
+using namespace std;
+
+class TypeError : public runtime_error {
+    public:
+        explicit TypeError(const string& message) : runtime_error("Erro de tipo: " + message) {}
+};
+
+// Verifica os tipos da árvore inteira antes de qualquer avaliação e a
+// reescreve em nós tipados (IntAdd, IntLess, BoolAnd...) na arena.
+// Operandos de tipos diferentes e operadores inválidos lançam TypeError.
+// Os nós tipados não leem slots: variáveis só são avaliadas pelo bytecode
+// de uma CompiledExpression
+class TypeChecker : private ExpressionVisitor {
+    private:
+        pmr::memory_resource& arena;
+        IntNodePtr int_result;
+        BoolNodePtr bool_result;
+        ValueType result_type = ValueType::INVALID;
+
+        ValueType check(const Expression& expression);
+        void error(const string& message);
+
+        void visit(const Literal& expression) override;
+        void visit(const Variable& expression) override;
+        void visit(const PrimaryExpression& expression) override;
+        void visit(const UnaryExpression& expression) override;
+        void visit(const BinaryExpression& expression) override;
+
+    public:
+        explicit TypeChecker(pmr::memory_resource& arena) : arena(arena) {}
+
+        TypedExpression check_and_rewrite(const Expression& expression);
+};
+
+#endif
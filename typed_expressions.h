@@ -0,0 +1,149 @@
+#ifndef TYPED_EXPRESSIONS_H
+#define TYPED_EXPRESSIONS_H
+
+#include "expressions.h"
+#include <type_traits>
+using namespace std;
+
+// Nós monomórficos produzidos pelo TypeChecker: cada um já sabe o tipo dos
+// operandos e devolve int/bool direto, sem variant e sem checagem de tipo
+
+class IntNode {
+    public:
+        virtual ~IntNode() = default;
+        virtual int evaluate() const = 0;
+};
+
+class BoolNode {
+    public:
+        virtual ~BoolNode() = default;
+        virtual bool evaluate() const = 0;
+};
+
+using IntNodePtr = arena_ptr<IntNode>;
+using BoolNodePtr = arena_ptr<BoolNode>;
+
+class IntConstant : public IntNode {
+    private:
+        int value;
+
+    public:
+        explicit IntConstant(int v) : value(v) {}
+        inline int evaluate() const override { return value; }
+};
+
+class BoolConstant : public BoolNode {
+    private:
+        bool value;
+
+    public:
+        explicit BoolConstant(bool v) : value(v) {}
+        inline bool evaluate() const override { return value; }
+};
+
+class IntNegate : public IntNode {
+    private:
+        IntNodePtr operand;
+
+    public:
+        explicit IntNegate(IntNodePtr o) : operand(move(o)) {}
+        inline int evaluate() const override {
+            EDOO_PROFILE_OPERATOR("-", true);
+            return -operand->evaluate();
+        }
+};
+
+// Operações; os operandos são avaliados antes, da esquerda para a direita
+struct AddOp { static constexpr const char* symbol = "+"; static inline int apply(int l, int r) { return l + r; } };
+struct SubOp { static constexpr const char* symbol = "-"; static inline int apply(int l, int r) { return l - r; } };
+struct MulOp { static constexpr const char* symbol = "*"; static inline int apply(int l, int r) { return l * r; } };
+struct DivOp {
+    static constexpr const char* symbol = "/";
+    static inline int apply(int l, int r) {
+        if (r == 0) throw ExpressionError("Divisão por zero");
+        return l / r;
+    }
+};
+struct LessOp { static constexpr const char* symbol = "<"; static inline bool apply(int l, int r) { return l < r; } };
+struct GreaterOp { static constexpr const char* symbol = ">"; static inline bool apply(int l, int r) { return l > r; } };
+struct LessEqualOp { static constexpr const char* symbol = "<="; static inline bool apply(int l, int r) { return l <= r; } };
+struct GreaterEqualOp { static constexpr const char* symbol = ">="; static inline bool apply(int l, int r) { return l >= r; } };
+struct EqualOp { static constexpr const char* symbol = "=="; template <typename T> static inline bool apply(T l, T r) { return l == r; } };
+struct NotEqualOp { static constexpr const char* symbol = "!="; template <typename T> static inline bool apply(T l, T r) { return l != r; } };
+
+// Result: IntNode ou BoolNode; Operand: int ou bool
+template <typename Result, typename Operand, typename Op>
+class TypedBinary : public Result {
+    private:
+        using OperandPtr = arena_ptr<conditional_t<is_same_v<Operand, int>, IntNode, BoolNode>>;
+        using Value = conditional_t<is_same_v<Result, IntNode>, int, bool>;
+        OperandPtr left;
+        OperandPtr right;
+
+    public:
+        TypedBinary(OperandPtr l, OperandPtr r) : left(move(l)), right(move(r)) {}
+
+        inline Value evaluate() const override {
+            EDOO_PROFILE_OPERATOR(Op::symbol, false);
+            Operand lv = left->evaluate();
+            Operand rv = right->evaluate();
+            return Op::apply(lv, rv);
+        }
+};
+
+using IntAdd          = TypedBinary<IntNode, int, AddOp>;
+using IntSub          = TypedBinary<IntNode, int, SubOp>;
+using IntMul          = TypedBinary<IntNode, int, MulOp>;
+using IntDiv          = TypedBinary<IntNode, int, DivOp>;
+using IntLess         = TypedBinary<BoolNode, int, LessOp>;
+using IntGreater      = TypedBinary<BoolNode, int, GreaterOp>;
+using IntLessEqual    = TypedBinary<BoolNode, int, LessEqualOp>;
+using IntGreaterEqual = TypedBinary<BoolNode, int, GreaterEqualOp>;
+using IntEqual        = TypedBinary<BoolNode, int, EqualOp>;
+using IntNotEqual     = TypedBinary<BoolNode, int, NotEqualOp>;
+using BoolEqual       = TypedBinary<BoolNode, bool, EqualOp>;
+using BoolNotEqual    = TypedBinary<BoolNode, bool, NotEqualOp>;
+
+// && (Decisive = false) e ||: a direita só é avaliada quando a esquerda não
+// decide o resultado. Os tipos já foram checados, então pular a direita não
+// esconde nenhum erro de tipo
+template <bool Decisive>
+class TypedShortCircuit : public BoolNode {
+    private:
+        BoolNodePtr left;
+        BoolNodePtr right;
+
+    public:
+        TypedShortCircuit(BoolNodePtr l, BoolNodePtr r) : left(move(l)), right(move(r)) {}
+
+        inline bool evaluate() const override {
+            if (left->evaluate() == Decisive) return Decisive;
+            EDOO_PROFILE_OPERATOR(Decisive ? "||" : "&&", false);
+            return right->evaluate();
+        }
+};
+
+using BoolAnd = TypedShortCircuit<false>;
+using BoolOr  = TypedShortCircuit<true>;
+
+// Raiz de uma árvore tipada: exatamente um dos dois ponteiros é válido
+class TypedExpression {
+    private:
+        IntNodePtr int_root;
+        BoolNodePtr bool_root;
+
+    public:
+        explicit TypedExpression(IntNodePtr root) : int_root(move(root)) {}
+        explicit TypedExpression(BoolNodePtr root) : bool_root(move(root)) {}
+
+        inline ValueType get_type() const { return int_root ? ValueType::INTEGER : ValueType::BOOLEAN; }
+        inline int evaluate_int() const { return int_root->evaluate(); }
+        inline bool evaluate_bool() const { return bool_root->evaluate(); }
+
+        inline variant<int, bool> evaluate() const {
+            if (int_root) return int_root->evaluate();
+            return bool_root->evaluate();
+        }
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef VARIABLES_H
+#define VARIABLES_H
+
+#include "expressions.h"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+class VariableError : public runtime_error {
+    public:
+        explicit VariableError(const string& message) : runtime_error(message) {}
+};
+
+struct VariableInfo {
+    string name;
+    ValueType type;
+    uint32_t slot;
+};
+
+// Declarações das variáveis de uma regra. Cada variável recebe um slot
+// na ordem de declaração; na avaliação os valores vêm num array de
+// int32_t indexado pelo slot (booleanos como 0/1)
+class Variables {
+    private:
+        vector<VariableInfo> declared;
+
+    public:
+        Variables() = default;
+
+        inline uint32_t declare(string_view name, ValueType type) {
+            if (type == ValueType::INVALID) {
+                throw VariableError("Tipo inválido para a variável " + string(name));
+            }
+            if (const VariableInfo* existing = find(name)) {
+                if (existing->type != type) {
+                    throw VariableError("Variável redeclarada com outro tipo: " + string(name));
+                }
+                return existing->slot;
+            }
+            uint32_t slot = static_cast<uint32_t>(declared.size());
+            declared.push_back({string(name), type, slot});
+            return slot;
+        }
+
+        // Poucas variáveis por regra: a busca linear só roda na compilação
+        inline const VariableInfo* find(string_view name) const {
+            for (const auto& variable : declared) {
+                if (variable.name == name) return &variable;
+            }
+            return nullptr;
+        }
+
+        inline size_t size() const { return declared.size(); }
+        inline const VariableInfo& operator[](size_t slot) const { return declared[slot]; }
+        inline auto begin() const { return declared.begin(); }
+        inline auto end() const { return declared.end(); }
+};
+
+#endif